@@ -0,0 +1,241 @@
+// Compares walking the pointer AST with walking the FlatAST on large
+// generated functions.
+//
+// Usage: flat_ast_bench [statements] [depth] [repeats]
+//
+// Each statement of the generated function is `x = <random expression>;`
+// with expressions of the given depth. Two measurements are taken:
+//  - emit: a codegen-shaped pass lowering every expression to a linear
+//    stack-machine instruction buffer, once recursively over the pointer
+//    AST and once as a single loop over the flat arrays. Both produce the
+//    same instructions, which is checked.
+//  - IRGenerator: full LLVM IR generation for the original AST and for the
+//    AST rebuilt from the flat form, which lays nodes out in post-order.
+//    Both are type-checked first, outside the timing.
+
+#include "ast/ASTContext.h"
+#include "ast/ASTVisitor.h"
+#include "ast/FlatAST.h"
+#include "ast/IdentifierTable.h"
+#include "ast/Type.h"
+#include "codegen/IRGenerator.h"
+#include "sema/TypeChecker.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+
+struct Instr {
+    enum Op : uint8_t { Const, Load, Binary, Unary, Call, Pop, Ret };
+    Op op;
+    int64_t operand;
+
+    bool operator==(const Instr &other) const { return op == other.op && operand == other.operand; }
+};
+
+int64_t nameOperand(const ast::IdentifierInfo *name) {
+    return static_cast<int64_t>(reinterpret_cast<uintptr_t>(name));
+}
+
+/** Lowers the pointer AST with recursive visits. */
+class PointerEmitter : public ast::ASTVisitor<PointerEmitter> {
+    friend class ast::ASTVisitor<PointerEmitter>;
+
+public:
+    explicit PointerEmitter(std::vector<Instr> &out) : out_(out) {}
+
+private:
+    std::vector<Instr> &out_;
+
+    void visitIntegerLiteral(ast::IntegerLiteral *node) { out_.push_back({Instr::Const, node->value}); }
+    void visitIdentifier(ast::Identifier *node) { out_.push_back({Instr::Load, nameOperand(node->name)}); }
+    void visitBinaryExpr(ast::BinaryExpr *node) {
+        visit(node->left);
+        visit(node->right);
+        out_.push_back({Instr::Binary, static_cast<int64_t>(node->op)});
+    }
+    void visitUnaryExpr(ast::UnaryExpr *node) {
+        visit(node->operand);
+        out_.push_back({Instr::Unary, static_cast<int64_t>(node->op)});
+    }
+    void visitExprStmt(ast::ExprStmt *node) {
+        visit(node->expression);
+        out_.push_back({Instr::Pop, 0});
+    }
+    void visitReturnStmt(ast::ReturnStmt *node) {
+        visit(node->expression);
+        out_.push_back({Instr::Ret, 0});
+    }
+    void visitVarDecl(ast::VarDecl *node) { visit(node->initializer); }
+    void visitCompoundStmt(ast::CompoundStmt *node) {
+        for (auto *stmt : node->statements) {
+            visit(stmt);
+        }
+    }
+    void visitFunctionDecl(ast::FunctionDecl *node) { visit(node->body); }
+    void visitTranslationUnit(ast::TranslationUnit *node) {
+        for (auto *decl : node->declarations) {
+            visit(decl);
+        }
+    }
+};
+
+/**
+ * Lowers the FlatAST in one loop. Post-order numbering puts operands before
+ * their operator, so no recursion is needed for straight-line code.
+ */
+void emitFlat(const ast::FlatAST &flat, std::vector<Instr> &out) {
+    auto kinds = flat.getKinds();
+    for (ast::FlatAST::NodeIndex i = 0; i < kinds.size(); ++i) {
+        switch (kinds[i]) {
+            case ast::NodeKind::IntegerLiteral:
+                out.push_back({Instr::Const, flat.getIntegerValue(i)});
+                break;
+            case ast::NodeKind::Identifier:
+                out.push_back({Instr::Load, nameOperand(flat.getIdentifier(i))});
+                break;
+            case ast::NodeKind::BinaryExpr:
+                out.push_back({Instr::Binary, static_cast<int64_t>(flat.getBinary(i).op)});
+                break;
+            case ast::NodeKind::UnaryExpr:
+                out.push_back({Instr::Unary, static_cast<int64_t>(flat.getUnary(i).op)});
+                break;
+            case ast::NodeKind::ExprStmt:
+                out.push_back({Instr::Pop, 0});
+                break;
+            case ast::NodeKind::ReturnStmt:
+                out.push_back({Instr::Ret, 0});
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+/** Builds `int main(void) { int x = 1, a = 2, b = 3; x = ...; ...; return x; }`. */
+ast::TranslationUnit *generateFunction(ast::ASTContext &context, size_t statements, unsigned depth) {
+    std::mt19937 random(42);
+    auto &types = context.getTypes();
+    auto *x = context.getIdentifier("x");
+    const ast::IdentifierInfo *names[] = {x, context.getIdentifier("a"), context.getIdentifier("b")};
+    const ast::BinaryExpr::OpKind ops[] = {
+        ast::BinaryExpr::OpKind::Add, ast::BinaryExpr::OpKind::Sub, ast::BinaryExpr::OpKind::Mul,
+        ast::BinaryExpr::OpKind::BitwiseAnd, ast::BinaryExpr::OpKind::BitwiseOr,
+        ast::BinaryExpr::OpKind::BitwiseXor,
+    };
+
+    std::function<ast::Expr*(unsigned)> expression = [&](unsigned level) -> ast::Expr* {
+        if (level == 0 || random() % 8 == 0) {
+            if (random() % 2 == 0) {
+                return context.create<ast::IntegerLiteral>(static_cast<long long>(random() % 9 + 1));
+            }
+            return context.create<ast::Identifier>(names[random() % 3]);
+        }
+        if (random() % 10 == 0) {
+            return context.create<ast::UnaryExpr>(expression(level - 1), ast::UnaryExpr::OpKind::Minus);
+        }
+        auto *left = expression(level - 1);
+        auto *right = expression(level - 1);
+        return context.create<ast::BinaryExpr>(left, right, ops[random() % std::size(ops)]);
+    };
+
+    std::vector<ast::Stmt*> body;
+    for (size_t i = 0; i < 3; ++i) {
+        body.push_back(context.create<ast::VarDecl>(names[i], types.getIntType(),
+                                                    context.create<ast::IntegerLiteral>(static_cast<long long>(i + 1))));
+    }
+    for (size_t i = 0; i < statements; ++i) {
+        auto *target = context.create<ast::Identifier>(x);
+        auto *assign = context.create<ast::BinaryExpr>(target, expression(depth), ast::BinaryExpr::OpKind::Assign);
+        body.push_back(context.create<ast::ExprStmt>(assign));
+    }
+    body.push_back(context.create<ast::ReturnStmt>(context.create<ast::Identifier>(x)));
+
+    auto *function = context.create<ast::FunctionDecl>(context.getIdentifier("main"), types.getIntType(),
+                                                       std::span<ast::FunctionDecl::Parameter>(),
+                                                       context.create<ast::CompoundStmt>(context.copyArray(body)));
+    return context.create<ast::TranslationUnit>(context.copyArray(std::vector<ast::Node*>{function}));
+}
+
+/** Best of `repeats` runs, in milliseconds. */
+double timeBest(unsigned repeats, const std::function<void()> &run) {
+    double best = 0;
+    for (unsigned r = 0; r < repeats; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        best = r == 0 ? elapsed.count() : std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    size_t statements = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+    unsigned depth = argc > 2 ? static_cast<unsigned>(std::strtoul(argv[2], nullptr, 10)) : 6;
+    unsigned repeats = argc > 3 ? static_cast<unsigned>(std::strtoul(argv[3], nullptr, 10)) : 5;
+
+    ast::IdentifierTable identifiers;
+    ast::TypeContext types;
+    ast::ASTContext context(identifiers, types);
+    auto *unit = generateFunction(context, statements, depth);
+
+    ast::FlatAST flat;
+    double flattenTime = timeBest(repeats, [&] { flat = ast::FlatAST::flatten(unit); });
+
+    ast::ASTContext rebuiltContext(identifiers, types);
+    double unflattenTime = timeBest(repeats, [&] {
+        rebuiltContext.reset();
+        flat.unflatten(rebuiltContext);
+    });
+    auto *rebuilt = static_cast<ast::TranslationUnit*>(flat.unflatten(rebuiltContext));
+
+    std::vector<Instr> pointerCode;
+    std::vector<Instr> flatCode;
+    double pointerEmit = timeBest(repeats, [&] {
+        pointerCode.clear();
+        PointerEmitter(pointerCode).visit(unit);
+    });
+    double flatEmit = timeBest(repeats, [&] {
+        flatCode.clear();
+        emitFlat(flat, flatCode);
+    });
+    if (pointerCode != flatCode) {
+        std::cerr << "error: pointer and flat traversals disagree" << std::endl;
+        return 1;
+    }
+
+    if (!sema::TypeChecker(types).checkTypes(unit) || !sema::TypeChecker(types).checkTypes(rebuilt)) {
+        std::cerr << "error: generated function does not type-check" << std::endl;
+        return 1;
+    }
+    std::string pointerIR;
+    std::string rebuiltIR;
+    double pointerCodegen = timeBest(repeats, [&] { pointerIR = codegen::IRGenerator().generateIR(unit); });
+    double rebuiltCodegen = timeBest(repeats, [&] { rebuiltIR = codegen::IRGenerator().generateIR(rebuilt); });
+    if (pointerIR != rebuiltIR) {
+        std::cerr << "error: IR of the rebuilt AST differs" << std::endl;
+        return 1;
+    }
+
+    std::cout << "nodes:              " << flat.size() << "\n"
+              << "pointer AST bytes:  " << context.getBytesReserved() << "\n"
+              << "flat AST bytes:     " << flat.getMemoryUsage() << "\n"
+              << std::fixed << std::setprecision(3)
+              << "flatten:            " << flattenTime << " ms\n"
+              << "unflatten:          " << unflattenTime << " ms\n"
+              << "emit, pointer AST:  " << pointerEmit << " ms\n"
+              << "emit, flat AST:     " << flatEmit << " ms\n"
+              << "IRGenerator:        " << pointerCodegen << " ms\n"
+              << "IRGenerator, rebuilt from flat: " << rebuiltCodegen << " ms\n";
+    return 0;
+}
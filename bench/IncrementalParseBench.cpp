@@ -0,0 +1,147 @@
+// Compares parsing a file from scratch with reparsing it through
+// IncrementalParser after an edit to one function.
+//
+// Usage: incremental_parse_bench [functions] [repeats]
+//
+// The generated file defines the given number of small functions. One in
+// the middle has an expression lengthened, and the file is reparsed. The
+// reparse must parse only the edited function, keep the nodes of the
+// others, and move every declaration after the edit by the edit's length.
+// A blank line inserted into a body changes no token but moves those after
+// it, so that function must be reparsed as well.
+
+#include "ast/Stmt.h"
+#include "parser/IncrementalParser.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+/** `int f<i>(int x) { int y = x * <i>; return y + <i>; }` for every i. */
+std::string generateSource(size_t functions, size_t edited, const std::string &editedReturn) {
+    std::string source;
+    for (size_t i = 0; i < functions; ++i) {
+        std::string n = std::to_string(i);
+        source += "int f" + n + "(int x) {\n";
+        source += "    int y = x * " + n + ";\n";
+        source += i == edited ? "    return " + editedReturn + ";\n" : "    return y + " + n + ";\n";
+        source += "}\n\n";
+    }
+    return source;
+}
+
+/** Offset of the last statement in the body of function i. */
+uint32_t lastStatementOffset(ast::TranslationUnit *unit, size_t i) {
+    return static_cast<ast::FunctionDecl*>(unit->declarations[i])->body->statements.back()->loc.getOffset();
+}
+
+/** Best of `repeats` runs, in milliseconds. */
+double timeBest(unsigned repeats, const std::function<void()> &run) {
+    double best = 0;
+    for (unsigned r = 0; r < repeats; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        best = r == 0 ? elapsed.count() : std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    size_t functions = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000;
+    unsigned repeats = argc > 2 ? static_cast<unsigned>(std::strtoul(argv[2], nullptr, 10)) : 5;
+    if (functions < 2) {
+        std::cerr << "error: need at least two functions" << std::endl;
+        return 1;
+    }
+    size_t edited = functions / 2;
+    std::string before = generateSource(functions, edited, "y + " + std::to_string(edited));
+    std::string after = generateSource(functions, edited, "y * 2 + " + std::to_string(edited));
+    int64_t delta = static_cast<int64_t>(after.size()) - static_cast<int64_t>(before.size());
+
+    parser::IncrementalParser parser;
+    auto *unit = parser.parse(before);
+    if (parser.getNumberOfSyntaxErrors() > 0 || unit->declarations.size() != functions) {
+        std::cerr << "error: generated file does not parse" << std::endl;
+        return 1;
+    }
+    std::vector<ast::Node*> oldNodes(unit->declarations.begin(), unit->declarations.end());
+    std::vector<uint32_t> oldOffsets;
+    for (auto *decl : oldNodes) {
+        oldOffsets.push_back(decl->loc.getOffset());
+    }
+    auto lastBody = [&] { return static_cast<ast::FunctionDecl*>(unit->declarations.back())->body; };
+    int64_t oldBodyOffset = lastBody()->loc.getOffset();
+
+    unit = parser.parse(after);
+    if (parser.getReparsedCount() != 1) {
+        std::cerr << "error: reparsed " << parser.getReparsedCount() << " declarations, expected 1" << std::endl;
+        return 1;
+    }
+    if (unit->declarations.size() != functions) {
+        std::cerr << "error: edited file has " << unit->declarations.size() << " declarations" << std::endl;
+        return 1;
+    }
+    for (size_t i = 0; i < functions; ++i) {
+        ast::Node *decl = unit->declarations[i];
+        if ((i == edited) == (decl == oldNodes[i])) {
+            std::cerr << "error: declaration " << i << (i == edited ? " was reused" : " was reparsed") << std::endl;
+            return 1;
+        }
+        int64_t expected = static_cast<int64_t>(oldOffsets[i]) + (i > edited ? delta : 0);
+        if (decl->loc.getOffset() != expected) {
+            std::cerr << "error: declaration " << i << " is at offset " << decl->loc.getOffset() << ", expected "
+                      << expected << std::endl;
+            return 1;
+        }
+    }
+    if (lastBody()->loc.getOffset() != oldBodyOffset + delta) {
+        std::cerr << "error: nested locations were not moved with their declaration" << std::endl;
+        return 1;
+    }
+
+    std::string spaced = before;
+    std::string header = "int f" + std::to_string(edited) + "(int x) {\n";
+    spaced.insert(spaced.find(header) + header.size(), "\n");
+    parser.parse(before);
+    unit = parser.parse(spaced);
+    if (parser.getReparsedCount() != 1) {
+        std::cerr << "error: reparsed " << parser.getReparsedCount()
+                  << " declarations after a blank line was inserted, expected 1" << std::endl;
+        return 1;
+    }
+    parser::IncrementalParser fresh;
+    auto *expected = fresh.parse(spaced);
+    for (size_t i = 0; i < functions; ++i) {
+        if (lastStatementOffset(unit, i) != lastStatementOffset(expected, i)) {
+            std::cerr << "error: function " << i << " kept stale locations after a blank line was inserted"
+                      << std::endl;
+            return 1;
+        }
+    }
+
+    // Alternate between the two versions so every reparse sees one edit
+    bool edit = false;
+    double fullParse = timeBest(repeats, [&] { parser::IncrementalParser().parse(after); });
+    double reparse = timeBest(repeats, [&] {
+        parser.parse(edit ? after : before);
+        edit = !edit;
+    });
+
+    std::cout << "functions:          " << functions << "\n"
+              << "source bytes:       " << after.size() << "\n"
+              << std::fixed << std::setprecision(3)
+              << "parse from scratch: " << fullParse << " ms\n"
+              << "reparse after edit: " << reparse << " ms\n";
+    return 0;
+}
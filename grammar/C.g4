@@ -464,10 +464,13 @@ selectionStatement
     | 'switch' '(' expression ')' statement
     ;
 
+// Loop pragmas are the only directives the preprocessor passes on
 iterationStatement
-    : While '(' expression ')' statement
-    | Do statement While '(' expression ')' ';'
-    | For '(' forCondition ')' statement
+    : PragmaDirective* (
+        While '(' expression ')' statement
+        | Do statement While '(' expression ')' ';'
+        | For '(' forCondition ')' statement
+    )
     ;
 
 //    |   'for' '(' expression? ';' expression?  ';' forUpdate? ')' statement
@@ -1080,6 +1083,10 @@ MultiLineMacro
     : '#' (~[\n]*? '\\' '\r'? '\n')+ ~ [\n]+ -> channel (HIDDEN)
     ;
 
+PragmaDirective
+    : '#' [ \t]* 'pragma' ~ [\n]*
+    ;
+
 Directive
     : '#' ~ [\n]* -> channel (HIDDEN)
     ;
@@ -0,0 +1,69 @@
+#include "ast/ASTContext.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace ast {
+
+void *ASTContext::allocate(size_t size, size_t alignment) {
+    auto address = reinterpret_cast<std::uintptr_t>(current_);
+    size_t padding = (alignment - address % alignment) % alignment;
+    if (!current_ || padding + size > static_cast<size_t>(end_ - current_)) {
+        startSlab(size + alignment);
+        address = reinterpret_cast<std::uintptr_t>(current_);
+        padding = (alignment - address % alignment) % alignment;
+    }
+    std::byte *result = current_ + padding;
+    current_ = result + size;
+    return result;
+}
+
+void ASTContext::startSlab(size_t minimumSize) {
+    // Slabs double in size so the slab count stays logarithmic
+    size_t size = slabs_.empty() ? InitialSlabSize : std::min(slabs_.back().size * 2, MaxSlabSize);
+    size = std::max(size, minimumSize);
+    slabs_.push_back({std::unique_ptr<std::byte[]>(new std::byte[size]), size});
+    current_ = slabs_.back().memory.get();
+    end_ = current_ + size;
+    bytesReserved_ += size;
+}
+
+std::string_view ASTContext::copyString(std::string_view text) {
+    if (text.empty()) {
+        return {};
+    }
+    auto *data = static_cast<char*>(allocate(text.size(), 1));
+    std::memcpy(data, text.data(), text.size());
+    return {data, text.size()};
+}
+
+void ASTContext::adopt(ASTContext &&other) {
+    if (other.slabs_.empty()) {
+        return;
+    }
+    // Keep allocating from our own current slab; theirs are only kept alive
+    auto insertAt = slabs_.empty() ? slabs_.end() : slabs_.end() - 1;
+    slabs_.insert(insertAt,
+                  std::make_move_iterator(other.slabs_.begin()),
+                  std::make_move_iterator(other.slabs_.end()));
+    if (!current_) {
+        current_ = other.current_;
+        end_ = other.end_;
+    }
+    bytesReserved_ += other.bytesReserved_;
+    other.slabs_.clear();
+    other.current_ = other.end_ = nullptr;
+    other.bytesReserved_ = 0;
+}
+
+void ASTContext::reset() {
+    if (slabs_.empty()) {
+        return;
+    }
+    slabs_.resize(1);
+    current_ = slabs_.front().memory.get();
+    end_ = current_ + slabs_.front().size;
+    bytesReserved_ = slabs_.front().size;
+}
+
+} // namespace ast
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "ast/IdentifierTable.h"
+#include "ast/Type.h"
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ast {
+
+/**
+ * Owns the memory of an AST.
+ *
+ * Nodes, child lists and strings are bump-allocated out of slabs and are
+ * never destroyed individually; the whole AST is released at once when the
+ * context is destroyed or reset. Everything allocated here must therefore be
+ * trivially destructible: nodes refer to children by raw pointer, hold child
+ * lists as std::span and strings as std::string_view into the same context.
+ *
+ * Names are interned in an IdentifierTable and types uniqued in a
+ * TypeContext, both shared by every context of one compilation, so
+ * identifiers and types stay valid and comparable across contexts.
+ *
+ * A context is not thread-safe. Threads building parts of one AST each use
+ * their own context and hand it to the owner with adopt().
+ */
+class ASTContext {
+public:
+    /**
+     * @param identifiers Table interning names; must outlive the context
+     * @param types Context uniquing types; must outlive the context
+     */
+    ASTContext(IdentifierTable &identifiers, TypeContext &types)
+        : identifiers_(&identifiers), types_(&types) {}
+    ASTContext(const ASTContext &) = delete;
+    ASTContext &operator=(const ASTContext &) = delete;
+    ASTContext(ASTContext &&) = default;
+    ASTContext &operator=(ASTContext &&) = default;
+
+    /**
+     * Allocate and construct a node.
+     */
+    template <typename T, typename... Args>
+    T *create(Args &&...args) {
+        static_assert(std::is_trivially_destructible_v<T>,
+                      "arena-allocated types are never destroyed");
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    /**
+     * Copy a list into the arena.
+     */
+    template <typename T>
+    std::span<T> copyArray(const std::vector<T> &items) {
+        static_assert(std::is_trivially_destructible_v<T>,
+                      "arena-allocated types are never destroyed");
+        if (items.empty()) {
+            return {};
+        }
+        auto *data = static_cast<T*>(allocate(sizeof(T) * items.size(), alignof(T)));
+        std::uninitialized_copy(items.begin(), items.end(), data);
+        return {data, items.size()};
+    }
+
+    /**
+     * Copy a string into the arena.
+     */
+    std::string_view copyString(std::string_view text);
+
+    /**
+     * Intern a name.
+     */
+    IdentifierInfo *getIdentifier(std::string_view name) { return identifiers_->get(name); }
+
+    IdentifierTable &getIdentifiers() const { return *identifiers_; }
+
+    TypeContext &getTypes() const { return *types_; }
+
+    /**
+     * Take over every slab of another context, e.g. one filled on a worker
+     * thread. Nodes allocated there stay valid and are now owned here.
+     */
+    void adopt(ASTContext &&other);
+
+    /**
+     * Release everything allocated so far, keeping the first slab for reuse.
+     */
+    void reset();
+
+    /**
+     * Total bytes of slab memory held.
+     */
+    size_t getBytesReserved() const { return bytesReserved_; }
+
+    /**
+     * Raw allocation.
+     */
+    void *allocate(size_t size, size_t alignment);
+
+private:
+    static constexpr size_t InitialSlabSize = 4 * 1024;
+    static constexpr size_t MaxSlabSize = 1024 * 1024;
+
+    struct Slab {
+        std::unique_ptr<std::byte[]> memory;
+        size_t size;
+    };
+
+    IdentifierTable *identifiers_;
+    TypeContext *types_;
+    std::vector<Slab> slabs_;
+    std::byte *current_ = nullptr;
+    std::byte *end_ = nullptr;
+    size_t bytesReserved_ = 0;
+
+    void startSlab(size_t minimumSize);
+};
+
+} // namespace ast
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstdint>
+
+namespace ast {
+
+/**
+ * Layout of serialized AST files, shared by ASTWriter and ASTReader.
+ *
+ * A file is a FileHeader followed by sections of fixed-size records, each
+ * 8-byte aligned, so a mapped file is read in place. Numbers are stored in
+ * host byte order; the header's byteOrder field rejects files written on a
+ * machine of the other order.
+ *
+ * Nodes are numbered in post-order (see FlatAST). A node refers to its
+ * children by how many nodes earlier they are (0 means none), so every
+ * subtree is a contiguous, position-independent run of records. A function
+ * body can therefore be materialized on its own, long after the declaration.
+ */
+namespace format {
+
+constexpr char Magic[8] = {'M', 'M', 'O', 'C', 'A', 'S', 'T', '\0'};
+
+/** Bump on any change to the records below. */
+constexpr uint32_t Version = 4;
+
+constexpr uint32_t ByteOrderMark = 0x01020304;
+
+/** Marks an absent string or type reference. */
+constexpr uint32_t None = 0xffffffff;
+
+struct Section {
+    uint64_t offset;  // from the start of the file
+    uint64_t count;   // number of entries
+};
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    Section stringOffsets;  // uint32_t, one more than there are strings
+    Section stringData;     // char
+    Section types;          // TypeRecord
+    Section typeRefs;       // uint32_t type indices for parameter lists
+    Section nodes;          // NodeRecord; the root is last
+    Section children;       // uint32_t relative node references for child lists
+    Section parameters;     // ParameterRecord
+    Section loopHints;      // LoopHintRecord, in node order
+};
+
+/**
+ * One type. Types are listed after the types they refer to, so a reader
+ * can create them front to back.
+ */
+struct TypeRecord {
+    uint8_t kind;         // Type::Kind
+    uint8_t detail;       // BuiltinKind, qualifier mask or variadic flag
+    uint16_t reserved;
+    uint32_t inner;       // pointee, element, return or base type
+    uint32_t paramBegin;  // into typeRefs
+    uint32_t paramCount;
+    uint64_t numElements;
+};
+
+/**
+ * One AST node. Which operand holds what depends on the kind:
+ *
+ *   IntegerLiteral                   op: BuiltinKind; operands 0-1: the 64-bit value
+ *   FloatingLiteral                  operands 0-1: the 64-bit value
+ *   CharacterLiteral                 operand 0: the value
+ *   StringLiteral, Identifier        operand 0: string
+ *   BinaryExpr                       op; operands 0-1: left, right
+ *   UnaryExpr                        op, flags: prefix; operand 0
+ *   CallExpr                         operand 0: callee; 1-2: argument list
+ *   ArraySubscriptExpr               operands 0-1: array, index
+ *   MemberExpr                       flags: arrow; operand 0: object, 1: string
+ *   ConditionalExpr, IfStmt          operands 0-2
+ *   ExprStmt, ReturnStmt             operand 0
+ *   WhileStmt                        operands 0-1: condition, body
+ *   ForStmt                          operands 0-3: init, condition, increment, body
+ *   CompoundStmt, TranslationUnit    operands 1-2: child list
+ *   VarDecl                          operand 0: initializer, 1: name, 2: type
+ *   FunctionDecl                     operand 0: nodes in the body subtree (0 for a
+ *                                    prototype), 1: name, 2: return type,
+ *                                    3: first parameter; flags: parameter count;
+ *                                    op: 1 if declared without a prototype
+ *
+ * Child references are relative, child lists are (begin, count) ranges of
+ * the children section holding references relative to the owning node.
+ */
+struct NodeRecord {
+    uint8_t kind;  // NodeKind
+    uint8_t op;
+    uint16_t flags;
+    uint32_t loc;  // SourceLocation offset
+    uint32_t operands[4];
+};
+
+struct ParameterRecord {
+    uint32_t type;
+    uint32_t name;  // string, None if unnamed
+};
+
+/**
+ * Pragmas on a loop (see LoopHints), kept out of NodeRecord as few loops
+ * have any. States are LoopHints::State values.
+ */
+struct LoopHintRecord {
+    uint32_t node;
+    uint8_t vectorize;
+    uint8_t interleave;
+    uint8_t unroll;
+    uint8_t independentIterations;
+    uint32_t vectorizeWidth;
+    uint32_t interleaveCount;
+    uint32_t unrollCount;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(TypeRecord) == 24, "type records are part of the file format");
+static_assert(sizeof(NodeRecord) == 24, "node records are part of the file format");
+static_assert(sizeof(ParameterRecord) == 8, "parameter records are part of the file format");
+static_assert(sizeof(LoopHintRecord) == 24, "loop hint records are part of the file format");
+
+} // namespace format
+
+} // namespace ast
@@ -0,0 +1,445 @@
+#include "ast/ASTReader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ast {
+
+namespace {
+
+[[noreturn]] void corrupt(const std::string &what) {
+    throw std::runtime_error("Corrupt AST file: " + what);
+}
+
+} // namespace
+
+ASTReader::ASTReader(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open AST file: " + path);
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || info.st_size == 0) {
+        ::close(fd);
+        throw std::runtime_error("Cannot read AST file: " + path);
+    }
+    size_ = static_cast<size_t>(info.st_size);
+    void *mapping = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Cannot map AST file: " + path);
+    }
+    mapping_ = mapping;
+    data_ = static_cast<const char*>(mapping);
+
+    try {
+        load();
+    } catch (...) {
+        ::munmap(mapping_, size_);
+        throw;
+    }
+}
+
+ASTReader::ASTReader(const void *data, size_t size) : data_(static_cast<const char*>(data)), size_(size) {
+    if (reinterpret_cast<uintptr_t>(data) % 8 != 0) {
+        throw std::invalid_argument("AST buffer must be 8-byte aligned");
+    }
+    load();
+}
+
+ASTReader::~ASTReader() {
+    if (mapping_) {
+        ::munmap(mapping_, size_);
+    }
+}
+
+void ASTReader::load() {
+    if (size_ < sizeof(format::FileHeader)) {
+        throw std::runtime_error("Not an AST file");
+    }
+    const auto *header = reinterpret_cast<const format::FileHeader*>(data_);
+    if (std::memcmp(header->magic, format::Magic, sizeof(format::Magic)) != 0) {
+        throw std::runtime_error("Not an AST file");
+    }
+    if (header->byteOrder != format::ByteOrderMark) {
+        throw std::runtime_error("AST file was written with a different byte order");
+    }
+    if (header->version != format::Version) {
+        throw std::runtime_error("AST file version " + std::to_string(header->version) +
+                                 " is not supported (expected " + std::to_string(format::Version) + ")");
+    }
+
+    stringOffsets_ = getSection<uint32_t>(header->stringOffsets);
+    stringData_ = getSection<char>(header->stringData);
+    types_ = getSection<format::TypeRecord>(header->types);
+    typeRefs_ = getSection<uint32_t>(header->typeRefs);
+    nodes_ = getSection<format::NodeRecord>(header->nodes);
+    children_ = getSection<uint32_t>(header->children);
+    parameters_ = getSection<format::ParameterRecord>(header->parameters);
+    loopHints_ = getSection<format::LoopHintRecord>(header->loopHints);
+
+    if (stringOffsets_.empty()) {
+        corrupt("missing string table");
+    }
+    if (nodes_.empty() || nodes_.back().kind != static_cast<uint8_t>(NodeKind::TranslationUnit)) {
+        corrupt("no translation unit");
+    }
+}
+
+template <typename T>
+std::span<const T> ASTReader::getSection(const format::Section &section) const {
+    if (section.offset > size_ || section.offset % alignof(T) != 0 ||
+        section.count > (size_ - section.offset) / sizeof(T)) {
+        corrupt("section out of bounds");
+    }
+    return {reinterpret_cast<const T*>(data_ + section.offset), static_cast<size_t>(section.count)};
+}
+
+std::string_view ASTReader::getString(uint32_t index) const {
+    if (index + 1 >= stringOffsets_.size()) {
+        corrupt("bad string index");
+    }
+    uint32_t begin = stringOffsets_[index];
+    uint32_t end = stringOffsets_[index + 1];
+    if (begin > end || end > stringData_.size()) {
+        corrupt("bad string offsets");
+    }
+    return std::string_view(stringData_.data() + begin, end - begin);
+}
+
+const IdentifierInfo *ASTReader::getName(ASTContext &context, uint32_t index) const {
+    return index == format::None ? nullptr : context.getIdentifier(getString(index));
+}
+
+const Type *ASTReader::getType(ASTContext &context, uint32_t index) {
+    if (index == format::None) {
+        return nullptr;
+    }
+    if (index >= types_.size()) {
+        corrupt("bad type index");
+    }
+    TypeContext &types = context.getTypes();
+    if (typeContext_ != &types) {
+        typeContext_ = &types;
+        typeCache_.assign(types_.size(), nullptr);
+    }
+    if (typeCache_[index]) {
+        return typeCache_[index];
+    }
+
+    const format::TypeRecord &record = types_[index];
+    // Writers list inner types first; anything else would recurse forever
+    if (record.inner != format::None && record.inner >= index) {
+        corrupt("type refers forward");
+    }
+    const Type *type = nullptr;
+    switch (static_cast<Type::Kind>(record.kind)) {
+        case Type::Kind::Builtin:
+            if (record.detail > static_cast<uint8_t>(BuiltinType::BuiltinKind::LastKind)) {
+                corrupt("bad builtin type");
+            }
+            type = types.getBuiltinType(static_cast<BuiltinType::BuiltinKind>(record.detail));
+            break;
+        case Type::Kind::Pointer:
+            type = types.getPointerType(getType(context, record.inner));
+            break;
+        case Type::Kind::Array:
+            type = types.getArrayType(getType(context, record.inner), record.numElements);
+            break;
+        case Type::Kind::Function: {
+            if (record.paramBegin > typeRefs_.size() || record.paramCount > typeRefs_.size() - record.paramBegin) {
+                corrupt("bad parameter types");
+            }
+            std::vector<const Type*> params;
+            for (uint32_t p = 0; p < record.paramCount; ++p) {
+                uint32_t param = typeRefs_[record.paramBegin + p];
+                if (param >= index) {
+                    corrupt("type refers forward");
+                }
+                params.push_back(getType(context, param));
+            }
+            type = types.getFunctionType(getType(context, record.inner), params, record.detail != 0);
+            break;
+        }
+        case Type::Kind::Qualified:
+            type = types.getQualifiedType(getType(context, record.inner), record.detail);
+            break;
+        default:
+            corrupt("bad type kind");
+    }
+    if (!type) {
+        corrupt("incomplete type");
+    }
+    typeCache_[index] = type;
+    return type;
+}
+
+LoopHints ASTReader::getLoopHints(uint32_t node) const {
+    LoopHints hints;
+    auto it = std::lower_bound(loopHints_.begin(), loopHints_.end(), node,
+                               [](const format::LoopHintRecord &record, uint32_t n) { return record.node < n; });
+    if (it == loopHints_.end() || it->node != node) {
+        return hints;
+    }
+    auto state = [](uint8_t value) {
+        if (value > static_cast<uint8_t>(LoopHints::State::Full)) {
+            corrupt("bad loop hint");
+        }
+        return static_cast<LoopHints::State>(value);
+    };
+    hints.vectorize = state(it->vectorize);
+    hints.interleave = state(it->interleave);
+    hints.unroll = state(it->unroll);
+    hints.independentIterations = it->independentIterations != 0;
+    hints.vectorizeWidth = it->vectorizeWidth;
+    hints.interleaveCount = it->interleaveCount;
+    hints.unrollCount = it->unrollCount;
+    return hints;
+}
+
+TranslationUnit *ASTReader::readTranslationUnit(ASTContext &context, bool lazyBodies) {
+    auto root = static_cast<uint32_t>(nodes_.size() - 1);
+    if (!lazyBodies) {
+        return static_cast<TranslationUnit*>(materialize(context, 0, root));
+    }
+
+    // Top-level declarations are consecutive subtrees ending at each entry
+    // of the unit's list. Definitions are read alone, their bodies skipped.
+    const format::NodeRecord &unit = nodes_[root];
+    uint32_t begin = unit.operands[1];
+    uint32_t count = unit.operands[2];
+    if (begin > children_.size() || count > children_.size() - begin) {
+        corrupt("bad child list");
+    }
+    std::vector<Node*> declarations;
+    uint32_t next = 0;
+    for (uint32_t c = 0; c < count; ++c) {
+        uint32_t rel = children_[begin + c];
+        if (rel == 0 || rel > root - next) {
+            corrupt("bad declaration");
+        }
+        uint32_t index = root - rel;
+        const format::NodeRecord &record = nodes_[index];
+        uint32_t bodySize = record.operands[0];
+        if (record.kind == static_cast<uint8_t>(NodeKind::FunctionDecl) && bodySize > 0 &&
+            bodySize == index - next) {
+            FunctionDecl *function = readFunction(context, index, nullptr);
+            lazyBodies_[function] = {next, index - 1};
+            declarations.push_back(function);
+        } else {
+            declarations.push_back(materialize(context, next, index));
+        }
+        next = index + 1;
+    }
+    auto *node = context.create<TranslationUnit>(context.copyArray(declarations));
+    node->loc = utils::SourceLocation::getFromOffset(unit.loc);
+    return node;
+}
+
+CompoundStmt *ASTReader::loadBody(FunctionDecl *function, ASTContext &context) {
+    auto it = lazyBodies_.find(function);
+    if (it == lazyBodies_.end()) {
+        return nullptr;
+    }
+    auto [first, last] = it->second;
+    lazyBodies_.erase(it);
+
+    Node *body = materialize(context, first, last);
+    if (body->getKind() != NodeKind::CompoundStmt) {
+        corrupt("function body is not a block");
+    }
+    function->body = static_cast<CompoundStmt*>(body);
+    return function->body;
+}
+
+void ASTReader::loadAllBodies(ASTContext &context) {
+    while (!lazyBodies_.empty()) {
+        loadBody(const_cast<FunctionDecl*>(lazyBodies_.begin()->first), context);
+    }
+}
+
+FunctionDecl *ASTReader::readFunction(ASTContext &context, uint32_t index, CompoundStmt *body) {
+    const format::NodeRecord &record = nodes_[index];
+    const uint32_t *ops = record.operands;
+    if (ops[3] > parameters_.size() || record.flags > parameters_.size() - ops[3]) {
+        corrupt("bad parameter list");
+    }
+    std::vector<FunctionDecl::Parameter> params;
+    for (uint32_t p = 0; p < record.flags; ++p) {
+        const format::ParameterRecord &param = parameters_[ops[3] + p];
+        params.emplace_back(getType(context, param.type), getName(context, param.name));
+    }
+
+    auto *function = context.create<FunctionDecl>(getName(context, ops[1]), getType(context, ops[2]),
+                                                  context.copyArray(params), body);
+    function->hasPrototype = record.op == 0;
+    function->loc = utils::SourceLocation::getFromOffset(record.loc);
+    return function;
+}
+
+Node *ASTReader::materialize(ASTContext &context, uint32_t first, uint32_t last) {
+    std::vector<Node*> nodes(last - first + 1);
+
+    auto child = [&](uint32_t self, uint32_t rel) -> Node* {
+        if (rel == 0) {
+            return nullptr;
+        }
+        if (rel > self - first || !nodes[self - rel - first]) {
+            corrupt("node refers outside its subtree");
+        }
+        return nodes[self - rel - first];
+    };
+    auto expr = [&](uint32_t self, uint32_t rel) -> Expr* {
+        Node *node = child(self, rel);
+        if (node && !Expr::classof(node)) {
+            corrupt("expected an expression");
+        }
+        return static_cast<Expr*>(node);
+    };
+    auto stmt = [&](uint32_t self, uint32_t rel) -> Stmt* {
+        Node *node = child(self, rel);
+        if (node && !Stmt::classof(node)) {
+            corrupt("expected a statement");
+        }
+        return static_cast<Stmt*>(node);
+    };
+    auto list = [&](uint32_t self, const format::NodeRecord &record, auto *kind) {
+        using T = std::remove_pointer_t<decltype(kind)>;
+        uint32_t begin = record.operands[1];
+        uint32_t count = record.operands[2];
+        if (begin > children_.size() || count > children_.size() - begin) {
+            corrupt("bad child list");
+        }
+        std::vector<T*> items;
+        items.reserve(count);
+        for (uint32_t c = 0; c < count; ++c) {
+            Node *node = child(self, children_[begin + c]);
+            if constexpr (!std::is_same_v<T, Node>) {
+                if (node && !T::classof(node)) {
+                    corrupt("unexpected node in child list");
+                }
+            }
+            items.push_back(static_cast<T*>(node));
+        }
+        return context.copyArray(items);
+    };
+    auto value = [](const format::NodeRecord &record) {
+        return uint64_t(record.operands[0]) | (uint64_t(record.operands[1]) << 32);
+    };
+
+    for (uint32_t i = first; i <= last; ++i) {
+        const format::NodeRecord &record = nodes_[i];
+        const uint32_t *ops = record.operands;
+        Node *node = nullptr;
+        switch (static_cast<NodeKind>(record.kind)) {
+            case NodeKind::IntegerLiteral:
+                if (record.op > static_cast<uint8_t>(BuiltinType::BuiltinKind::LastKind)) {
+                    corrupt("bad literal type");
+                }
+                node = context.create<IntegerLiteral>(static_cast<long long>(value(record)),
+                                                      static_cast<BuiltinType::BuiltinKind>(record.op));
+                break;
+            case NodeKind::FloatingLiteral: {
+                uint64_t bits = value(record);
+                double number;
+                std::memcpy(&number, &bits, sizeof(number));
+                node = context.create<FloatingLiteral>(number);
+                break;
+            }
+            case NodeKind::CharacterLiteral:
+                node = context.create<CharacterLiteral>(static_cast<char>(ops[0]));
+                break;
+            case NodeKind::StringLiteral:
+                node = context.create<StringLiteral>(context.copyString(getString(ops[0])));
+                break;
+            case NodeKind::Identifier:
+                node = context.create<Identifier>(getName(context, ops[0]));
+                break;
+            case NodeKind::BinaryExpr:
+                if (record.op > static_cast<uint8_t>(BinaryExpr::OpKind::LastKind)) {
+                    corrupt("bad operator");
+                }
+                node = context.create<BinaryExpr>(expr(i, ops[0]), expr(i, ops[1]),
+                                                  static_cast<BinaryExpr::OpKind>(record.op));
+                break;
+            case NodeKind::UnaryExpr:
+                if (record.op > static_cast<uint8_t>(UnaryExpr::OpKind::LastKind)) {
+                    corrupt("bad operator");
+                }
+                node = context.create<UnaryExpr>(expr(i, ops[0]), static_cast<UnaryExpr::OpKind>(record.op),
+                                                 record.flags != 0);
+                break;
+            case NodeKind::CallExpr:
+                node = context.create<CallExpr>(expr(i, ops[0]), list(i, record, static_cast<Expr*>(nullptr)));
+                break;
+            case NodeKind::ArraySubscriptExpr:
+                node = context.create<ArraySubscriptExpr>(expr(i, ops[0]), expr(i, ops[1]));
+                break;
+            case NodeKind::MemberExpr:
+                node = context.create<MemberExpr>(expr(i, ops[0]), getName(context, ops[1]), record.flags != 0);
+                break;
+            case NodeKind::ConditionalExpr:
+                node = context.create<ConditionalExpr>(expr(i, ops[0]), expr(i, ops[1]), expr(i, ops[2]));
+                break;
+            case NodeKind::ExprStmt:
+                node = context.create<ExprStmt>(expr(i, ops[0]));
+                break;
+            case NodeKind::ReturnStmt:
+                node = context.create<ReturnStmt>(expr(i, ops[0]));
+                break;
+            case NodeKind::IfStmt:
+                node = context.create<IfStmt>(expr(i, ops[0]), stmt(i, ops[1]), stmt(i, ops[2]));
+                break;
+            case NodeKind::WhileStmt: {
+                auto *loop = context.create<WhileStmt>(expr(i, ops[0]), stmt(i, ops[1]));
+                loop->hints = getLoopHints(i);
+                node = loop;
+                break;
+            }
+            case NodeKind::ForStmt: {
+                auto *loop = context.create<ForStmt>(stmt(i, ops[0]), expr(i, ops[1]), expr(i, ops[2]), stmt(i, ops[3]));
+                loop->hints = getLoopHints(i);
+                node = loop;
+                break;
+            }
+            case NodeKind::BreakStmt:
+                node = context.create<BreakStmt>();
+                break;
+            case NodeKind::ContinueStmt:
+                node = context.create<ContinueStmt>();
+                break;
+            case NodeKind::CompoundStmt:
+                node = context.create<CompoundStmt>(list(i, record, static_cast<Stmt*>(nullptr)));
+                break;
+            case NodeKind::VarDecl:
+                node = context.create<VarDecl>(getName(context, ops[1]), getType(context, ops[2]), expr(i, ops[0]));
+                break;
+            case NodeKind::FunctionDecl: {
+                // The body, if any, ends right before the function
+                Node *body = ops[0] > 0 ? child(i, 1) : nullptr;
+                if (body && body->getKind() != NodeKind::CompoundStmt) {
+                    corrupt("function body is not a block");
+                }
+                node = readFunction(context, i, static_cast<CompoundStmt*>(body));
+                break;
+            }
+            case NodeKind::TranslationUnit:
+                node = context.create<TranslationUnit>(list(i, record, static_cast<Node*>(nullptr)));
+                break;
+            default:
+                corrupt("bad node kind");
+        }
+        node->loc = utils::SourceLocation::getFromOffset(record.loc);
+        nodes[i - first] = node;
+    }
+    return nodes.back();
+}
+
+} // namespace ast
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "ast/ASTContext.h"
+#include "ast/ASTFormat.h"
+#include "ast/Stmt.h"
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ast {
+
+/**
+ * Loads a binary AST file written by ASTWriter.
+ *
+ * A file is mapped into memory and its record arrays are read in place;
+ * opening one only validates the header and section bounds. Nodes are
+ * created in an ASTContext when asked for. With lazy bodies, function
+ * definitions are read without their bodies, which are materialized one
+ * at a time by loadBody(), e.g. only for the functions a TU actually emits.
+ *
+ * The reader must outlive the lazy definitions it hands out until their
+ * bodies are loaded. Names and types are interned in the context's
+ * IdentifierTable and TypeContext.
+ */
+class ASTReader {
+public:
+    /**
+     * Map a file.
+     * @throws std::runtime_error if it cannot be read or is not a valid AST
+     *         file of this version
+     */
+    explicit ASTReader(const std::string &path);
+
+    /**
+     * Read from a buffer the caller keeps alive, e.g. one received from a
+     * compile server. The buffer must be 8-byte aligned.
+     */
+    ASTReader(const void *data, size_t size);
+
+    ~ASTReader();
+    ASTReader(const ASTReader &) = delete;
+    ASTReader &operator=(const ASTReader &) = delete;
+
+    /**
+     * Materialize the translation unit.
+     * @param lazyBodies Leave function bodies unread; see loadBody()
+     */
+    TranslationUnit *readTranslationUnit(ASTContext &context, bool lazyBodies = false);
+
+    /**
+     * Whether a function read with lazy bodies still has its body on disk.
+     * Such a function is a definition even though its body is null.
+     */
+    bool hasLazyBody(const FunctionDecl *function) const { return lazyBodies_.count(function) != 0; }
+
+    /**
+     * Materialize the body of a lazily read function and attach it.
+     * @return The body, or nullptr if the function has none pending
+     */
+    CompoundStmt *loadBody(FunctionDecl *function, ASTContext &context);
+
+    /** Load every pending body. */
+    void loadAllBodies(ASTContext &context);
+
+    size_t getNumNodes() const { return nodes_.size(); }
+
+private:
+    const char *data_ = nullptr;
+    size_t size_ = 0;
+    void *mapping_ = nullptr;  // owned mmap, if the reader opened the file
+
+    std::span<const uint32_t> stringOffsets_;
+    std::span<const char> stringData_;
+    std::span<const format::TypeRecord> types_;
+    std::span<const uint32_t> typeRefs_;
+    std::span<const format::NodeRecord> nodes_;
+    std::span<const uint32_t> children_;
+    std::span<const format::ParameterRecord> parameters_;
+    std::span<const format::LoopHintRecord> loopHints_;
+
+    // Types are interned per TypeContext, so the table is rebuilt per context
+    TypeContext *typeContext_ = nullptr;
+    std::vector<const Type*> typeCache_;
+
+    /** Nodes [first, last] of each pending body. */
+    std::unordered_map<const FunctionDecl*, std::pair<uint32_t, uint32_t>> lazyBodies_;
+
+    void load();
+
+    template <typename T>
+    std::span<const T> getSection(const format::Section &section) const;
+
+    std::string_view getString(uint32_t index) const;
+    const IdentifierInfo *getName(ASTContext &context, uint32_t index) const;
+    const Type *getType(ASTContext &context, uint32_t index);
+    LoopHints getLoopHints(uint32_t node) const;
+
+    /**
+     * Create the nodes [first, last], a run of whole subtrees, and return
+     * the last.
+     */
+    Node *materialize(ASTContext &context, uint32_t first, uint32_t last);
+
+    /** Create a FunctionDecl from its record with the given body. */
+    FunctionDecl *readFunction(ASTContext &context, uint32_t index, CompoundStmt *body);
+};
+
+} // namespace ast
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "ast/Node.h"
+#include "ast/Expr.h"
+#include "ast/Stmt.h"
+
+namespace ast {
+
+/**
+ * CRTP visitor dispatching on NodeKind with a single switch.
+ *
+ * Derived classes define visitX(X*) for the node classes they handle. Any
+ * node without its own method falls back to visitExpr or visitStmt, and
+ * from there to visitNode, which returns RetTy(). Null children, left where
+ * the builder met a construct it does not model, go straight to visitNode.
+ *
+ * Derived visit methods may be private if the derived class befriends
+ * ASTVisitor<Derived, RetTy>.
+ */
+template <typename Derived, typename RetTy = void>
+class ASTVisitor {
+public:
+    RetTy visit(Node *node) {
+        if (!node) {
+            return derived().visitNode(node);
+        }
+        switch (node->getKind()) {
+            case NodeKind::IntegerLiteral: return derived().visitIntegerLiteral(static_cast<IntegerLiteral*>(node));
+            case NodeKind::FloatingLiteral: return derived().visitFloatingLiteral(static_cast<FloatingLiteral*>(node));
+            case NodeKind::CharacterLiteral: return derived().visitCharacterLiteral(static_cast<CharacterLiteral*>(node));
+            case NodeKind::StringLiteral: return derived().visitStringLiteral(static_cast<StringLiteral*>(node));
+            case NodeKind::Identifier: return derived().visitIdentifier(static_cast<Identifier*>(node));
+            case NodeKind::BinaryExpr: return derived().visitBinaryExpr(static_cast<BinaryExpr*>(node));
+            case NodeKind::UnaryExpr: return derived().visitUnaryExpr(static_cast<UnaryExpr*>(node));
+            case NodeKind::CallExpr: return derived().visitCallExpr(static_cast<CallExpr*>(node));
+            case NodeKind::ArraySubscriptExpr: return derived().visitArraySubscriptExpr(static_cast<ArraySubscriptExpr*>(node));
+            case NodeKind::MemberExpr: return derived().visitMemberExpr(static_cast<MemberExpr*>(node));
+            case NodeKind::ConditionalExpr: return derived().visitConditionalExpr(static_cast<ConditionalExpr*>(node));
+            
+            case NodeKind::ExprStmt: return derived().visitExprStmt(static_cast<ExprStmt*>(node));
+            case NodeKind::ReturnStmt: return derived().visitReturnStmt(static_cast<ReturnStmt*>(node));
+            case NodeKind::IfStmt: return derived().visitIfStmt(static_cast<IfStmt*>(node));
+            case NodeKind::WhileStmt: return derived().visitWhileStmt(static_cast<WhileStmt*>(node));
+            case NodeKind::ForStmt: return derived().visitForStmt(static_cast<ForStmt*>(node));
+            case NodeKind::BreakStmt: return derived().visitBreakStmt(static_cast<BreakStmt*>(node));
+            case NodeKind::ContinueStmt: return derived().visitContinueStmt(static_cast<ContinueStmt*>(node));
+            case NodeKind::CompoundStmt: return derived().visitCompoundStmt(static_cast<CompoundStmt*>(node));
+            case NodeKind::VarDecl: return derived().visitVarDecl(static_cast<VarDecl*>(node));
+            
+            case NodeKind::FunctionDecl: return derived().visitFunctionDecl(static_cast<FunctionDecl*>(node));
+            case NodeKind::TranslationUnit: return derived().visitTranslationUnit(static_cast<TranslationUnit*>(node));
+        }
+        return RetTy();
+    }
+    
+protected:
+    // Expressions
+    RetTy visitIntegerLiteral(IntegerLiteral *node) { return derived().visitExpr(node); }
+    RetTy visitFloatingLiteral(FloatingLiteral *node) { return derived().visitExpr(node); }
+    RetTy visitCharacterLiteral(CharacterLiteral *node) { return derived().visitExpr(node); }
+    RetTy visitStringLiteral(StringLiteral *node) { return derived().visitExpr(node); }
+    RetTy visitIdentifier(Identifier *node) { return derived().visitExpr(node); }
+    RetTy visitBinaryExpr(BinaryExpr *node) { return derived().visitExpr(node); }
+    RetTy visitUnaryExpr(UnaryExpr *node) { return derived().visitExpr(node); }
+    RetTy visitCallExpr(CallExpr *node) { return derived().visitExpr(node); }
+    RetTy visitArraySubscriptExpr(ArraySubscriptExpr *node) { return derived().visitExpr(node); }
+    RetTy visitMemberExpr(MemberExpr *node) { return derived().visitExpr(node); }
+    RetTy visitConditionalExpr(ConditionalExpr *node) { return derived().visitExpr(node); }
+    
+    // Statements
+    RetTy visitExprStmt(ExprStmt *node) { return derived().visitStmt(node); }
+    RetTy visitReturnStmt(ReturnStmt *node) { return derived().visitStmt(node); }
+    RetTy visitIfStmt(IfStmt *node) { return derived().visitStmt(node); }
+    RetTy visitWhileStmt(WhileStmt *node) { return derived().visitStmt(node); }
+    RetTy visitForStmt(ForStmt *node) { return derived().visitStmt(node); }
+    RetTy visitBreakStmt(BreakStmt *node) { return derived().visitStmt(node); }
+    RetTy visitContinueStmt(ContinueStmt *node) { return derived().visitStmt(node); }
+    RetTy visitCompoundStmt(CompoundStmt *node) { return derived().visitStmt(node); }
+    RetTy visitVarDecl(VarDecl *node) { return derived().visitStmt(node); }
+    
+    // Top-level declarations
+    RetTy visitFunctionDecl(FunctionDecl *node) { return derived().visitNode(node); }
+    RetTy visitTranslationUnit(TranslationUnit *node) { return derived().visitNode(node); }
+    
+    // Fallbacks
+    RetTy visitExpr(Expr *node) { return derived().visitNode(node); }
+    RetTy visitStmt(Stmt *node) { return derived().visitNode(node); }
+    RetTy visitNode(Node *) { return RetTy(); }
+    
+private:
+    Derived &derived() { return *static_cast<Derived*>(this); }
+};
+
+} // namespace ast
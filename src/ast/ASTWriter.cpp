@@ -0,0 +1,343 @@
+#include "ast/ASTWriter.h"
+#include "ast/ASTFormat.h"
+#include "ast/Casting.h"
+#include "ast/FlatAST.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace ast {
+
+namespace {
+
+using format::NodeRecord;
+using format::TypeRecord;
+using NodeIndex = FlatAST::NodeIndex;
+
+class Writer {
+public:
+    explicit Writer(const FlatAST &flat) : flat_(flat), first_(flat.size()) {}
+
+    void write(std::ostream &out) {
+        stringOffsets_.push_back(0);
+        nodes_.reserve(flat_.size());
+        for (NodeIndex i = 0; i < flat_.size(); ++i) {
+            nodes_.push_back(encode(i));
+        }
+
+        format::FileHeader header{};
+        std::memcpy(header.magic, format::Magic, sizeof(header.magic));
+        header.version = format::Version;
+        header.byteOrder = format::ByteOrderMark;
+
+        uint64_t offset = sizeof(header);
+        auto place = [&offset](format::Section &section, const auto &items) {
+            using Item = typename std::decay_t<decltype(items)>::value_type;
+            section.offset = offset;
+            section.count = items.size();
+            offset = align(offset + items.size() * sizeof(Item));
+        };
+        place(header.stringOffsets, stringOffsets_);
+        place(header.stringData, stringData_);
+        place(header.types, types_);
+        place(header.typeRefs, typeRefs_);
+        place(header.nodes, nodes_);
+        place(header.children, children_);
+        place(header.parameters, parameters_);
+        place(header.loopHints, loopHints_);
+
+        uint64_t written = 0;
+        auto emit = [&](const void *data, size_t size) {
+            out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+            written += size;
+            static const char zeros[8] = {};
+            out.write(zeros, static_cast<std::streamsize>(align(written) - written));
+            written = align(written);
+        };
+        auto emitSection = [&](const auto &items) {
+            using Item = typename std::decay_t<decltype(items)>::value_type;
+            emit(items.data(), items.size() * sizeof(Item));
+        };
+        emit(&header, sizeof(header));
+        emitSection(stringOffsets_);
+        emitSection(stringData_);
+        emitSection(types_);
+        emitSection(typeRefs_);
+        emitSection(nodes_);
+        emitSection(children_);
+        emitSection(parameters_);
+        emitSection(loopHints_);
+
+        if (!out) {
+            throw std::runtime_error("Failed to write AST");
+        }
+    }
+
+private:
+    const FlatAST &flat_;
+
+    std::vector<uint32_t> stringOffsets_;
+    std::string stringData_;
+    std::unordered_map<std::string_view, uint32_t> strings_;
+
+    std::vector<TypeRecord> types_;
+    std::vector<uint32_t> typeRefs_;
+    std::unordered_map<const Type*, uint32_t> typeIndices_;
+
+    std::vector<NodeRecord> nodes_;
+    std::vector<uint32_t> children_;
+    std::vector<format::ParameterRecord> parameters_;
+    std::vector<format::LoopHintRecord> loopHints_;
+    std::vector<NodeIndex> first_;  // first node of each node's subtree
+
+    static uint64_t align(uint64_t offset) { return (offset + 7) & ~uint64_t(7); }
+
+    uint32_t addString(std::string_view text) {
+        auto [it, inserted] = strings_.try_emplace(text, static_cast<uint32_t>(stringOffsets_.size() - 1));
+        if (inserted) {
+            stringData_.append(text);
+            stringOffsets_.push_back(static_cast<uint32_t>(stringData_.size()));
+        }
+        return it->second;
+    }
+
+    uint32_t addName(const IdentifierInfo *name) {
+        return name ? addString(name->getName()) : format::None;
+    }
+
+    uint32_t addType(const Type *type) {
+        if (!type) {
+            return format::None;
+        }
+        if (auto it = typeIndices_.find(type); it != typeIndices_.end()) {
+            return it->second;
+        }
+
+        // Inner types first, so readers can build the table front to back
+        TypeRecord record{};
+        record.kind = static_cast<uint8_t>(type->getKind());
+        record.inner = format::None;
+        if (auto *builtin = dyn_cast<BuiltinType>(type)) {
+            record.detail = static_cast<uint8_t>(builtin->getBuiltinKind());
+        } else if (auto *pointer = dyn_cast<PointerType>(type)) {
+            record.inner = addType(pointer->getPointeeType());
+        } else if (auto *array = dyn_cast<ArrayType>(type)) {
+            record.inner = addType(array->getElementType());
+            record.numElements = array->getNumElements();
+        } else if (auto *function = dyn_cast<FunctionType>(type)) {
+            record.inner = addType(function->getReturnType());
+            record.detail = function->isVariadic();
+            std::vector<uint32_t> params;
+            for (auto *param : function->getParamTypes()) {
+                params.push_back(addType(param));
+            }
+            record.paramBegin = static_cast<uint32_t>(typeRefs_.size());
+            record.paramCount = static_cast<uint32_t>(params.size());
+            typeRefs_.insert(typeRefs_.end(), params.begin(), params.end());
+        } else if (auto *qualified = dyn_cast<QualifiedType>(type)) {
+            record.inner = addType(qualified->getBaseType());
+            record.detail = static_cast<uint8_t>(qualified->getQualifiers());
+        }
+
+        uint32_t index = static_cast<uint32_t>(types_.size());
+        types_.push_back(record);
+        typeIndices_[type] = index;
+        return index;
+    }
+
+    /** Reference from node `self` to `child`, extending self's subtree. */
+    uint32_t ref(NodeIndex self, NodeIndex child) {
+        if (child == FlatAST::NoNode) {
+            return 0;
+        }
+        first_[self] = std::min(first_[self], first_[child]);
+        return self - child;
+    }
+
+    void addList(NodeRecord &record, NodeIndex self, std::span<const NodeIndex> list) {
+        record.operands[1] = static_cast<uint32_t>(children_.size());
+        record.operands[2] = static_cast<uint32_t>(list.size());
+        for (auto child : list) {
+            children_.push_back(ref(self, child));
+        }
+    }
+
+    void addLoopHints(NodeIndex loop, const LoopHints &hints) {
+        if (hints.empty()) {
+            return;
+        }
+        format::LoopHintRecord record{};
+        record.node = loop;
+        record.vectorize = static_cast<uint8_t>(hints.vectorize);
+        record.interleave = static_cast<uint8_t>(hints.interleave);
+        record.unroll = static_cast<uint8_t>(hints.unroll);
+        record.independentIterations = hints.independentIterations;
+        record.vectorizeWidth = hints.vectorizeWidth;
+        record.interleaveCount = hints.interleaveCount;
+        record.unrollCount = hints.unrollCount;
+        loopHints_.push_back(record);
+    }
+
+    static void setValue(NodeRecord &record, uint64_t value) {
+        record.operands[0] = static_cast<uint32_t>(value);
+        record.operands[1] = static_cast<uint32_t>(value >> 32);
+    }
+
+    NodeRecord encode(NodeIndex i) {
+        first_[i] = i;
+
+        NodeRecord record{};
+        record.kind = static_cast<uint8_t>(flat_.getKind(i));
+        record.loc = flat_.getLocation(i).getOffset();
+        switch (flat_.getKind(i)) {
+            case NodeKind::IntegerLiteral:
+                record.op = static_cast<uint8_t>(flat_.getIntegerKind(i));
+                setValue(record, static_cast<uint64_t>(flat_.getIntegerValue(i)));
+                break;
+            case NodeKind::FloatingLiteral: {
+                double value = flat_.getFloatingValue(i);
+                uint64_t bits;
+                std::memcpy(&bits, &value, sizeof(bits));
+                setValue(record, bits);
+                break;
+            }
+            case NodeKind::CharacterLiteral:
+                record.operands[0] = static_cast<uint8_t>(flat_.getCharacterValue(i));
+                break;
+            case NodeKind::StringLiteral:
+                record.operands[0] = addString(flat_.getStringValue(i));
+                break;
+            case NodeKind::Identifier:
+                record.operands[0] = addName(flat_.getIdentifier(i));
+                break;
+            case NodeKind::BinaryExpr: {
+                const auto &binary = flat_.getBinary(i);
+                record.op = static_cast<uint8_t>(binary.op);
+                record.operands[0] = ref(i, binary.left);
+                record.operands[1] = ref(i, binary.right);
+                break;
+            }
+            case NodeKind::UnaryExpr: {
+                const auto &unary = flat_.getUnary(i);
+                record.op = static_cast<uint8_t>(unary.op);
+                record.flags = unary.isPrefix;
+                record.operands[0] = ref(i, unary.operand);
+                break;
+            }
+            case NodeKind::CallExpr: {
+                const auto &call = flat_.getCall(i);
+                record.operands[0] = ref(i, call.callee);
+                addList(record, i, flat_.getChildren(call.arguments));
+                break;
+            }
+            case NodeKind::ArraySubscriptExpr: {
+                const auto &subscript = flat_.getSubscript(i);
+                record.operands[0] = ref(i, subscript.array);
+                record.operands[1] = ref(i, subscript.index);
+                break;
+            }
+            case NodeKind::MemberExpr: {
+                const auto &member = flat_.getMember(i);
+                record.flags = member.isArrow;
+                record.operands[0] = ref(i, member.object);
+                record.operands[1] = addName(member.member);
+                break;
+            }
+            case NodeKind::ConditionalExpr: {
+                const auto &conditional = flat_.getConditional(i);
+                record.operands[0] = ref(i, conditional.condition);
+                record.operands[1] = ref(i, conditional.trueExpr);
+                record.operands[2] = ref(i, conditional.falseExpr);
+                break;
+            }
+            case NodeKind::ExprStmt:
+                record.operands[0] = ref(i, flat_.getExprStmtExpression(i));
+                break;
+            case NodeKind::ReturnStmt:
+                record.operands[0] = ref(i, flat_.getReturnValue(i));
+                break;
+            case NodeKind::IfStmt: {
+                const auto &ifStmt = flat_.getIf(i);
+                record.operands[0] = ref(i, ifStmt.condition);
+                record.operands[1] = ref(i, ifStmt.thenStmt);
+                record.operands[2] = ref(i, ifStmt.elseStmt);
+                break;
+            }
+            case NodeKind::WhileStmt: {
+                const auto &whileStmt = flat_.getWhile(i);
+                record.operands[0] = ref(i, whileStmt.condition);
+                record.operands[1] = ref(i, whileStmt.body);
+                addLoopHints(i, whileStmt.hints);
+                break;
+            }
+            case NodeKind::ForStmt: {
+                const auto &forStmt = flat_.getFor(i);
+                record.operands[0] = ref(i, forStmt.init);
+                record.operands[1] = ref(i, forStmt.condition);
+                record.operands[2] = ref(i, forStmt.increment);
+                record.operands[3] = ref(i, forStmt.body);
+                addLoopHints(i, forStmt.hints);
+                break;
+            }
+            case NodeKind::BreakStmt:
+            case NodeKind::ContinueStmt:
+                break;
+            case NodeKind::CompoundStmt:
+                addList(record, i, flat_.getCompoundBody(i));
+                break;
+            case NodeKind::VarDecl: {
+                const auto &var = flat_.getVar(i);
+                record.operands[0] = ref(i, var.initializer);
+                record.operands[1] = addName(var.name);
+                record.operands[2] = addType(var.type);
+                break;
+            }
+            case NodeKind::FunctionDecl: {
+                const auto &function = flat_.getFunction(i);
+                // The body is the only child, so it ends right before the function
+                if (function.body != FlatAST::NoNode) {
+                    ref(i, function.body);
+                    record.operands[0] = i - first_[i];
+                }
+                record.operands[1] = addName(function.name);
+                record.operands[2] = addType(function.returnType);
+                auto params = flat_.getParameters(function.parameters);
+                if (params.size() > UINT16_MAX) {
+                    throw std::runtime_error("Too many parameters to serialize");
+                }
+                record.operands[3] = static_cast<uint32_t>(parameters_.size());
+                record.flags = static_cast<uint16_t>(params.size());
+                record.op = !function.hasPrototype;
+                for (const auto &[type, name] : params) {
+                    parameters_.push_back({addType(type), addName(name)});
+                }
+                break;
+            }
+            case NodeKind::TranslationUnit:
+                addList(record, i, flat_.getDeclarations(i));
+                break;
+        }
+        return record;
+    }
+};
+
+} // namespace
+
+void ASTWriter::write(TranslationUnit *unit, std::ostream &out) {
+    FlatAST flat = FlatAST::flatten(unit);
+    Writer(flat).write(out);
+}
+
+void ASTWriter::writeFile(TranslationUnit *unit, const std::string &path) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        throw std::runtime_error("Cannot write AST file: " + path);
+    }
+    write(unit, out);
+}
+
+} // namespace ast
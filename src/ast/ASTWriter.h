@@ -0,0 +1,33 @@
+#pragma once
+
+#include "ast/Stmt.h"
+
+#include <ostream>
+#include <string>
+
+namespace ast {
+
+/**
+ * Serializes a translation unit to the binary AST format (see ASTFormat.h),
+ * for loading with ASTReader in a later build or another process.
+ *
+ * Names are written once each to a string table and types once each to a
+ * type table. Source locations are stored as written; they only make sense
+ * to a SourceManager that loads the same buffers in the same order.
+ */
+class ASTWriter {
+public:
+    /**
+     * Serialize to a stream.
+     * @throws std::runtime_error if the stream fails
+     */
+    static void write(TranslationUnit *unit, std::ostream &out);
+
+    /**
+     * Serialize to a file, replacing it.
+     * @throws std::runtime_error if the file cannot be written
+     */
+    static void writeFile(TranslationUnit *unit, const std::string &path);
+};
+
+} // namespace ast
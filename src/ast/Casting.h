@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cassert>
+
+namespace ast {
+
+/**
+ * LLVM-style checked casts. Each class of a hierarchy (AST nodes, types)
+ * provides `static bool classof(const Base*)`; these never touch RTTI.
+ */
+
+template <typename To, typename From>
+bool isa(const From *value) {
+    return To::classof(value);
+}
+
+template <typename To, typename From>
+To *cast(From *value) {
+    assert(isa<To>(value) && "cast<To>() to an incompatible kind");
+    return static_cast<To*>(value);
+}
+
+template <typename To, typename From>
+const To *cast(const From *value) {
+    assert(isa<To>(value) && "cast<To>() to an incompatible kind");
+    return static_cast<const To*>(value);
+}
+
+template <typename To, typename From>
+To *dyn_cast(From *value) {
+    return isa<To>(value) ? static_cast<To*>(value) : nullptr;
+}
+
+template <typename To, typename From>
+const To *dyn_cast(const From *value) {
+    return isa<To>(value) ? static_cast<const To*>(value) : nullptr;
+}
+
+/** Like dyn_cast, but accepts nullptr. */
+template <typename To, typename From>
+To *dyn_cast_or_null(From *value) {
+    return value ? dyn_cast<To>(value) : nullptr;
+}
+
+template <typename To, typename From>
+const To *dyn_cast_or_null(const From *value) {
+    return value ? dyn_cast<To>(value) : nullptr;
+}
+
+} // namespace ast
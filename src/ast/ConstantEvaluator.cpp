@@ -0,0 +1,481 @@
+#include "ast/ConstantEvaluator.h"
+#include "ast/Casting.h"
+
+#include <cmath>
+#include <limits>
+
+namespace ast {
+
+using BuiltinKind = BuiltinType::BuiltinKind;
+using BinaryOp = BinaryExpr::OpKind;
+using UnaryOp = UnaryExpr::OpKind;
+
+namespace {
+
+unsigned getWidth(BuiltinKind kind) {
+    switch (kind) {
+        case BuiltinKind::Bool:
+            return 1;
+        case BuiltinKind::Char:
+        case BuiltinKind::SignedChar:
+        case BuiltinKind::UnsignedChar:
+            return 8;
+        case BuiltinKind::Short:
+        case BuiltinKind::UnsignedShort:
+            return 16;
+        case BuiltinKind::Int:
+        case BuiltinKind::UnsignedInt:
+        case BuiltinKind::Float:
+            return 32;
+        default:
+            return 64;
+    }
+}
+
+bool isUnsignedKind(BuiltinKind kind) {
+    switch (kind) {
+        case BuiltinKind::Bool:
+        case BuiltinKind::UnsignedChar:
+        case BuiltinKind::UnsignedShort:
+        case BuiltinKind::UnsignedInt:
+        case BuiltinKind::UnsignedLong:
+        case BuiltinKind::UnsignedLongLong:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool isFloatingKind(BuiltinKind kind) {
+    return kind == BuiltinKind::Float || kind == BuiltinKind::Double || kind == BuiltinKind::LongDouble;
+}
+
+/** Whether value is representable in a signed type of the given width. */
+bool fitsSigned(int64_t value, unsigned width) {
+    if (width >= 64) {
+        return true;
+    }
+    int64_t limit = int64_t(1) << (width - 1);
+    return value >= -limit && value < limit;
+}
+
+bool isLiteral(const Expr *expr) {
+    return expr && (isa<IntegerLiteral>(expr) || isa<FloatingLiteral>(expr) || isa<CharacterLiteral>(expr));
+}
+
+bool isAssignment(BinaryOp op) {
+    switch (op) {
+        case BinaryOp::Assign:
+        case BinaryOp::AddAssign:
+        case BinaryOp::SubAssign:
+        case BinaryOp::MulAssign:
+        case BinaryOp::DivAssign:
+        case BinaryOp::ModAssign:
+            return true;
+        default:
+            return false;
+    }
+}
+
+} // namespace
+
+Constant Constant::getInteger(BuiltinKind kind, uint64_t bits) {
+    unsigned width = getWidth(kind);
+    if (kind == BuiltinKind::Bool) {
+        bits = bits != 0;
+    } else if (width < 64) {
+        uint64_t mask = (uint64_t(1) << width) - 1;
+        bits &= mask;
+        if (!isUnsignedKind(kind) && (bits >> (width - 1)) != 0) {
+            bits |= ~mask;
+        }
+    }
+    return Constant(kind, bits, 0.0);
+}
+
+Constant Constant::getFloating(BuiltinKind kind, double value) {
+    if (kind == BuiltinKind::Float) {
+        value = static_cast<float>(value);
+    }
+    return Constant(kind, 0, value);
+}
+
+bool Constant::isFloating() const {
+    return isFloatingKind(kind_);
+}
+
+bool Constant::isUnsigned() const {
+    return isUnsignedKind(kind_);
+}
+
+unsigned Constant::getBitWidth() const {
+    return getWidth(kind_);
+}
+
+std::string Constant::toString() const {
+    if (isFloating()) {
+        return std::to_string(floating_);
+    }
+    return isUnsigned() ? std::to_string(bits_) : std::to_string(getSExtValue());
+}
+
+std::optional<Constant> ConstantEvaluator::fail(std::string reason) {
+    failure_ = std::move(reason);
+    return std::nullopt;
+}
+
+std::optional<Constant> ConstantEvaluator::evaluate(const Expr *expr) {
+    if (!expr) {
+        return fail("missing expression");
+    }
+    switch (expr->getKind()) {
+        case NodeKind::IntegerLiteral: {
+            auto *literal = cast<IntegerLiteral>(expr);
+            return Constant::getInteger(literal->builtinKind, static_cast<uint64_t>(literal->value));
+        }
+        case NodeKind::CharacterLiteral:
+            return Constant::getInteger(BuiltinKind::Int, static_cast<uint64_t>(cast<CharacterLiteral>(expr)->value));
+        case NodeKind::FloatingLiteral:
+            return Constant::getFloating(BuiltinKind::Double, cast<FloatingLiteral>(expr)->value);
+        case NodeKind::BinaryExpr:
+            return evaluateBinary(cast<BinaryExpr>(expr));
+        case NodeKind::UnaryExpr:
+            return evaluateUnary(cast<UnaryExpr>(expr));
+        case NodeKind::ConditionalExpr:
+            return evaluateConditional(cast<ConditionalExpr>(expr));
+        default:
+            return fail("'" + expr->toString() + "' is not a constant expression");
+    }
+}
+
+std::optional<int64_t> ConstantEvaluator::evaluateAsInteger(const Expr *expr) {
+    auto value = evaluate(expr);
+    if (!value) {
+        return std::nullopt;
+    }
+    if (value->isFloating()) {
+        fail("integer constant expression has floating type");
+        return std::nullopt;
+    }
+    return value->getSExtValue();
+}
+
+std::optional<Constant> ConstantEvaluator::evaluateAs(const Expr *expr, const Type *type) {
+    auto *builtin = dyn_cast<BuiltinType>(type->getUnqualifiedType());
+    if (!builtin || builtin->isVoid()) {
+        return fail("cannot convert a constant to '" + type->toString() + "'");
+    }
+    auto value = evaluate(expr);
+    if (!value) {
+        return std::nullopt;
+    }
+    return convert(*value, builtin->getBuiltinKind());
+}
+
+std::optional<Constant> ConstantEvaluator::convert(const Constant &value, BuiltinKind to) {
+    if (to == BuiltinKind::Bool) {
+        return Constant::getInteger(to, !value.isZero());
+    }
+    if (isFloatingKind(to)) {
+        if (value.isFloating()) {
+            return Constant::getFloating(to, value.getFloatingValue());
+        }
+        double converted = value.isUnsigned() ? static_cast<double>(value.getZExtValue())
+                                              : static_cast<double>(value.getSExtValue());
+        return Constant::getFloating(to, converted);
+    }
+    if (!value.isFloating()) {
+        return Constant::getInteger(to, value.getZExtValue());
+    }
+
+    // Floating to integer truncates; values out of range are undefined
+    double truncated = std::trunc(value.getFloatingValue());
+    unsigned width = getWidth(to);
+    bool inRange;
+    if (isUnsignedKind(to)) {
+        inRange = truncated >= 0.0 && truncated < std::ldexp(1.0, static_cast<int>(width));
+    } else {
+        double limit = std::ldexp(1.0, static_cast<int>(width) - 1);
+        inRange = truncated >= -limit && truncated < limit;
+    }
+    if (!inRange) {
+        return fail("floating value " + value.toString() + " is out of range of the integer type");
+    }
+    uint64_t bits = isUnsignedKind(to) ? static_cast<uint64_t>(truncated)
+                                       : static_cast<uint64_t>(static_cast<int64_t>(truncated));
+    return Constant::getInteger(to, bits);
+}
+
+Constant ConstantEvaluator::promote(const Constant &value) {
+    BuiltinKind promoted = BuiltinType::getPromotedKind(value.getKind());
+    if (promoted == value.getKind()) {
+        return value;
+    }
+    // Every narrower type fits in int
+    return Constant::getInteger(promoted, value.getZExtValue());
+}
+
+BuiltinKind ConstantEvaluator::getCommonKind(const Constant &left, const Constant &right) {
+    return BuiltinType::getCommonKind(left.getKind(), right.getKind());
+}
+
+std::optional<Constant> ConstantEvaluator::makeInteger(BuiltinKind kind, int64_t value, bool overflowed) {
+    if (!isUnsignedKind(kind) && (overflowed || !fitsSigned(value, getWidth(kind)))) {
+        return fail("integer overflow in constant expression");
+    }
+    return Constant::getInteger(kind, static_cast<uint64_t>(value));
+}
+
+std::optional<Constant> ConstantEvaluator::evaluateBinary(const BinaryExpr *expr) {
+    if (isAssignment(expr->op)) {
+        return fail("assignment is not a constant expression");
+    }
+
+    auto left = evaluate(expr->left);
+    if (!left) {
+        return std::nullopt;
+    }
+
+    // The right operand of && and || is not evaluated, and so need not be
+    // constant, when the left one decides the result
+    if (expr->op == BinaryOp::LogicalAnd || expr->op == BinaryOp::LogicalOr) {
+        bool decided = expr->op == BinaryOp::LogicalAnd ? left->isZero() : !left->isZero();
+        if (decided) {
+            return Constant::getInteger(BuiltinKind::Int, expr->op == BinaryOp::LogicalOr);
+        }
+        auto right = evaluate(expr->right);
+        if (!right) {
+            return std::nullopt;
+        }
+        return Constant::getInteger(BuiltinKind::Int, !right->isZero());
+    }
+
+    auto right = evaluate(expr->right);
+    if (!right) {
+        return std::nullopt;
+    }
+    if (expr->op == BinaryOp::LeftShift || expr->op == BinaryOp::RightShift) {
+        return evaluateShift(expr->op, promote(*left), promote(*right));
+    }
+
+    BuiltinKind common = getCommonKind(promote(*left), promote(*right));
+    auto l = convert(*left, common);
+    auto r = convert(*right, common);
+    if (!l || !r) {
+        return std::nullopt;
+    }
+    return evaluateArithmetic(expr->op, *l, *r);
+}
+
+std::optional<Constant> ConstantEvaluator::evaluateArithmetic(BinaryOp op, const Constant &left,
+                                                              const Constant &right) {
+    BuiltinKind kind = left.getKind();
+
+    if (left.isFloating()) {
+        double a = left.getFloatingValue();
+        double b = right.getFloatingValue();
+        switch (op) {
+            case BinaryOp::Add: return Constant::getFloating(kind, a + b);
+            case BinaryOp::Sub: return Constant::getFloating(kind, a - b);
+            case BinaryOp::Mul: return Constant::getFloating(kind, a * b);
+            case BinaryOp::Div: return Constant::getFloating(kind, a / b);
+            case BinaryOp::LT: return Constant::getInteger(BuiltinKind::Int, a < b);
+            case BinaryOp::GT: return Constant::getInteger(BuiltinKind::Int, a > b);
+            case BinaryOp::LE: return Constant::getInteger(BuiltinKind::Int, a <= b);
+            case BinaryOp::GE: return Constant::getInteger(BuiltinKind::Int, a >= b);
+            case BinaryOp::EQ: return Constant::getInteger(BuiltinKind::Int, a == b);
+            case BinaryOp::NE: return Constant::getInteger(BuiltinKind::Int, a != b);
+            default: return fail("invalid operands of floating type");
+        }
+    }
+
+    uint64_t a = left.getZExtValue();
+    uint64_t b = right.getZExtValue();
+    int64_t sa = left.getSExtValue();
+    int64_t sb = right.getSExtValue();
+    bool isUnsigned = left.isUnsigned();
+    int64_t result = 0;
+    bool overflowed;
+    switch (op) {
+        case BinaryOp::Add:
+            if (isUnsigned) return Constant::getInteger(kind, a + b);
+            overflowed = __builtin_add_overflow(sa, sb, &result);
+            return makeInteger(kind, result, overflowed);
+        case BinaryOp::Sub:
+            if (isUnsigned) return Constant::getInteger(kind, a - b);
+            overflowed = __builtin_sub_overflow(sa, sb, &result);
+            return makeInteger(kind, result, overflowed);
+        case BinaryOp::Mul:
+            if (isUnsigned) return Constant::getInteger(kind, a * b);
+            overflowed = __builtin_mul_overflow(sa, sb, &result);
+            return makeInteger(kind, result, overflowed);
+        case BinaryOp::Div:
+        case BinaryOp::Mod:
+            if (b == 0) {
+                return fail("division by zero in constant expression");
+            }
+            if (isUnsigned) {
+                return Constant::getInteger(kind, op == BinaryOp::Div ? a / b : a % b);
+            }
+            // The remainder is undefined too when the quotient overflows
+            if (sb == -1 && sa == std::numeric_limits<int64_t>::min()) {
+                return makeInteger(kind, 0, true);
+            }
+            if (!makeInteger(kind, sa / sb, false)) {
+                return std::nullopt;
+            }
+            return Constant::getInteger(kind, static_cast<uint64_t>(op == BinaryOp::Div ? sa / sb : sa % sb));
+        case BinaryOp::BitwiseAnd: return Constant::getInteger(kind, a & b);
+        case BinaryOp::BitwiseOr: return Constant::getInteger(kind, a | b);
+        case BinaryOp::BitwiseXor: return Constant::getInteger(kind, a ^ b);
+        case BinaryOp::LT: return Constant::getInteger(BuiltinKind::Int, isUnsigned ? a < b : sa < sb);
+        case BinaryOp::GT: return Constant::getInteger(BuiltinKind::Int, isUnsigned ? a > b : sa > sb);
+        case BinaryOp::LE: return Constant::getInteger(BuiltinKind::Int, isUnsigned ? a <= b : sa <= sb);
+        case BinaryOp::GE: return Constant::getInteger(BuiltinKind::Int, isUnsigned ? a >= b : sa >= sb);
+        case BinaryOp::EQ: return Constant::getInteger(BuiltinKind::Int, a == b);
+        case BinaryOp::NE: return Constant::getInteger(BuiltinKind::Int, a != b);
+        default: return fail("operator is not allowed in a constant expression");
+    }
+}
+
+std::optional<Constant> ConstantEvaluator::evaluateShift(BinaryOp op, const Constant &left, const Constant &right) {
+    if (left.isFloating() || right.isFloating()) {
+        return fail("invalid operands of floating type");
+    }
+    // The result has the promoted type of the left operand
+    BuiltinKind kind = left.getKind();
+    unsigned width = left.getBitWidth();
+    if ((!right.isUnsigned() && right.getSExtValue() < 0) || right.getZExtValue() >= width) {
+        return fail("shift count " + right.toString() + " is out of range");
+    }
+    auto count = static_cast<unsigned>(right.getZExtValue());
+
+    if (op == BinaryOp::RightShift) {
+        // Negative values shift arithmetically, as the code generator does
+        return left.isUnsigned() ? Constant::getInteger(kind, left.getZExtValue() >> count)
+                                 : Constant::getInteger(kind, static_cast<uint64_t>(left.getSExtValue() >> count));
+    }
+    if (left.isUnsigned()) {
+        return Constant::getInteger(kind, left.getZExtValue() << count);
+    }
+    if (left.getSExtValue() < 0) {
+        return fail("left shift of negative value " + left.toString());
+    }
+    if (count > 0 && (left.getSExtValue() >> (width - 1 - count)) != 0) {
+        return makeInteger(kind, 0, true);
+    }
+    return Constant::getInteger(kind, left.getZExtValue() << count);
+}
+
+std::optional<Constant> ConstantEvaluator::evaluateUnary(const UnaryExpr *expr) {
+    if (expr->op == UnaryOp::Sizeof) {
+        // Before type checking only constant operands have a known type
+        if (expr->operand->type) {
+            return Constant::getInteger(BuiltinKind::UnsignedLong, expr->operand->type->getSize());
+        }
+        auto operand = evaluate(expr->operand);
+        if (!operand) {
+            return std::nullopt;
+        }
+        return Constant::getInteger(BuiltinKind::UnsignedLong, BuiltinType::getKindSize(operand->getKind()));
+    }
+    switch (expr->op) {
+        case UnaryOp::Plus:
+        case UnaryOp::Minus:
+        case UnaryOp::Not:
+        case UnaryOp::BitwiseNot:
+            break;
+        default:
+            return fail("'" + expr->toString() + "' is not a constant expression");
+    }
+
+    auto operand = evaluate(expr->operand);
+    if (!operand) {
+        return std::nullopt;
+    }
+    if (expr->op == UnaryOp::Not) {
+        return Constant::getInteger(BuiltinKind::Int, operand->isZero());
+    }
+
+    Constant value = promote(*operand);
+    BuiltinKind kind = value.getKind();
+    if (expr->op == UnaryOp::Plus) {
+        return value;
+    }
+    if (expr->op == UnaryOp::BitwiseNot) {
+        if (value.isFloating()) {
+            return fail("invalid operand of floating type");
+        }
+        return Constant::getInteger(kind, ~value.getZExtValue());
+    }
+
+    if (value.isFloating()) {
+        return Constant::getFloating(kind, -value.getFloatingValue());
+    }
+    if (value.isUnsigned()) {
+        return Constant::getInteger(kind, 0 - value.getZExtValue());
+    }
+    int64_t result = 0;
+    bool overflowed = __builtin_sub_overflow(int64_t(0), value.getSExtValue(), &result);
+    return makeInteger(kind, result, overflowed);
+}
+
+std::optional<Constant> ConstantEvaluator::evaluateConditional(const ConditionalExpr *expr) {
+    auto condition = evaluate(expr->condition);
+    if (!condition) {
+        return std::nullopt;
+    }
+    const Expr *chosen = condition->isZero() ? expr->falseExpr : expr->trueExpr;
+    const Expr *other = condition->isZero() ? expr->trueExpr : expr->falseExpr;
+    auto value = evaluate(chosen);
+    if (!value) {
+        return std::nullopt;
+    }
+
+    // The arm not taken is not evaluated, but still takes part in the
+    // result type when its own type is known
+    std::string reason = failure_;
+    auto otherValue = evaluate(other);
+    failure_ = reason;
+    if (!otherValue) {
+        return promote(*value);
+    }
+    return convert(*value, getCommonKind(promote(*value), promote(*otherValue)));
+}
+
+Expr *ConstantEvaluator::fold(Expr *expr, ASTContext &context) {
+    bool operandsConstant = false;
+    if (auto *binary = dyn_cast<BinaryExpr>(expr)) {
+        operandsConstant = !isAssignment(binary->op) && isLiteral(binary->left) && isLiteral(binary->right);
+    } else if (auto *unary = dyn_cast<UnaryExpr>(expr)) {
+        operandsConstant = isLiteral(unary->operand);
+    } else if (auto *conditional = dyn_cast<ConditionalExpr>(expr)) {
+        operandsConstant = isLiteral(conditional->condition) && isLiteral(conditional->trueExpr) &&
+                           isLiteral(conditional->falseExpr);
+    }
+    if (!operandsConstant) {
+        return expr;
+    }
+
+    auto value = evaluate(expr);
+    if (!value) {
+        return expr;
+    }
+
+    // Only values a literal reproduces exactly, type included, are folded:
+    // an integer literal carries any type from int up, a floating literal
+    // is always a double
+    Expr *literal = nullptr;
+    if (value->getKind() == BuiltinKind::Double) {
+        literal = context.create<FloatingLiteral>(value->getFloatingValue());
+    } else if (value->getKind() >= BuiltinKind::Int && value->getKind() <= BuiltinKind::UnsignedLongLong) {
+        literal = context.create<IntegerLiteral>(value->getSExtValue(), value->getKind());
+    }
+    if (!literal) {
+        return expr;
+    }
+    literal->loc = expr->loc;
+    return literal;
+}
+
+} // namespace ast
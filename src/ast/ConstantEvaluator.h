@@ -0,0 +1,119 @@
+#pragma once
+
+#include "ast/ASTContext.h"
+#include "ast/Expr.h"
+#include "ast/Type.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace ast {
+
+/**
+ * The value of an arithmetic constant expression together with its C type.
+ *
+ * Integers are kept as 64-bit patterns normalized to the width of their
+ * type: sign-extended for signed types, zero-extended for unsigned ones.
+ * Floating values are held as double; long double is evaluated at double
+ * precision.
+ */
+class Constant {
+public:
+    using BuiltinKind = BuiltinType::BuiltinKind;
+
+    /** An integer of the given type, truncated to its width. */
+    static Constant getInteger(BuiltinKind kind, uint64_t bits);
+    static Constant getFloating(BuiltinKind kind, double value);
+
+    BuiltinKind getKind() const { return kind_; }
+    bool isFloating() const;
+    bool isInteger() const { return !isFloating(); }
+    bool isUnsigned() const;
+
+    /** Width of the type in bits; 1 for _Bool. */
+    unsigned getBitWidth() const;
+
+    int64_t getSExtValue() const { return static_cast<int64_t>(bits_); }
+    uint64_t getZExtValue() const { return bits_; }
+    double getFloatingValue() const { return floating_; }
+    bool isZero() const { return isFloating() ? floating_ == 0.0 : bits_ == 0; }
+
+    std::string toString() const;
+
+private:
+    Constant(BuiltinKind kind, uint64_t bits, double floating) : kind_(kind), bits_(bits), floating_(floating) {}
+
+    BuiltinKind kind_;
+    uint64_t bits_;
+    double floating_;
+};
+
+/**
+ * Evaluates arithmetic constant expressions (C11 6.6) over the AST.
+ *
+ * Literals carry no suffix in the AST, so an integer literal is an int if
+ * it fits and a long otherwise, and a character literal is an int. Operands
+ * undergo the usual arithmetic conversions. Unsigned arithmetic wraps;
+ * signed overflow, division by zero and out-of-range shifts make an
+ * expression non-constant, and getFailureReason() says why.
+ */
+class ConstantEvaluator {
+public:
+    /**
+     * Evaluate an arithmetic constant expression.
+     * @return The value, or nullopt if expr is not a constant expression
+     */
+    std::optional<Constant> evaluate(const Expr *expr);
+
+    /**
+     * Evaluate an integer constant expression, as required for array
+     * lengths, case labels and _Static_assert.
+     */
+    std::optional<int64_t> evaluateAsInteger(const Expr *expr);
+
+    /**
+     * Evaluate expr and convert it as if assigned to an object of type,
+     * which must be arithmetic.
+     */
+    std::optional<Constant> evaluateAs(const Expr *expr, const Type *type);
+
+    /**
+     * Convert a constant to another arithmetic type.
+     * @return nullopt if a floating value does not fit the integer type
+     */
+    std::optional<Constant> convert(const Constant &value, Constant::BuiltinKind to);
+
+    /** Why the last evaluation failed. */
+    const std::string &getFailureReason() const { return failure_; }
+
+    /**
+     * Replace an operator whose operands are all literals by the literal
+     * of its value. Applied as the AST is built bottom-up, this folds every
+     * constant subtree at constant cost per node.
+     * @return The literal, or expr itself if it cannot be folded into one
+     */
+    Expr *fold(Expr *expr, ASTContext &context);
+
+private:
+    std::string failure_;
+
+    std::optional<Constant> fail(std::string reason);
+
+    std::optional<Constant> evaluateBinary(const BinaryExpr *expr);
+    std::optional<Constant> evaluateUnary(const UnaryExpr *expr);
+    std::optional<Constant> evaluateConditional(const ConditionalExpr *expr);
+    std::optional<Constant> evaluateArithmetic(BinaryExpr::OpKind op, const Constant &left, const Constant &right);
+    std::optional<Constant> evaluateShift(BinaryExpr::OpKind op, const Constant &left, const Constant &right);
+
+    /** Integer promotion: types narrower than int become int. */
+    static Constant promote(const Constant &value);
+
+    /** The common type of the usual arithmetic conversions. */
+    static Constant::BuiltinKind getCommonKind(const Constant &left, const Constant &right);
+
+    /** Wrap bits into kind, or fail if a signed result does not fit. */
+    std::optional<Constant> makeInteger(Constant::BuiltinKind kind, int64_t value, bool overflowed);
+};
+
+} // namespace ast
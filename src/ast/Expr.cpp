@@ -57,6 +57,7 @@ std::string UnaryExpr::opToString() const {
         case OpKind::PostDecrement: return "--";
         case OpKind::AddressOf: return "&";
         case OpKind::Dereference: return "*";
+        case OpKind::Sizeof: return "sizeof ";
         default: return "?";
     }
 }
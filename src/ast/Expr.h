@@ -1,27 +1,58 @@
 #pragma once
 
 #include "ast/Node.h"
-#include <memory>
+#include "ast/IdentifierTable.h"
+#include "ast/Type.h"
+#include <span>
+#include <string_view>
 
 namespace ast {
 
+/**
+ * Whether an expression designates an object (C11 6.3.2.1).
+ */
+enum class ValueCategory : uint8_t {
+    RValue,
+    LValue
+};
+
 /**
  * Base class for all expressions.
  */
 struct Expr : public Node {
-    virtual ~Expr() = default;
+    // Resolved by semantic analysis; null until the expression is checked.
+    // Arrays and functions keep their own type here and decay where used.
+    const Type *type = nullptr;
+    ValueCategory valueCategory = ValueCategory::RValue;
+    
+    bool isLValue() const { return valueCategory == ValueCategory::LValue; }
+    
+    static bool classof(const Node *node) {
+        return node->getKind() >= NodeKind::FirstExpr && node->getKind() <= NodeKind::LastExpr;
+    }
+    
+protected:
+    explicit Expr(NodeKind kind) : Node(kind) {}
 };
 
 /**
  * Integer literal expression.
  */
 struct IntegerLiteral : public Expr {
-    long long value;
+    long long value;  // the bits of the value, which may be unsigned
+    // The type from the suffix and radix (C11 6.4.4.1p5)
+    BuiltinType::BuiltinKind builtinKind;
+    
+    explicit IntegerLiteral(long long val, BuiltinType::BuiltinKind kind = BuiltinType::BuiltinKind::Int)
+        : Expr(NodeKind::IntegerLiteral), value(val), builtinKind(kind) {}
     
-    explicit IntegerLiteral(long long val) : value(val) {}
+    static bool classof(const Node *node) { return node->getKind() == NodeKind::IntegerLiteral; }
     
     std::string toString() const override {
-        return std::to_string(value);
+        bool isUnsigned = builtinKind == BuiltinType::BuiltinKind::UnsignedInt ||
+                          builtinKind == BuiltinType::BuiltinKind::UnsignedLong ||
+                          builtinKind == BuiltinType::BuiltinKind::UnsignedLongLong;
+        return isUnsigned ? std::to_string(static_cast<unsigned long long>(value)) : std::to_string(value);
     }
 };
 
@@ -31,7 +62,9 @@ struct IntegerLiteral : public Expr {
 struct FloatingLiteral : public Expr {
     double value;
     
-    explicit FloatingLiteral(double val) : value(val) {}
+    explicit FloatingLiteral(double val) : Expr(NodeKind::FloatingLiteral), value(val) {}
+    
+    static bool classof(const Node *node) { return node->getKind() == NodeKind::FloatingLiteral; }
     
     std::string toString() const override {
         return std::to_string(value);
@@ -44,7 +77,9 @@ struct FloatingLiteral : public Expr {
 struct CharacterLiteral : public Expr {
     char value;
     
-    explicit CharacterLiteral(char val) : value(val) {}
+    explicit CharacterLiteral(char val) : Expr(NodeKind::CharacterLiteral), value(val) {}
+    
+    static bool classof(const Node *node) { return node->getKind() == NodeKind::CharacterLiteral; }
     
     std::string toString() const override {
         return "'" + std::string(1, value) + "'";
@@ -55,12 +90,14 @@ struct CharacterLiteral : public Expr {
  * String literal expression.
  */
 struct StringLiteral : public Expr {
-    std::string value;
+    std::string_view value;
     
-    explicit StringLiteral(std::string val) : value(std::move(val)) {}
+    explicit StringLiteral(std::string_view val) : Expr(NodeKind::StringLiteral), value(val) {}
+    
+    static bool classof(const Node *node) { return node->getKind() == NodeKind::StringLiteral; }
     
     std::string toString() const override {
-        return "\"" + value + "\"";
+        return "\"" + std::string(value) + "\"";
     }
 };
 
@@ -68,12 +105,30 @@ struct StringLiteral : public Expr {
  * Identifier expression.
  */
 struct Identifier : public Expr {
-    std::string name;
+    /**
+     * What a name refers to, resolved by semantic analysis.
+     */
+    enum class BindingKind : uint8_t {
+        Unbound,
+        Local,     // variable or parameter of the enclosing function
+        Global,    // variable at file scope
+        Function
+    };
+    
+    const IdentifierInfo *name;
     
-    explicit Identifier(std::string n) : name(std::move(n)) {}
+    // Slot of the declaration the name refers to: local slots are numbered
+    // per function, parameters first, and global ones per translation unit.
+    // See VarDecl::index and FunctionDecl::index.
+    BindingKind binding = BindingKind::Unbound;
+    unsigned index = 0;
+    
+    explicit Identifier(const IdentifierInfo *n) : Expr(NodeKind::Identifier), name(n) {}
+    
+    static bool classof(const Node *node) { return node->getKind() == NodeKind::Identifier; }
     
     std::string toString() const override {
-        return name;
+        return std::string(name->getName());
     }
 };
 
@@ -87,15 +142,24 @@ struct BinaryExpr : public Expr {
         LogicalAnd, LogicalOr,
         BitwiseAnd, BitwiseOr, BitwiseXor,
         LeftShift, RightShift,
-        Assign, AddAssign, SubAssign, MulAssign, DivAssign, ModAssign
+        Assign, AddAssign, SubAssign, MulAssign, DivAssign, ModAssign,
+        LastKind = ModAssign
     };
     
-    std::unique_ptr<Expr> left;
-    std::unique_ptr<Expr> right;
+    Expr *left;
+    Expr *right;
     OpKind op;
     
-    BinaryExpr(std::unique_ptr<Expr> l, std::unique_ptr<Expr> r, OpKind operation)
-        : left(std::move(l)), right(std::move(r)), op(operation) {}
+    // Arithmetic type both operands are converted to before the operation,
+    // set by semantic analysis. It differs from the result type for
+    // comparisons and compound assignments, and is null when an operand is
+    // a pointer or the operator is logical or a plain assignment.
+    const Type *operandType = nullptr;
+    
+    BinaryExpr(Expr *l, Expr *r, OpKind operation)
+        : Expr(NodeKind::BinaryExpr), left(l), right(r), op(operation) {}
+    
+    static bool classof(const Node *node) { return node->getKind() == NodeKind::BinaryExpr; }
     
     std::string toString() const override;
     
@@ -111,15 +175,19 @@ struct UnaryExpr : public Expr {
         Plus, Minus, Not, BitwiseNot,
         PreIncrement, PostIncrement,
         PreDecrement, PostDecrement,
-        AddressOf, Dereference
+        AddressOf, Dereference,
+        Sizeof,  // of an expression, which is not evaluated
+        LastKind = Sizeof
     };
     
-    std::unique_ptr<Expr> operand;
+    Expr *operand;
     OpKind op;
     bool isPrefix;
     
-    UnaryExpr(std::unique_ptr<Expr> operand, OpKind operation, bool prefix = true)
-        : operand(std::move(operand)), op(operation), isPrefix(prefix) {}
+    UnaryExpr(Expr *operand, OpKind operation, bool prefix = true)
+        : Expr(NodeKind::UnaryExpr), operand(operand), op(operation), isPrefix(prefix) {}
+    
+    static bool classof(const Node *node) { return node->getKind() == NodeKind::UnaryExpr; }
     
     std::string toString() const override;
     
@@ -131,11 +199,13 @@ private:
  * Function call expression.
  */
 struct CallExpr : public Expr {
-    std::unique_ptr<Expr> function;
-    std::vector<std::unique_ptr<Expr>> arguments;
+    Expr *function;
+    std::span<Expr*> arguments;
+    
+    CallExpr(Expr *func, std::span<Expr*> args)
+        : Expr(NodeKind::CallExpr), function(func), arguments(args) {}
     
-    CallExpr(std::unique_ptr<Expr> func, std::vector<std::unique_ptr<Expr>> args)
-        : function(std::move(func)), arguments(std::move(args)) {}
+    static bool classof(const Node *node) { return node->getKind() == NodeKind::CallExpr; }
     
     std::string toString() const override;
 };
@@ -144,11 +214,13 @@ struct CallExpr : public Expr {
  * Array subscript expression (e.g., arr[index]).
  */
 struct ArraySubscriptExpr : public Expr {
-    std::unique_ptr<Expr> array;
-    std::unique_ptr<Expr> index;
+    Expr *array;
+    Expr *index;
     
-    ArraySubscriptExpr(std::unique_ptr<Expr> arr, std::unique_ptr<Expr> idx)
-        : array(std::move(arr)), index(std::move(idx)) {}
+    ArraySubscriptExpr(Expr *arr, Expr *idx)
+        : Expr(NodeKind::ArraySubscriptExpr), array(arr), index(idx) {}
+    
+    static bool classof(const Node *node) { return node->getKind() == NodeKind::ArraySubscriptExpr; }
     
     std::string toString() const override {
         return array->toString() + "[" + index->toString() + "]";
@@ -159,15 +231,17 @@ struct ArraySubscriptExpr : public Expr {
  * Member access expression (e.g., obj.member).
  */
 struct MemberExpr : public Expr {
-    std::unique_ptr<Expr> object;
-    std::string member;
+    Expr *object;
+    const IdentifierInfo *member;
     bool isArrow; // true for ->, false for .
     
-    MemberExpr(std::unique_ptr<Expr> obj, std::string mem, bool arrow = false)
-        : object(std::move(obj)), member(std::move(mem)), isArrow(arrow) {}
+    MemberExpr(Expr *obj, const IdentifierInfo *mem, bool arrow = false)
+        : Expr(NodeKind::MemberExpr), object(obj), member(mem), isArrow(arrow) {}
+    
+    static bool classof(const Node *node) { return node->getKind() == NodeKind::MemberExpr; }
     
     std::string toString() const override {
-        return object->toString() + (isArrow ? "->" : ".") + member;
+        return object->toString() + (isArrow ? "->" : ".") + std::string(member->getName());
     }
 };
 
@@ -175,12 +249,14 @@ struct MemberExpr : public Expr {
  * Ternary conditional expression (e.g., condition ? true_expr : false_expr).
  */
 struct ConditionalExpr : public Expr {
-    std::unique_ptr<Expr> condition;
-    std::unique_ptr<Expr> trueExpr;
-    std::unique_ptr<Expr> falseExpr;
+    Expr *condition;
+    Expr *trueExpr;
+    Expr *falseExpr;
+    
+    ConditionalExpr(Expr *cond, Expr *trueE, Expr *falseE)
+        : Expr(NodeKind::ConditionalExpr), condition(cond), trueExpr(trueE), falseExpr(falseE) {}
     
-    ConditionalExpr(std::unique_ptr<Expr> cond, std::unique_ptr<Expr> trueE, std::unique_ptr<Expr> falseE)
-        : condition(std::move(cond)), trueExpr(std::move(trueE)), falseExpr(std::move(falseE)) {}
+    static bool classof(const Node *node) { return node->getKind() == NodeKind::ConditionalExpr; }
     
     std::string toString() const override {
         return condition->toString() + " ? " + trueExpr->toString() + " : " + falseExpr->toString();
@@ -0,0 +1,302 @@
+#include "ast/FlatAST.h"
+#include "ast/ASTVisitor.h"
+
+#include <stdexcept>
+
+namespace ast {
+
+/**
+ * Appends a pointer AST to a FlatAST in post-order.
+ */
+class FlatASTBuilder : public ASTVisitor<FlatASTBuilder, FlatAST::NodeIndex> {
+    friend class ASTVisitor<FlatASTBuilder, FlatAST::NodeIndex>;
+
+public:
+    explicit FlatASTBuilder(FlatAST &flat) : flat_(flat) {}
+
+private:
+    using NodeIndex = FlatAST::NodeIndex;
+
+    FlatAST &flat_;
+
+    /** Append a node whose payload goes to `payloads`; children must be added already. */
+    template <typename T>
+    NodeIndex add(const Node *node, std::vector<T> &payloads, T payload) {
+        NodeIndex index = addNode(node, payloads.size());
+        payloads.push_back(std::move(payload));
+        return index;
+    }
+
+    NodeIndex addNode(const Node *node, size_t slot) {
+        if (flat_.kinds_.size() >= FlatAST::NoNode) {
+            throw std::length_error("AST too large to flatten");
+        }
+        flat_.kinds_.push_back(node->getKind());
+        flat_.locations_.push_back(node->loc);
+        flat_.slots_.push_back(static_cast<uint32_t>(slot));
+        return static_cast<NodeIndex>(flat_.kinds_.size() - 1);
+    }
+
+    template <typename T>
+    FlatAST::Range addChildren(std::span<T*> nodes) {
+        // Children may add child lists of their own, so collect first
+        std::vector<NodeIndex> indices;
+        indices.reserve(nodes.size());
+        for (auto *node : nodes) {
+            indices.push_back(visit(node));
+        }
+        FlatAST::Range range{static_cast<uint32_t>(flat_.children_.size()), static_cast<uint32_t>(indices.size())};
+        flat_.children_.insert(flat_.children_.end(), indices.begin(), indices.end());
+        return range;
+    }
+
+    NodeIndex visitIntegerLiteral(IntegerLiteral *node) {
+        return add(node, flat_.integers_, FlatAST::Integer{node->value, node->builtinKind});
+    }
+    NodeIndex visitFloatingLiteral(FloatingLiteral *node) { return add(node, flat_.floats_, node->value); }
+    NodeIndex visitCharacterLiteral(CharacterLiteral *node) { return add(node, flat_.characters_, node->value); }
+
+    NodeIndex visitStringLiteral(StringLiteral *node) {
+        FlatAST::Range range{static_cast<uint32_t>(flat_.stringData_.size()), static_cast<uint32_t>(node->value.size())};
+        flat_.stringData_.append(node->value);
+        return add(node, flat_.strings_, range);
+    }
+
+    NodeIndex visitIdentifier(Identifier *node) {
+        return add<const IdentifierInfo*>(node, flat_.identifiers_, node->name);
+    }
+
+    NodeIndex visitBinaryExpr(BinaryExpr *node) {
+        return add(node, flat_.binaries_, FlatAST::Binary{visit(node->left), visit(node->right), node->op});
+    }
+
+    NodeIndex visitUnaryExpr(UnaryExpr *node) {
+        return add(node, flat_.unaries_, FlatAST::Unary{visit(node->operand), node->op, node->isPrefix});
+    }
+
+    NodeIndex visitCallExpr(CallExpr *node) {
+        return add(node, flat_.calls_, FlatAST::Call{visit(node->function), addChildren(node->arguments)});
+    }
+
+    NodeIndex visitArraySubscriptExpr(ArraySubscriptExpr *node) {
+        return add(node, flat_.subscripts_, FlatAST::Subscript{visit(node->array), visit(node->index)});
+    }
+
+    NodeIndex visitMemberExpr(MemberExpr *node) {
+        return add(node, flat_.members_, FlatAST::Member{visit(node->object), node->member, node->isArrow});
+    }
+
+    NodeIndex visitConditionalExpr(ConditionalExpr *node) {
+        return add(node, flat_.conditionals_,
+                   FlatAST::Conditional{visit(node->condition), visit(node->trueExpr), visit(node->falseExpr)});
+    }
+
+    NodeIndex visitExprStmt(ExprStmt *node) { return add(node, flat_.exprStmts_, visit(node->expression)); }
+    NodeIndex visitReturnStmt(ReturnStmt *node) { return add(node, flat_.returns_, visit(node->expression)); }
+
+    NodeIndex visitIfStmt(IfStmt *node) {
+        return add(node, flat_.ifs_, FlatAST::If{visit(node->condition), visit(node->thenStmt), visit(node->elseStmt)});
+    }
+
+    NodeIndex visitWhileStmt(WhileStmt *node) {
+        return add(node, flat_.whiles_, FlatAST::While{visit(node->condition), visit(node->body), node->hints});
+    }
+
+    NodeIndex visitForStmt(ForStmt *node) {
+        return add(node, flat_.fors_, FlatAST::For{visit(node->init), visit(node->condition),
+                                                   visit(node->increment), visit(node->body), node->hints});
+    }
+
+    NodeIndex visitBreakStmt(BreakStmt *node) { return addNode(node, 0); }
+    NodeIndex visitContinueStmt(ContinueStmt *node) { return addNode(node, 0); }
+
+    NodeIndex visitCompoundStmt(CompoundStmt *node) {
+        return add(node, flat_.compounds_, addChildren(node->statements));
+    }
+
+    NodeIndex visitVarDecl(VarDecl *node) {
+        return add(node, flat_.vars_, FlatAST::Var{node->name, node->type, visit(node->initializer)});
+    }
+
+    NodeIndex visitFunctionDecl(FunctionDecl *node) {
+        FlatAST::Range parameters{static_cast<uint32_t>(flat_.parameters_.size()),
+                                  static_cast<uint32_t>(node->parameters.size())};
+        flat_.parameters_.insert(flat_.parameters_.end(), node->parameters.begin(), node->parameters.end());
+        return add(node, flat_.functions_,
+                   FlatAST::Function{node->name, node->returnType, parameters, visit(node->body),
+                                     node->hasPrototype});
+    }
+
+    NodeIndex visitTranslationUnit(TranslationUnit *node) {
+        return add(node, flat_.units_, addChildren(node->declarations));
+    }
+
+    // Every kind is handled above, so only null children get here
+    NodeIndex visitNode(Node *) { return FlatAST::NoNode; }
+};
+
+FlatAST FlatAST::flatten(Node *root) {
+    FlatAST flat;
+    FlatASTBuilder(flat).visit(root);
+    return flat;
+}
+
+namespace {
+
+template <typename T>
+T *getNode(const std::vector<Node*> &nodes, FlatAST::NodeIndex index) {
+    return index == FlatAST::NoNode ? nullptr : static_cast<T*>(nodes[index]);
+}
+
+template <typename T>
+std::span<T*> copyChildren(ASTContext &context, const std::vector<Node*> &nodes,
+                           std::span<const FlatAST::NodeIndex> children) {
+    std::vector<T*> list;
+    list.reserve(children.size());
+    for (auto child : children) {
+        list.push_back(getNode<T>(nodes, child));
+    }
+    return context.copyArray(list);
+}
+
+} // namespace
+
+std::string_view FlatAST::getStringValue(NodeIndex node) const {
+    const Range &range = strings_[slots_[node]];
+    return std::string_view(stringData_).substr(range.begin, range.size);
+}
+
+Node *FlatAST::unflatten(ASTContext &context) const {
+    // Post-order: every child is built before the node referring to it
+    std::vector<Node*> nodes(size());
+    for (NodeIndex i = 0; i < size(); ++i) {
+        Node *node = nullptr;
+        switch (kinds_[i]) {
+            case NodeKind::IntegerLiteral:
+                node = context.create<IntegerLiteral>(getIntegerValue(i), getIntegerKind(i));
+                break;
+            case NodeKind::FloatingLiteral:
+                node = context.create<FloatingLiteral>(getFloatingValue(i));
+                break;
+            case NodeKind::CharacterLiteral:
+                node = context.create<CharacterLiteral>(getCharacterValue(i));
+                break;
+            case NodeKind::StringLiteral:
+                node = context.create<StringLiteral>(context.copyString(getStringValue(i)));
+                break;
+            case NodeKind::Identifier:
+                node = context.create<Identifier>(getIdentifier(i));
+                break;
+            case NodeKind::BinaryExpr: {
+                const Binary &binary = getBinary(i);
+                node = context.create<BinaryExpr>(getNode<Expr>(nodes, binary.left),
+                                                  getNode<Expr>(nodes, binary.right), binary.op);
+                break;
+            }
+            case NodeKind::UnaryExpr: {
+                const Unary &unary = getUnary(i);
+                node = context.create<UnaryExpr>(getNode<Expr>(nodes, unary.operand), unary.op, unary.isPrefix);
+                break;
+            }
+            case NodeKind::CallExpr: {
+                const Call &call = getCall(i);
+                node = context.create<CallExpr>(getNode<Expr>(nodes, call.callee),
+                                                copyChildren<Expr>(context, nodes, getChildren(call.arguments)));
+                break;
+            }
+            case NodeKind::ArraySubscriptExpr: {
+                const Subscript &subscript = getSubscript(i);
+                node = context.create<ArraySubscriptExpr>(getNode<Expr>(nodes, subscript.array),
+                                                          getNode<Expr>(nodes, subscript.index));
+                break;
+            }
+            case NodeKind::MemberExpr: {
+                const Member &member = getMember(i);
+                node = context.create<MemberExpr>(getNode<Expr>(nodes, member.object), member.member, member.isArrow);
+                break;
+            }
+            case NodeKind::ConditionalExpr: {
+                const Conditional &conditional = getConditional(i);
+                node = context.create<ConditionalExpr>(getNode<Expr>(nodes, conditional.condition),
+                                                       getNode<Expr>(nodes, conditional.trueExpr),
+                                                       getNode<Expr>(nodes, conditional.falseExpr));
+                break;
+            }
+            case NodeKind::ExprStmt:
+                node = context.create<ExprStmt>(getNode<Expr>(nodes, getExprStmtExpression(i)));
+                break;
+            case NodeKind::ReturnStmt:
+                node = context.create<ReturnStmt>(getNode<Expr>(nodes, getReturnValue(i)));
+                break;
+            case NodeKind::IfStmt: {
+                const If &ifStmt = getIf(i);
+                node = context.create<IfStmt>(getNode<Expr>(nodes, ifStmt.condition),
+                                              getNode<Stmt>(nodes, ifStmt.thenStmt),
+                                              getNode<Stmt>(nodes, ifStmt.elseStmt));
+                break;
+            }
+            case NodeKind::WhileStmt: {
+                const While &whileStmt = getWhile(i);
+                auto *loop = context.create<WhileStmt>(getNode<Expr>(nodes, whileStmt.condition),
+                                                       getNode<Stmt>(nodes, whileStmt.body));
+                loop->hints = whileStmt.hints;
+                node = loop;
+                break;
+            }
+            case NodeKind::ForStmt: {
+                const For &forStmt = getFor(i);
+                auto *loop = context.create<ForStmt>(getNode<Stmt>(nodes, forStmt.init),
+                                                     getNode<Expr>(nodes, forStmt.condition),
+                                                     getNode<Expr>(nodes, forStmt.increment),
+                                                     getNode<Stmt>(nodes, forStmt.body));
+                loop->hints = forStmt.hints;
+                node = loop;
+                break;
+            }
+            case NodeKind::BreakStmt:
+                node = context.create<BreakStmt>();
+                break;
+            case NodeKind::ContinueStmt:
+                node = context.create<ContinueStmt>();
+                break;
+            case NodeKind::CompoundStmt:
+                node = context.create<CompoundStmt>(copyChildren<Stmt>(context, nodes, getCompoundBody(i)));
+                break;
+            case NodeKind::VarDecl: {
+                const Var &var = getVar(i);
+                node = context.create<VarDecl>(var.name, var.type, getNode<Expr>(nodes, var.initializer));
+                break;
+            }
+            case NodeKind::FunctionDecl: {
+                const Function &function = getFunction(i);
+                auto parameters = getParameters(function.parameters);
+                auto *decl = context.create<FunctionDecl>(
+                    function.name, function.returnType,
+                    context.copyArray(std::vector<FunctionDecl::Parameter>(parameters.begin(), parameters.end())),
+                    getNode<CompoundStmt>(nodes, function.body));
+                decl->hasPrototype = function.hasPrototype;
+                node = decl;
+                break;
+            }
+            case NodeKind::TranslationUnit:
+                node = context.create<TranslationUnit>(copyChildren<Node>(context, nodes, getDeclarations(i)));
+                break;
+        }
+        node->loc = locations_[i];
+        nodes[i] = node;
+    }
+    return nodes.empty() ? nullptr : nodes.back();
+}
+
+size_t FlatAST::getMemoryUsage() const {
+    auto bytes = [](const auto &array) {
+        return array.capacity() * sizeof(typename std::decay_t<decltype(array)>::value_type);
+    };
+    return bytes(kinds_) + bytes(locations_) + bytes(slots_) + bytes(integers_) + bytes(floats_) +
+           bytes(characters_) + bytes(strings_) + bytes(identifiers_) + bytes(binaries_) + bytes(unaries_) +
+           bytes(calls_) + bytes(subscripts_) + bytes(members_) + bytes(conditionals_) + bytes(exprStmts_) +
+           bytes(returns_) + bytes(ifs_) + bytes(whiles_) + bytes(fors_) + bytes(compounds_) + bytes(vars_) +
+           bytes(functions_) + bytes(units_) + bytes(children_) + bytes(parameters_) + bytes(stringData_);
+}
+
+} // namespace ast
@@ -0,0 +1,208 @@
+#pragma once
+
+#include "ast/Node.h"
+#include "ast/Expr.h"
+#include "ast/Stmt.h"
+#include "ast/ASTContext.h"
+#include "utils/SourceLocation.h"
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ast {
+
+/**
+ * An AST stored as arrays instead of linked nodes.
+ *
+ * Every node is identified by a 32-bit NodeIndex. Nodes are numbered in
+ * post-order, so children always come before their parent and the root is
+ * last, and a bottom-up pass is a single loop over the index range. Kind,
+ * location and payload slot of each node are parallel arrays. The payload
+ * of each kind lives in its own array, and child lists are ranges of one
+ * shared index pool.
+ *
+ * Identifiers and types are the interned objects of the source AST, so its
+ * IdentifierTable and TypeContext must outlive the FlatAST.
+ */
+class FlatAST {
+public:
+    using NodeIndex = uint32_t;
+
+    /** Stands for a null child, left where the builder met an unmodelled construct. */
+    static constexpr NodeIndex NoNode = std::numeric_limits<NodeIndex>::max();
+
+    /** A run of entries in one of the shared pools. */
+    struct Range {
+        uint32_t begin = 0;
+        uint32_t size = 0;
+    };
+
+    struct Integer {
+        long long value;
+        BuiltinType::BuiltinKind kind;
+    };
+
+    struct Binary {
+        NodeIndex left;
+        NodeIndex right;
+        BinaryExpr::OpKind op;
+    };
+
+    struct Unary {
+        NodeIndex operand;
+        UnaryExpr::OpKind op;
+        bool isPrefix;
+    };
+
+    struct Call {
+        NodeIndex callee;
+        Range arguments;
+    };
+
+    struct Subscript {
+        NodeIndex array;
+        NodeIndex index;
+    };
+
+    struct Member {
+        NodeIndex object;
+        const IdentifierInfo *member;
+        bool isArrow;
+    };
+
+    struct Conditional {
+        NodeIndex condition;
+        NodeIndex trueExpr;
+        NodeIndex falseExpr;
+    };
+
+    struct If {
+        NodeIndex condition;
+        NodeIndex thenStmt;
+        NodeIndex elseStmt;
+    };
+
+    struct While {
+        NodeIndex condition;
+        NodeIndex body;
+        LoopHints hints;
+    };
+
+    struct For {
+        NodeIndex init;
+        NodeIndex condition;
+        NodeIndex increment;
+        NodeIndex body;
+        LoopHints hints;
+    };
+
+    struct Var {
+        const IdentifierInfo *name;
+        const Type *type;
+        NodeIndex initializer;
+    };
+
+    struct Function {
+        const IdentifierInfo *name;
+        const Type *returnType;
+        Range parameters;
+        NodeIndex body;
+        bool hasPrototype;
+    };
+
+    /**
+     * Flatten a pointer AST. The tree is only read.
+     * @param root Any node, usually a TranslationUnit
+     */
+    static FlatAST flatten(Node *root);
+
+    /**
+     * Rebuild the pointer AST in a context.
+     * @return The root node
+     */
+    Node *unflatten(ASTContext &context) const;
+
+    size_t size() const { return kinds_.size(); }
+    bool empty() const { return kinds_.empty(); }
+    NodeIndex getRoot() const { return empty() ? NoNode : static_cast<NodeIndex>(size() - 1); }
+
+    NodeKind getKind(NodeIndex node) const { return kinds_[node]; }
+    utils::SourceLocation getLocation(NodeIndex node) const { return locations_[node]; }
+
+    /** All node kinds, indexed by NodeIndex. */
+    std::span<const NodeKind> getKinds() const { return kinds_; }
+
+    // Payload of a node; the node must be of the matching kind
+    long long getIntegerValue(NodeIndex node) const { return integers_[slots_[node]].value; }
+    BuiltinType::BuiltinKind getIntegerKind(NodeIndex node) const { return integers_[slots_[node]].kind; }
+    double getFloatingValue(NodeIndex node) const { return floats_[slots_[node]]; }
+    char getCharacterValue(NodeIndex node) const { return characters_[slots_[node]]; }
+    std::string_view getStringValue(NodeIndex node) const;
+    const IdentifierInfo *getIdentifier(NodeIndex node) const { return identifiers_[slots_[node]]; }
+    const Binary &getBinary(NodeIndex node) const { return binaries_[slots_[node]]; }
+    const Unary &getUnary(NodeIndex node) const { return unaries_[slots_[node]]; }
+    const Call &getCall(NodeIndex node) const { return calls_[slots_[node]]; }
+    const Subscript &getSubscript(NodeIndex node) const { return subscripts_[slots_[node]]; }
+    const Member &getMember(NodeIndex node) const { return members_[slots_[node]]; }
+    const Conditional &getConditional(NodeIndex node) const { return conditionals_[slots_[node]]; }
+    NodeIndex getExprStmtExpression(NodeIndex node) const { return exprStmts_[slots_[node]]; }
+    NodeIndex getReturnValue(NodeIndex node) const { return returns_[slots_[node]]; }
+    const If &getIf(NodeIndex node) const { return ifs_[slots_[node]]; }
+    const While &getWhile(NodeIndex node) const { return whiles_[slots_[node]]; }
+    const For &getFor(NodeIndex node) const { return fors_[slots_[node]]; }
+    std::span<const NodeIndex> getCompoundBody(NodeIndex node) const { return getChildren(compounds_[slots_[node]]); }
+    const Var &getVar(NodeIndex node) const { return vars_[slots_[node]]; }
+    const Function &getFunction(NodeIndex node) const { return functions_[slots_[node]]; }
+    std::span<const NodeIndex> getDeclarations(NodeIndex node) const { return getChildren(units_[slots_[node]]); }
+
+    std::span<const NodeIndex> getChildren(Range range) const {
+        return std::span<const NodeIndex>(children_).subspan(range.begin, range.size);
+    }
+    std::span<const FunctionDecl::Parameter> getParameters(Range range) const {
+        return std::span<const FunctionDecl::Parameter>(parameters_).subspan(range.begin, range.size);
+    }
+
+    /** Bytes held by all arrays. */
+    size_t getMemoryUsage() const;
+
+private:
+    friend class FlatASTBuilder;
+
+    // Per node
+    std::vector<NodeKind> kinds_;
+    std::vector<utils::SourceLocation> locations_;
+    std::vector<uint32_t> slots_;  // index into the payload array of the kind
+
+    // Per kind
+    std::vector<Integer> integers_;
+    std::vector<double> floats_;
+    std::vector<char> characters_;
+    std::vector<Range> strings_;  // into stringData_
+    std::vector<const IdentifierInfo*> identifiers_;
+    std::vector<Binary> binaries_;
+    std::vector<Unary> unaries_;
+    std::vector<Call> calls_;
+    std::vector<Subscript> subscripts_;
+    std::vector<Member> members_;
+    std::vector<Conditional> conditionals_;
+    std::vector<NodeIndex> exprStmts_;
+    std::vector<NodeIndex> returns_;
+    std::vector<If> ifs_;
+    std::vector<While> whiles_;
+    std::vector<For> fors_;
+    std::vector<Range> compounds_;
+    std::vector<Var> vars_;
+    std::vector<Function> functions_;
+    std::vector<Range> units_;
+
+    // Shared pools
+    std::vector<NodeIndex> children_;
+    std::vector<FunctionDecl::Parameter> parameters_;
+    std::string stringData_;
+};
+
+} // namespace ast
@@ -0,0 +1,20 @@
+#include "ast/IdentifierTable.h"
+
+namespace ast {
+
+IdentifierInfo *IdentifierTable::get(std::string_view name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = names_.find(name);
+    if (it == names_.end()) {
+        it = names_.try_emplace(std::string(name)).first;
+        it->second.name_ = it->first;
+    }
+    return &it->second;
+}
+
+size_t IdentifierTable::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return names_.size();
+}
+
+} // namespace ast
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace ast {
+
+/**
+ * One interned name. Every occurrence of the same spelling within a
+ * compilation shares one IdentifierInfo, so names compare and hash by
+ * pointer.
+ */
+class IdentifierInfo {
+public:
+    std::string_view getName() const { return name_; }
+
+private:
+    friend class IdentifierTable;
+    std::string_view name_;
+};
+
+/**
+ * Interns identifier spellings for one compilation.
+ *
+ * Returned handles stay valid for the lifetime of the table, which must
+ * therefore outlive every AST and pass keyed by them. Lookups are
+ * serialized, so threads building parts of one AST may share a table.
+ */
+class IdentifierTable {
+public:
+    IdentifierTable() = default;
+    IdentifierTable(const IdentifierTable &) = delete;
+    IdentifierTable &operator=(const IdentifierTable &) = delete;
+
+    /**
+     * Return the unique IdentifierInfo for a spelling, creating it on first
+     * use.
+     */
+    IdentifierInfo *get(std::string_view name);
+
+    /**
+     * Number of distinct names interned.
+     */
+    size_t size() const;
+
+private:
+    struct NameHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view name) const { return std::hash<std::string_view>{}(name); }
+    };
+
+    mutable std::mutex mutex_;
+    // Node-based, so keys and values never move once inserted
+    std::unordered_map<std::string, IdentifierInfo, NameHash, std::equal_to<>> names_;
+};
+
+} // namespace ast
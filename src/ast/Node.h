@@ -1,23 +1,73 @@
 #pragma once
 
+#include "utils/SourceLocation.h"
+
+#include <cstdint>
 #include <memory>
 #include <vector>
 #include <string>
 
 namespace ast {
 
+/**
+ * Concrete node classes. Expressions and statements each occupy a
+ * contiguous range so Expr and Stmt can be tested with two compares.
+ */
+enum class NodeKind : uint8_t {
+    // Expressions
+    IntegerLiteral,
+    FloatingLiteral,
+    CharacterLiteral,
+    StringLiteral,
+    Identifier,
+    BinaryExpr,
+    UnaryExpr,
+    CallExpr,
+    ArraySubscriptExpr,
+    MemberExpr,
+    ConditionalExpr,
+    
+    // Statements
+    ExprStmt,
+    ReturnStmt,
+    IfStmt,
+    WhileStmt,
+    ForStmt,
+    BreakStmt,
+    ContinueStmt,
+    CompoundStmt,
+    VarDecl,
+    
+    // Top-level declarations
+    FunctionDecl,
+    TranslationUnit,
+    
+    FirstExpr = IntegerLiteral,
+    LastExpr = ConditionalExpr,
+    FirstStmt = ExprStmt,
+    LastStmt = VarDecl
+};
+
 /**
  * Base class for all AST nodes.
- * Uses virtual destructor to enable RTTI via dynamic_cast.
+ * Nodes are allocated in an ASTContext and never destroyed individually, so
+ * the destructor is trivial. Each node records its NodeKind; use isa, cast
+ * and dyn_cast from ast/Casting.h rather than dynamic_cast.
  */
 struct Node {
-    virtual ~Node() = default;
+    // Where the node starts; decode it with the compilation's SourceManager
+    utils::SourceLocation loc;
     
-    // Source location information
-    int line = 0;
-    int column = 0;
+    NodeKind getKind() const { return kind_; }
     
     virtual std::string toString() const = 0;
+    
+protected:
+    explicit Node(NodeKind kind) : kind_(kind) {}
+    ~Node() = default;
+    
+private:
+    NodeKind kind_;
 };
 
 } // namespace ast
@@ -34,7 +34,7 @@ std::string CompoundStmt::toString() const {
 }
 
 std::string VarDecl::toString() const {
-    std::string result = type + " " + name;
+    std::string result = type->toString() + " " + std::string(name->getName());
     if (initializer) {
         result += " = " + initializer->toString();
     }
@@ -44,11 +44,11 @@ std::string VarDecl::toString() const {
 
 std::string FunctionDecl::toString() const {
     std::ostringstream oss;
-    oss << returnType << " " << name << "(";
+    oss << returnType->toString() << " " << name->getName() << "(";
     
     for (size_t i = 0; i < parameters.size(); ++i) {
         if (i > 0) oss << ", ";
-        oss << parameters[i].first << " " << parameters[i].second;
+        oss << parameters[i].first->toString() << " " << parameters[i].second->getName();
     }
     oss << ")";
     
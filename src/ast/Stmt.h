@@ -2,8 +2,11 @@
 
 #include "ast/Node.h"
 #include "ast/Expr.h"
-#include <memory>
-#include <vector>
+#include "ast/Type.h"
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <utility>
 
 namespace ast {
 
@@ -11,16 +14,23 @@ namespace ast {
  * Base class for all statements.
  */
 struct Stmt : public Node {
-    virtual ~Stmt() = default;
+    static bool classof(const Node *node) {
+        return node->getKind() >= NodeKind::FirstStmt && node->getKind() <= NodeKind::LastStmt;
+    }
+    
+protected:
+    explicit Stmt(NodeKind kind) : Node(kind) {}
 };
 
 /**
  * Expression statement (e.g., "x = 5;").
  */
 struct ExprStmt : public Stmt {
-    std::unique_ptr<Expr> expression;
+    Expr *expression;
+    
+    explicit ExprStmt(Expr *expr) : Stmt(NodeKind::ExprStmt), expression(expr) {}
     
-    explicit ExprStmt(std::unique_ptr<Expr> expr) : expression(std::move(expr)) {}
+    static bool classof(const Node *node) { return node->getKind() == NodeKind::ExprStmt; }
     
     std::string toString() const override {
         return expression ? expression->toString() + ";" : ";";
@@ -31,10 +41,12 @@ struct ExprStmt : public Stmt {
  * Return statement.
  */
 struct ReturnStmt : public Stmt {
-    std::unique_ptr<Expr> expression;
+    Expr *expression;
     
-    explicit ReturnStmt(std::unique_ptr<Expr> expr = nullptr) 
-        : expression(std::move(expr)) {}
+    explicit ReturnStmt(Expr *expr = nullptr) 
+        : Stmt(NodeKind::ReturnStmt), expression(expr) {}
+    
+    static bool classof(const Node *node) { return node->getKind() == NodeKind::ReturnStmt; }
     
     std::string toString() const override {
         return "return" + (expression ? " " + expression->toString() : "") + ";";
@@ -45,26 +57,55 @@ struct ReturnStmt : public Stmt {
  * If statement.
  */
 struct IfStmt : public Stmt {
-    std::unique_ptr<Expr> condition;
-    std::unique_ptr<Stmt> thenStmt;
-    std::unique_ptr<Stmt> elseStmt;
+    Expr *condition;
+    Stmt *thenStmt;
+    Stmt *elseStmt;
+    
+    IfStmt(Expr *cond, Stmt *then, Stmt *elseS = nullptr)
+        : Stmt(NodeKind::IfStmt), condition(cond), thenStmt(then), elseStmt(elseS) {}
     
-    IfStmt(std::unique_ptr<Expr> cond, std::unique_ptr<Stmt> then, 
-           std::unique_ptr<Stmt> elseS = nullptr)
-        : condition(std::move(cond)), thenStmt(std::move(then)), elseStmt(std::move(elseS)) {}
+    static bool classof(const Node *node) { return node->getKind() == NodeKind::IfStmt; }
     
     std::string toString() const override;
 };
 
+/**
+ * Transformations requested for a loop by the pragmas before it: #pragma
+ * clang loop, #pragma unroll and nounroll, #pragma GCC unroll and ivdep, and
+ * #pragma omp simd. Counts and widths are 0 when not given.
+ */
+struct LoopHints {
+    enum class State : uint8_t {
+        Default, Enable, Disable,
+        Full  // unroll only: unroll completely
+    };
+    
+    State vectorize = State::Default;
+    State interleave = State::Default;
+    State unroll = State::Default;
+    bool independentIterations = false;  // no dependences between iterations
+    uint32_t vectorizeWidth = 0;
+    uint32_t interleaveCount = 0;
+    uint32_t unrollCount = 0;
+    
+    bool empty() const {
+        return vectorize == State::Default && interleave == State::Default && unroll == State::Default &&
+               !independentIterations && !vectorizeWidth && !interleaveCount && !unrollCount;
+    }
+};
+
 /**
  * While statement.
  */
 struct WhileStmt : public Stmt {
-    std::unique_ptr<Expr> condition;
-    std::unique_ptr<Stmt> body;
+    Expr *condition;
+    Stmt *body;
+    LoopHints hints;
+    
+    WhileStmt(Expr *cond, Stmt *body)
+        : Stmt(NodeKind::WhileStmt), condition(cond), body(body) {}
     
-    WhileStmt(std::unique_ptr<Expr> cond, std::unique_ptr<Stmt> body)
-        : condition(std::move(cond)), body(std::move(body)) {}
+    static bool classof(const Node *node) { return node->getKind() == NodeKind::WhileStmt; }
     
     std::string toString() const override {
         return "while (" + condition->toString() + ") " + body->toString();
@@ -75,15 +116,16 @@ struct WhileStmt : public Stmt {
  * For statement.
  */
 struct ForStmt : public Stmt {
-    std::unique_ptr<Stmt> init;     // Can be declaration or expression statement
-    std::unique_ptr<Expr> condition;
-    std::unique_ptr<Expr> increment;
-    std::unique_ptr<Stmt> body;
+    Stmt *init;     // Can be declaration or expression statement
+    Expr *condition;
+    Expr *increment;
+    Stmt *body;
+    LoopHints hints;
+    
+    ForStmt(Stmt *init, Expr *cond, Expr *inc, Stmt *body)
+        : Stmt(NodeKind::ForStmt), init(init), condition(cond), increment(inc), body(body) {}
     
-    ForStmt(std::unique_ptr<Stmt> init, std::unique_ptr<Expr> cond,
-            std::unique_ptr<Expr> inc, std::unique_ptr<Stmt> body)
-        : init(std::move(init)), condition(std::move(cond)), 
-          increment(std::move(inc)), body(std::move(body)) {}
+    static bool classof(const Node *node) { return node->getKind() == NodeKind::ForStmt; }
     
     std::string toString() const override;
 };
@@ -92,6 +134,10 @@ struct ForStmt : public Stmt {
  * Break statement.
  */
 struct BreakStmt : public Stmt {
+    BreakStmt() : Stmt(NodeKind::BreakStmt) {}
+    
+    static bool classof(const Node *node) { return node->getKind() == NodeKind::BreakStmt; }
+    
     std::string toString() const override {
         return "break;";
     }
@@ -101,6 +147,10 @@ struct BreakStmt : public Stmt {
  * Continue statement.
  */
 struct ContinueStmt : public Stmt {
+    ContinueStmt() : Stmt(NodeKind::ContinueStmt) {}
+    
+    static bool classof(const Node *node) { return node->getKind() == NodeKind::ContinueStmt; }
+    
     std::string toString() const override {
         return "continue;";
     }
@@ -110,10 +160,12 @@ struct ContinueStmt : public Stmt {
  * Compound statement (block).
  */
 struct CompoundStmt : public Stmt {
-    std::vector<std::unique_ptr<Stmt>> statements;
+    std::span<Stmt*> statements;
+    
+    explicit CompoundStmt(std::span<Stmt*> stmts)
+        : Stmt(NodeKind::CompoundStmt), statements(stmts) {}
     
-    explicit CompoundStmt(std::vector<std::unique_ptr<Stmt>> stmts)
-        : statements(std::move(stmts)) {}
+    static bool classof(const Node *node) { return node->getKind() == NodeKind::CompoundStmt; }
     
     std::string toString() const override;
 };
@@ -122,12 +174,18 @@ struct CompoundStmt : public Stmt {
  * Variable declaration statement.
  */
 struct VarDecl : public Stmt {
-    std::string name;
-    std::string type;
-    std::unique_ptr<Expr> initializer;
+    const IdentifierInfo *name;
+    const Type *type;
+    Expr *initializer;
+    
+    // Slot assigned by semantic analysis: among the enclosing function's
+    // locals, or among the translation unit's globals at file scope
+    unsigned index = 0;
     
-    VarDecl(std::string n, std::string t, std::unique_ptr<Expr> init = nullptr)
-        : name(std::move(n)), type(std::move(t)), initializer(std::move(init)) {}
+    VarDecl(const IdentifierInfo *n, const Type *t, Expr *init = nullptr)
+        : Stmt(NodeKind::VarDecl), name(n), type(t), initializer(init) {}
+    
+    static bool classof(const Node *node) { return node->getKind() == NodeKind::VarDecl; }
     
     std::string toString() const override;
 };
@@ -136,16 +194,26 @@ struct VarDecl : public Stmt {
  * Function declaration/definition.
  */
 struct FunctionDecl : public Node {
-    std::string name;
-    std::string returnType;
-    std::vector<std::pair<std::string, std::string>> parameters; // (type, name) pairs
-    std::unique_ptr<CompoundStmt> body; // nullptr for declarations
+    using Parameter = std::pair<const Type*, const IdentifierInfo*>; // (type, name)
+    
+    const IdentifierInfo *name;
+    const Type *returnType;
+    std::span<Parameter> parameters;
+    CompoundStmt *body; // nullptr for declarations
+    bool hasPrototype = true; // false for an empty identifier list, as in int f()
+    
+    // Assigned by semantic analysis: the function's slot among the
+    // translation unit's globals, shared by all its declarations, and the
+    // number of local slots its definition needs
+    unsigned index = 0;
+    unsigned numLocals = 0;
     
-    FunctionDecl(std::string n, std::string retType, 
-                 std::vector<std::pair<std::string, std::string>> params,
-                 std::unique_ptr<CompoundStmt> body = nullptr)
-        : name(std::move(n)), returnType(std::move(retType)), 
-          parameters(std::move(params)), body(std::move(body)) {}
+    FunctionDecl(const IdentifierInfo *n, const Type *retType, 
+                 std::span<Parameter> params,
+                 CompoundStmt *body = nullptr)
+        : Node(NodeKind::FunctionDecl), name(n), returnType(retType), parameters(params), body(body) {}
+    
+    static bool classof(const Node *node) { return node->getKind() == NodeKind::FunctionDecl; }
     
     std::string toString() const override;
     
@@ -156,10 +224,12 @@ struct FunctionDecl : public Node {
  * Translation unit (top-level AST node).
  */
 struct TranslationUnit : public Node {
-    std::vector<std::unique_ptr<Node>> declarations;
+    std::span<Node*> declarations;
+    
+    explicit TranslationUnit(std::span<Node*> decls)
+        : Node(NodeKind::TranslationUnit), declarations(decls) {}
     
-    explicit TranslationUnit(std::vector<std::unique_ptr<Node>> decls)
-        : declarations(std::move(decls)) {}
+    static bool classof(const Node *node) { return node->getKind() == NodeKind::TranslationUnit; }
     
     std::string toString() const override;
 };
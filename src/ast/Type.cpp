@@ -0,0 +1,325 @@
+#include "ast/Type.h"
+#include "ast/Casting.h"
+
+namespace ast {
+
+namespace {
+
+using BK = BuiltinType::BuiltinKind;
+
+const BuiltinType *asBuiltin(const Type *type) {
+    return dyn_cast<BuiltinType>(type->getUnqualifiedType());
+}
+
+const char *builtinName(BK kind) {
+    switch (kind) {
+        case BK::Void: return "void";
+        case BK::Bool: return "_Bool";
+        case BK::Char: return "char";
+        case BK::SignedChar: return "signed char";
+        case BK::UnsignedChar: return "unsigned char";
+        case BK::Short: return "short";
+        case BK::UnsignedShort: return "unsigned short";
+        case BK::Int: return "int";
+        case BK::UnsignedInt: return "unsigned int";
+        case BK::Long: return "long";
+        case BK::UnsignedLong: return "unsigned long";
+        case BK::LongLong: return "long long";
+        case BK::UnsignedLongLong: return "unsigned long long";
+        case BK::Float: return "float";
+        case BK::Double: return "double";
+        case BK::LongDouble: return "long double";
+    }
+    return "<unknown>";
+}
+
+// LP64: long and pointers are 8 bytes, long double is the 16-byte x87 format
+uint64_t builtinSize(BK kind) {
+    switch (kind) {
+        case BK::Void:
+        case BK::Bool:
+        case BK::Char:
+        case BK::SignedChar:
+        case BK::UnsignedChar:
+            return 1;
+        case BK::Short:
+        case BK::UnsignedShort:
+            return 2;
+        case BK::Int:
+        case BK::UnsignedInt:
+        case BK::Float:
+            return 4;
+        case BK::Long:
+        case BK::UnsignedLong:
+        case BK::LongLong:
+        case BK::UnsignedLongLong:
+        case BK::Double:
+            return 8;
+        case BK::LongDouble:
+            return 16;
+    }
+    return 1;
+}
+
+/** Integer conversion rank (C11 6.3.1.1); signed and unsigned share one. */
+int getRank(BK kind) {
+    switch (kind) {
+        case BK::Bool:
+            return 0;
+        case BK::Char:
+        case BK::SignedChar:
+        case BK::UnsignedChar:
+            return 1;
+        case BK::Short:
+        case BK::UnsignedShort:
+            return 2;
+        case BK::Int:
+        case BK::UnsignedInt:
+            return 3;
+        case BK::Long:
+        case BK::UnsignedLong:
+            return 4;
+        default:
+            return 5;
+    }
+}
+
+bool isUnsignedKind(BK kind) {
+    switch (kind) {
+        case BK::Bool:
+        case BK::UnsignedChar:
+        case BK::UnsignedShort:
+        case BK::UnsignedInt:
+        case BK::UnsignedLong:
+        case BK::UnsignedLongLong:
+            return true;
+        default:
+            return false;
+    }
+}
+
+BK getUnsignedKind(BK kind) {
+    switch (kind) {
+        case BK::Int:
+            return BK::UnsignedInt;
+        case BK::Long:
+            return BK::UnsignedLong;
+        case BK::LongLong:
+            return BK::UnsignedLongLong;
+        default:
+            return kind;
+    }
+}
+
+} // namespace
+
+uint64_t BuiltinType::getKindSize(BK kind) {
+    return builtinSize(kind);
+}
+
+BK BuiltinType::getPromotedKind(BK kind) {
+    if (kind >= BK::Float || getRank(kind) >= getRank(BK::Int)) {
+        return kind;
+    }
+    // Every narrower type fits in int
+    return BK::Int;
+}
+
+BK BuiltinType::getCommonKind(BK left, BK right) {
+    if (left >= BK::Float || right >= BK::Float) {
+        return left > right ? left : right;
+    }
+    if (left == right) {
+        return left;
+    }
+    if (isUnsignedKind(left) == isUnsignedKind(right)) {
+        return getRank(left) >= getRank(right) ? left : right;
+    }
+    BK u = isUnsignedKind(left) ? left : right;
+    BK s = isUnsignedKind(left) ? right : left;
+    if (getRank(u) >= getRank(s)) {
+        return u;
+    }
+    if (builtinSize(s) > builtinSize(u)) {
+        return s;
+    }
+    return getUnsignedKind(s);
+}
+
+const Type *Type::getUnqualifiedType() const {
+    if (auto *qualified = dyn_cast<QualifiedType>(this)) {
+        return qualified->getBaseType();
+    }
+    return this;
+}
+
+bool Type::isVoid() const {
+    auto *builtin = asBuiltin(this);
+    return builtin && builtin->getBuiltinKind() == BK::Void;
+}
+
+bool Type::isBool() const {
+    auto *builtin = asBuiltin(this);
+    return builtin && builtin->getBuiltinKind() == BK::Bool;
+}
+
+bool Type::isInteger() const {
+    auto *builtin = asBuiltin(this);
+    return builtin && builtin->getBuiltinKind() >= BK::Bool &&
+           builtin->getBuiltinKind() <= BK::UnsignedLongLong;
+}
+
+bool Type::isSignedInteger() const {
+    auto *builtin = asBuiltin(this);
+    if (!builtin) {
+        return false;
+    }
+    switch (builtin->getBuiltinKind()) {
+        case BK::Char:       // char is signed on x86-64
+        case BK::SignedChar:
+        case BK::Short:
+        case BK::Int:
+        case BK::Long:
+        case BK::LongLong:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool Type::isFloating() const {
+    auto *builtin = asBuiltin(this);
+    return builtin && builtin->getBuiltinKind() >= BK::Float;
+}
+
+bool Type::isPointer() const {
+    return isa<PointerType>(getUnqualifiedType());
+}
+
+bool Type::isArray() const {
+    return isa<ArrayType>(getUnqualifiedType());
+}
+
+bool Type::isFunction() const {
+    return isa<FunctionType>(getUnqualifiedType());
+}
+
+unsigned Type::getPointerDepth() const {
+    unsigned depth = 0;
+    const Type *type = getUnqualifiedType();
+    while (auto *pointer = dyn_cast<PointerType>(type)) {
+        ++depth;
+        type = pointer->getPointeeType()->getUnqualifiedType();
+    }
+    return depth;
+}
+
+std::string Type::toString() const {
+    switch (kind_) {
+        case Kind::Builtin:
+            return builtinName(cast<BuiltinType>(this)->getBuiltinKind());
+        case Kind::Pointer:
+            return cast<PointerType>(this)->getPointeeType()->toString() + " *";
+        case Kind::Array: {
+            auto *array = cast<ArrayType>(this);
+            return array->getElementType()->toString() + "[" +
+                   std::to_string(array->getNumElements()) + "]";
+        }
+        case Kind::Function: {
+            auto *function = cast<FunctionType>(this);
+            std::string result = function->getReturnType()->toString() + "(";
+            auto params = function->getParamTypes();
+            for (size_t i = 0; i < params.size(); ++i) {
+                if (i > 0) result += ", ";
+                result += params[i]->toString();
+            }
+            if (function->isVariadic()) {
+                result += params.empty() ? "..." : ", ...";
+            }
+            return result + ")";
+        }
+        case Kind::Qualified: {
+            auto *qualified = cast<QualifiedType>(this);
+            std::string result;
+            if (qualified->isConst()) result += "const ";
+            if (qualified->isVolatile()) result += "volatile ";
+            if (qualified->getQualifiers() & QualifiedType::Restrict) result += "restrict ";
+            return result + qualified->getBaseType()->toString();
+        }
+    }
+    return "<unknown>";
+}
+
+TypeContext::TypeContext() {
+    for (size_t i = 0; i <= static_cast<size_t>(BK::LastKind); ++i) {
+        auto kind = static_cast<BK>(i);
+        builtinStorage_.push_back(BuiltinType(nextID_++, kind, builtinSize(kind)));
+        builtins_.push_back(&builtinStorage_.back());
+    }
+}
+
+const PointerType *TypeContext::getPointerType(const Type *pointee) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto [it, inserted] = pointers_.try_emplace(pointee, nullptr);
+    if (inserted) {
+        pointerStorage_.push_back(PointerType(nextID_++, pointee));
+        it->second = &pointerStorage_.back();
+    }
+    return it->second;
+}
+
+const ArrayType *TypeContext::getArrayType(const Type *element, uint64_t numElements) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto [it, inserted] = arrays_.try_emplace({element, numElements}, nullptr);
+    if (inserted) {
+        arrayStorage_.push_back(ArrayType(nextID_++, element, numElements));
+        it->second = &arrayStorage_.back();
+    }
+    return it->second;
+}
+
+const FunctionType *TypeContext::getFunctionType(const Type *result,
+                                                 std::span<const Type *const> params,
+                                                 bool variadic) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (auto it = functions_.find({result, params, variadic}); it != functions_.end()) {
+        return it->second;
+    }
+    functionStorage_.push_back(FunctionType(nextID_++, result, std::vector<const Type*>(params.begin(), params.end()), variadic));
+    const FunctionType *function = &functionStorage_.back();
+    functions_.emplace(FunctionKey{result, function->getParamTypes(), variadic}, function);
+    return function;
+}
+
+size_t TypeContext::KeyHash::operator()(const FunctionKey &key) const {
+    size_t hash = combine(std::hash<const Type*>()(key.result), key.variadic);
+    for (const Type *param : key.params) {
+        hash = combine(hash, std::hash<const Type*>()(param));
+    }
+    return hash;
+}
+
+const Type *TypeContext::getQualifiedType(const Type *base, unsigned qualifiers) {
+    if (auto *qualified = dyn_cast<QualifiedType>(base)) {
+        qualifiers |= qualified->getQualifiers();
+        base = qualified->getBaseType();
+    }
+    if (qualifiers == 0) {
+        return base;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto [it, inserted] = qualified_.try_emplace({base, qualifiers}, nullptr);
+    if (inserted) {
+        qualifiedStorage_.push_back(QualifiedType(nextID_++, base, qualifiers));
+        it->second = &qualifiedStorage_.back();
+    }
+    return it->second;
+}
+
+size_t TypeContext::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return nextID_;
+}
+
+} // namespace ast
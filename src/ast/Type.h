@@ -0,0 +1,299 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ast {
+
+/**
+ * A C type.
+ *
+ * Types are created only by a TypeContext and are uniqued there: two
+ * structurally identical types are the same object, so types compare by
+ * pointer. Size and alignment follow the x86-64 LP64 ABI and are computed
+ * once when the type is created.
+ */
+class Type {
+public:
+    enum class Kind : uint8_t {
+        Builtin,
+        Pointer,
+        Array,
+        Function,
+        Qualified
+    };
+
+    Kind getKind() const { return kind_; }
+
+    /**
+     * Dense index, unique within the owning TypeContext. Suitable for
+     * indexing side tables such as a code generator's lowered types.
+     */
+    unsigned getID() const { return id_; }
+
+    /** Size in bytes (sizeof). */
+    uint64_t getSize() const { return size_; }
+
+    /** Alignment in bytes (_Alignof). */
+    uint64_t getAlignment() const { return alignment_; }
+
+    /** The type with any qualifiers removed. */
+    const Type *getUnqualifiedType() const;
+
+    bool isVoid() const;
+    bool isBool() const;
+    bool isInteger() const;
+    bool isSignedInteger() const;
+    bool isUnsignedInteger() const { return isInteger() && !isSignedInteger(); }
+    bool isFloating() const;
+    bool isArithmetic() const { return isInteger() || isFloating(); }
+    bool isScalar() const { return isArithmetic() || isPointer(); }
+    bool isPointer() const;
+    bool isArray() const;
+    bool isFunction() const;
+
+    /** Number of pointer levels, e.g. 2 for `int **`. */
+    unsigned getPointerDepth() const;
+
+    /** C spelling, e.g. "const int *". */
+    std::string toString() const;
+
+protected:
+    Type(Kind kind, unsigned id, uint64_t size, uint64_t alignment)
+        : kind_(kind), id_(id), size_(size), alignment_(alignment) {}
+
+private:
+    Kind kind_;
+    unsigned id_;
+    uint64_t size_;
+    uint64_t alignment_;
+};
+
+/**
+ * void, _Bool and the arithmetic types.
+ */
+class BuiltinType : public Type {
+public:
+    enum class BuiltinKind : uint8_t {
+        Void,
+        Bool,
+        Char,
+        SignedChar,
+        UnsignedChar,
+        Short,
+        UnsignedShort,
+        Int,
+        UnsignedInt,
+        Long,
+        UnsignedLong,
+        LongLong,
+        UnsignedLongLong,
+        Float,
+        Double,
+        LongDouble,
+        LastKind = LongDouble
+    };
+
+    BuiltinKind getBuiltinKind() const { return builtinKind_; }
+
+    /** Integer promotion (C11 6.3.1.1): kinds narrower than int become int. */
+    static BuiltinKind getPromotedKind(BuiltinKind kind);
+
+    /** Size in bytes of an object of the kind. */
+    static uint64_t getKindSize(BuiltinKind kind);
+
+    /**
+     * The common real type of the usual arithmetic conversions (C11
+     * 6.3.1.8). Both kinds must be arithmetic and already promoted.
+     */
+    static BuiltinKind getCommonKind(BuiltinKind left, BuiltinKind right);
+
+    static bool classof(const Type *type) { return type->getKind() == Kind::Builtin; }
+
+private:
+    friend class TypeContext;
+    BuiltinType(unsigned id, BuiltinKind kind, uint64_t size)
+        : Type(Kind::Builtin, id, size, size), builtinKind_(kind) {}
+
+    BuiltinKind builtinKind_;
+};
+
+class PointerType : public Type {
+public:
+    const Type *getPointeeType() const { return pointee_; }
+
+    static bool classof(const Type *type) { return type->getKind() == Kind::Pointer; }
+
+private:
+    friend class TypeContext;
+    PointerType(unsigned id, const Type *pointee)
+        : Type(Kind::Pointer, id, 8, 8), pointee_(pointee) {}
+
+    const Type *pointee_;
+};
+
+/**
+ * Array of known length.
+ */
+class ArrayType : public Type {
+public:
+    const Type *getElementType() const { return element_; }
+    uint64_t getNumElements() const { return numElements_; }
+
+    static bool classof(const Type *type) { return type->getKind() == Kind::Array; }
+
+private:
+    friend class TypeContext;
+    ArrayType(unsigned id, const Type *element, uint64_t numElements)
+        : Type(Kind::Array, id, element->getSize() * numElements, element->getAlignment()),
+          element_(element), numElements_(numElements) {}
+
+    const Type *element_;
+    uint64_t numElements_;
+};
+
+class FunctionType : public Type {
+public:
+    const Type *getReturnType() const { return result_; }
+    std::span<const Type *const> getParamTypes() const { return params_; }
+    bool isVariadic() const { return variadic_; }
+
+    static bool classof(const Type *type) { return type->getKind() == Kind::Function; }
+
+private:
+    friend class TypeContext;
+    FunctionType(unsigned id, const Type *result, std::vector<const Type*> params, bool variadic)
+        : Type(Kind::Function, id, 1, 1), result_(result), params_(std::move(params)),
+          variadic_(variadic) {}
+
+    const Type *result_;
+    std::vector<const Type*> params_;
+    bool variadic_;
+};
+
+/**
+ * A type with const, volatile or restrict applied. The base type is never
+ * itself qualified.
+ */
+class QualifiedType : public Type {
+public:
+    enum Qualifier : unsigned {
+        Const = 1,
+        Volatile = 2,
+        Restrict = 4
+    };
+
+    const Type *getBaseType() const { return base_; }
+    unsigned getQualifiers() const { return qualifiers_; }
+    bool isConst() const { return qualifiers_ & Const; }
+    bool isVolatile() const { return qualifiers_ & Volatile; }
+
+    static bool classof(const Type *type) { return type->getKind() == Kind::Qualified; }
+
+private:
+    friend class TypeContext;
+    QualifiedType(unsigned id, const Type *base, unsigned qualifiers)
+        : Type(Kind::Qualified, id, base->getSize(), base->getAlignment()),
+          base_(base), qualifiers_(qualifiers) {}
+
+    const Type *base_;
+    unsigned qualifiers_;
+};
+
+/**
+ * Creates and uniques the types of one compilation.
+ *
+ * Types are hash-consed: each kind has a hash table keyed by the operands
+ * that identify a type, so finding an existing type takes constant time and
+ * allocates nothing. Returned types stay valid for the lifetime of the
+ * context, which must therefore outlive every AST and pass referring to
+ * them. Builtin types are created up front and can be read without
+ * locking; creating composite types is serialized, so threads building
+ * parts of one AST may share a context.
+ */
+class TypeContext {
+public:
+    TypeContext();
+    TypeContext(const TypeContext &) = delete;
+    TypeContext &operator=(const TypeContext &) = delete;
+
+    const BuiltinType *getBuiltinType(BuiltinType::BuiltinKind kind) const {
+        return builtins_[static_cast<size_t>(kind)];
+    }
+    const BuiltinType *getVoidType() const { return getBuiltinType(BuiltinType::BuiltinKind::Void); }
+    const BuiltinType *getBoolType() const { return getBuiltinType(BuiltinType::BuiltinKind::Bool); }
+    const BuiltinType *getCharType() const { return getBuiltinType(BuiltinType::BuiltinKind::Char); }
+    const BuiltinType *getIntType() const { return getBuiltinType(BuiltinType::BuiltinKind::Int); }
+    const BuiltinType *getLongType() const { return getBuiltinType(BuiltinType::BuiltinKind::Long); }
+    const BuiltinType *getDoubleType() const { return getBuiltinType(BuiltinType::BuiltinKind::Double); }
+
+    const PointerType *getPointerType(const Type *pointee);
+    const ArrayType *getArrayType(const Type *element, uint64_t numElements);
+    const FunctionType *getFunctionType(const Type *result, std::span<const Type *const> params,
+                                        bool variadic = false);
+
+    /**
+     * Apply qualifiers to a type. Qualifiers already on the type are kept;
+     * with no qualifiers the unqualified type itself is returned.
+     */
+    const Type *getQualifiedType(const Type *base, unsigned qualifiers);
+
+    /**
+     * Number of types created so far; every type's ID is below this.
+     */
+    size_t size() const;
+
+private:
+    /**
+     * Structure of a function type. The parameters of stored keys are those
+     * of the type itself, so a lookup copies nothing.
+     */
+    struct FunctionKey {
+        const Type *result;
+        std::span<const Type *const> params;
+        bool variadic;
+
+        bool operator==(const FunctionKey &other) const {
+            return result == other.result && variadic == other.variadic &&
+                   std::equal(params.begin(), params.end(), other.params.begin(), other.params.end());
+        }
+    };
+
+    /** Hashes the operands that identify a composite type. */
+    struct KeyHash {
+        template <typename T, typename U>
+        size_t operator()(const std::pair<T, U> &key) const { return combine(std::hash<T>()(key.first), key.second); }
+        size_t operator()(const FunctionKey &key) const;
+
+        static size_t combine(size_t seed, size_t value) {
+            return seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+        }
+    };
+
+    mutable std::mutex mutex_;
+    unsigned nextID_ = 0;
+
+    // Deques never move their elements, so handed-out pointers stay valid
+    std::deque<BuiltinType> builtinStorage_;
+    std::deque<PointerType> pointerStorage_;
+    std::deque<ArrayType> arrayStorage_;
+    std::deque<FunctionType> functionStorage_;
+    std::deque<QualifiedType> qualifiedStorage_;
+
+    std::vector<const BuiltinType*> builtins_;
+    std::unordered_map<const Type*, const PointerType*> pointers_;
+    std::unordered_map<std::pair<const Type*, uint64_t>, const ArrayType*, KeyHash> arrays_;
+    std::unordered_map<FunctionKey, const FunctionType*, KeyHash> functions_;
+    std::unordered_map<std::pair<const Type*, unsigned>, const QualifiedType*, KeyHash> qualified_;
+};
+
+} // namespace ast
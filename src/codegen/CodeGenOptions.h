@@ -0,0 +1,41 @@
+#pragma once
+
+namespace codegen {
+
+/**
+ * Choices the command line makes about the IR generated.
+ *
+ * By default the generator tells LLVM what C leaves undefined, which is
+ * what lets the optimizer widen induction variables, compute trip counts
+ * and delete empty loops. Each fact can be withdrawn for code that relies
+ * on the behavior anyway.
+ */
+struct CodeGenOptions {
+    /**
+     * Signed overflow wraps around (-fwrapv). When false, signed
+     * arithmetic carries nsw, as overflow is undefined (C11 6.5p5).
+     */
+    bool wrapv = false;
+    
+    /**
+     * Loops whose controlling expression is not a constant may be assumed
+     * to terminate (C11 6.8.5p6) and are marked llvm.loop.mustprogress.
+     * Turned off by -fno-finite-loops.
+     */
+    bool finiteLoops = true;
+    
+    /**
+     * Parameters are marked noundef, since passing an indeterminate value
+     * is undefined. Turned off by -fno-noundef-params.
+     */
+    bool noundefParams = true;
+    
+    /**
+     * Objects are only accessed through lvalues of a type that may alias
+     * them (C11 6.5p7), so loads and stores carry TBAA metadata. Turned off
+     * by -fno-strict-aliasing.
+     */
+    bool strictAliasing = true;
+};
+
+} // namespace codegen
@@ -1,21 +1,111 @@
 #include "codegen/IRGenerator.h"
+#include "ast/Casting.h"
 #include "utils/Error.h"
 
+#include "llvm/IR/CFG.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/GlobalVariable.h"
 #include "llvm/IR/Verifier.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/TargetParser/Host.h"
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 
 namespace codegen {
 
-IRGenerator::IRGenerator() {
+namespace {
+
+/** Marks the locals whose address is taken, which must live in memory. */
+class AddressTakenFinder : public ast::ASTVisitor<AddressTakenFinder> {
+    friend class ast::ASTVisitor<AddressTakenFinder>;
+    
+public:
+    explicit AddressTakenFinder(std::vector<bool> &addressTaken) : addressTaken_(addressTaken) {}
+    
+private:
+    std::vector<bool> &addressTaken_;
+    
+    void visitUnaryExpr(ast::UnaryExpr *node) {
+        auto *id = ast::dyn_cast_or_null<ast::Identifier>(node->operand);
+        if (node->op == ast::UnaryExpr::OpKind::AddressOf && id &&
+            id->binding == ast::Identifier::BindingKind::Local) {
+            addressTaken_[id->index] = true;
+        }
+        if (node->op != ast::UnaryExpr::OpKind::Sizeof) {
+            visit(node->operand);  // the operand of sizeof is never evaluated
+        }
+    }
+    void visitBinaryExpr(ast::BinaryExpr *node) {
+        visit(node->left);
+        visit(node->right);
+    }
+    void visitCallExpr(ast::CallExpr *node) {
+        visit(node->function);
+        for (auto *arg : node->arguments) {
+            visit(arg);
+        }
+    }
+    void visitArraySubscriptExpr(ast::ArraySubscriptExpr *node) {
+        visit(node->array);
+        visit(node->index);
+    }
+    void visitMemberExpr(ast::MemberExpr *node) {
+        visit(node->object);
+    }
+    void visitConditionalExpr(ast::ConditionalExpr *node) {
+        visit(node->condition);
+        visit(node->trueExpr);
+        visit(node->falseExpr);
+    }
+    void visitExprStmt(ast::ExprStmt *node) {
+        visit(node->expression);
+    }
+    void visitReturnStmt(ast::ReturnStmt *node) {
+        visit(node->expression);
+    }
+    void visitIfStmt(ast::IfStmt *node) {
+        visit(node->condition);
+        visit(node->thenStmt);
+        visit(node->elseStmt);
+    }
+    void visitWhileStmt(ast::WhileStmt *node) {
+        visit(node->condition);
+        visit(node->body);
+    }
+    void visitForStmt(ast::ForStmt *node) {
+        visit(node->init);
+        visit(node->condition);
+        visit(node->increment);
+        visit(node->body);
+    }
+    void visitCompoundStmt(ast::CompoundStmt *node) {
+        for (auto *stmt : node->statements) {
+            visit(stmt);
+        }
+    }
+    void visitVarDecl(ast::VarDecl *node) {
+        visit(node->initializer);
+    }
+};
+
+} // namespace
+
+IRGenerator::IRGenerator(const CodeGenOptions &options) : options_(options) {
+    startModule();
+}
+
+void IRGenerator::startModule() {
+    // Tear down in dependency order before replacing the context
+    builder_.reset();
+    module_.reset();
+    
     context_ = std::make_unique<llvm::LLVMContext>();
     module_ = std::make_unique<llvm::Module>("main", *context_);
     builder_ = std::make_unique<llvm::IRBuilder<>>(*context_);
+    llvmTypes_.clear(); // lowered types belong to the old context
+    tbaaTags_.clear();
     
     // Set target triple to avoid warnings during compilation
     module_->setTargetTriple(llvm::sys::getDefaultTargetTriple());
@@ -23,7 +113,39 @@ IRGenerator::IRGenerator() {
 
 std::string IRGenerator::generateIR(ast::TranslationUnit *tu) {
     visitTranslationUnit(tu);
+    return printModule();
+}
+
+void IRGenerator::emitDeclaration(ast::Node *decl) {
+    if (auto *funcDecl = ast::dyn_cast<ast::FunctionDecl>(decl)) {
+        declareFunction(funcDecl);
+        visitFunctionDecl(funcDecl);
+    } else if (auto *varDecl = ast::dyn_cast<ast::VarDecl>(decl)) {
+        visitVarDecl(varDecl);
+    }
+}
+
+std::string IRGenerator::finishModule() {
+    std::string ir = printModule();
+    
+    // Nothing may keep pointing into the old module
+    locals_.clear();
+    addressTaken_.clear();
+    currentDefs_.clear();
+    incompletePhis_.clear();
+    sealedBlocks_.clear();
+    globals_.clear();
+    loopStack_.clear();
+    liveAllocas_.clear();
+    scopeStarts_.clear();
+    allocaInsertPoint_ = nullptr;
+    currentFunction_ = nullptr;
+    startModule();
     
+    return ir;
+}
+
+std::string IRGenerator::printModule() {
     // Verify the module
     std::string error;
     llvm::raw_string_ostream errorStream(error);
@@ -39,62 +161,60 @@ std::string IRGenerator::generateIR(ast::TranslationUnit *tu) {
     return ir;
 }
 
-void IRGenerator::visitTranslationUnit(ast::TranslationUnit *tu) {
+llvm::Value* IRGenerator::visitTranslationUnit(ast::TranslationUnit *tu) {
     // First pass: Create function declarations (signatures only)
     for (const auto &decl : tu->declarations) {
-        if (auto *funcDecl = dynamic_cast<ast::FunctionDecl*>(decl.get())) {
-            createFunction(funcDecl->name, funcDecl->returnType, funcDecl->parameters);
+        if (auto *funcDecl = ast::dyn_cast<ast::FunctionDecl>(decl)) {
+            declareFunction(funcDecl);
         }
     }
     
     // Second pass: Generate function bodies and variable declarations
     for (const auto &decl : tu->declarations) {
-        if (auto *funcDecl = dynamic_cast<ast::FunctionDecl*>(decl.get())) {
-            visitFunctionDecl(funcDecl);
-        } else if (auto *varDecl = dynamic_cast<ast::VarDecl*>(decl.get())) {
-            visitVarDecl(varDecl);
-        }
+        visit(decl);
     }
+    return nullptr;
 }
 
-void IRGenerator::visitFunctionDecl(ast::FunctionDecl *func) {
+llvm::Value* IRGenerator::visitFunctionDecl(ast::FunctionDecl *func) {
     // Get the existing function declaration from first pass
-    llvm::Function *function = module_->getFunction(func->name);
-    if (!function) {
-        error("Function declaration not found: " + func->name);
-        return;
-    }
+    llvm::Function *function = getOrDeclareFunction(func->index);
     
     if (func->isDefinition()) {
         currentFunction_ = function;
+        currentReturnType_ = func->returnType;
         
         // Create entry basic block
         llvm::BasicBlock *entry = llvm::BasicBlock::Create(*context_, "entry", function);
         builder_->SetInsertPoint(entry);
+        allocaInsertPoint_ = nullptr;
+        currentDefs_.clear();
+        incompletePhis_.clear();
+        sealedBlocks_.clear();
+        sealBlock(entry);
         
-        // Clear previous function's named values
-        namedValues_.clear();
-        
-        // Add function parameters to symbol table
-        auto paramIt = func->parameters.begin();
+        // One slot per local; parameters take the first ones. Only locals
+        // whose address is taken need memory.
+        locals_.assign(func->numLocals, Local());
+        addressTaken_.assign(func->numLocals, false);
+        AddressTakenFinder(addressTaken_).visit(func->body);
         for (auto &arg : function->args()) {
-            if (paramIt != func->parameters.end()) {
-                arg.setName(paramIt->second);
-                namedValues_[paramIt->second] = &arg;
-                ++paramIt;
-            }
+            const auto &param = func->parameters[arg.getArgNo()];
+            arg.setName(param.second->getName());
+            declareLocal(arg.getArgNo(), param.second, param.first);
+            emitStore(getLocal(arg.getArgNo()), &arg);
         }
         
         // Generate function body
-        visitCompoundStmt(func->body.get());
+        visitCompoundStmt(func->body);
         // Ensure function is properly terminated
         if (!function->getReturnType()->isVoidTy()) {
-            if (!builder_->GetInsertBlock()->getTerminator()) {
+            if (!isTerminated()) {
                 // Insert default return 0 for non-void functions
-                builder_->CreateRet(llvm::ConstantInt::get(function->getReturnType(), 0));
+                builder_->CreateRet(llvm::Constant::getNullValue(function->getReturnType()));
             }
         } else {
-            if (!builder_->GetInsertBlock()->getTerminator()) {
+            if (!isTerminated()) {
                 builder_->CreateRetVoid();
             }
         }
@@ -106,118 +226,123 @@ void IRGenerator::visitFunctionDecl(ast::FunctionDecl *func) {
         }
         
         currentFunction_ = nullptr;
+        currentReturnType_ = nullptr;
     }
+    return function;
 }
 
-void IRGenerator::visitVarDecl(ast::VarDecl *var) {
+llvm::Value* IRGenerator::visitVarDecl(ast::VarDecl *var) {
     llvm::Type *type = getLLVMType(var->type);
-    int depth=0; for(char c: var->type) if(c=='*') depth++; pointerDepth_[var->name]=depth;
     if (currentFunction_) {
-        llvm::AllocaInst *alloca = builder_->CreateAlloca(type, nullptr, var->name);
-        namedValues_[var->name] = alloca;
+        llvm::AllocaInst *alloca = declareLocal(var->index, var->name, var->type);
+        if (alloca) {
+            builder_->CreateLifetimeStart(alloca);
+            liveAllocas_.push_back(alloca);
+        }
         if (var->initializer) {
-            llvm::Value *initValue = visitExpr(var->initializer.get());
-            builder_->CreateStore(initValue, alloca);
+            llvm::Value *initValue = visit(var->initializer);
+            emitStore(getLocal(var->index), convert(initValue, getType(var->initializer), var->type));
+        } else if (!alloca) {
+            // Indeterminate each time the declaration is reached
+            writeVariable(var->index, builder_->GetInsertBlock(), llvm::UndefValue::get(type));
         }
+        return alloca;
     } else {
         // Global variable
-        llvm::Constant *initializer = nullptr;
+        GlobalSymbol &symbol = recordGlobal(var->index);
+        symbol.name = var->name;
+        symbol.type = var->type;
+        llvm::Constant *initializer = llvm::Constant::getNullValue(type);
         if (var->initializer) {
-            // For now, only support constant initializers for globals
-            if (auto *intLit = dynamic_cast<ast::IntegerLiteral*>(var->initializer.get())) {
-                initializer = llvm::ConstantInt::get(type, intLit->value);
-            } else {
-                initializer = llvm::Constant::getNullValue(type);
-            }
-        } else {
-            initializer = llvm::Constant::getNullValue(type);
+            initializer = emitConstantInitializer(var, type);
         }
         
-        auto *globalVar = new llvm::GlobalVariable(
+        auto *global = new llvm::GlobalVariable(
             *module_, type, false, llvm::GlobalValue::ExternalLinkage,
-            initializer, var->name
+            initializer, var->name->getName()
         );
-        namedValues_[var->name] = globalVar;
+        getModuleGlobal(var->index) = global;
+        return global;
     }
 }
 
-int IRGenerator::computePointerDepth(ast::Expr *expr) {
-    if (auto *id = dynamic_cast<ast::Identifier*>(expr)) {
-        auto it = pointerDepth_.find(id->name); if(it!=pointerDepth_.end()) return it->second; return 0;
-    } else if (auto *un = dynamic_cast<ast::UnaryExpr*>(expr)) {
-        if (un->op == ast::UnaryExpr::OpKind::Dereference) {
-            // Dereference reduces depth by 1
-            int inner = computePointerDepth(un->operand.get());
-            return inner>0? inner-1 : 0;
-        } else if (un->op == ast::UnaryExpr::OpKind::AddressOf) {
-            int inner = computePointerDepth(un->operand.get());
-            return inner+1; // & increases depth
+llvm::Constant* IRGenerator::emitConstantInitializer(ast::VarDecl *var, llvm::Type *type) {
+    const ast::Type *varType = var->type->getUnqualifiedType();
+    std::string name(var->name->getName());
+    
+    if (auto *string = ast::dyn_cast<ast::StringLiteral>(var->initializer); string && varType->isPointer()) {
+        auto *data = llvm::ConstantDataArray::getString(*context_, string->value);
+        auto *storage = new llvm::GlobalVariable(*module_, data->getType(), true, llvm::GlobalValue::PrivateLinkage,
+                                                 data, ".str");
+        storage->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+        return storage;
+    }
+    
+    if (varType->isPointer()) {
+        // Only null pointer constants; addresses of objects are not supported yet
+        auto value = evaluator_.evaluate(var->initializer);
+        if (!value || value->isFloating() || !value->isZero()) {
+            error(var, "Initializer of global '" + name + "' is not a supported constant");
         }
+        return llvm::Constant::getNullValue(type);
     }
-    return 0;
+    
+    auto value = evaluator_.evaluateAs(var->initializer, varType);
+    if (!value) {
+        error(var, "Initializer of global '" + name + "' is not a constant: " + evaluator_.getFailureReason());
+    }
+    if (value->isFloating()) {
+        return llvm::ConstantFP::get(type, value->getFloatingValue());
+    }
+    return llvm::ConstantInt::get(type, value->getZExtValue());
 }
 
 llvm::Value* IRGenerator::visitStmt(ast::Stmt *stmt) {
-    if (auto *compoundStmt = dynamic_cast<ast::CompoundStmt*>(stmt)) {
-        return visitCompoundStmt(compoundStmt);
-    } else if (auto *exprStmt = dynamic_cast<ast::ExprStmt*>(stmt)) {
-        return visitExprStmt(exprStmt);
-    } else if (auto *returnStmt = dynamic_cast<ast::ReturnStmt*>(stmt)) {
-        return visitReturnStmt(returnStmt);
-    } else if (auto *ifStmt = dynamic_cast<ast::IfStmt*>(stmt)) {
-        return visitIfStmt(ifStmt);
-    } else if (auto *whileStmt = dynamic_cast<ast::WhileStmt*>(stmt)) {
-        return visitWhileStmt(whileStmt);
-    } else if (auto *forStmt = dynamic_cast<ast::ForStmt*>(stmt)) {
-        return visitForStmt(forStmt);
-    } else if (auto *varDecl = dynamic_cast<ast::VarDecl*>(stmt)) {
-        visitVarDecl(varDecl);
-        return nullptr;
-    } else if (auto *breakStmt = dynamic_cast<ast::BreakStmt*>(stmt)) {
-        return visitBreakStmt(breakStmt);
-    } else if (auto *continueStmt = dynamic_cast<ast::ContinueStmt*>(stmt)) {
-        return visitContinueStmt(continueStmt);
-    }
-    
-    error("Unsupported statement type");
+    error(stmt, "Unsupported statement type");
+    return nullptr;
+}
+
+llvm::Value* IRGenerator::visitNode(ast::Node *node) {
+    error(node, "Unsupported construct");
     return nullptr;
 }
 
 llvm::Value* IRGenerator::visitCompoundStmt(ast::CompoundStmt *stmt) {
     llvm::Value *lastValue = nullptr;
     
+    enterScope();
     for (const auto &s : stmt->statements) {
-        lastValue = visitStmt(s.get());
+        lastValue = visit(s);
+        if (isTerminated()) {
+            break; // without labels, nothing after a jump is reachable
+        }
     }
+    exitScope();
     
     return lastValue;
 }
 
 llvm::Value* IRGenerator::visitExprStmt(ast::ExprStmt *stmt) {
     if (stmt->expression) {
-        return visitExpr(stmt->expression.get());
+        return visit(stmt->expression);
     }
     return nullptr;
 }
 
 llvm::Value* IRGenerator::visitReturnStmt(ast::ReturnStmt *stmt) {
     if (stmt->expression) {
-        llvm::Value *retValue = visitExpr(stmt->expression.get());
-        return builder_->CreateRet(retValue);
+        llvm::Value *retValue = visit(stmt->expression);
+        if (currentReturnType_->isVoid()) {
+            return builder_->CreateRetVoid();
+        }
+        return builder_->CreateRet(convert(retValue, getType(stmt->expression), currentReturnType_));
     } else {
         return builder_->CreateRetVoid();
     }
 }
 
 llvm::Value* IRGenerator::visitIfStmt(ast::IfStmt *stmt) {
-    llvm::Value *condValue = visitExpr(stmt->condition.get());
-    // Normalize boolean sized integers
-    if (condValue->getType()->isIntegerTy(1)) {
-        // Already i1, use directly
-    } else if (condValue->getType()->isIntegerTy()) {
-        condValue = builder_->CreateICmpNE(condValue, llvm::ConstantInt::get(condValue->getType(), 0), "ifcondnorm");
-    }
-    // Convert condition to boolean (now condValue should be i1)
+    llvm::Value *condValue = toBool(visit(stmt->condition));
     llvm::Function *function = builder_->GetInsertBlock()->getParent();
     llvm::BasicBlock *thenBlock = llvm::BasicBlock::Create(*context_, "then", function);
     llvm::BasicBlock *elseBlock = stmt->elseStmt ? llvm::BasicBlock::Create(*context_, "else") : nullptr;
@@ -228,20 +353,23 @@ llvm::Value* IRGenerator::visitIfStmt(ast::IfStmt *stmt) {
         builder_->CreateCondBr(condValue, thenBlock, mergeBlock);
     }
     builder_->SetInsertPoint(thenBlock);
-    visitStmt(stmt->thenStmt.get());
-    if (!thenBlock->getTerminator()) {
+    sealBlock(thenBlock);
+    visit(stmt->thenStmt);
+    if (!isTerminated()) {
         builder_->CreateBr(mergeBlock);
     }
     if (elseBlock) {
         function->insert(function->end(), elseBlock);
         builder_->SetInsertPoint(elseBlock);
-        visitStmt(stmt->elseStmt.get());
-        if (!elseBlock->getTerminator()) {
+        sealBlock(elseBlock);
+        visit(stmt->elseStmt);
+        if (!isTerminated()) {
             builder_->CreateBr(mergeBlock);
         }
     }
     function->insert(function->end(), mergeBlock);
     builder_->SetInsertPoint(mergeBlock);
+    sealBlock(mergeBlock);
     return nullptr;
 }
 
@@ -252,28 +380,31 @@ llvm::Value* IRGenerator::visitWhileStmt(ast::WhileStmt *stmt) {
     llvm::BasicBlock *afterBlock = llvm::BasicBlock::Create(*context_, "afterloop", function);
     
     // Push loop context for break/continue
-    loopStack_.push_back({loopBlock, afterBlock}); // continue goes to loop condition, break goes to after
+    loopStack_.push_back({loopBlock, afterBlock, liveAllocas_.size()}); // continue goes to loop condition, break goes to after
     
+    llvm::BasicBlock *preheader = builder_->GetInsertBlock();
     builder_->CreateBr(loopBlock);
     builder_->SetInsertPoint(loopBlock);
     
-    llvm::Value *condValue = visitExpr(stmt->condition.get());
-    condValue = builder_->CreateICmpNE(condValue, 
-        llvm::ConstantInt::get(*context_, llvm::APInt(32, 0)), "loopcond");
+    llvm::Value *condValue = toBool(visit(stmt->condition));
     
     builder_->CreateCondBr(condValue, bodyBlock, afterBlock);
     
     builder_->SetInsertPoint(bodyBlock);
-    visitStmt(stmt->body.get());
+    sealBlock(bodyBlock);
+    visit(stmt->body);
     // Only add branch if the block is not already terminated (in case of break/continue)
-    if (!bodyBlock->getTerminator()) {
+    if (!isTerminated()) {
         builder_->CreateBr(loopBlock);
     }
+    sealBlock(loopBlock); // the back edges are known now
+    addLoopMetadata(loopBlock, preheader, stmt->condition, stmt->hints);
     
     // Pop loop context
     loopStack_.pop_back();
     
     builder_->SetInsertPoint(afterBlock);
+    sealBlock(afterBlock);
     
     return nullptr;
 }
@@ -292,26 +423,23 @@ llvm::Value* IRGenerator::visitForStmt(ast::ForStmt *stmt) {
     llvm::BasicBlock *incrementBlock = llvm::BasicBlock::Create(*context_, "for.inc", function);
     llvm::BasicBlock *afterBlock = llvm::BasicBlock::Create(*context_, "for.end", function);
     
-    // Generate initialization code
+    // Generate initialization code; a declaration there lives until the loop ends
+    enterScope();
     if (stmt->init) {
-        visitStmt(stmt->init.get());
+        visit(stmt->init);
     }
     
     // Push loop context for break/continue (continue goes to increment, break goes to after)
-    loopStack_.push_back({incrementBlock, afterBlock});
+    loopStack_.push_back({incrementBlock, afterBlock, liveAllocas_.size()});
     
     // Jump to loop condition check
+    llvm::BasicBlock *preheader = builder_->GetInsertBlock();
     builder_->CreateBr(loopBlock);
     
     // Generate loop condition block
     builder_->SetInsertPoint(loopBlock);
     if (stmt->condition) {
-        llvm::Value *condValue = visitExpr(stmt->condition.get());
-        // Convert to boolean if needed
-        if (condValue->getType()->isIntegerTy() && condValue->getType()->getIntegerBitWidth() != 1) {
-            condValue = builder_->CreateICmpNE(condValue, 
-                llvm::ConstantInt::get(condValue->getType(), 0), "for.cond");
-        }
+        llvm::Value *condValue = toBool(visit(stmt->condition));
         builder_->CreateCondBr(condValue, bodyBlock, afterBlock);
     } else {
         // No condition means infinite loop (until break)
@@ -320,68 +448,54 @@ llvm::Value* IRGenerator::visitForStmt(ast::ForStmt *stmt) {
     
     // Generate loop body
     builder_->SetInsertPoint(bodyBlock);
+    sealBlock(bodyBlock);
     if (stmt->body) {
-        visitStmt(stmt->body.get());
+        visit(stmt->body);
     }
     
     // Only jump to increment if not already terminated (break/continue)
-    if (!bodyBlock->getTerminator()) {
+    if (!isTerminated()) {
         builder_->CreateBr(incrementBlock);
     }
     
     // Generate increment block
     builder_->SetInsertPoint(incrementBlock);
+    sealBlock(incrementBlock);
     if (stmt->increment) {
-        visitExpr(stmt->increment.get());
+        visit(stmt->increment);
     }
     
     // Jump back to condition check
     builder_->CreateBr(loopBlock);
+    sealBlock(loopBlock);
+    addLoopMetadata(loopBlock, preheader, stmt->condition, stmt->hints);
     
     // Pop loop context
     loopStack_.pop_back();
     
     // Continue with code after the loop
     builder_->SetInsertPoint(afterBlock);
+    sealBlock(afterBlock);
+    exitScope();
     
     return nullptr;
 }
 
 llvm::Value* IRGenerator::visitExpr(ast::Expr *expr) {
-    if (auto *intLit = dynamic_cast<ast::IntegerLiteral*>(expr)) {
-        return visitIntegerLiteral(intLit);
-    } else if (auto *floatLit = dynamic_cast<ast::FloatingLiteral*>(expr)) {
-        return visitFloatingLiteral(floatLit);
-    } else if (auto *charLit = dynamic_cast<ast::CharacterLiteral*>(expr)) {
-        return visitCharacterLiteral(charLit);
-    } else if (auto *strLit = dynamic_cast<ast::StringLiteral*>(expr)) {
-        return visitStringLiteral(strLit);
-    } else if (auto *id = dynamic_cast<ast::Identifier*>(expr)) {
-        return visitIdentifier(id);
-    } else if (auto *binExpr = dynamic_cast<ast::BinaryExpr*>(expr)) {
-        return visitBinaryExpr(binExpr);
-    } else if (auto *unaryExpr = dynamic_cast<ast::UnaryExpr*>(expr)) {
-        return visitUnaryExpr(unaryExpr);
-    } else if (auto *callExpr = dynamic_cast<ast::CallExpr*>(expr)) {
-        return visitCallExpr(callExpr);
-    } else if (auto *condExpr = dynamic_cast<ast::ConditionalExpr*>(expr)) {
-        return visitConditionalExpr(condExpr);
-    }
-    
-    error("Unsupported expression type");
+    error(expr, "Unsupported expression type");
     return nullptr;
 }
 
 llvm::Value* IRGenerator::visitIntegerLiteral(ast::IntegerLiteral *lit) {
-    return llvm::ConstantInt::get(*context_, llvm::APInt(32, lit->value));
+    return llvm::ConstantInt::get(getLLVMType(getType(lit)), lit->value, true);
 }
 
 llvm::Value* IRGenerator::visitFloatingLiteral(ast::FloatingLiteral *lit) {
-    return llvm::ConstantFP::get(*context_, llvm::APFloat(lit->value));
+    return llvm::ConstantFP::get(getLLVMType(getType(lit)), lit->value);
 }
 
 llvm::Value* IRGenerator::visitCharacterLiteral(ast::CharacterLiteral *lit) {
-    return llvm::ConstantInt::get(*context_, llvm::APInt(8, lit->value));
+    return llvm::ConstantInt::get(getLLVMType(getType(lit)), lit->value, true);
 }
 
 llvm::Value* IRGenerator::visitStringLiteral(ast::StringLiteral *lit) {
@@ -389,138 +503,169 @@ llvm::Value* IRGenerator::visitStringLiteral(ast::StringLiteral *lit) {
 }
 
 llvm::Value* IRGenerator::visitIdentifier(ast::Identifier *id) {
-    llvm::Value *ptr = namedValues_[id->name];
-    if(!ptr) {
-        // Fallback: treat identifier as function symbol
-        if (auto *fn = module_->getFunction(id->name)) {
-            return fn; // function pointer usable for direct call via CallExpr elsewhere
+    switch (id->binding) {
+        case ast::Identifier::BindingKind::Local:
+            if (getType(id)->isArray()) {
+                return emitAddress(id); // arrays decay to a pointer to their first element
+            }
+            return emitLoad(getLocal(id->index), id->name->getName());
+        case ast::Identifier::BindingKind::Global: {
+            llvm::GlobalVariable *global = getOrDeclareGlobal(id->index);
+            if (getType(id)->isArray()) {
+                return global;
+            }
+            return createLoad(getType(id), global, id->name->getName());
         }
-        error("Unknown variable name: "+id->name); return nullptr;
-    }
-    if (auto *ai = llvm::dyn_cast<llvm::AllocaInst>(ptr)) {
-        return builder_->CreateLoad(ai->getAllocatedType(), ptr, id->name);
+        case ast::Identifier::BindingKind::Function:
+            return getOrDeclareFunction(id->index); // function pointer usable for direct call via CallExpr elsewhere
+        case ast::Identifier::BindingKind::Unbound:
+            break;
     }
-    return ptr;
+    error(id, "Unbound identifier: " + std::string(id->name->getName()));
+    return nullptr;
 }
 
 llvm::Value* IRGenerator::emitAddress(ast::Expr *expr) {
-    if (auto *id = dynamic_cast<ast::Identifier*>(expr)) {
-        auto it = namedValues_.find(id->name);
-        if (it!=namedValues_.end()) return it->second;
-        error("Unknown variable name: "+id->name); return nullptr;
-    } else if (auto *un = dynamic_cast<ast::UnaryExpr*>(expr)) {
+    if (auto *id = ast::dyn_cast<ast::Identifier>(expr)) {
+        if (id->binding == ast::Identifier::BindingKind::Local) {
+            if (!locals_[id->index].alloca) {
+                error(id, "Address of register variable: " + std::string(id->name->getName()));
+            }
+            return locals_[id->index].alloca;
+        }
+        if (id->binding == ast::Identifier::BindingKind::Global) return getOrDeclareGlobal(id->index);
+        error(id, "Not a variable: " + std::string(id->name->getName())); return nullptr;
+    } else if (auto *un = ast::dyn_cast<ast::UnaryExpr>(expr)) {
         if (un->op == ast::UnaryExpr::OpKind::Dereference) {
             // Address of *E is the value of E (a pointer)
-            llvm::Value *v = visitExpr(un->operand.get());
-            if(!v || !v->getType()->isPointerTy()) { error("Dereference of non-pointer type"); return nullptr; }
+            llvm::Value *v = visit(un->operand);
+            if(!v || !v->getType()->isPointerTy()) { error(un, "Dereference of non-pointer type"); return nullptr; }
             return v;
         }
+    } else if (auto *subscript = ast::dyn_cast<ast::ArraySubscriptExpr>(expr)) {
+        // E1[E2] is *(E1 + E2), so either operand may be the pointer
+        llvm::Value *base = visit(subscript->array);
+        llvm::Value *index = visit(subscript->index);
+        const ast::Type *baseType = getType(subscript->array);
+        const ast::Type *indexType = getType(subscript->index);
+        if (!isPointerOperand(baseType)) {
+            std::swap(base, index);
+            std::swap(baseType, indexType);
+        }
+        return emitPointerOffset(base, baseType, index, indexType, false);
     }
-    error("Not an lvalue expression"); return nullptr;
-}
-llvm::Value* IRGenerator::loadIdentifier(const std::string &name) {
-    auto it = namedValues_.find(name); if(it==namedValues_.end()) return nullptr;
-    llvm::Value *allocaPtr = it->second;
-    if (auto *ai = llvm::dyn_cast<llvm::AllocaInst>(allocaPtr)) {
-        return builder_->CreateLoad(ai->getAllocatedType(), allocaPtr, name);
-    }
-    return allocaPtr;
+    error(expr, "Not an lvalue expression"); return nullptr;
 }
 
 llvm::Value* IRGenerator::visitUnaryExpr(ast::UnaryExpr *expr) {
     switch (expr->op) {
+        case ast::UnaryExpr::OpKind::Sizeof:
+            // The operand is not evaluated, only its type matters
+            return llvm::ConstantInt::get(getLLVMType(getType(expr)), getType(expr->operand)->getSize());
         case ast::UnaryExpr::OpKind::AddressOf: {
-            return emitAddress(expr->operand.get());
+            return emitAddress(expr->operand);
         }
         case ast::UnaryExpr::OpKind::Dereference: {
-            int operandDepth = computePointerDepth(expr->operand.get());
-            if (operandDepth == 0) { error("Dereference of non-pointer type"); return nullptr; }
-            int resultDepth = operandDepth - 1;
-            llvm::Value *operandVal = emitAddress(expr->operand.get());
-            if (!operandVal || !operandVal->getType()->isPointerTy()) { error("Dereference of non-pointer type"); return nullptr; }
-            if (resultDepth > 0) {
-                llvm::Type *ptrTy = llvm::PointerType::get(*context_, 0);
-                return builder_->CreateLoad(ptrTy, operandVal, "derefptr");
-            } else {
-                llvm::Type *intTy = llvm::Type::getInt32Ty(*context_);
-                return builder_->CreateLoad(intTy, operandVal, "derefval");
+            llvm::Value *address = emitAddress(expr);
+            if (!address) return nullptr;
+            if (getType(expr)->isArray()) {
+                return address;
             }
+            return createLoad(getType(expr), address, "derefval");
         }
         case ast::UnaryExpr::OpKind::PreIncrement:
         case ast::UnaryExpr::OpKind::PreDecrement:
         case ast::UnaryExpr::OpKind::PostIncrement:
         case ast::UnaryExpr::OpKind::PostDecrement: {
-            // Support only integer variables for now
-            llvm::Value *addr = emitAddress(expr->operand.get());
-            if(!addr) return nullptr;
-            llvm::Type *valTy = llvm::Type::getInt32Ty(*context_);
-            llvm::Value *oldVal = builder_->CreateLoad(valTy, addr, "oldinc");
-            llvm::Value *one = llvm::ConstantInt::get(valTy, 1);
+            LValue lvalue = emitLValue(expr->operand);
+            const ast::Type *type = getType(expr);
+            llvm::Type *valTy = getLLVMType(type);
+            llvm::Value *oldVal = emitLoad(lvalue, "oldinc");
             bool isInc = (expr->op==ast::UnaryExpr::OpKind::PreIncrement || expr->op==ast::UnaryExpr::OpKind::PostIncrement);
-            llvm::Value *newVal = isInc ? builder_->CreateAdd(oldVal, one, "inc") : builder_->CreateSub(oldVal, one, "dec");
-            builder_->CreateStore(newVal, addr);
+            llvm::Value *newVal;
+            if (type->isPointer()) {
+                llvm::Value *step = llvm::ConstantInt::get(llvm::Type::getInt64Ty(*context_), isInc ? 1 : -1, true);
+                newVal = builder_->CreateInBoundsGEP(getElementType(type), oldVal, step, "incdec.ptr");
+            } else if (valTy->isFloatingPointTy()) {
+                llvm::Value *one = llvm::ConstantFP::get(valTy, 1.0);
+                newVal = isInc ? builder_->CreateFAdd(oldVal, one, "inc") : builder_->CreateFSub(oldVal, one, "dec");
+            } else {
+                // Narrower types are promoted, so only int and wider can overflow
+                llvm::Value *one = llvm::ConstantInt::get(valTy, 1);
+                bool nsw = hasUndefinedOverflow(type);
+                newVal = isInc ? builder_->CreateAdd(oldVal, one, "inc", false, nsw)
+                               : builder_->CreateSub(oldVal, one, "dec", false, nsw);
+            }
+            emitStore(lvalue, newVal);
             // Pre returns new, post returns old
             bool isPost = (expr->op==ast::UnaryExpr::OpKind::PostIncrement || expr->op==ast::UnaryExpr::OpKind::PostDecrement);
             return isPost ? oldVal : newVal;
         }
         case ast::UnaryExpr::OpKind::Plus: {
-            llvm::Value *v = visitExpr(expr->operand.get());
-            return v;
+            // Only the integer promotion
+            return convert(visit(expr->operand), getType(expr->operand), getType(expr));
         }
         case ast::UnaryExpr::OpKind::Minus: {
-            llvm::Value *v = visitExpr(expr->operand.get());
-            return builder_->CreateNeg(v, "negtmp");
+            llvm::Value *v = convert(visit(expr->operand), getType(expr->operand), getType(expr));
+            if (v->getType()->isFloatingPointTy()) {
+                return builder_->CreateFNeg(v, "negtmp");
+            }
+            return builder_->CreateNeg(v, "negtmp", false, hasUndefinedOverflow(getType(expr)));
         }
         case ast::UnaryExpr::OpKind::Not: {
-            llvm::Value *v = visitExpr(expr->operand.get());
-            return builder_->CreateNot(v, "nottmp");
+            llvm::Value *v = toBool(visit(expr->operand));
+            return builder_->CreateZExt(builder_->CreateNot(v, "nottmp"), getLLVMType(getType(expr)), "notext");
         }
         case ast::UnaryExpr::OpKind::BitwiseNot: {
-            llvm::Value *v = visitExpr(expr->operand.get());
+            llvm::Value *v = convert(visit(expr->operand), getType(expr->operand), getType(expr));
             return builder_->CreateNot(v, "nottmp");
         }
         default:
-            error("Unsupported unary operator");
+            error(expr, "Unsupported unary operator");
             return nullptr;
     }
 }
 
 llvm::Value* IRGenerator::visitBinaryExpr(ast::BinaryExpr *expr) {
     if (expr->op == ast::BinaryExpr::OpKind::Assign) {
-        llvm::Value *rhs = visitExpr(expr->right.get());
-        llvm::Value *lhsAddr = emitAddress(expr->left.get());
-        if(!lhsAddr) return nullptr;
-        builder_->CreateStore(rhs, lhsAddr);
+        llvm::Value *rhs = visit(expr->right);
+        LValue lhs = emitLValue(expr->left);
+        rhs = convert(rhs, getType(expr->right), getType(expr));
+        emitStore(lhs, rhs);
         return rhs;
     }
     // Compound assignments
     if (expr->op == ast::BinaryExpr::OpKind::AddAssign || expr->op == ast::BinaryExpr::OpKind::SubAssign ||
         expr->op == ast::BinaryExpr::OpKind::MulAssign || expr->op == ast::BinaryExpr::OpKind::DivAssign ||
         expr->op == ast::BinaryExpr::OpKind::ModAssign) {
-        llvm::Value *lhsAddr = emitAddress(expr->left.get());
-        if(!lhsAddr) return nullptr;
-        llvm::Value *lhsVal = visitExpr(expr->left.get()); // loads
-        llvm::Value *rhsVal = visitExpr(expr->right.get());
-        llvm::Value *result=nullptr;
-        switch(expr->op){
-            case ast::BinaryExpr::OpKind::AddAssign: result=builder_->CreateAdd(lhsVal,rhsVal,"addeq"); break;
-            case ast::BinaryExpr::OpKind::SubAssign: result=builder_->CreateSub(lhsVal,rhsVal,"subeq"); break;
-            case ast::BinaryExpr::OpKind::MulAssign: result=builder_->CreateMul(lhsVal,rhsVal,"muleq"); break;
-            case ast::BinaryExpr::OpKind::DivAssign: result=builder_->CreateSDiv(lhsVal,rhsVal,"diveq"); break;
-            case ast::BinaryExpr::OpKind::ModAssign: result=builder_->CreateSRem(lhsVal,rhsVal,"modeq"); break;
-            default: break;
-        }
-        builder_->CreateStore(result,lhsAddr);
+        LValue lhs = emitLValue(expr->left);
+        const ast::Type *lhsType = getType(expr);
+        llvm::Value *lhsVal = emitLoad(lhs, "compound");
+        llvm::Value *rhsVal = visit(expr->right);
+        if (!expr->operandType) {
+            // Sema lets only pointer += and -= through without an operand type
+            llvm::Value *result = emitPointerOffset(lhsVal, lhsType, rhsVal, getType(expr->right),
+                                                    expr->op == ast::BinaryExpr::OpKind::SubAssign);
+            emitStore(lhs, result);
+            return result;
+        }
+        // E1 op= E2 is E1 = E1 op E2 with E1 evaluated once
+        lhsVal = convert(lhsVal, lhsType, expr->operandType);
+        rhsVal = convert(rhsVal, getType(expr->right), expr->operandType);
+        static constexpr ast::BinaryExpr::OpKind Operators[] = {
+            ast::BinaryExpr::OpKind::Add, ast::BinaryExpr::OpKind::Sub, ast::BinaryExpr::OpKind::Mul,
+            ast::BinaryExpr::OpKind::Div, ast::BinaryExpr::OpKind::Mod
+        };
+        auto op = Operators[static_cast<int>(expr->op) - static_cast<int>(ast::BinaryExpr::OpKind::AddAssign)];
+        llvm::Value *result = convert(emitArithmetic(op, lhsVal, rhsVal, expr->operandType), expr->operandType, lhsType);
+        emitStore(lhs, result);
         return result;
     }
     // Short-circuit logical AND / OR
     if (expr->op == ast::BinaryExpr::OpKind::LogicalAnd || expr->op == ast::BinaryExpr::OpKind::LogicalOr) {
         llvm::Function *function = builder_->GetInsertBlock()->getParent();
-        llvm::BasicBlock *lhsBlock = builder_->GetInsertBlock();
-        llvm::Value *lhsVal = visitExpr(expr->left.get());
-        // Convert to i1 if needed
-        if(lhsVal->getType()->isIntegerTy() && lhsVal->getType()->getIntegerBitWidth()!=1)
-            lhsVal = builder_->CreateICmpNE(lhsVal, llvm::ConstantInt::get(lhsVal->getType(),0), "lhsbool");
+        llvm::Value *lhsVal = toBool(visit(expr->left));
+        llvm::BasicBlock *lhsBlock = builder_->GetInsertBlock(); // after any blocks the left side made
         llvm::BasicBlock *rhsBlock = llvm::BasicBlock::Create(*context_, expr->op==ast::BinaryExpr::OpKind::LogicalAnd?"and.rhs":"or.rhs", function);
         llvm::BasicBlock *mergeBlock = llvm::BasicBlock::Create(*context_, expr->op==ast::BinaryExpr::OpKind::LogicalAnd?"and.merge":"or.merge");
         if (expr->op == ast::BinaryExpr::OpKind::LogicalAnd) {
@@ -530,14 +675,14 @@ llvm::Value* IRGenerator::visitBinaryExpr(ast::BinaryExpr *expr) {
         }
         // RHS
         builder_->SetInsertPoint(rhsBlock);
-        llvm::Value *rhsVal = visitExpr(expr->right.get());
-        if(rhsVal->getType()->isIntegerTy() && rhsVal->getType()->getIntegerBitWidth()!=1)
-            rhsVal = builder_->CreateICmpNE(rhsVal, llvm::ConstantInt::get(rhsVal->getType(),0), "rhsbool");
+        sealBlock(rhsBlock);
+        llvm::Value *rhsVal = toBool(visit(expr->right));
         builder_->CreateBr(mergeBlock);
         rhsBlock = builder_->GetInsertBlock();
         // Merge
         function->insert(function->end(), mergeBlock);
         builder_->SetInsertPoint(mergeBlock);
+        sealBlock(mergeBlock);
         llvm::PHINode *phi = builder_->CreatePHI(llvm::Type::getInt1Ty(*context_), 2, expr->op==ast::BinaryExpr::OpKind::LogicalAnd?"andphi":"orphi");
         if (expr->op == ast::BinaryExpr::OpKind::LogicalAnd) {
             phi->addIncoming(rhsVal, rhsBlock);
@@ -546,67 +691,174 @@ llvm::Value* IRGenerator::visitBinaryExpr(ast::BinaryExpr *expr) {
             phi->addIncoming(llvm::ConstantInt::getTrue(*context_), lhsBlock);
             phi->addIncoming(rhsVal, rhsBlock);
         }
-        // Extend to int32 like other comparisons
-        return builder_->CreateZExt(phi, llvm::Type::getInt32Ty(*context_), "logicext");
+        // The result is an int, like other comparisons
+        return builder_->CreateZExt(phi, getLLVMType(getType(expr)), "logicext");
     }
-    llvm::Value *left = visitExpr(expr->left.get());
-    llvm::Value *right = visitExpr(expr->right.get());
+    llvm::Value *left = visit(expr->left);
+    llvm::Value *right = visit(expr->right);
     if(!left || !right) return nullptr;
-    switch (expr->op) {
-        case ast::BinaryExpr::OpKind::Add: return builder_->CreateAdd(left,right,"addtmp");
-        case ast::BinaryExpr::OpKind::Sub: return builder_->CreateSub(left,right,"subtmp");
-        case ast::BinaryExpr::OpKind::Mul: return builder_->CreateMul(left,right,"multmp");
-        case ast::BinaryExpr::OpKind::Div: return builder_->CreateSDiv(left,right,"divtmp");
-        case ast::BinaryExpr::OpKind::Mod: return builder_->CreateSRem(left,right,"modtmp");
-        case ast::BinaryExpr::OpKind::LT: { auto *cmp=builder_->CreateICmpSLT(left,right,"cmptmp"); return builder_->CreateZExt(cmp, llvm::Type::getInt32Ty(*context_),"booltmp"); }
-        case ast::BinaryExpr::OpKind::GT: { auto *cmp=builder_->CreateICmpSGT(left,right,"cmptmp"); return builder_->CreateZExt(cmp, llvm::Type::getInt32Ty(*context_),"booltmp"); }
-        case ast::BinaryExpr::OpKind::LE: { auto *cmp=builder_->CreateICmpSLE(left,right,"cmptmp"); return builder_->CreateZExt(cmp, llvm::Type::getInt32Ty(*context_),"booltmp"); }
-        case ast::BinaryExpr::OpKind::GE: { auto *cmp=builder_->CreateICmpSGE(left,right,"cmptmp"); return builder_->CreateZExt(cmp, llvm::Type::getInt32Ty(*context_),"booltmp"); }
-        case ast::BinaryExpr::OpKind::EQ: { auto *cmp=builder_->CreateICmpEQ(left,right,"cmptmp"); return builder_->CreateZExt(cmp, llvm::Type::getInt32Ty(*context_),"booltmp"); }
-        case ast::BinaryExpr::OpKind::NE: { auto *cmp=builder_->CreateICmpNE(left,right,"cmptmp"); return builder_->CreateZExt(cmp, llvm::Type::getInt32Ty(*context_),"booltmp"); }
+    bool isComparison = expr->op >= ast::BinaryExpr::OpKind::LT && expr->op <= ast::BinaryExpr::OpKind::NE;
+    bool isUnsigned;
+    if (const ast::Type *operandType = expr->operandType) {
+        left = convert(left, getType(expr->left), operandType);
+        right = convert(right, getType(expr->right), operandType);
+        isUnsigned = operandType->isUnsignedInteger();
+    } else if (isComparison) {
+        // Pointers, or a pointer and a null pointer constant; addresses are unsigned
+        llvm::Type *ptrTy = llvm::PointerType::get(*context_, 0);
+        left = convert(left, ptrTy);
+        right = convert(right, ptrTy);
+        isUnsigned = true;
+    } else {
+        return emitPointerArithmetic(expr, left, right);
+    }
+    if (isComparison) {
+        bool isFloating = left->getType()->isFloatingPointTy();
+        llvm::CmpInst::Predicate predicate;
+        switch (expr->op) {
+            case ast::BinaryExpr::OpKind::LT:
+                predicate = isFloating ? llvm::CmpInst::FCMP_OLT : isUnsigned ? llvm::CmpInst::ICMP_ULT : llvm::CmpInst::ICMP_SLT;
+                break;
+            case ast::BinaryExpr::OpKind::GT:
+                predicate = isFloating ? llvm::CmpInst::FCMP_OGT : isUnsigned ? llvm::CmpInst::ICMP_UGT : llvm::CmpInst::ICMP_SGT;
+                break;
+            case ast::BinaryExpr::OpKind::LE:
+                predicate = isFloating ? llvm::CmpInst::FCMP_OLE : isUnsigned ? llvm::CmpInst::ICMP_ULE : llvm::CmpInst::ICMP_SLE;
+                break;
+            case ast::BinaryExpr::OpKind::GE:
+                predicate = isFloating ? llvm::CmpInst::FCMP_OGE : isUnsigned ? llvm::CmpInst::ICMP_UGE : llvm::CmpInst::ICMP_SGE;
+                break;
+            case ast::BinaryExpr::OpKind::EQ:
+                predicate = isFloating ? llvm::CmpInst::FCMP_OEQ : llvm::CmpInst::ICMP_EQ;
+                break;
+            default:
+                predicate = isFloating ? llvm::CmpInst::FCMP_UNE : llvm::CmpInst::ICMP_NE;
+                break;
+        }
+        llvm::Value *cmp = builder_->CreateCmp(predicate, left, right, "cmptmp");
+        return builder_->CreateZExt(cmp, getLLVMType(getType(expr)), "booltmp");
+    }
+    return emitArithmetic(expr->op, left, right, expr->operandType);
+}
+
+llvm::Value* IRGenerator::emitArithmetic(ast::BinaryExpr::OpKind op, llvm::Value *left, llvm::Value *right,
+                                         const ast::Type *type) {
+    if (type->isFloating()) {
+        switch (op) {
+            case ast::BinaryExpr::OpKind::Add: return builder_->CreateFAdd(left,right,"addtmp");
+            case ast::BinaryExpr::OpKind::Sub: return builder_->CreateFSub(left,right,"subtmp");
+            case ast::BinaryExpr::OpKind::Mul: return builder_->CreateFMul(left,right,"multmp");
+            case ast::BinaryExpr::OpKind::Div: return builder_->CreateFDiv(left,right,"divtmp");
+            case ast::BinaryExpr::OpKind::Mod: return builder_->CreateFRem(left,right,"modtmp");
+            default: error(nullptr, "Invalid operands to binary operator"); return nullptr;
+        }
+    }
+    bool isUnsigned = type->isUnsignedInteger();
+    bool nsw = hasUndefinedOverflow(type);
+    switch (op) {
+        case ast::BinaryExpr::OpKind::Add: return builder_->CreateAdd(left,right,"addtmp",false,nsw);
+        case ast::BinaryExpr::OpKind::Sub: return builder_->CreateSub(left,right,"subtmp",false,nsw);
+        case ast::BinaryExpr::OpKind::Mul: return builder_->CreateMul(left,right,"multmp",false,nsw);
+        case ast::BinaryExpr::OpKind::Div:
+            return isUnsigned ? builder_->CreateUDiv(left,right,"divtmp") : builder_->CreateSDiv(left,right,"divtmp");
+        case ast::BinaryExpr::OpKind::Mod:
+            return isUnsigned ? builder_->CreateURem(left,right,"modtmp") : builder_->CreateSRem(left,right,"modtmp");
         case ast::BinaryExpr::OpKind::BitwiseAnd: return builder_->CreateAnd(left,right,"andtmp");
         case ast::BinaryExpr::OpKind::BitwiseOr: return builder_->CreateOr(left,right,"ortmp");
         case ast::BinaryExpr::OpKind::BitwiseXor: return builder_->CreateXor(left,right,"xortmp");
-        case ast::BinaryExpr::OpKind::LeftShift: return builder_->CreateShl(left,right,"shltmp");
-        case ast::BinaryExpr::OpKind::RightShift: return builder_->CreateAShr(left,right,"shrtmp");
-        default: error("Unsupported binary operator"); return nullptr;
+        case ast::BinaryExpr::OpKind::LeftShift: return builder_->CreateShl(left,right,"shltmp",false,nsw);
+        case ast::BinaryExpr::OpKind::RightShift:
+            return isUnsigned ? builder_->CreateLShr(left,right,"shrtmp") : builder_->CreateAShr(left,right,"shrtmp");
+        default: error(nullptr, "Unsupported binary operator"); return nullptr;
     }
 }
 
+llvm::Value* IRGenerator::emitPointerArithmetic(ast::BinaryExpr *expr, llvm::Value *left, llvm::Value *right) {
+    const ast::Type *leftType = getType(expr->left);
+    const ast::Type *rightType = getType(expr->right);
+    if (isPointerOperand(leftType) && isPointerOperand(rightType)) {
+        // The difference counts elements; both pointers point into the same
+        // array, so the byte difference divides exactly
+        llvm::Type *intPtrTy = llvm::Type::getInt64Ty(*context_);
+        llvm::Value *diff = builder_->CreateSub(builder_->CreatePtrToInt(left, intPtrTy, "sub.ptr.lhs"),
+                                                builder_->CreatePtrToInt(right, intPtrTy, "sub.ptr.rhs"), "sub.ptr.sub");
+        uint64_t size = getElementSize(leftType);
+        if (size == 1) {
+            return diff;
+        }
+        return builder_->CreateExactSDiv(diff, llvm::ConstantInt::get(intPtrTy, size), "sub.ptr.div");
+    }
+    if (isPointerOperand(rightType)) {
+        return emitPointerOffset(right, rightType, left, leftType, false); // integer + pointer
+    }
+    return emitPointerOffset(left, leftType, right, rightType, expr->op == ast::BinaryExpr::OpKind::Sub);
+}
+
+llvm::Value* IRGenerator::emitPointerOffset(llvm::Value *pointer, const ast::Type *pointerType, llvm::Value *offset,
+                                            const ast::Type *offsetType, bool subtract) {
+    // Offsets are pointer-sized; unsigned ones zero-extend
+    llvm::Type *intPtrTy = llvm::Type::getInt64Ty(*context_);
+    offset = offsetType->isSignedInteger() ? builder_->CreateSExtOrTrunc(offset, intPtrTy, "idx.ext")
+                                           : builder_->CreateZExtOrTrunc(offset, intPtrTy, "idx.ext");
+    if (subtract) {
+        offset = builder_->CreateNeg(offset, "idx.neg");
+    }
+    return builder_->CreateInBoundsGEP(getElementType(pointerType), pointer, offset, "add.ptr");
+}
+
+llvm::Type* IRGenerator::getElementType(const ast::Type *pointerType) {
+    const ast::Type *type = pointerType->getUnqualifiedType();
+    const ast::Type *element = type->isArray() ? ast::cast<ast::ArrayType>(type)->getElementType()
+                                               : ast::cast<ast::PointerType>(type)->getPointeeType();
+    // As in GNU C, void and function pointers step by bytes
+    if (element->isVoid() || element->isFunction()) {
+        return llvm::Type::getInt8Ty(*context_);
+    }
+    return getLLVMType(element);
+}
+
+uint64_t IRGenerator::getElementSize(const ast::Type *pointerType) {
+    const ast::Type *type = pointerType->getUnqualifiedType();
+    const ast::Type *element = type->isArray() ? ast::cast<ast::ArrayType>(type)->getElementType()
+                                               : ast::cast<ast::PointerType>(type)->getPointeeType();
+    return element->isFunction() ? 1 : element->getSize();
+}
+
 llvm::Value* IRGenerator::visitCallExpr(ast::CallExpr *expr) {
     // Get the function being called
-    auto *funcExpr = expr->function.get();
+    auto *funcExpr = expr->function;
     
     // For now, only handle direct function calls (identifier)
-    auto *identifier = dynamic_cast<ast::Identifier*>(funcExpr);
+    auto *identifier = ast::dyn_cast<ast::Identifier>(funcExpr);
     if (!identifier) {
-        error("Only direct function calls are supported");
+        error(expr, "Only direct function calls are supported");
         return nullptr;
     }
     
-    std::string funcName = identifier->name;
-    
-    // Look up the function in the module
-    llvm::Function *function = module_->getFunction(funcName);
-    if (!function) {
-        error("Unknown function name: " + funcName);
+    if (identifier->binding != ast::Identifier::BindingKind::Function) {
+        error(expr, "Not a function: " + std::string(identifier->name->getName()));
         return nullptr;
     }
+    llvm::Function *function = getOrDeclareFunction(identifier->index);
     
-    // Generate arguments
+    // Generate arguments, converted to the parameter types
     std::vector<llvm::Value*> args;
+    const ParameterList &params = globalSymbols_[identifier->index].params;
     for (auto &arg : expr->arguments) {
-        llvm::Value *argValue = visitExpr(arg.get());
+        llvm::Value *argValue = visit(arg);
         if (!argValue) {
-            error("Failed to generate argument");
+            error(arg, "Failed to generate argument");
             return nullptr;
         }
+        if (args.size() < params.size()) {
+            argValue = convert(argValue, getType(arg), params[args.size()].first);
+        }
         args.push_back(argValue);
     }
     
     // Check argument count
     if (args.size() != function->arg_size()) {
-        error("Function call argument count mismatch");
+        error(expr, "Function call argument count mismatch");
         return nullptr;
     }
     
@@ -614,22 +866,30 @@ llvm::Value* IRGenerator::visitCallExpr(ast::CallExpr *expr) {
     return builder_->CreateCall(function, args, "calltmp");
 }
 
+llvm::Value* IRGenerator::visitArraySubscriptExpr(ast::ArraySubscriptExpr *expr) {
+    llvm::Value *address = emitAddress(expr);
+    const ast::Type *type = getType(expr);
+    if (type->isArray()) {
+        return address; // a row of a multidimensional array decays in turn
+    }
+    return createLoad(type, address, "arrayidx");
+}
+
 llvm::Value* IRGenerator::visitConditionalExpr(ast::ConditionalExpr *expr) {
     // Generate condition
-    llvm::Value *condValue = visitExpr(expr->condition.get());
+    llvm::Value *condValue = visit(expr->condition);
     if (!condValue) {
-        error("Failed to generate condition for ternary operator");
+        error(expr, "Failed to generate condition for ternary operator");
         return nullptr;
     }
     
     // Convert condition to boolean
-    condValue = builder_->CreateICmpNE(condValue, 
-        llvm::ConstantInt::get(*context_, llvm::APInt(32, 0)), "condtmp");
+    condValue = toBool(condValue);
     
     // Get current function
     llvm::Function *function = currentFunction_;
     if (!function) {
-        error("Ternary operator outside function");
+        error(expr, "Ternary operator outside function");
         return nullptr;
     }
     
@@ -643,9 +903,10 @@ llvm::Value* IRGenerator::visitConditionalExpr(ast::ConditionalExpr *expr) {
     
     // Generate true expression
     builder_->SetInsertPoint(thenBlock);
-    llvm::Value *thenValue = visitExpr(expr->trueExpr.get());
+    sealBlock(thenBlock);
+    llvm::Value *thenValue = visit(expr->trueExpr);
     if (!thenValue) {
-        error("Failed to generate true expression for ternary operator");
+        error(expr, "Failed to generate true expression for ternary operator");
         return nullptr;
     }
     builder_->CreateBr(mergeBlock);
@@ -654,9 +915,10 @@ llvm::Value* IRGenerator::visitConditionalExpr(ast::ConditionalExpr *expr) {
     // Generate false expression
     function->insert(function->end(), elseBlock);
     builder_->SetInsertPoint(elseBlock);
-    llvm::Value *elseValue = visitExpr(expr->falseExpr.get());
+    sealBlock(elseBlock);
+    llvm::Value *elseValue = visit(expr->falseExpr);
     if (!elseValue) {
-        error("Failed to generate false expression for ternary operator");
+        error(expr, "Failed to generate false expression for ternary operator");
         return nullptr;
     }
     builder_->CreateBr(mergeBlock);
@@ -665,6 +927,18 @@ llvm::Value* IRGenerator::visitConditionalExpr(ast::ConditionalExpr *expr) {
     // Merge block with PHI node
     function->insert(function->end(), mergeBlock);
     builder_->SetInsertPoint(mergeBlock);
+    sealBlock(mergeBlock);
+    
+    // Both arms yield the type of the whole; convert each at the end of its block
+    const ast::Type *type = getType(expr);
+    if (type->isVoid()) {
+        return nullptr;
+    }
+    builder_->SetInsertPoint(thenBlock->getTerminator());
+    thenValue = convert(thenValue, getType(expr->trueExpr), type);
+    builder_->SetInsertPoint(elseBlock->getTerminator());
+    elseValue = convert(elseValue, getType(expr->falseExpr), type);
+    builder_->SetInsertPoint(mergeBlock);
     
     llvm::PHINode *phi = builder_->CreatePHI(thenValue->getType(), 2, "iftmp");
     phi->addIncoming(thenValue, thenBlock);
@@ -673,33 +947,558 @@ llvm::Value* IRGenerator::visitConditionalExpr(ast::ConditionalExpr *expr) {
     return phi;
 }
 
-llvm::Type* IRGenerator::getLLVMType(const std::string &cType) {
-    // Handle pointer types
-    if (cType.back() == '*') {
-        // Modern LLVM uses opaque pointers, so we just return a pointer type
-        return llvm::PointerType::get(*context_, 0);
+llvm::Type* IRGenerator::getLLVMType(const ast::Type *type) {
+    // Each type is lowered once per module context
+    unsigned id = type->getID();
+    if (id >= llvmTypes_.size()) {
+        llvmTypes_.resize(id + 1, nullptr);
+    }
+    if (!llvmTypes_[id]) {
+        llvmTypes_[id] = lowerType(type);
+    }
+    return llvmTypes_[id];
+}
+
+llvm::Type* IRGenerator::lowerType(const ast::Type *type) {
+    using BK = ast::BuiltinType::BuiltinKind;
+    switch (type->getKind()) {
+        case ast::Type::Kind::Builtin:
+            switch (ast::cast<ast::BuiltinType>(type)->getBuiltinKind()) {
+                case BK::Void: return llvm::Type::getVoidTy(*context_);
+                case BK::Bool: return llvm::Type::getInt1Ty(*context_);  // C11 _Bool type
+                case BK::Float: return llvm::Type::getFloatTy(*context_);
+                case BK::Double: return llvm::Type::getDoubleTy(*context_);
+                case BK::LongDouble: return llvm::Type::getX86_FP80Ty(*context_);
+                default: return llvm::Type::getIntNTy(*context_, type->getSize() * 8);
+            }
+        case ast::Type::Kind::Pointer:
+            // Modern LLVM uses opaque pointers, so we just return a pointer type
+            return llvm::PointerType::get(*context_, 0);
+        case ast::Type::Kind::Array: {
+            auto *array = ast::cast<ast::ArrayType>(type);
+            return llvm::ArrayType::get(getLLVMType(array->getElementType()), array->getNumElements());
+        }
+        case ast::Type::Kind::Function: {
+            auto *function = ast::cast<ast::FunctionType>(type);
+            std::vector<llvm::Type*> params;
+            for (const ast::Type *param : function->getParamTypes()) {
+                params.push_back(getLLVMType(param));
+            }
+            return llvm::FunctionType::get(getLLVMType(function->getReturnType()), params,
+                                           function->isVariadic());
+        }
+        case ast::Type::Kind::Qualified:
+            return getLLVMType(ast::cast<ast::QualifiedType>(type)->getBaseType());
+    }
+    return llvm::Type::getInt32Ty(*context_);
+}
+
+const ast::Type* IRGenerator::getType(const ast::Expr *expr) {
+    if (!expr->type) {
+        error(expr, "Expression '" + expr->toString() + "' was not type-checked");
+    }
+    return expr->type;
+}
+
+llvm::Value* IRGenerator::convert(llvm::Value *value, const ast::Type *from, const ast::Type *to) {
+    llvm::Type *source = value->getType();
+    llvm::Type *target = getLLVMType(to);
+    if (source == target) {
+        return value;
+    }
+    if (target->isIntegerTy(1)) {
+        return toBool(value);
+    }
+    // _Bool and the unsigned types zero-extend
+    bool isSigned = from->isSignedInteger();
+    if (source->isIntegerTy() && target->isIntegerTy()) {
+        return isSigned ? builder_->CreateSExtOrTrunc(value, target, "conv")
+                        : builder_->CreateZExtOrTrunc(value, target, "conv");
+    }
+    if (source->isIntegerTy() && target->isFloatingPointTy()) {
+        return isSigned ? builder_->CreateSIToFP(value, target, "conv")
+                        : builder_->CreateUIToFP(value, target, "conv");
+    }
+    if (source->isFloatingPointTy() && target->isIntegerTy()) {
+        return to->isUnsignedInteger() ? builder_->CreateFPToUI(value, target, "conv")
+                                       : builder_->CreateFPToSI(value, target, "conv");
+    }
+    return convert(value, target);
+}
+
+llvm::Value* IRGenerator::convert(llvm::Value *value, llvm::Type *to) {
+    llvm::Type *from = value->getType();
+    if (from == to) {
+        return value;
+    }
+    if (to->isIntegerTy(1)) {
+        return toBool(value);
+    }
+    if (from->isIntegerTy() && to->isIntegerTy()) {
+        return from->isIntegerTy(1) ? builder_->CreateZExt(value, to, "conv")
+                                    : builder_->CreateSExtOrTrunc(value, to, "conv");
+    }
+    if (from->isIntegerTy() && to->isFloatingPointTy()) {
+        return from->isIntegerTy(1) ? builder_->CreateUIToFP(value, to, "conv")
+                                    : builder_->CreateSIToFP(value, to, "conv");
+    }
+    if (from->isFloatingPointTy() && to->isIntegerTy()) {
+        return builder_->CreateFPToSI(value, to, "conv");
+    }
+    if (from->isFloatingPointTy() && to->isFloatingPointTy()) {
+        return builder_->CreateFPCast(value, to, "conv");
     }
+    if (from->isPointerTy() && to->isIntegerTy()) {
+        return builder_->CreatePtrToInt(value, to, "conv");
+    }
+    if (from->isIntegerTy() && to->isPointerTy()) {
+        return builder_->CreateIntToPtr(value, to, "conv");
+    }
+    return value;
+}
+
+llvm::Value* IRGenerator::toBool(llvm::Value *value) {
+    llvm::Type *type = value->getType();
+    if (type->isIntegerTy(1)) {
+        return value;
+    }
+    if (type->isFloatingPointTy()) {
+        return builder_->CreateFCmpUNE(value, llvm::ConstantFP::get(type, 0.0), "tobool");
+    }
+    if (type->isPointerTy()) {
+        return builder_->CreateIsNotNull(value, "tobool");
+    }
+    return builder_->CreateICmpNE(value, llvm::ConstantInt::get(type, 0), "tobool");
+}
+
+llvm::Function* IRGenerator::declareFunction(ast::FunctionDecl *func) {
+    // Kept beyond the AST, which may be freed before later modules need it
+    GlobalSymbol &symbol = recordGlobal(func->index);
+    if (symbol.isFunction && !func->hasPrototype) {
+        return getOrDeclareFunction(func->index); // f() adds nothing to an earlier declaration
+    }
+    bool refined = symbol.isFunction && !symbol.hasPrototype;
+    symbol.name = func->name;
+    symbol.type = func->returnType;
+    symbol.params.assign(func->parameters.begin(), func->parameters.end());
+    symbol.isFunction = true;
+    symbol.hasPrototype = func->hasPrototype;
     
-    if (cType == "int") {
-        return llvm::Type::getInt32Ty(*context_);
-    } else if (cType == "char") {
-        return llvm::Type::getInt8Ty(*context_);
-    } else if (cType == "float") {
-        return llvm::Type::getFloatTy(*context_);
-    } else if (cType == "double") {
-        return llvm::Type::getDoubleTy(*context_);
-    } else if (cType == "_Bool") {
-        return llvm::Type::getInt1Ty(*context_);  // C11 _Bool type
-    } else if (cType == "void") {
-        return llvm::Type::getVoidTy(*context_);
+    // A function first declared as f() was given no parameters; redeclare
+    // it with those of the prototype, keeping any calls already emitted
+    llvm::GlobalValue *&global = getModuleGlobal(func->index);
+    if (refined && global && llvm::cast<llvm::Function>(global)->isDeclaration()) {
+        llvm::GlobalValue *old = global;
+        global = nullptr;
+        llvm::Function *function = getOrDeclareFunction(func->index);
+        function->takeName(old);
+        old->replaceAllUsesWith(llvm::ConstantExpr::getBitCast(function, old->getType()));
+        old->eraseFromParent();
+        return function;
+    }
+    return getOrDeclareFunction(func->index); // a prototype and its definition share a slot
+}
+
+IRGenerator::GlobalSymbol& IRGenerator::recordGlobal(unsigned index) {
+    if (index >= globalSymbols_.size()) {
+        globalSymbols_.resize(index + 1);
+    }
+    return globalSymbols_[index];
+}
+
+llvm::GlobalValue*& IRGenerator::getModuleGlobal(unsigned index) {
+    if (index >= globals_.size()) {
+        globals_.resize(index + 1, nullptr);
+    }
+    return globals_[index];
+}
+
+llvm::Function* IRGenerator::getOrDeclareFunction(unsigned index) {
+    if (index >= globalSymbols_.size() || !globalSymbols_[index].isFunction) {
+        error(nullptr, "Call to a function that was never declared");
+        return nullptr;
+    }
+    llvm::GlobalValue *&global = getModuleGlobal(index);
+    if (!global) {
+        const GlobalSymbol &symbol = globalSymbols_[index];
+        global = createFunction(symbol.name, symbol.type, symbol.params);
+    }
+    return llvm::cast<llvm::Function>(global);
+}
+
+llvm::GlobalVariable* IRGenerator::getOrDeclareGlobal(unsigned index) {
+    if (index >= globalSymbols_.size() || !globalSymbols_[index].type || globalSymbols_[index].isFunction) {
+        error(nullptr, "Use of a global that was never declared");
+        return nullptr;
+    }
+    llvm::GlobalValue *&global = getModuleGlobal(index);
+    if (!global) {
+        // Defined in an earlier module: declare it external here
+        const GlobalSymbol &symbol = globalSymbols_[index];
+        global = new llvm::GlobalVariable(
+            *module_, getLLVMType(symbol.type), false, llvm::GlobalValue::ExternalLinkage,
+            nullptr, symbol.name->getName()
+        );
+    }
+    return llvm::cast<llvm::GlobalVariable>(global);
+}
+
+llvm::AllocaInst* IRGenerator::createEntryAlloca(llvm::Type *type, llvm::StringRef name) {
+    // Keep the allocas together, in declaration order, at the top of the entry block
+    llvm::BasicBlock &entry = currentFunction_->getEntryBlock();
+    llvm::IRBuilder<> entryBuilder(&entry, allocaInsertPoint_ ? std::next(allocaInsertPoint_->getIterator())
+                                                              : entry.begin());
+    allocaInsertPoint_ = entryBuilder.CreateAlloca(type, nullptr, name);
+    return allocaInsertPoint_;
+}
+
+llvm::AllocaInst* IRGenerator::declareLocal(unsigned slot, Name name, const ast::Type *type) {
+    Local &local = locals_[slot];
+    local.name = name;
+    local.type = type;
+    auto *qualified = ast::dyn_cast<ast::QualifiedType>(type);
+    bool isVolatile = qualified && qualified->isVolatile();
+    if (type->isScalar() && !addressTaken_[slot] && !isVolatile) {
+        return nullptr;
+    }
+    local.alloca = createEntryAlloca(getLLVMType(type), name->getName());
+    return local.alloca;
+}
+
+IRGenerator::LValue IRGenerator::emitLValue(ast::Expr *expr) {
+    auto *id = ast::dyn_cast<ast::Identifier>(expr);
+    if (id && id->binding == ast::Identifier::BindingKind::Local) {
+        return getLocal(id->index);
+    }
+    LValue lvalue;
+    lvalue.address = emitAddress(expr);
+    lvalue.type = getType(expr);
+    return lvalue;
+}
+
+IRGenerator::LValue IRGenerator::getLocal(unsigned slot) {
+    LValue lvalue;
+    lvalue.address = locals_[slot].alloca;
+    lvalue.slot = slot;
+    lvalue.type = locals_[slot].type;
+    return lvalue;
+}
+
+llvm::Value* IRGenerator::emitLoad(const LValue &lvalue, const llvm::Twine &name) {
+    if (lvalue.address) {
+        return createLoad(lvalue.type, lvalue.address, name);
+    }
+    return readVariable(lvalue.slot, builder_->GetInsertBlock());
+}
+
+void IRGenerator::emitStore(const LValue &lvalue, llvm::Value *value) {
+    if (lvalue.address) {
+        createStore(value, lvalue.address, lvalue.type);
     } else {
-        // Default to int
-        return llvm::Type::getInt32Ty(*context_);
+        writeVariable(lvalue.slot, builder_->GetInsertBlock(), value);
     }
 }
 
-llvm::Function* IRGenerator::createFunction(const std::string &name, const std::string &returnType,
-                                            const std::vector<std::pair<std::string, std::string>> &params) {
+llvm::LoadInst* IRGenerator::createLoad(const ast::Type *type, llvm::Value *address, const llvm::Twine &name) {
+    llvm::LoadInst *load = builder_->CreateLoad(getLLVMType(type), address, name);
+    if (llvm::MDNode *tag = getTBAATag(type)) {
+        load->setMetadata(llvm::LLVMContext::MD_tbaa, tag);
+    }
+    return load;
+}
+
+llvm::StoreInst* IRGenerator::createStore(llvm::Value *value, llvm::Value *address, const ast::Type *type) {
+    llvm::StoreInst *store = builder_->CreateStore(value, address);
+    if (llvm::MDNode *tag = getTBAATag(type)) {
+        store->setMetadata(llvm::LLVMContext::MD_tbaa, tag);
+    }
+    return store;
+}
+
+llvm::MDNode* IRGenerator::getTBAATag(const ast::Type *type) {
+    if (!options_.strictAliasing) {
+        return nullptr;
+    }
+    unsigned id = type->getUnqualifiedType()->getID();
+    if (id >= tbaaTags_.size()) {
+        tbaaTags_.resize(id + 1, nullptr);
+    }
+    if (!tbaaTags_[id]) {
+        // Scalars are accessed whole, at offset 0 of themselves
+        llvm::MDNode *node = getTBAATypeNode(type);
+        tbaaTags_[id] = llvm::MDBuilder(*context_).createTBAAStructTagNode(node, node, 0);
+    }
+    return tbaaTags_[id];
+}
+
+llvm::MDNode* IRGenerator::getTBAATypeNode(const ast::Type *type) {
+    using BK = ast::BuiltinType::BuiltinKind;
+    // Nodes are uniqued by name and parent, so they need no cache of their own
+    llvm::MDBuilder builder(*context_);
+    llvm::MDNode *root = builder.createTBAARoot("Simple C/C++ TBAA");
+    llvm::MDNode *omnipotentChar = builder.createTBAAScalarTypeNode("omnipotent char", root);
+    type = type->getUnqualifiedType();
+    
+    if (type->isPointer()) {
+        llvm::MDNode *anyPointer = builder.createTBAAScalarTypeNode("any pointer", omnipotentChar);
+        unsigned depth = 0;
+        const ast::Type *pointee = type;
+        while (pointee->isPointer()) {
+            pointee = ast::cast<ast::PointerType>(pointee->getUnqualifiedType())->getPointeeType();
+            ++depth;
+        }
+        // Pointers to objects that alias everything alias every pointer
+        llvm::MDNode *pointeeNode = getTBAATypeNode(pointee);
+        if (pointeeNode == omnipotentChar || pointee->isFunction()) {
+            return anyPointer;
+        }
+        auto *pointeeName = llvm::cast<llvm::MDString>(pointeeNode->getOperand(0));
+        return builder.createTBAAScalarTypeNode("p" + std::to_string(depth) + " " + pointeeName->getString().str(),
+                                                anyPointer);
+    }
+    
+    auto *builtin = ast::dyn_cast<ast::BuiltinType>(type);
+    if (!builtin) {
+        return omnipotentChar;
+    }
+    switch (builtin->getBuiltinKind()) {
+        case BK::Bool: return builder.createTBAAScalarTypeNode("_Bool", omnipotentChar);
+        case BK::Short:
+        case BK::UnsignedShort: return builder.createTBAAScalarTypeNode("short", omnipotentChar);
+        case BK::Int:
+        case BK::UnsignedInt: return builder.createTBAAScalarTypeNode("int", omnipotentChar);
+        case BK::Long:
+        case BK::UnsignedLong: return builder.createTBAAScalarTypeNode("long", omnipotentChar);
+        case BK::LongLong:
+        case BK::UnsignedLongLong: return builder.createTBAAScalarTypeNode("long long", omnipotentChar);
+        case BK::Float: return builder.createTBAAScalarTypeNode("float", omnipotentChar);
+        case BK::Double: return builder.createTBAAScalarTypeNode("double", omnipotentChar);
+        case BK::LongDouble: return builder.createTBAAScalarTypeNode("long double", omnipotentChar);
+        default: return omnipotentChar; // void and the character types
+    }
+}
+
+void IRGenerator::writeVariable(unsigned slot, llvm::BasicBlock *block, llvm::Value *value) {
+    currentDefs_[{slot, block}] = value;
+}
+
+llvm::Value* IRGenerator::readVariable(unsigned slot, llvm::BasicBlock *block) {
+    auto it = currentDefs_.find({slot, block});
+    if (it != currentDefs_.end()) {
+        return it->second;
+    }
+    return readVariableRecursive(slot, block);
+}
+
+llvm::Value* IRGenerator::readVariableRecursive(unsigned slot, llvm::BasicBlock *block) {
+    const Local &local = locals_[slot];
+    llvm::IRBuilder<> phiBuilder(block, block->begin());
+    llvm::Value *value;
+    if (!sealedBlocks_.contains(block)) {
+        // Operands are added once every predecessor is known
+        llvm::PHINode *phi = phiBuilder.CreatePHI(getLLVMType(local.type), 0, local.name->getName());
+        incompletePhis_[block].push_back({slot, phi});
+        value = phi;
+    } else if (llvm::BasicBlock *pred = block->getSinglePredecessor()) {
+        value = readVariable(slot, pred); // no phi needed
+    } else {
+        // Record the phi first to break cycles through loops
+        llvm::PHINode *phi = phiBuilder.CreatePHI(getLLVMType(local.type), 0, local.name->getName());
+        writeVariable(slot, block, phi);
+        value = addPhiOperands(slot, phi);
+    }
+    writeVariable(slot, block, value);
+    return value;
+}
+
+llvm::Value* IRGenerator::addPhiOperands(unsigned slot, llvm::PHINode *phi) {
+    for (llvm::BasicBlock *pred : llvm::predecessors(phi->getParent())) {
+        phi->addIncoming(readVariable(slot, pred), pred);
+    }
+    return tryRemoveTrivialPhi(phi);
+}
+
+llvm::Value* IRGenerator::tryRemoveTrivialPhi(llvm::PHINode *phi) {
+    // A phi merging only one value besides itself is that value
+    llvm::Value *same = nullptr;
+    for (llvm::Value *operand : phi->incoming_values()) {
+        if (operand == same || operand == phi) {
+            continue;
+        }
+        if (same) {
+            return phi; // merges at least two values
+        }
+        same = operand;
+    }
+    if (!same) {
+        same = llvm::UndefValue::get(phi->getType()); // unreachable, or read before any assignment
+    }
+    
+    // Replacing the phi may make the phis using it trivial in turn
+    llvm::SmallVector<llvm::WeakTrackingVH, 8> users;
+    for (llvm::User *user : phi->users()) {
+        if (user != phi && llvm::isa<llvm::PHINode>(user)) {
+            users.push_back(user);
+        }
+    }
+    phi->replaceAllUsesWith(same);
+    phi->eraseFromParent();
+    for (llvm::Value *user : users) {
+        if (auto *userPhi = llvm::dyn_cast_or_null<llvm::PHINode>(user)) {
+            tryRemoveTrivialPhi(userPhi);
+        }
+    }
+    return same;
+}
+
+void IRGenerator::sealBlock(llvm::BasicBlock *block) {
+    auto it = incompletePhis_.find(block);
+    if (it != incompletePhis_.end()) {
+        auto phis = std::move(it->second);
+        incompletePhis_.erase(it);
+        for (auto &[slot, phi] : phis) {
+            addPhiOperands(slot, phi);
+        }
+    }
+    sealedBlocks_.insert(block);
+}
+
+void IRGenerator::addLoopMetadata(llvm::BasicBlock *header, llvm::BasicBlock *preheader, ast::Expr *condition,
+                                  const ast::LoopHints &hints) {
+    using State = ast::LoopHints::State;
+    llvm::SmallVector<llvm::Metadata*, 8> properties;
+    properties.push_back(nullptr); // replaced by the loop ID itself
+    auto addProperty = [&](llvm::StringRef name, llvm::Metadata *value = nullptr) {
+        llvm::SmallVector<llvm::Metadata*, 2> operands{llvm::MDString::get(*context_, name)};
+        if (value) {
+            operands.push_back(value);
+        }
+        properties.push_back(llvm::MDNode::get(*context_, operands));
+    };
+    auto constant = [&](llvm::Type *type, uint64_t value) {
+        return llvm::ConstantAsMetadata::get(llvm::ConstantInt::get(type, value));
+    };
+    
+    if (options_.finiteLoops && condition && !evaluator_.evaluate(condition)) {
+        addProperty("llvm.loop.mustprogress");
+    }
+    
+    // A width or interleave count asks for the vectorizer as well, so that
+    // it is reported when it cannot comply
+    State vectorize = hints.vectorize;
+    if (vectorize == State::Default &&
+        (hints.interleave == State::Enable || hints.vectorizeWidth > 1 || hints.interleaveCount > 1)) {
+        vectorize = State::Enable;
+    }
+    if (vectorize != State::Default) {
+        addProperty("llvm.loop.vectorize.enable", constant(builder_->getInt1Ty(), vectorize == State::Enable));
+    }
+    if (hints.vectorizeWidth) {
+        addProperty("llvm.loop.vectorize.width", constant(builder_->getInt32Ty(), hints.vectorizeWidth));
+    }
+    if (hints.interleaveCount || hints.interleave == State::Disable) {
+        uint32_t count = hints.interleave == State::Disable ? 1 : hints.interleaveCount;
+        addProperty("llvm.loop.interleave.count", constant(builder_->getInt32Ty(), count));
+    }
+    
+    if (hints.unrollCount) {
+        addProperty("llvm.loop.unroll.count", constant(builder_->getInt32Ty(), hints.unrollCount));
+    } else if (hints.unroll == State::Enable) {
+        addProperty("llvm.loop.unroll.enable");
+    } else if (hints.unroll == State::Disable) {
+        addProperty("llvm.loop.unroll.disable");
+    } else if (hints.unroll == State::Full) {
+        addProperty("llvm.loop.unroll.full");
+    }
+    
+    if (hints.independentIterations) {
+        addProperty("llvm.loop.parallel_accesses", addAccessGroup(header, preheader));
+    }
+    
+    if (properties.size() == 1) {
+        return;
+    }
+    llvm::MDNode *loopID = llvm::MDNode::getDistinct(*context_, properties);
+    loopID->replaceOperandWith(0, loopID);
+    
+    // LLVM reads the loop ID off the latches, and ignores it unless every
+    // latch carries the same one
+    for (llvm::BasicBlock *pred : llvm::predecessors(header)) {
+        if (pred != preheader) {
+            pred->getTerminator()->setMetadata(llvm::LLVMContext::MD_loop, loopID);
+        }
+    }
+}
+
+llvm::MDNode* IRGenerator::addAccessGroup(llvm::BasicBlock *header, llvm::BasicBlock *preheader) {
+    // The loop is the header and every block reaching a back edge without
+    // passing through it
+    llvm::SmallPtrSet<llvm::BasicBlock*, 16> blocks{header};
+    llvm::SmallVector<llvm::BasicBlock*, 16> worklist;
+    for (llvm::BasicBlock *pred : llvm::predecessors(header)) {
+        if (pred != preheader && blocks.insert(pred).second) {
+            worklist.push_back(pred);
+        }
+    }
+    while (!worklist.empty()) {
+        for (llvm::BasicBlock *pred : llvm::predecessors(worklist.pop_back_val())) {
+            if (blocks.insert(pred).second) {
+                worklist.push_back(pred);
+            }
+        }
+    }
+    
+    // An access already in an inner loop's group joins a list of groups
+    llvm::MDNode *group = llvm::MDNode::getDistinct(*context_, {});
+    for (llvm::BasicBlock *block : blocks) {
+        for (llvm::Instruction &inst : *block) {
+            if (!inst.mayReadOrWriteMemory()) {
+                continue;
+            }
+            llvm::MDNode *groups = group;
+            if (llvm::MDNode *inner = inst.getMetadata(llvm::LLVMContext::MD_access_group)) {
+                llvm::SmallVector<llvm::Metadata*, 4> list;
+                if (inner->getNumOperands() == 0) {
+                    list.push_back(inner);
+                } else {
+                    list.append(inner->op_begin(), inner->op_end());
+                }
+                list.push_back(group);
+                groups = llvm::MDNode::get(*context_, list);
+            }
+            inst.setMetadata(llvm::LLVMContext::MD_access_group, groups);
+        }
+    }
+    return group;
+}
+
+bool IRGenerator::hasUndefinedOverflow(const ast::Type *type) const {
+    auto *builtin = ast::dyn_cast<ast::BuiltinType>(type->getUnqualifiedType());
+    return !options_.wrapv && builtin && builtin->isSignedInteger() &&
+           ast::BuiltinType::getPromotedKind(builtin->getBuiltinKind()) == builtin->getBuiltinKind();
+}
+
+void IRGenerator::enterScope() {
+    scopeStarts_.push_back(liveAllocas_.size());
+}
+
+void IRGenerator::exitScope() {
+    size_t start = scopeStarts_.back();
+    scopeStarts_.pop_back();
+    endLifetimes(start);
+    liveAllocas_.resize(start);
+}
+
+void IRGenerator::endLifetimes(size_t start) {
+    if (isTerminated()) {
+        return; // e.g. after a return, which ends every lifetime
+    }
+    for (size_t i = liveAllocas_.size(); i > start; --i) {
+        builder_->CreateLifetimeEnd(liveAllocas_[i - 1]);
+    }
+}
+
+llvm::Function* IRGenerator::createFunction(Name name, const ast::Type *returnType, const ParameterList &params) {
     std::vector<llvm::Type*> paramTypes;
     for (const auto &param : params) {
         paramTypes.push_back(getLLVMType(param.first));
@@ -709,40 +1508,49 @@ llvm::Function* IRGenerator::createFunction(const std::string &name, const std::
     llvm::FunctionType *funcType = llvm::FunctionType::get(retType, paramTypes, false);
     
     llvm::Function *function = llvm::Function::Create(
-        funcType, llvm::Function::ExternalLinkage, name, module_.get()
+        funcType, llvm::Function::ExternalLinkage, name->getName(), module_.get()
     );
+    if (options_.noundefParams) {
+        for (auto &arg : function->args()) {
+            arg.addAttr(llvm::Attribute::NoUndef);
+        }
+    }
     
     return function;
 }
 
 llvm::Value* IRGenerator::visitBreakStmt(ast::BreakStmt *stmt) {
-    (void)stmt; // Suppress unused parameter warning
     if (loopStack_.empty()) {
-        error("Break statement not within a loop");
+        error(stmt, "Break statement not within a loop");
         return nullptr;
     }
     
-    // Jump to the break block of the innermost loop
+    // Jump to the break block of the innermost loop, leaving the blocks in it
+    endLifetimes(loopStack_.back().liveAllocas);
     builder_->CreateBr(loopStack_.back().breakBlock);
     
     return nullptr;
 }
 
 llvm::Value* IRGenerator::visitContinueStmt(ast::ContinueStmt *stmt) {
-    (void)stmt; // Suppress unused parameter warning
     if (loopStack_.empty()) {
-        error("Continue statement not within a loop");
+        error(stmt, "Continue statement not within a loop");
         return nullptr;
     }
     
-    // Jump to the continue block of the innermost loop
+    // Jump to the continue block of the innermost loop, leaving the blocks in it
+    endLifetimes(loopStack_.back().liveAllocas);
     builder_->CreateBr(loopStack_.back().continueBlock);
     
     return nullptr;
 }
 
-void IRGenerator::error(const std::string &message) {
-    throw std::runtime_error("IR Generation error: " + message);
+void IRGenerator::error(const ast::Node *node, const std::string &message) {
+    std::string where;
+    if (sourceManager_ && node && node->loc.isValid()) {
+        where = sourceManager_->getDescription(node->loc) + ": ";
+    }
+    throw std::runtime_error(where + "IR Generation error: " + message);
 }
 
 } // namespace codegen
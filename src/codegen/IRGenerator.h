@@ -3,26 +3,42 @@
 #include "ast/Node.h"
 #include "ast/Expr.h"
 #include "ast/Stmt.h"
+#include "ast/ASTVisitor.h"
+#include "ast/ConstantEvaluator.h"
+#include "ast/Type.h"
+#include "codegen/CodeGenOptions.h"
+#include "utils/SourceManager.h"
 
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/MDBuilder.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/Value.h"
 #include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalVariable.h"
 #include "llvm/IR/Type.h"
+#include "llvm/IR/ValueHandle.h"
 
 #include <memory>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <vector>
 
 namespace codegen {
 
 /**
  * LLVM IR generator for AST nodes.
+ *
+ * Expressions must have been annotated by sema::TypeChecker: their C types
+ * decide how values are sized, extended and compared.
  */
-class IRGenerator {
+class IRGenerator : public ast::ASTVisitor<IRGenerator, llvm::Value*> {
+    friend class ast::ASTVisitor<IRGenerator, llvm::Value*>;
+    
 public:
-    IRGenerator();
+    explicit IRGenerator(const CodeGenOptions &options = CodeGenOptions());
     ~IRGenerator() = default;
     
     /**
@@ -30,31 +46,112 @@ public:
      */
     std::string generateIR(ast::TranslationUnit *tu);
     
+    /**
+     * Lower a single top-level declaration into the current module.
+     * Functions and globals from earlier modules stay callable: they are
+     * redeclared on first use.
+     */
+    void emitDeclaration(ast::Node *decl);
+    
+    /**
+     * Verify and print the current module, then start a fresh module and
+     * context so the finished one's memory is released.
+     */
+    std::string finishModule();
+    
+    /**
+     * Resolve node locations through sourceManager in error messages.
+     */
+    void setSourceManager(const utils::SourceManager *sourceManager) { sourceManager_ = sourceManager; }
+    
 private:
+    CodeGenOptions options_;
+    const utils::SourceManager *sourceManager_ = nullptr;
     std::unique_ptr<llvm::LLVMContext> context_;
     std::unique_ptr<llvm::Module> module_;
     std::unique_ptr<llvm::IRBuilder<>> builder_;
     
-    // Symbol table for variables
-    std::unordered_map<std::string, llvm::Value*> namedValues_;
-    std::unordered_map<std::string,int> pointerDepth_;
+    using Name = const ast::IdentifierInfo*;
+    using ParameterList = std::vector<std::pair<const ast::Type*, Name>>; // (type, name)
+    
+    // The current function's locals, indexed by the slots sema assigned.
+    // A local lives in memory if its address is taken, it is volatile, or
+    // it is not a scalar; every other local is an SSA variable whose value
+    // is looked up with readVariable().
+    struct Local {
+        llvm::AllocaInst *alloca = nullptr;  // null for an SSA variable
+        const ast::Type *type = nullptr;
+        Name name = nullptr;
+    };
+    std::vector<Local> locals_;
+    std::vector<bool> addressTaken_;
+    
+    // SSA construction after Braun et al., "Simple and Efficient
+    // Construction of Static Single Assignment Form" (CC 2013). A block is
+    // sealed once all its predecessors are known; reading a variable in an
+    // unsealed block leaves a phi to be completed when it is sealed.
+    // Definitions are tracked handles, so replacing a trivial phi updates
+    // every block that recorded it.
+    llvm::DenseMap<std::pair<unsigned, llvm::BasicBlock*>, llvm::WeakTrackingVH> currentDefs_;
+    llvm::DenseMap<llvm::BasicBlock*, std::vector<std::pair<unsigned, llvm::PHINode*>>> incompletePhis_;
+    llvm::SmallPtrSet<llvm::BasicBlock*, 32> sealedBlocks_;
+    
+    // Every function and global seen so far, indexed by slot and used to
+    // redeclare them in later modules. Names and types live in the identifier
+    // table and type context, which outlive the AST of any one declaration.
+    struct GlobalSymbol {
+        Name name = nullptr;
+        const ast::Type *type = nullptr;  // the return type of a function
+        ParameterList params;
+        bool isFunction = false;
+        bool hasPrototype = false;  // params came from a prototype, not f()
+    };
+    std::vector<GlobalSymbol> globalSymbols_;
+    
+    // The current module's declaration of each global slot, or null
+    std::vector<llvm::GlobalValue*> globals_;
+    
+    // Lowered types of the current module's context, indexed by type ID
+    std::vector<llvm::Type*> llvmTypes_;
+    
+    // TBAA access tags of the current module's context, indexed by the ID
+    // of the unqualified type accessed
+    std::vector<llvm::MDNode*> tbaaTags_;
     
     // Current function being generated
     llvm::Function *currentFunction_ = nullptr;
+    const ast::Type *currentReturnType_ = nullptr;
     
     // Loop context for break/continue statements
     struct LoopContext {
         llvm::BasicBlock *continueBlock;  // Where continue should jump
         llvm::BasicBlock *breakBlock;     // Where break should jump
+        size_t liveAllocas;               // Size of liveAllocas_ when the loop was entered
     };
     std::vector<LoopContext> loopStack_;
     
-    // Visit methods for different AST node types
-    void visitTranslationUnit(ast::TranslationUnit *tu);
-    void visitFunctionDecl(ast::FunctionDecl *func);
-    void visitVarDecl(ast::VarDecl *var);
+    // Locals are allocated in the entry block, after the last alloca made
+    // there; null until the current function's first one
+    llvm::AllocaInst *allocaInsertPoint_ = nullptr;
     
+    // Allocas of the locals declared in the open blocks, innermost last, and
+    // the index of each block's first one. Their lifetimes end when control
+    // leaves the block.
+    std::vector<llvm::AllocaInst*> liveAllocas_;
+    std::vector<size_t> scopeStarts_;
+    
+    ast::ConstantEvaluator evaluator_;
+    
+    // Visit methods for different AST node types, reached through visit()
+    llvm::Value* visitTranslationUnit(ast::TranslationUnit *tu);
+    llvm::Value* visitFunctionDecl(ast::FunctionDecl *func);
+    llvm::Value* visitVarDecl(ast::VarDecl *var);
+    
+    // Fallbacks for node kinds without code generation
     llvm::Value* visitStmt(ast::Stmt *stmt);
+    llvm::Value* visitExpr(ast::Expr *expr);
+    llvm::Value* visitNode(ast::Node *node);
+    
     llvm::Value* visitCompoundStmt(ast::CompoundStmt *stmt);
     llvm::Value* visitExprStmt(ast::ExprStmt *stmt);
     llvm::Value* visitReturnStmt(ast::ReturnStmt *stmt);
@@ -64,7 +161,6 @@ private:
     llvm::Value* visitBreakStmt(ast::BreakStmt *stmt);
     llvm::Value* visitContinueStmt(ast::ContinueStmt *stmt);
     
-    llvm::Value* visitExpr(ast::Expr *expr);
     llvm::Value* visitIntegerLiteral(ast::IntegerLiteral *lit);
     llvm::Value* visitFloatingLiteral(ast::FloatingLiteral *lit);
     llvm::Value* visitCharacterLiteral(ast::CharacterLiteral *lit);
@@ -73,18 +169,153 @@ private:
     llvm::Value* visitBinaryExpr(ast::BinaryExpr *expr);
     llvm::Value* visitUnaryExpr(ast::UnaryExpr *expr);
     llvm::Value* visitCallExpr(ast::CallExpr *expr);
+    llvm::Value* visitArraySubscriptExpr(ast::ArraySubscriptExpr *expr);
     llvm::Value* visitConditionalExpr(ast::ConditionalExpr *expr);
     
     // Helper methods
-    llvm::Type* getLLVMType(const std::string &cType);
-    llvm::Function* createFunction(const std::string &name, const std::string &returnType,
-                                   const std::vector<std::pair<std::string, std::string>> &params);
+    void startModule();
+    std::string printModule();
+    llvm::Function* declareFunction(ast::FunctionDecl *func);
+    GlobalSymbol& recordGlobal(unsigned index);
+    llvm::GlobalValue*& getModuleGlobal(unsigned index);
+    llvm::Function* getOrDeclareFunction(unsigned index);
+    llvm::GlobalVariable* getOrDeclareGlobal(unsigned index);
+    llvm::Type* getLLVMType(const ast::Type *type);
+    llvm::Type* lowerType(const ast::Type *type);
+    llvm::Function* createFunction(Name name, const ast::Type *returnType, const ParameterList &params);
     llvm::Value* emitAddress(ast::Expr *expr);
-    int computePointerDepth(ast::Expr *expr);
-    llvm::Value* loadIdentifier(const std::string &name);
     
-    // Error handling
-    void error(const std::string &message);
+    // Pointer arithmetic (C11 6.5.6). Operands of pointer or array type
+    // step by whole elements through inbounds GEPs typed with the element,
+    // which lets alias analysis and SCEV reason about the accesses.
+    bool isPointerOperand(const ast::Type *type) const { return type->isPointer() || type->isArray(); }
+    llvm::Type* getElementType(const ast::Type *pointerType);
+    uint64_t getElementSize(const ast::Type *pointerType);
+    llvm::Value* emitPointerOffset(llvm::Value *pointer, const ast::Type *pointerType, llvm::Value *offset,
+                                   const ast::Type *offsetType, bool subtract);
+    llvm::Value* emitPointerArithmetic(ast::BinaryExpr *expr, llvm::Value *left, llvm::Value *right);
+    
+    /**
+     * An object that can be read and assigned: memory at an address, or
+     * an SSA variable.
+     */
+    struct LValue {
+        llvm::Value *address = nullptr;  // null for an SSA variable
+        unsigned slot = 0;               // local slot of an SSA variable
+        const ast::Type *type = nullptr;
+    };
+    LValue emitLValue(ast::Expr *expr);
+    LValue getLocal(unsigned slot);
+    llvm::Value* emitLoad(const LValue &lvalue, const llvm::Twine &name);
+    void emitStore(const LValue &lvalue, llvm::Value *value);
+    
+    /**
+     * Load or store an object of C type type in memory, tagged with the
+     * type for type-based alias analysis.
+     */
+    llvm::LoadInst* createLoad(const ast::Type *type, llvm::Value *address, const llvm::Twine &name);
+    llvm::StoreInst* createStore(llvm::Value *value, llvm::Value *address, const ast::Type *type);
+    
+    /**
+     * The TBAA tag for an access to an object of C type type, or null when
+     * strict aliasing is off. The type tree follows C11 6.5p7: character
+     * types alias everything, signed and unsigned variants of a type alias
+     * each other, and pointers are told apart by what they point to, with
+     * void pointers aliasing every pointer.
+     */
+    llvm::MDNode* getTBAATag(const ast::Type *type);
+    llvm::MDNode* getTBAATypeNode(const ast::Type *type);
+    
+    /**
+     * Set up the local in slot, allocating it if it must live in memory.
+     * @return The local's alloca, or null for an SSA variable
+     */
+    llvm::AllocaInst* declareLocal(unsigned slot, Name name, const ast::Type *type);
+    
+    // SSA construction
+    void writeVariable(unsigned slot, llvm::BasicBlock *block, llvm::Value *value);
+    llvm::Value* readVariable(unsigned slot, llvm::BasicBlock *block);
+    llvm::Value* readVariableRecursive(unsigned slot, llvm::BasicBlock *block);
+    llvm::Value* addPhiOperands(unsigned slot, llvm::PHINode *phi);
+    llvm::Value* tryRemoveTrivialPhi(llvm::PHINode *phi);
+    
+    /**
+     * Declare that every predecessor of block has been emitted.
+     */
+    void sealBlock(llvm::BasicBlock *block);
+    
+    /**
+     * Allocate a local in the entry block, so that each is allocated once
+     * per call however often its declaration runs.
+     */
+    llvm::AllocaInst* createEntryAlloca(llvm::Type *type, llvm::StringRef name);
+    
+    /**
+     * Attach the loop's llvm.loop metadata to every back edge into header,
+     * the branches from blocks other than preheader. Loops whose condition
+     * is not a constant are marked as making progress (C11 6.8.5p6), and
+     * the transformations requested by pragmas are passed on to the
+     * vectorizer and unroller.
+     */
+    void addLoopMetadata(llvm::BasicBlock *header, llvm::BasicBlock *preheader, ast::Expr *condition,
+                         const ast::LoopHints &hints);
+    
+    /**
+     * Put every memory access of the loop headed by header into a new
+     * access group, which llvm.loop.parallel_accesses then declares free of
+     * dependences between iterations.
+     * @return The access group
+     */
+    llvm::MDNode* addAccessGroup(llvm::BasicBlock *header, llvm::BasicBlock *preheader);
+    
+    /**
+     * Whether overflow in arithmetic of type is undefined, so that it can
+     * be marked nsw. type is the type the operation is performed in.
+     */
+    bool hasUndefinedOverflow(const ast::Type *type) const;
+    
+    // Block scopes of locals
+    void enterScope();
+    void exitScope();
+    
+    /**
+     * End the lifetimes of the live allocas from index start on, innermost
+     * first, unless the current block is already terminated.
+     */
+    void endLifetimes(size_t start);
+    bool isTerminated() const { return builder_->GetInsertBlock()->getTerminator() != nullptr; }
+    
+    /**
+     * Evaluate a global's initializer, which C requires to be constant.
+     */
+    llvm::Constant* emitConstantInitializer(ast::VarDecl *var, llvm::Type *type);
+    
+    /**
+     * The type semantic analysis resolved for expr.
+     * @throws std::runtime_error if expr was not type-checked
+     */
+    const ast::Type* getType(const ast::Expr *expr);
+    
+    /**
+     * Convert a value of C type from to C type to (C11 6.3). The source
+     * type decides between sign and zero extension.
+     */
+    llvm::Value* convert(llvm::Value *value, const ast::Type *from, const ast::Type *to);
+    
+    /**
+     * Apply an arithmetic, bitwise or shift operator to operands already
+     * converted to type.
+     */
+    llvm::Value* emitArithmetic(ast::BinaryExpr::OpKind op, llvm::Value *left, llvm::Value *right,
+                                const ast::Type *type);
+    
+    // Conversions between IR types alone, for values without a C type.
+    // Integers are treated as signed except _Bool.
+    llvm::Value* convert(llvm::Value *value, llvm::Type *to);
+    llvm::Value* toBool(llvm::Value *value);
+    
+    // Error handling; node locates the error and may be null
+    void error(const ast::Node *node, const std::string &message);
 };
 
 } // namespace codegen
@@ -1,9 +1,22 @@
 #include "driver/Driver.h"
 #include "parser/ASTBuilder.h"
+#include "parser/TopLevelParser.h"
+#include "parser/ParallelParser.h"
+#include "parser/ByteCharStream.h"
+#include "parser/DeclarationStream.h"
+#include "parser/ChunkedCharStream.h"
+#include "parser/QueueTokenSource.h"
+#include "sema/TypeChecker.h"
 #include "codegen/IRGenerator.h"
 #include "preprocessor/Preprocessor.h"
 #include "utils/Error.h"
+#include "utils/BoundedQueue.h"
+#include "utils/ThreadPool.h"
 #include "ast/Stmt.h"
+#include "ast/ASTContext.h"
+#include "ast/Casting.h"
+#include "ast/ASTReader.h"
+#include "ast/ASTWriter.h"
 
 #include "antlr4-runtime.h"
 #include "CLexer.h"
@@ -13,15 +26,65 @@
 #include <fstream>
 #include <sstream>
 #include <cstdlib>
+#include <thread>
 
 namespace driver {
 
+namespace {
+
+/**
+ * Writes syntax errors to a stream of the caller's choosing instead of
+ * std::cerr, so that files checked concurrently do not interleave them.
+ */
+class SyntaxErrorListener : public antlr4::BaseErrorListener {
+public:
+    SyntaxErrorListener(const std::string &file, std::ostream &os) : file_(file), os_(os) {}
+    
+    void syntaxError(antlr4::Recognizer *, antlr4::Token *, size_t line, size_t charPositionInLine,
+                     const std::string &msg, std::exception_ptr) override {
+        os_ << file_ << ": line " << line << ":" << charPositionInLine << " " << msg << "\n";
+        ++errors_;
+    }
+    
+    size_t getNumberOfErrors() const { return errors_; }
+    
+private:
+    const std::string &file_;
+    std::ostream &os_;
+    size_t errors_ = 0;
+};
+
+} // namespace
+
 int Driver::compile(const std::string &inputFile, const std::string &outputFile) {
+    if (syntaxOnly_) {
+        return checkSyntax({inputFile});
+    }
+    
     try {
         log("Compiling " + inputFile + " to " + outputFile);
         
-        // Preprocess the input file
-        std::string preprocessedSource = preprocessFile(inputFile);
+        ast::IdentifierTable identifiers;
+        ast::TypeContext types;
+        ast::ASTContext context(identifiers, types);
+        
+        // A serialized AST skips the front end. The generator emits every
+        // definition, so the bodies are read up front rather than lazily.
+        if (inputFile.size() > 4 && inputFile.ends_with(".ast") && !emitAST_) {
+            ast::ASTReader reader(inputFile);
+            return compileTranslationUnit(reader.readTranslationUnit(context), types, outputFile);
+        }
+        
+        if (pipeline_ && !preprocessOnly_ && !emitAST_) {
+            return compilePipelined(inputFile, outputFile);
+        }
+        
+        // Preprocess the input file. The SourceManager keeps every file
+        // read, so AST locations can be traced back through #include.
+        utils::SourceManager sourceManager;
+        utils::FileID mainFile = preprocessFile(inputFile, sourceManager);
+        std::string_view preprocessedSource = sourceManager.getBufferData(mainFile);
+        utils::SourceLocation bufferStart = sourceManager.getLocForStartOfFile(mainFile);
         
         if (preprocessOnly_) {
             // Output preprocessed source and exit
@@ -38,53 +101,159 @@ int Driver::compile(const std::string &inputFile, const std::string &outputFile)
             return 0;
         }
         
+        if (streaming_ && !emitAST_) {
+            parser::ByteCharStream input(preprocessedSource);
+            CLexer lexer(&input);
+            return compileStreaming(&lexer, outputFile, bufferStart, &sourceManager);
+        }
+        
         // Parse the preprocessed source
-        auto ast = parseString(preprocessedSource);
+        auto *ast = parseString(preprocessedSource, bufferStart, context);
         if (!ast) {
             std::cerr << "Error: Failed to parse " << inputFile << std::endl;
             return 1;
         }
         
-        // Generate LLVM IR
-        std::string irFile = outputFile + ".ll";
-        if (!generateIR(ast.get(), irFile)) {
-            std::cerr << "Error: Failed to generate LLVM IR" << std::endl;
-            return 1;
-        }
-        
-        if (debug_) {
-            log("Generated LLVM IR: " + irFile);
+        if (emitAST_) {
+            std::string astFile = outputFile;
+            if (astFile == "a.out") {
+                size_t dot = inputFile.find_last_of('.');
+                astFile = inputFile.substr(0, dot == std::string::npos ? inputFile.size() : dot) + ".ast";
+            }
+            ast::ASTWriter::writeFile(ast, astFile);
+            log("Wrote AST: " + astFile);
             return 0;
         }
         
-        // Compile to object file
-        std::string objectFile = outputFile + ".o";
-        if (!compileToObject(irFile, objectFile)) {
-            std::cerr << "Error: Failed to compile to object file" << std::endl;
-            return 1;
-        }
+        return compileTranslationUnit(ast, types, outputFile, &sourceManager);
         
-        // Link to executable
-        if (!linkExecutable(objectFile, outputFile)) {
-            std::cerr << "Error: Failed to link executable" << std::endl;
-            return 1;
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
+
+int Driver::checkSyntax(const std::vector<std::string> &inputFiles) {
+    std::vector<std::ostringstream> diagnostics(inputFiles.size());
+    std::vector<int> results(inputFiles.size(), 0);
+    
+    if (fileJobs_ != 1 && inputFiles.size() > 1) {
+        utils::ThreadPool pool(fileJobs_);
+        for (size_t i = 0; i < inputFiles.size(); ++i) {
+            pool.submit([this, &inputFiles, &diagnostics, &results, i] {
+                results[i] = checkFile(inputFiles[i], diagnostics[i]);
+            });
+        }
+        pool.wait();
+    } else {
+        for (size_t i = 0; i < inputFiles.size(); ++i) {
+            results[i] = checkFile(inputFiles[i], diagnostics[i]);
+        }
+    }
+    
+    int result = 0;
+    for (size_t i = 0; i < inputFiles.size(); ++i) {
+        std::cerr << diagnostics[i].str();
+        if (results[i] != 0) {
+            result = 1;
         }
+    }
+    return result;
+}
+
+int Driver::checkFile(const std::string &inputFile, std::ostream &diagnostics) {
+    try {
+        log("Checking " + inputFile);
+        
+        ast::IdentifierTable identifiers;
+        ast::TypeContext types;
+        ast::ASTContext context(identifiers, types);
+        ast::TranslationUnit *ast = nullptr;
+        utils::SourceManager sourceManager;
         
-        // Clean up intermediate files
-        if (!debug_) {
-            std::remove(irFile.c_str());
-            std::remove(objectFile.c_str());
+        if (inputFile.size() > 4 && inputFile.ends_with(".ast")) {
+            ast::ASTReader reader(inputFile);
+            ast = reader.readTranslationUnit(context);
+        } else {
+            utils::FileID mainFile = preprocessFile(inputFile, sourceManager);
+            parser::ByteCharStream input(sourceManager.getBufferData(mainFile));
+            
+            // Syntax errors go to this file's diagnostics
+            SyntaxErrorListener listener(inputFile, diagnostics);
+            CLexer lexer(&input);
+            lexer.removeErrorListeners();
+            lexer.addErrorListener(&listener);
+            antlr4::CommonTokenStream tokens(&lexer);
+            CParser parser(&tokens);
+            parser.removeErrorListeners();
+            parser.addErrorListener(&listener);
+            
+            auto *tree = parser.translationUnit();
+            if (listener.getNumberOfErrors() > 0) {
+                return 1;
+            }
+            parser::ASTBuilder builder(context, sourceManager.getLocForStartOfFile(mainFile));
+            ast = builder.buildTranslationUnit(tree);
         }
         
-        log("Successfully compiled " + inputFile + " to " + outputFile);
-        return 0;
+        sema::TypeChecker checker(types, semaJobs_);
+        checker.setDiagnosticStream(diagnostics);
+        if (sourceManager.getNumBuffers() > 0) {
+            checker.setSourceManager(&sourceManager); // a serialized AST has no source
+        }
+        return checker.checkTypes(ast) ? 0 : 1;
         
     } catch (const std::exception &e) {
-        std::cerr << "Error: " << e.what() << std::endl;
+        diagnostics << "Error: " << inputFile << ": " << e.what() << "\n";
         return 1;
     }
 }
 
+int Driver::compileTranslationUnit(ast::TranslationUnit *ast, ast::TypeContext &types,
+                                   const std::string &outputFile, const utils::SourceManager *sourceManager) {
+    // Annotate expressions with the types code generation relies on
+    sema::TypeChecker checker(types, semaJobs_);
+    checker.setSourceManager(sourceManager);
+    if (!checker.checkTypes(ast)) {
+        std::cerr << "Error: Type checking failed" << std::endl;
+        return 1;
+    }
+    
+    // Generate LLVM IR
+    std::string irFile = outputFile + ".ll";
+    if (!generateIR(ast, irFile, sourceManager)) {
+        std::cerr << "Error: Failed to generate LLVM IR" << std::endl;
+        return 1;
+    }
+    
+    if (debug_) {
+        log("Generated LLVM IR: " + irFile);
+        return 0;
+    }
+    
+    // Compile to object file
+    std::string objectFile = outputFile + ".o";
+    if (!compileToObject(irFile, objectFile)) {
+        std::cerr << "Error: Failed to compile to object file" << std::endl;
+        return 1;
+    }
+    
+    // Link to executable
+    if (!linkExecutable({objectFile}, outputFile)) {
+        std::cerr << "Error: Failed to link executable" << std::endl;
+        return 1;
+    }
+    
+    // Clean up intermediate files
+    if (!debug_) {
+        std::remove(irFile.c_str());
+        std::remove(objectFile.c_str());
+    }
+    
+    log("Successfully compiled " + outputFile);
+    return 0;
+}
+
 void Driver::addIncludeDirectory(const std::string &dir) {
     includeDirs_.push_back(dir);
 }
@@ -93,11 +262,12 @@ void Driver::addMacroDefinition(const std::string &macro) {
     macroDefinitions_.push_back(macro);
 }
 
-std::string Driver::preprocessFile(const std::string &filename) {
+utils::FileID Driver::preprocessFile(const std::string &filename, utils::SourceManager &sourceManager) {
     log("Preprocessing " + filename);
     
     preprocessor::Preprocessor preprocessor;
     preprocessor.setVerbose(verbose_);
+    preprocessor.setSourceManager(&sourceManager);
     
     // Add include directories
     for (const auto &dir : includeDirs_) {
@@ -109,15 +279,256 @@ std::string Driver::preprocessFile(const std::string &filename) {
         preprocessor.addMacroDefinition(macro);
     }
     
-    return preprocessor.preprocess(filename);
+    return preprocessor.preprocessToBuffer(filename);
 }
 
-std::unique_ptr<ast::TranslationUnit> Driver::parseString(const std::string &source) {
-    // Create ANTLR input stream
-    antlr4::ANTLRInputStream input(source);
+int Driver::compileStreaming(antlr4::TokenSource *tokens, const std::string &outputFile,
+                             utils::SourceLocation bufferStart, const utils::SourceManager *sourceManager) {
+    // Names and types are uniqued once for the whole file; the generator
+    // keeps the signatures it carries between modules in terms of them
+    ast::IdentifierTable identifiers;
+    ast::TypeContext types;
+    parser::DeclarationStream declarations(tokens, identifiers, types, bufferStart);
+    sema::TypeChecker checker(types);
+    checker.setSourceManager(sourceManager);
+    codegen::IRGenerator generator(codeGenOptions_);
+    generator.setSourceManager(sourceManager);
+    
+    std::vector<std::string> irFiles;
+    std::vector<std::string> objectFiles;
+    size_t functionsInModule = 0;
+    
+    // Modules already flushed must not outlive a failed compilation
+    auto removeFiles = [&]() {
+        for (const auto &file : irFiles) {
+            std::remove(file.c_str());
+        }
+        for (const auto &file : objectFiles) {
+            std::remove(file.c_str());
+        }
+    };
+    
+    auto flush = [&]() {
+        std::string irFile = outputFile + "." + std::to_string(irFiles.size()) + ".ll";
+        std::ofstream file(irFile);
+        if (!file.is_open()) {
+            throw std::runtime_error("Cannot write to output file: " + irFile);
+        }
+        file << generator.finishModule();
+        irFiles.push_back(irFile);
+        functionsInModule = 0;
+    };
+    
+    try {
+        while (auto *decl = declarations.next()) {
+            if (!checker.checkDeclaration(decl)) {
+                std::cerr << "Error: Type checking failed" << std::endl;
+                removeFiles();
+                return 1;
+            }
+            generator.emitDeclaration(decl);
+            auto *func = ast::dyn_cast<ast::FunctionDecl>(decl);
+            if (func && func->isDefinition() && ++functionsInModule >= streamBatchSize_) {
+                flush();
+            }
+        }
+        if (functionsInModule > 0 || irFiles.empty()) {
+            flush();
+        }
+    } catch (...) {
+        removeFiles();
+        throw;
+    }
+    
+    if (declarations.getNumberOfSyntaxErrors() > 0) {
+        std::cerr << "Error: Failed to parse input" << std::endl;
+        removeFiles();
+        return 1;
+    }
+    
+    if (debug_) {
+        for (const auto &irFile : irFiles) {
+            log("Generated LLVM IR: " + irFile);
+        }
+        return 0;
+    }
+    
+    for (const auto &irFile : irFiles) {
+        std::string objectFile = irFile.substr(0, irFile.size() - 3) + ".o";
+        if (!compileToObject(irFile, objectFile)) {
+            std::cerr << "Error: Failed to compile to object file" << std::endl;
+            objectFiles.push_back(objectFile); // may be partly written
+            removeFiles();
+            return 1;
+        }
+        std::remove(irFile.c_str());
+        objectFiles.push_back(objectFile);
+    }
+    
+    bool linked = linkExecutable(objectFiles, outputFile);
+    for (const auto &objectFile : objectFiles) {
+        std::remove(objectFile.c_str());
+    }
+    if (!linked) {
+        std::cerr << "Error: Failed to link executable" << std::endl;
+        return 1;
+    }
+    
+    log("Successfully compiled to " + outputFile);
+    return 0;
+}
+
+namespace {
+
+/**
+ * Stream buffer handing fixed-size chunks of written text to a queue.
+ */
+class QueueStreamBuf : public std::streambuf {
+public:
+    explicit QueueStreamBuf(utils::BoundedQueue<std::string> &chunks) : chunks_(chunks) {
+        buffer_.resize(ChunkSize);
+        setp(buffer_.data(), buffer_.data() + buffer_.size());
+    }
+    
+protected:
+    int_type overflow(int_type ch) override {
+        if (!flushChunk()) {
+            return traits_type::eof();
+        }
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+    
+    int sync() override {
+        return flushChunk() ? 0 : -1;
+    }
+    
+private:
+    static constexpr size_t ChunkSize = 64 * 1024;
+    
+    utils::BoundedQueue<std::string> &chunks_;
+    std::string buffer_;
+    
+    bool flushChunk() {
+        size_t length = static_cast<size_t>(pptr() - pbase());
+        setp(buffer_.data(), buffer_.data() + buffer_.size());
+        return length == 0 || chunks_.push(buffer_.substr(0, length));
+    }
+};
+
+} // namespace
+
+int Driver::compilePipelined(const std::string &inputFile, const std::string &outputFile) {
+    using TokenBatch = parser::QueueTokenSource::Batch;
+    constexpr size_t QueueDepth = 16;
+    constexpr size_t TokensPerBatch = 256;
+    
+    utils::BoundedQueue<std::string> text(QueueDepth);
+    utils::BoundedQueue<TokenBatch> tokens(QueueDepth);
+    
+    // Stage 1: preprocessor writes text chunks
+    std::thread preprocessThread([&] {
+        try {
+            QueueStreamBuf buffer(text);
+            std::ostream out(&buffer);
+            out.exceptions(std::ios::badbit);
+            preprocessor::Preprocessor preprocessor;
+            preprocessor.setVerbose(verbose_);
+            for (const auto &dir : includeDirs_) {
+                preprocessor.addIncludeDirectory(dir);
+            }
+            for (const auto &macro : macroDefinitions_) {
+                preprocessor.addMacroDefinition(macro);
+            }
+            preprocessor.preprocess(inputFile, out);
+            out.flush();
+            text.close();
+        } catch (...) {
+            text.close(std::current_exception());
+        }
+    });
+    
+    // Stage 2: lexer turns text into batches of self-contained tokens
+    std::thread lexThread([&] {
+        try {
+            parser::ChunkedCharStream input(text, inputFile);
+            CLexer lexer(&input);
+            TokenBatch batch;
+            for (;;) {
+                std::unique_ptr<antlr4::Token> token = lexer.nextToken();
+                if (token->getType() == antlr4::Token::EOF) {
+                    break;
+                }
+                // Without a source: the lexer and its input die with this thread
+                auto copy = std::make_unique<antlr4::CommonToken>(token->getType(), token->getText());
+                copy->setChannel(token->getChannel());
+                copy->setStartIndex(token->getStartIndex());
+                copy->setStopIndex(token->getStopIndex());
+                copy->setLine(token->getLine());
+                copy->setCharPositionInLine(token->getCharPositionInLine());
+                batch.push_back(std::move(copy));
+                if (batch.size() == TokensPerBatch) {
+                    if (!tokens.push(std::move(batch))) {
+                        return; // consumer gave up
+                    }
+                    batch = TokenBatch();
+                }
+            }
+            if (!batch.empty()) {
+                tokens.push(std::move(batch));
+            }
+            tokens.close();
+        } catch (...) {
+            tokens.close(std::current_exception());
+        }
+    });
+    
+    // Stage 3: parse and generate code on this thread
+    auto joinStages = [&] {
+        text.cancel();
+        tokens.cancel();
+        preprocessThread.join();
+        lexThread.join();
+    };
+    int result;
+    try {
+        parser::QueueTokenSource source(tokens);
+        result = compileStreaming(&source, outputFile);
+    } catch (...) {
+        joinStages();
+        throw;
+    }
+    joinStages();
+    return result;
+}
+
+ast::TranslationUnit *Driver::parseString(std::string_view source, utils::SourceLocation bufferStart,
+                                          ast::ASTContext &context) {
+    // Token start indices are byte offsets, matching the SourceManager
+    parser::ByteCharStream input(source);
     
     // Create lexer
     CLexer lexer(&input);
+    
+    if (parseJobs_ != 1) {
+        // Top level first, then function bodies in parallel
+        parser::ParallelParser parallel(parseJobs_);
+        return parallel.parse(&lexer, context, bufferStart);
+    }
+    
+    if (!buildParseTree_) {
+        // Parse and convert one external declaration at a time
+        parser::TopLevelParser topLevel(&lexer, context, bufferStart);
+        std::vector<ast::Node*> declarations;
+        while (auto *decl = topLevel.next()) {
+            declarations.push_back(decl);
+        }
+        return context.create<ast::TranslationUnit>(context.copyArray(declarations));
+    }
+    
     antlr4::CommonTokenStream tokens(&lexer);
     
     // Create parser
@@ -127,15 +538,11 @@ std::unique_ptr<ast::TranslationUnit> Driver::parseString(const std::string &sou
     auto *tree = parser.translationUnit();
     
     // Build AST
-    parser::ASTBuilder builder;
-    auto result = builder.visit(tree);
-    
-    // Convert raw pointer back to unique_ptr
-    auto *translation_unit_ptr = std::any_cast<ast::TranslationUnit*>(result);
-    return std::unique_ptr<ast::TranslationUnit>(translation_unit_ptr);
+    parser::ASTBuilder builder(context, bufferStart);
+    return builder.buildTranslationUnit(tree);
 }
 
-std::unique_ptr<ast::TranslationUnit> Driver::parseFile(const std::string &filename) {
+ast::TranslationUnit *Driver::parseFile(const std::string &filename, ast::ASTContext &context) {
     std::ifstream file(filename);
     if (!file.is_open()) {
         throw std::runtime_error("Cannot open file: " + filename);
@@ -159,17 +566,15 @@ std::unique_ptr<ast::TranslationUnit> Driver::parseFile(const std::string &filen
     auto *tree = parser.translationUnit();
     
     // Build AST
-    parser::ASTBuilder builder;
-    auto result = builder.visit(tree);
-    
-    // Convert raw pointer back to unique_ptr
-    auto *translation_unit_ptr = std::any_cast<ast::TranslationUnit*>(result);
-    return std::unique_ptr<ast::TranslationUnit>(translation_unit_ptr);
+    parser::ASTBuilder builder(context);
+    return builder.buildTranslationUnit(tree);
 }
 
-bool Driver::generateIR(ast::TranslationUnit *ast, const std::string &outputFile) {
+bool Driver::generateIR(ast::TranslationUnit *ast, const std::string &outputFile,
+                        const utils::SourceManager *sourceManager) {
     try {
-        codegen::IRGenerator generator;
+        codegen::IRGenerator generator(codeGenOptions_);
+        generator.setSourceManager(sourceManager);
         std::string ir = generator.generateIR(ast);
         
         std::ofstream file(outputFile);
@@ -187,15 +592,19 @@ bool Driver::generateIR(ast::TranslationUnit *ast, const std::string &outputFile
 }
 
 bool Driver::compileToObject(const std::string &irFile, const std::string &objectFile) {
-    std::string command = "clang -c -Wno-override-module " + irFile + " -o " + objectFile;
+    std::string command = "clang -c -O" + optimizationLevel_ + " -Wno-override-module " + irFile + " -o " + objectFile;
     log("Executing: " + command);
     
     int result = std::system(command.c_str());
     return result == 0;
 }
 
-bool Driver::linkExecutable(const std::string &objectFile, const std::string &executableFile) {
-    std::string command = "clang " + objectFile + " -o " + executableFile;
+bool Driver::linkExecutable(const std::vector<std::string> &objectFiles, const std::string &executableFile) {
+    std::string command = "clang";
+    for (const auto &objectFile : objectFiles) {
+        command += " " + objectFile;
+    }
+    command += " -o " + executableFile;
     log("Executing: " + command);
     
     int result = std::system(command.c_str());
@@ -1,11 +1,22 @@
 #pragma once
 
+#include "codegen/CodeGenOptions.h"
+#include "utils/SourceManager.h"
+
+#include <iosfwd>
 #include <string>
+#include <string_view>
 #include <memory>
 #include <vector>
 
 namespace ast {
     struct TranslationUnit;
+    class ASTContext;
+    class TypeContext;
+}
+
+namespace antlr4 {
+    class TokenSource;
 }
 
 namespace driver {
@@ -25,6 +36,14 @@ public:
      */
     int compile(const std::string &inputFile, const std::string &outputFile = "a.out");
     
+    /**
+     * Preprocess, parse and type-check source files without generating
+     * code, several files at a time. Each file's diagnostics are printed
+     * together, in the order the files are given.
+     * @return 0 if every file is free of errors, non-zero otherwise
+     */
+    int checkSyntax(const std::vector<std::string> &inputFiles);
+    
     /**
      * Set verbose output.
      */
@@ -40,6 +59,92 @@ public:
      */
     void setPreprocessOnly(bool preprocessOnly) { preprocessOnly_ = preprocessOnly; }
     
+    /**
+     * Set syntax-only mode: stop after type checking. No LLVM context is
+     * created and nothing is written.
+     */
+    void setSyntaxOnly(bool syntaxOnly) { syntaxOnly_ = syntaxOnly; }
+    
+    /**
+     * Set the number of files checked at once in syntax-only mode.
+     * 0 selects the hardware concurrency.
+     */
+    void setFileJobs(unsigned jobs) { fileJobs_ = jobs; }
+    
+    /**
+     * Set whether to materialize the parse tree for the whole translation
+     * unit before building the AST. When false, declarations are parsed and
+     * converted one at a time, which lowers peak memory on large inputs.
+     */
+    void setBuildParseTree(bool buildParseTree) { buildParseTree_ = buildParseTree; }
+    
+    /**
+     * Set the number of threads used to parse function bodies.
+     * 1 parses serially; 0 selects the hardware concurrency.
+     */
+    void setParseJobs(unsigned jobs) { parseJobs_ = jobs; }
+    
+    /**
+     * Set the number of threads used to type-check function bodies.
+     * 1 checks serially; 0 selects the hardware concurrency.
+     */
+    void setSemaJobs(unsigned jobs) { semaJobs_ = jobs; }
+    
+    /**
+     * Set streaming mode: declarations flow one at a time from the lexer
+     * through parsing and code generation, and the IR is emitted in batches
+     * of separately compiled modules. Peak memory is bounded by the largest
+     * declaration and one batch rather than by the whole translation unit.
+     */
+    void setStreaming(bool streaming) { streaming_ = streaming; }
+    
+    /**
+     * Set the number of function definitions per module in streaming mode.
+     */
+    void setStreamBatchSize(size_t batchSize) { streamBatchSize_ = batchSize; }
+    
+    /**
+     * Set pipelined mode: preprocessing, lexing and parsing plus code
+     * generation run on three threads connected by bounded queues. Implies
+     * streaming.
+     */
+    void setPipeline(bool pipeline) { pipeline_ = pipeline; }
+    
+    /**
+     * Set AST-emitting mode: parse the input and write it in the binary AST
+     * format instead of compiling it. Inputs ending in .ast are read back
+     * without preprocessing or parsing.
+     */
+    void setEmitAST(bool emitAST) { emitAST_ = emitAST; }
+    
+    /**
+     * Set whether signed overflow wraps around (-fwrapv).
+     */
+    void setWrapv(bool wrapv) { codeGenOptions_.wrapv = wrapv; }
+    
+    /**
+     * Set whether loops with a non-constant condition may be assumed to
+     * terminate, as C11 allows.
+     */
+    void setFiniteLoops(bool finiteLoops) { codeGenOptions_.finiteLoops = finiteLoops; }
+    
+    /**
+     * Set whether parameters are marked noundef.
+     */
+    void setNoundefParams(bool noundefParams) { codeGenOptions_.noundefParams = noundefParams; }
+    
+    /**
+     * Set whether memory accesses carry type-based alias information.
+     */
+    void setStrictAliasing(bool strictAliasing) { codeGenOptions_.strictAliasing = strictAliasing; }
+    
+    /**
+     * Set the optimization level the IR is compiled at: "0" to "3", "s" or
+     * "z", as for -O. Only when optimizing are loop pragmas acted on, and a
+     * requested transformation that cannot be done is warned about.
+     */
+    void setOptimizationLevel(const std::string &level) { optimizationLevel_ = level; }
+    
     /**
      * Add an include directory to the preprocessor search path.
      */
@@ -54,28 +159,73 @@ private:
     bool verbose_ = false;
     bool debug_ = false;
     bool preprocessOnly_ = false;
+    bool syntaxOnly_ = false;
+    unsigned fileJobs_ = 0;
+    bool buildParseTree_ = true;
+    unsigned parseJobs_ = 1;
+    unsigned semaJobs_ = 1;
+    bool streaming_ = false;
+    size_t streamBatchSize_ = 64;
+    bool pipeline_ = false;
+    bool emitAST_ = false;
+    codegen::CodeGenOptions codeGenOptions_;
+    std::string optimizationLevel_ = "0";
     std::vector<std::string> includeDirs_;
     std::vector<std::string> macroDefinitions_;
     
     /**
-     * Preprocess the input file.
+     * Preprocess the input file into a buffer of sourceManager.
+     */
+    utils::FileID preprocessFile(const std::string &filename, utils::SourceManager &sourceManager);
+    
+    /**
+     * Check one file for checkSyntax().
+     * @param diagnostics Receives the file's syntax and type errors
+     * @return 0 if the file is free of errors, non-zero otherwise
+     */
+    int checkFile(const std::string &inputFile, std::ostream &diagnostics);
+    
+    /**
+     * Parse, generate and compile tokens one declaration at a time.
+     * @param bufferStart Location of the first character lexed
+     * @param sourceManager Holds the lexed buffer, to locate errors; may be null
+     */
+    int compileStreaming(antlr4::TokenSource *tokens, const std::string &outputFile,
+                         utils::SourceLocation bufferStart = utils::SourceLocation::getFromOffset(1),
+                         const utils::SourceManager *sourceManager = nullptr);
+    
+    /**
+     * Compile with preprocessor and lexer running on their own threads.
+     */
+    int compilePipelined(const std::string &inputFile, const std::string &outputFile);
+    
+    /**
+     * Parse source code from string and build AST in context.
+     * @param bufferStart Location of the first character of source
      */
-    std::string preprocessFile(const std::string &filename);
+    ast::TranslationUnit *parseString(std::string_view source, utils::SourceLocation bufferStart,
+                                      ast::ASTContext &context);
     
     /**
-     * Parse source code from string and build AST.
+     * Parse the input file and build AST in context.
      */
-    std::unique_ptr<ast::TranslationUnit> parseString(const std::string &source);
+    ast::TranslationUnit *parseFile(const std::string &filename, ast::ASTContext &context);
     
     /**
-     * Parse the input file and build AST.
+     * Type-check a translation unit, then generate code for it and link
+     * it into outputFile.
+     * @param types Context the AST's types were created in
+     * @param sourceManager Holds the source the AST was built from, to
+     *        locate errors; null for an AST read from a file
      */
-    std::unique_ptr<ast::TranslationUnit> parseFile(const std::string &filename);
+    int compileTranslationUnit(ast::TranslationUnit *ast, ast::TypeContext &types, const std::string &outputFile,
+                               const utils::SourceManager *sourceManager = nullptr);
     
     /**
      * Generate LLVM IR from AST.
      */
-    bool generateIR(ast::TranslationUnit *ast, const std::string &outputFile);
+    bool generateIR(ast::TranslationUnit *ast, const std::string &outputFile,
+                    const utils::SourceManager *sourceManager = nullptr);
     
     /**
      * Compile LLVM IR to object file.
@@ -83,9 +233,9 @@ private:
     bool compileToObject(const std::string &irFile, const std::string &objectFile);
     
     /**
-     * Link object file to executable.
+     * Link object files to executable.
      */
-    bool linkExecutable(const std::string &objectFile, const std::string &executableFile);
+    bool linkExecutable(const std::vector<std::string> &objectFiles, const std::string &executableFile);
     
     void log(const std::string &message);
 };
@@ -4,12 +4,26 @@
 #include <vector>
 
 void printUsage(const std::string &programName) {
-    std::cout << "Usage: " << programName << " [options] <input.c>\n"
+    std::cout << "Usage: " << programName << " [options] <input.c|input.ast>...\n"
               << "Options:\n"
               << "  -o <file>      Specify output file (default: a.out)\n"
               << "  -v             Verbose output\n"
               << "  -d             Debug mode (emit LLVM IR)\n"
               << "  -E             Preprocess only\n"
+              << "  -fsyntax-only  Parse and type-check only; accepts several input files\n"
+              << "  -j <n>         Check <n> files at once with -fsyntax-only (default: all cores)\n"
+              << "  -fno-parse-tree Parse one declaration at a time (lower peak memory)\n"
+              << "  -fparallel-parse[=<n>] Parse function bodies on <n> threads (default: all cores)\n"
+              << "  -fparallel-sema[=<n>] Type-check function bodies on <n> threads (default: all cores)\n"
+              << "  -fstreaming    Parse and generate code one declaration at a time\n"
+              << "  -fstream-batch=<n> Function definitions per module with -fstreaming (default: 64)\n"
+              << "  -fpipeline     Preprocess, lex and parse on concurrent threads (implies -fstreaming)\n"
+              << "  -O<level>      Optimize at level 0-3, s or z (default: 0); needed for loop pragmas\n"
+              << "  -fwrapv        Make signed overflow wrap around instead of undefined\n"
+              << "  -fno-finite-loops Do not assume loops with a non-constant condition terminate\n"
+              << "  -fno-noundef-params Do not assume parameters receive determinate values\n"
+              << "  -fno-strict-aliasing Do not assume objects are accessed only through compatible types\n"
+              << "  -emit-ast      Write the parsed AST (default: <input>.ast); .ast inputs are compiled directly\n"
               << "  -I <dir>       Add include directory\n"
               << "  -D <macro>     Define macro\n"
               << "  --version      Show version information\n"
@@ -27,11 +41,13 @@ int main(int argc, char *argv[]) {
         return 1;
     }
     
-    std::string inputFile;
+    std::vector<std::string> inputFiles;
     std::string outputFile = "a.out";
     bool verbose = false;
     bool debug = false;
     bool preprocessOnly = false;
+    bool syntaxOnly = false;
+    bool buildParseTree = true;
     
     driver::Driver driver;
     
@@ -51,6 +67,81 @@ int main(int argc, char *argv[]) {
             debug = true;
         } else if (arg == "-E") {
             preprocessOnly = true;
+        } else if (arg == "-fsyntax-only") {
+            syntaxOnly = true;
+        } else if (arg == "-j") {
+            if (i + 1 < argc) {
+                try {
+                    driver.setFileJobs(static_cast<unsigned>(std::stoul(argv[++i])));
+                } catch (const std::exception &) {
+                    std::cerr << "Error: invalid job count for -j\n";
+                    return 1;
+                }
+            } else {
+                std::cerr << "Error: -j requires an argument\n";
+                return 1;
+            }
+        } else if (arg == "-fno-parse-tree") {
+            buildParseTree = false;
+        } else if (arg == "-fparallel-parse") {
+            driver.setParseJobs(0);
+        } else if (arg.rfind("-fparallel-parse=", 0) == 0) {
+            try {
+                driver.setParseJobs(static_cast<unsigned>(std::stoul(arg.substr(17))));
+            } catch (const std::exception &) {
+                std::cerr << "Error: invalid thread count in " << arg << "\n";
+                return 1;
+            }
+        } else if (arg == "-fparallel-sema") {
+            driver.setSemaJobs(0);
+        } else if (arg.rfind("-fparallel-sema=", 0) == 0) {
+            try {
+                driver.setSemaJobs(static_cast<unsigned>(std::stoul(arg.substr(16))));
+            } catch (const std::exception &) {
+                std::cerr << "Error: invalid thread count in " << arg << "\n";
+                return 1;
+            }
+        } else if (arg == "-fstreaming") {
+            driver.setStreaming(true);
+        } else if (arg.rfind("-fstream-batch=", 0) == 0) {
+            try {
+                size_t batchSize = std::stoul(arg.substr(15));
+                if (batchSize == 0) {
+                    throw std::invalid_argument(arg);
+                }
+                driver.setStreamBatchSize(batchSize);
+            } catch (const std::exception &) {
+                std::cerr << "Error: invalid batch size in " << arg << "\n";
+                return 1;
+            }
+        } else if (arg == "-fpipeline") {
+            driver.setPipeline(true);
+        } else if (arg.rfind("-O", 0) == 0) {
+            std::string level = arg.substr(2);
+            if (level.empty()) {
+                level = "1";
+            }
+            if (level != "0" && level != "1" && level != "2" && level != "3" && level != "s" && level != "z") {
+                std::cerr << "Error: invalid optimization level in " << arg << "\n";
+                return 1;
+            }
+            driver.setOptimizationLevel(level);
+        } else if (arg == "-fwrapv") {
+            driver.setWrapv(true);
+        } else if (arg == "-fno-wrapv") {
+            driver.setWrapv(false);
+        } else if (arg == "-ffinite-loops") {
+            driver.setFiniteLoops(true);
+        } else if (arg == "-fno-finite-loops") {
+            driver.setFiniteLoops(false);
+        } else if (arg == "-fno-noundef-params") {
+            driver.setNoundefParams(false);
+        } else if (arg == "-fstrict-aliasing") {
+            driver.setStrictAliasing(true);
+        } else if (arg == "-fno-strict-aliasing") {
+            driver.setStrictAliasing(false);
+        } else if (arg == "-emit-ast") {
+            driver.setEmitAST(true);
         } else if (arg == "-I") {
             if (i + 1 < argc) {
                 driver.addIncludeDirectory(argv[++i]);
@@ -73,28 +164,32 @@ int main(int argc, char *argv[]) {
                 return 1;
             }
         } else if (arg.front() != '-') {
-            if (inputFile.empty()) {
-                inputFile = arg;
-            } else {
-                std::cerr << "Error: Multiple input files not supported\n";
-                return 1;
-            }
+            inputFiles.push_back(arg);
         } else {
             std::cerr << "Error: Unknown option " << arg << "\n";
             return 1;
         }
     }
     
-    if (inputFile.empty()) {
+    if (inputFiles.empty()) {
         std::cerr << "Error: No input file specified\n";
         printUsage(argv[0]);
         return 1;
     }
+    if (inputFiles.size() > 1 && !syntaxOnly) {
+        std::cerr << "Error: Multiple input files are only supported with -fsyntax-only\n";
+        return 1;
+    }
     
     // Configure driver
     driver.setVerbose(verbose);
     driver.setDebug(debug);
     driver.setPreprocessOnly(preprocessOnly);
+    driver.setSyntaxOnly(syntaxOnly);
+    driver.setBuildParseTree(buildParseTree);
     
-    return driver.compile(inputFile, outputFile);
+    if (syntaxOnly) {
+        return driver.checkSyntax(inputFiles);
+    }
+    return driver.compile(inputFiles.front(), outputFile);
 }
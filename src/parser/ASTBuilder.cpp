@@ -1,850 +1,1014 @@
 #include "parser/ASTBuilder.h"
-#include "CParser.h"
-#include <stdexcept>
-#include <sstream>
+#include "ast/Casting.h"
+#include "utils/Error.h"
+#include <algorithm>
 #include <cctype>
-#include <iostream>
+#include <charconv>
+#include <cstdlib>
+#include <iterator>
 
 namespace parser {
 
-antlrcpp::Any ASTBuilder::visitTranslationUnit(CParser::TranslationUnitContext *ctx) {
-    std::vector<std::unique_ptr<ast::Node>> declarations;
+ast::TranslationUnit *ASTBuilder::buildTranslationUnit(CParser::TranslationUnitContext *ctx) {
+    std::vector<ast::Node*> declarations;
     
     for (auto *extDecl : ctx->externalDeclaration()) {
-        auto result = visit(extDecl);
-        try {
-            auto *node_ptr = std::any_cast<ast::Node*>(result);
-            if (node_ptr) {
-                declarations.push_back(std::unique_ptr<ast::Node>(node_ptr));
-            }
-        } catch (const std::bad_any_cast&) {
-            // Skip invalid nodes
+        if (auto *decl = buildExternalDeclaration(extDecl)) {
+            declarations.push_back(decl);
         }
     }
     
-    // Return raw pointer that will be wrapped by caller
-    return static_cast<ast::TranslationUnit*>(new ast::TranslationUnit(std::move(declarations)));
+    return context_.create<ast::TranslationUnit>(context_.copyArray(declarations));
 }
 
-antlrcpp::Any ASTBuilder::visitExternalDeclaration(CParser::ExternalDeclarationContext *ctx) {
-    if (ctx->functionDefinition()) {
-        return visit(ctx->functionDefinition());
-    } else if (ctx->declaration()) {
-        return visit(ctx->declaration());
+ast::Node *ASTBuilder::buildExternalDeclaration(CParser::ExternalDeclarationContext *ctx) {
+    if (auto *funcDef = ctx->functionDefinition()) {
+        return buildFunctionDefinition(funcDef);
+    } else if (auto *decl = ctx->declaration()) {
+        return buildDeclaration(decl);
     }
     return nullptr;
 }
 
-antlrcpp::Any ASTBuilder::visitFunctionDefinition(CParser::FunctionDefinitionContext *ctx) {
-    std::string returnType = extractTypeFromSpecifiers(ctx->declarationSpecifiers());
-    std::string name = extractIdentifierName(ctx->declarator()->directDeclarator());
+ast::FunctionDecl *ASTBuilder::buildFunctionDefinition(CParser::FunctionDefinitionContext *ctx) {
+    // Without specifiers the return type is implicitly int
+    const ast::Type *returnType = ctx->declarationSpecifiers()
+        ? buildSpecifierType(ctx->declarationSpecifiers()->declarationSpecifier())
+        : context_.getTypes().getIntType();
+    if (auto *function = ast::dyn_cast<ast::FunctionType>(applyDeclarator(returnType, ctx->declarator()))) {
+        returnType = function->getReturnType();
+    }
     
-    std::vector<std::pair<std::string, std::string>> parameters;
-    if (auto *directDecl = ctx->declarator()->directDeclarator()) {
-        for (auto *child : directDecl->children) {
-            if (auto *paramList = dynamic_cast<CParser::ParameterTypeListContext*>(child)) {
-                parameters = extractParameters(paramList);
-                break;
-            }
+    auto *body = buildCompoundStatement(ctx->compoundStatement());
+    
+    return setLocation(buildFunctionDecl(returnType, ctx->declarator(), body), ctx->getStart());
+}
+
+ast::FunctionDecl *ASTBuilder::buildFunctionDecl(const ast::Type *returnType, CParser::DeclaratorContext *declarator,
+                                                 ast::CompoundStmt *body) {
+    std::string name = extractIdentifierName(declarator->directDeclarator());
+    
+    std::span<ast::FunctionDecl::Parameter> parameters;
+    bool hasPrototype = false;
+    if (auto *directDecl = declarator->directDeclarator()) {
+        if (auto *paramList = directDecl->parameterTypeList()) {
+            parameters = extractParameters(paramList);
+            hasPrototype = true;
         }
     }
     
-    auto result = visit(ctx->compoundStatement());
-    auto *body_ptr = std::any_cast<ast::CompoundStmt*>(result);
-    auto body = std::unique_ptr<ast::CompoundStmt>(body_ptr);
+    auto *function = context_.create<ast::FunctionDecl>(context_.getIdentifier(name), returnType, parameters, body);
+    function->hasPrototype = hasPrototype;
+    return function;
+}
+
+ast::Node *ASTBuilder::buildDeclaration(CParser::DeclarationContext *ctx) {
+    if (auto *staticAssert = ctx->staticAssertDeclaration()) {
+        checkStaticAssert(staticAssert);
+        return nullptr;
+    }
+    
+    auto *initDeclList = ctx->initDeclaratorList();
+    if (!initDeclList) {
+        return nullptr;
+    }
     
-    // Return raw pointer
-    return static_cast<ast::Node*>(new ast::FunctionDecl(name, returnType, std::move(parameters), std::move(body)));
+    // For now, handle single declarators
+    const ast::Type *baseType = buildSpecifierType(ctx->declarationSpecifiers()->declarationSpecifier());
+    auto *initDecl = initDeclList->initDeclarator(0);
+    if (auto *function = ast::dyn_cast<ast::FunctionType>(applyDeclarator(baseType, initDecl->declarator()))) {
+        // A prototype
+        return setLocation(buildFunctionDecl(function->getReturnType(), initDecl->declarator(), nullptr),
+                           ctx->getStart());
+    }
+    return buildVarDecl(baseType, initDecl);
 }
 
-antlrcpp::Any ASTBuilder::visitDeclaration(CParser::DeclarationContext *ctx) {
-    std::string baseType = extractTypeFromSpecifiers(ctx->declarationSpecifiers());
+ast::VarDecl *ASTBuilder::buildVarDecl(const ast::Type *baseType, CParser::InitDeclaratorContext *ctx) {
+    auto *declarator = ctx->declarator();
+    if (!declarator->directDeclarator()) {
+        return nullptr;
+    }
     
-    if (ctx->initDeclaratorList()) {
-        // For now, handle single variable declarations
-        auto *initDecl = ctx->initDeclaratorList()->initDeclarator(0);
-        auto *declarator = initDecl->declarator();
-        
-        // Build full type including pointers
-        std::string fullType = baseType;
-        if (declarator->pointer()) {
-            // Count the number of '*' characters for pointer depth
-            std::string pointerText = declarator->pointer()->getText();
-            for (char c : pointerText) {
-                if (c == '*') {
-                    fullType += "*";
-                }
-            }
-        }
-        
-        std::string name = extractIdentifierName(declarator->directDeclarator());
-        
-        std::unique_ptr<ast::Expr> initializer = nullptr;
-        if (initDecl->initializer()) {
-            auto result = visit(initDecl->initializer()->assignmentExpression());
-            auto *expr_ptr = std::any_cast<ast::Expr*>(result);
-            initializer = std::unique_ptr<ast::Expr>(expr_ptr);
-        }
-        
-        return static_cast<ast::Node*>(new ast::VarDecl(name, fullType, std::move(initializer)));
+    const ast::Type *type = applyDeclarator(baseType, declarator);
+    std::string name = extractIdentifierName(declarator->directDeclarator());
+    
+    ast::Expr *initializer = nullptr;
+    if (ctx->initializer() && ctx->initializer()->assignmentExpression()) {
+        initializer = buildAssignmentExpression(ctx->initializer()->assignmentExpression());
     }
     
-    return nullptr;
+    return setLocation(context_.create<ast::VarDecl>(context_.getIdentifier(name), type, initializer),
+                       ctx->getStart());
 }
 
-antlrcpp::Any ASTBuilder::visitCompoundStatement(CParser::CompoundStatementContext *ctx) {
-    std::vector<std::unique_ptr<ast::Stmt>> statements;
+void ASTBuilder::checkStaticAssert(CParser::StaticAssertDeclarationContext *ctx) {
+    std::string where = "line " + std::to_string(ctx->getStart()->getLine());
+    auto *condition = buildConditionalExpression(ctx->constantExpression()->conditionalExpression());
+    auto value = evaluator_.evaluateAsInteger(condition);
+    if (!value) {
+        throw utils::SemanticError("static assertion expression at " + where +
+                                   " is not an integer constant expression: " + evaluator_.getFailureReason());
+    }
+    if (*value == 0) {
+        std::string message;
+        for (auto *literal : ctx->StringLiteral()) {
+            message += parseStringLiteral(literal->getText());
+        }
+        throw utils::SemanticError("static assertion failed at " + where + ": " + message);
+    }
+}
+
+ast::CompoundStmt *ASTBuilder::buildCompoundStatement(CParser::CompoundStatementContext *ctx) {
+    std::vector<ast::Stmt*> statements;
     
     if (ctx->blockItemList()) {
         for (auto *item : ctx->blockItemList()->blockItem()) {
+            ast::Stmt *stmt = nullptr;
             if (item->statement()) {
-                auto result = visit(item->statement());
-                auto *stmt_ptr = std::any_cast<ast::Stmt*>(result);
-                if (stmt_ptr) {
-                    statements.push_back(std::unique_ptr<ast::Stmt>(stmt_ptr));
-                }
+                stmt = buildStatement(item->statement());
             } else if (item->declaration()) {
-                auto result = visit(item->declaration());
-                auto *decl_ptr = std::any_cast<ast::Node*>(result);
-                if (auto *varDecl = dynamic_cast<ast::VarDecl*>(decl_ptr)) {
-                    statements.push_back(std::unique_ptr<ast::VarDecl>(varDecl));
-                }
+                // Block-scope prototypes produce no statement
+                stmt = ast::dyn_cast_or_null<ast::Stmt>(buildDeclaration(item->declaration()));
+            }
+            if (stmt) {
+                statements.push_back(stmt);
             }
         }
     }
     
-    return static_cast<ast::CompoundStmt*>(new ast::CompoundStmt(std::move(statements)));
+    return setLocation(context_.create<ast::CompoundStmt>(context_.copyArray(statements)), ctx->getStart());
 }
 
-antlrcpp::Any ASTBuilder::visitExpressionStatement(CParser::ExpressionStatementContext *ctx) {
-    if (auto *exprCtx = ctx->expression()) {
-        auto expr = extractExpr(visit(exprCtx));
-        return std::any(static_cast<ast::Stmt*>(new ast::ExprStmt(std::move(expr))));
+ast::Stmt *ASTBuilder::buildStatement(CParser::StatementContext *ctx) {
+    ast::Stmt *stmt = nullptr;
+    if (ctx->compoundStatement()) {
+        stmt = buildCompoundStatement(ctx->compoundStatement());
+    } else if (ctx->expressionStatement()) {
+        stmt = buildExpressionStatement(ctx->expressionStatement());
+    } else if (ctx->selectionStatement()) {
+        stmt = buildSelectionStatement(ctx->selectionStatement());
+    } else if (ctx->iterationStatement()) {
+        stmt = buildIterationStatement(ctx->iterationStatement());
+    } else if (ctx->jumpStatement()) {
+        stmt = buildJumpStatement(ctx->jumpStatement());
     }
-    return std::any(static_cast<ast::Stmt*>(new ast::ExprStmt(nullptr)));
+    return setLocation(stmt, ctx->getStart());
 }
 
-std::any ASTBuilder::visitJumpStatement(CParser::JumpStatementContext *ctx) {
+ast::Stmt *ASTBuilder::buildExpressionStatement(CParser::ExpressionStatementContext *ctx) {
+    ast::Expr *expr = ctx->expression() ? buildExpression(ctx->expression()) : nullptr;
+    return context_.create<ast::ExprStmt>(expr);
+}
+
+ast::Stmt *ASTBuilder::buildJumpStatement(CParser::JumpStatementContext *ctx) {
     if (ctx->Return()) {
-        auto expr = ctx->expression() ? extractExpr(visit(ctx->expression())) : nullptr;
-        return std::any(static_cast<ast::Stmt*>(new ast::ReturnStmt(std::move(expr))));
+        auto *expr = ctx->expression() ? buildExpression(ctx->expression()) : nullptr;
+        return context_.create<ast::ReturnStmt>(expr);
     } else if (ctx->Break()) {
-        return std::any(static_cast<ast::Stmt*>(new ast::BreakStmt()));
+        return context_.create<ast::BreakStmt>();
     } else if (ctx->Continue()) {
-        return std::any(static_cast<ast::Stmt*>(new ast::ContinueStmt()));
+        return context_.create<ast::ContinueStmt>();
     }
     return nullptr;
 }
 
-antlrcpp::Any ASTBuilder::visitExpression(CParser::ExpressionContext *ctx) {
-    // For comma operator, just return the last expression for simplicity
-    auto exprs = ctx->assignmentExpression();
-    return visit(exprs.back());
-}
-
-antlrcpp::Any ASTBuilder::visitAssignmentExpression(CParser::AssignmentExpressionContext *ctx) {
-    if (ctx->assignmentOperator()) {
-        auto leftResult = visit(ctx->unaryExpression());
-        auto left = std::unique_ptr<ast::Expr>(std::any_cast<ast::Expr*>(leftResult));
-        auto rightResult = visit(ctx->assignmentExpression());
-        auto right = std::unique_ptr<ast::Expr>(std::any_cast<ast::Expr*>(rightResult));
-        
-        // Parse the assignment operator type
-        std::string opText = ctx->assignmentOperator()->getText();
-        ast::BinaryExpr::OpKind op = ast::BinaryExpr::OpKind::Assign; // Default
-        
-        if (opText == "=") op = ast::BinaryExpr::OpKind::Assign;
-        else if (opText == "+=") op = ast::BinaryExpr::OpKind::AddAssign;
-        else if (opText == "-=") op = ast::BinaryExpr::OpKind::SubAssign;
-        else if (opText == "*=") op = ast::BinaryExpr::OpKind::MulAssign;
-        else if (opText == "/=") op = ast::BinaryExpr::OpKind::DivAssign;
-        else if (opText == "%=") op = ast::BinaryExpr::OpKind::ModAssign;
-        
-        return std::any(static_cast<ast::Expr*>(new ast::BinaryExpr(
-            std::move(left), std::move(right), op
-        )));
+ast::Stmt *ASTBuilder::buildSelectionStatement(CParser::SelectionStatementContext *ctx) {
+    if (!ctx->If()) {
+        // TODO: Handle switch statement
+        return nullptr;
     }
-    return visit(ctx->conditionalExpression());
+    
+    auto *condition = buildExpression(ctx->expression());
+    auto *thenStmt = buildStatement(ctx->statement(0));
+    ast::Stmt *elseStmt = nullptr;
+    if (ctx->statement().size() > 1) {
+        elseStmt = buildStatement(ctx->statement(1));
+    }
+    
+    return context_.create<ast::IfStmt>(condition, thenStmt, elseStmt);
 }
 
-antlrcpp::Any ASTBuilder::visitConditionalExpression(CParser::ConditionalExpressionContext *ctx) {
-    // Handle ternary operator: condition ? true_expr : false_expr
-    auto conditionResult = visit(ctx->logicalOrExpression());
-    auto condition = std::unique_ptr<ast::Expr>(std::any_cast<ast::Expr*>(conditionResult));
-    
-    // Check if this is actually a ternary expression
-    if (ctx->expression() && ctx->conditionalExpression()) {
-        // This is a ternary expression
-        auto trueResult = visit(ctx->expression());
-        auto trueExpr = std::unique_ptr<ast::Expr>(std::any_cast<ast::Expr*>(trueResult));
+ast::Stmt *ASTBuilder::buildIterationStatement(CParser::IterationStatementContext *ctx) {
+    ast::LoopHints hints = buildLoopHints(ctx);
+    if (ctx->For()) {
+        // for '(' forCondition ')' statement
+        auto *forCondition = ctx->forCondition();
+        ast::Stmt *init = nullptr;
+        ast::Expr *condition = nullptr;
+        ast::Expr *increment = nullptr;
         
-        auto falseResult = visit(ctx->conditionalExpression());
-        auto falseExpr = std::unique_ptr<ast::Expr>(std::any_cast<ast::Expr*>(falseResult));
+        // Init is either a declaration or an expression
+        if (forCondition->forDeclaration()) {
+            init = buildForDeclaration(forCondition->forDeclaration());
+        } else if (forCondition->expression()) {
+            init = context_.create<ast::ExprStmt>(buildExpression(forCondition->expression()));
+        }
         
-        return std::any(static_cast<ast::Expr*>(new ast::ConditionalExpr(
-            std::move(condition), std::move(trueExpr), std::move(falseExpr))));
-    } else {
-        // Just a regular logical OR expression
-        return std::any(condition.release());
+        // forExpression? ';' forExpression? cannot tell which one is present
+        // from the list alone, so look at where the ';' separators fall
+        size_t semis = 0;
+        for (auto *child : forCondition->children) {
+            if (auto *term = dynamic_cast<antlr4::tree::TerminalNode*>(child)) {
+                if (term->getSymbol()->getType() == CParser::Semi) {
+                    ++semis;
+                }
+            } else if (auto *forExpr = dynamic_cast<CParser::ForExpressionContext*>(child)) {
+                if (semis == 1) {
+                    condition = buildForExpression(forExpr);
+                } else {
+                    increment = buildForExpression(forExpr);
+                }
+            }
+        }
+        
+        auto *body = buildStatement(ctx->statement());
+        auto *loop = context_.create<ast::ForStmt>(init, condition, increment, body);
+        loop->hints = hints;
+        return loop;
     }
-}
-
-antlrcpp::Any ASTBuilder::visitLogicalOrExpression(CParser::LogicalOrExpressionContext *ctx) {
-    auto leftResult = visit(ctx->logicalAndExpression(0));
-    auto left = std::unique_ptr<ast::Expr>(std::any_cast<ast::Expr*>(leftResult));
     
-    for (size_t i = 1; i < ctx->logicalAndExpression().size(); ++i) {
-        auto rightResult = visit(ctx->logicalAndExpression(i));
-        auto right = std::unique_ptr<ast::Expr>(std::any_cast<ast::Expr*>(rightResult));
-        left = std::make_unique<ast::BinaryExpr>(
-            std::move(left), std::move(right), ast::BinaryExpr::OpKind::LogicalOr
-        );
+    if (ctx->Do()) {
+        // Do-while is not modelled yet, and its pragmas go with it
+        return nullptr;
     }
     
-    return std::any(left.release());
+    // while '(' expression ')' statement
+    auto *condition = buildExpression(ctx->expression());
+    auto *body = buildStatement(ctx->statement());
+    auto *loop = context_.create<ast::WhileStmt>(condition, body);
+    loop->hints = hints;
+    return loop;
 }
 
-antlrcpp::Any ASTBuilder::visitLogicalAndExpression(CParser::LogicalAndExpressionContext *ctx) {
-    auto leftResult = visit(ctx->inclusiveOrExpression(0));
-    auto left = std::unique_ptr<ast::Expr>(std::any_cast<ast::Expr*>(leftResult));
-    
-    for (size_t i = 1; i < ctx->inclusiveOrExpression().size(); ++i) {
-        auto rightResult = visit(ctx->inclusiveOrExpression(i));
-        auto right = std::unique_ptr<ast::Expr>(std::any_cast<ast::Expr*>(rightResult));
-        left = std::make_unique<ast::BinaryExpr>(
-            std::move(left), std::move(right), ast::BinaryExpr::OpKind::LogicalAnd
-        );
-    }
-    
-    return std::any(left.release());
-}
+namespace {
 
-antlrcpp::Any ASTBuilder::visitInclusiveOrExpression(CParser::InclusiveOrExpressionContext *ctx) {
-    auto leftResult = visit(ctx->exclusiveOrExpression(0));
-    auto left = std::unique_ptr<ast::Expr>(std::any_cast<ast::Expr*>(leftResult));
-    
-    for (size_t i = 1; i < ctx->exclusiveOrExpression().size(); ++i) {
-        auto rightResult = visit(ctx->exclusiveOrExpression(i));
-        auto right = std::unique_ptr<ast::Expr>(std::any_cast<ast::Expr*>(rightResult));
-        left = std::make_unique<ast::BinaryExpr>(
-            std::move(left), std::move(right), ast::BinaryExpr::OpKind::BitwiseOr
-        );
+/**
+ * Splits a pragma line into words, numbers and single punctuation
+ * characters, and reports malformed ones.
+ */
+class PragmaReader {
+public:
+    PragmaReader(std::string_view text, size_t line) : text_(text), line_(line) {}
+
+    /** The next token, or an empty one at the end of the line. */
+    std::string_view next() {
+        while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_]))) {
+            ++pos_;
+        }
+        size_t start = pos_;
+        while (pos_ < text_.size() && (std::isalnum(static_cast<unsigned char>(text_[pos_])) || text_[pos_] == '_')) {
+            ++pos_;
+        }
+        if (pos_ == start && pos_ < text_.size()) {
+            ++pos_;
+        }
+        return text_.substr(start, pos_ - start);
     }
-    
-    return std::any(left.release());
-}
 
-antlrcpp::Any ASTBuilder::visitExclusiveOrExpression(CParser::ExclusiveOrExpressionContext *ctx) {
-    auto left = extractExpr(visit(ctx->andExpression(0)));
-    
-    for (size_t i = 1; i < ctx->andExpression().size(); ++i) {
-        auto right = extractExpr(visit(ctx->andExpression(i)));
-        left = std::make_unique<ast::BinaryExpr>(
-            std::move(left), std::move(right), ast::BinaryExpr::OpKind::BitwiseXor
-        );
+    std::string_view peek() {
+        size_t pos = pos_;
+        std::string_view token = next();
+        pos_ = pos;
+        return token;
     }
-    
-    return std::any(left.release());
-}
 
-antlrcpp::Any ASTBuilder::visitAndExpression(CParser::AndExpressionContext *ctx) {
-    auto left = extractExpr(visit(ctx->equalityExpression(0)));
-    
-    for (size_t i = 1; i < ctx->equalityExpression().size(); ++i) {
-        auto right = extractExpr(visit(ctx->equalityExpression(i)));
-        left = std::make_unique<ast::BinaryExpr>(
-            std::move(left), std::move(right), ast::BinaryExpr::OpKind::BitwiseAnd
-        );
+    void expect(std::string_view token) {
+        std::string_view found = next();
+        if (found != token) {
+            fail("expected '" + std::string(token) + "' but found '" + std::string(found) + "'");
+        }
     }
-    
-    return std::any(left.release());
-}
 
-antlrcpp::Any ASTBuilder::visitEqualityExpression(CParser::EqualityExpressionContext *ctx) {
-    auto left = extractExpr(visit(ctx->relationalExpression(0)));
-    
-    for (size_t i = 1; i < ctx->relationalExpression().size(); ++i) {
-        auto right = extractExpr(visit(ctx->relationalExpression(i)));
-        
-        ast::BinaryExpr::OpKind op;
-        if (i - 1 < ctx->children.size()) {
-            auto *token = dynamic_cast<antlr4::tree::TerminalNode*>(ctx->children[2*i - 1]);
-            if (token && token->getSymbol()->getType() == CParser::Equal) {
-                op = ast::BinaryExpr::OpKind::EQ;
+    /** A positive integer literal, the value of option. */
+    uint32_t readCount(std::string_view option) {
+        std::string_view token = next();
+        uint32_t value = 0;
+        auto [ptr, ec] = std::from_chars(token.data(), token.data() + token.size(), value);
+        if (token.empty() || ec != std::errc() || ptr != token.data() + token.size() || value == 0) {
+            fail("invalid value '" + std::string(token) + "' for " + std::string(option) +
+                 "; must be a positive integer");
+        }
+        return value;
+    }
+
+    [[noreturn]] void fail(const std::string &message) const {
+        throw utils::SemanticError("malformed loop pragma at line " + std::to_string(line_) + ": " + message);
+    }
+
+private:
+    std::string_view text_;
+    size_t pos_ = 0;
+    size_t line_;
+};
+
+} // namespace
+
+ast::LoopHints ASTBuilder::buildLoopHints(CParser::IterationStatementContext *ctx) {
+    using State = ast::LoopHints::State;
+    ast::LoopHints hints;
+    auto setUnrollCount = [&hints](uint32_t count) {
+        // A count of 1 leaves the body as it is
+        hints.unroll = count == 1 ? State::Disable : State::Enable;
+        hints.unrollCount = count == 1 ? 0 : count;
+    };
+    for (auto *pragma : ctx->PragmaDirective()) {
+        std::string text = pragma->getText();
+        PragmaReader reader(text, pragma->getSymbol()->getLine());
+        reader.expect("#");
+        reader.expect("pragma");
+        std::string_view first = reader.next();
+        if (first == "GCC") {
+            if (reader.next() == "ivdep") {
+                hints.independentIterations = true;
+            } else if (reader.peek() == "0") {
+                // GCC unroll N; GCC also takes 0 for no unrolling
+                reader.next();
+                setUnrollCount(1);
             } else {
-                op = ast::BinaryExpr::OpKind::NE;
+                setUnrollCount(reader.readCount("GCC unroll"));
+            }
+        } else if (first == "unroll") {
+            // #pragma unroll, unroll N or unroll(N); without a count the
+            // unroller picks one
+            bool parenthesized = reader.peek() == "(";
+            if (parenthesized) {
+                reader.next();
+            }
+            if (parenthesized || !reader.peek().empty()) {
+                setUnrollCount(reader.readCount("unroll"));
+            } else {
+                hints.unroll = State::Enable;
+                hints.unrollCount = 0;
+            }
+            if (parenthesized) {
+                reader.expect(")");
+            }
+        } else if (first == "nounroll") {
+            hints.unroll = State::Disable;
+            hints.unrollCount = 0;
+        } else if (first == "omp") {
+            // The loop is to be vectorized without regard to dependences;
+            // of the clauses, only the width is a hint
+            reader.expect("simd");
+            hints.vectorize = State::Enable;
+            hints.independentIterations = true;
+            for (auto clause = reader.next(); !clause.empty(); clause = reader.next()) {
+                if (clause == "simdlen") {
+                    reader.expect("(");
+                    hints.vectorizeWidth = reader.readCount("simdlen");
+                    reader.expect(")");
+                }
             }
         } else {
-            op = ast::BinaryExpr::OpKind::EQ;
+            // #pragma clang loop option(value) ...
+            if (first != "clang") {
+                reader.fail("unknown pragma '" + std::string(first) + "'");
+            }
+            reader.expect("loop");
+            for (auto option = reader.next(); !option.empty(); option = reader.next()) {
+                reader.expect("(");
+                if (option == "vectorize_width") {
+                    hints.vectorizeWidth = reader.readCount(option);
+                } else if (option == "interleave_count") {
+                    hints.interleaveCount = reader.readCount(option);
+                } else if (option == "unroll_count") {
+                    hints.unroll = State::Enable;
+                    hints.unrollCount = reader.readCount(option);
+                } else if (option == "vectorize" || option == "interleave" || option == "unroll") {
+                    std::string_view value = reader.next();
+                    State state;
+                    if (value == "enable") {
+                        state = State::Enable;
+                    } else if (value == "disable") {
+                        state = State::Disable;
+                    } else if (value == "full" && option == "unroll") {
+                        state = State::Full;
+                    } else if (value == "assume_safety" && option == "vectorize") {
+                        state = State::Enable;
+                        hints.independentIterations = true;
+                    } else {
+                        reader.fail("invalid argument '" + std::string(value) + "' to " + std::string(option));
+                    }
+                    (option == "vectorize" ? hints.vectorize : option == "interleave" ? hints.interleave
+                                                                                       : hints.unroll) = state;
+                } else {
+                    reader.fail("unknown option '" + std::string(option) + "'");
+                }
+                reader.expect(")");
+            }
         }
-        
-        left = std::make_unique<ast::BinaryExpr>(std::move(left), std::move(right), op);
     }
-    
-    return std::any(left.release());
+    return hints;
 }
 
-antlrcpp::Any ASTBuilder::visitRelationalExpression(CParser::RelationalExpressionContext *ctx) {
-    auto left = extractExpr(visit(ctx->shiftExpression(0)));
-    
-    for (size_t i = 1; i < ctx->shiftExpression().size(); ++i) {
-        auto right = extractExpr(visit(ctx->shiftExpression(i)));
-        
-        ast::BinaryExpr::OpKind op = ast::BinaryExpr::OpKind::LT; // Default
-        
-        // Find the operator between expressions
-        if (2*i - 1 < ctx->children.size()) {
-            auto *token = dynamic_cast<antlr4::tree::TerminalNode*>(ctx->children[2*i - 1]);
-            if (token) {
-                std::string opText = token->getText();
-                if (opText == "<") op = ast::BinaryExpr::OpKind::LT;
-                else if (opText == ">") op = ast::BinaryExpr::OpKind::GT;
-                else if (opText == "<=") op = ast::BinaryExpr::OpKind::LE;
-                else if (opText == ">=") op = ast::BinaryExpr::OpKind::GE;
-            }
-        }
-        
-        left = std::make_unique<ast::BinaryExpr>(std::move(left), std::move(right), op);
+ast::VarDecl *ASTBuilder::buildForDeclaration(CParser::ForDeclarationContext *ctx) {
+    auto *initDeclList = ctx->initDeclaratorList();
+    if (!initDeclList || initDeclList->initDeclarator().empty()) {
+        return nullptr;
     }
     
-    return std::any(left.release());
+    // Only the first declarator is kept, as for ordinary declarations
+    const ast::Type *type = buildSpecifierType(ctx->declarationSpecifiers()->declarationSpecifier());
+    return buildVarDecl(type, initDeclList->initDeclarator(0));
 }
 
-antlrcpp::Any ASTBuilder::visitShiftExpression(CParser::ShiftExpressionContext *ctx) {
-    auto left = extractExpr(visit(ctx->additiveExpression(0)));
-    
-    for (size_t i = 1; i < ctx->additiveExpression().size(); ++i) {
-        auto right = extractExpr(visit(ctx->additiveExpression(i)));
-        
-        // Simplified - assume << for now
-        ast::BinaryExpr::OpKind op = ast::BinaryExpr::OpKind::LeftShift;
-        
-        left = std::make_unique<ast::BinaryExpr>(std::move(left), std::move(right), op);
+ast::Expr *ASTBuilder::buildForExpression(CParser::ForExpressionContext *ctx) {
+    // Comma operator semantics: the value is that of the last expression
+    return buildAssignmentExpression(ctx->assignmentExpression().back());
+}
+
+ast::Expr *ASTBuilder::buildExpression(CParser::ExpressionContext *ctx) {
+    // For comma operator, just return the last expression for simplicity
+    return buildAssignmentExpression(ctx->assignmentExpression().back());
+}
+
+ast::Expr *ASTBuilder::buildAssignmentExpression(CParser::AssignmentExpressionContext *ctx) {
+    if (auto *assignOp = ctx->assignmentOperator()) {
+        auto *left = buildUnaryExpression(ctx->unaryExpression());
+        auto *right = buildAssignmentExpression(ctx->assignmentExpression());
+        return setLocation(context_.create<ast::BinaryExpr>(left, right, tokenToAssignmentOp(assignOp->getStart())),
+                           assignOp->getStart());
     }
-    
-    return std::any(left.release());
+    if (ctx->conditionalExpression()) {
+        return buildConditionalExpression(ctx->conditionalExpression());
+    }
+    return nullptr;
 }
 
-antlrcpp::Any ASTBuilder::visitAdditiveExpression(CParser::AdditiveExpressionContext *ctx) {
-    auto left = extractExpr(visit(ctx->multiplicativeExpression(0)));
+ast::Expr *ASTBuilder::buildConditionalExpression(CParser::ConditionalExpressionContext *ctx) {
+    auto *condition = buildLogicalOrExpression(ctx->logicalOrExpression());
     
-    for (size_t i = 1; i < ctx->multiplicativeExpression().size(); ++i) {
-        auto right = extractExpr(visit(ctx->multiplicativeExpression(i)));
-        
-        ast::BinaryExpr::OpKind op;
-        if (i - 1 < ctx->children.size()) {
-            auto *token = dynamic_cast<antlr4::tree::TerminalNode*>(ctx->children[2*i - 1]);
-            if (token && token->getSymbol()->getType() == CParser::Plus) {
-                op = ast::BinaryExpr::OpKind::Add;
-            } else {
-                op = ast::BinaryExpr::OpKind::Sub;
-            }
-        } else {
-            op = ast::BinaryExpr::OpKind::Add;
-        }
-        
-        left = std::make_unique<ast::BinaryExpr>(std::move(left), std::move(right), op);
+    // condition ? true_expr : false_expr
+    if (ctx->expression() && ctx->conditionalExpression()) {
+        auto *trueExpr = buildExpression(ctx->expression());
+        auto *falseExpr = buildConditionalExpression(ctx->conditionalExpression());
+        auto *conditional = context_.create<ast::ConditionalExpr>(condition, trueExpr, falseExpr);
+        return evaluator_.fold(setLocation(conditional, ctx->getStart()), context_);
     }
     
-    return std::any(left.release());
+    return condition;
 }
 
-antlrcpp::Any ASTBuilder::visitMultiplicativeExpression(CParser::MultiplicativeExpressionContext *ctx) {
-    auto left = extractExpr(visit(ctx->castExpression(0)));
+template <typename Operand>
+ast::Expr *ASTBuilder::buildBinaryChain(antlr4::ParserRuleContext *ctx, const std::vector<Operand*> &operands,
+                                        ast::Expr *(ASTBuilder::*buildOperand)(Operand*)) {
+    auto *left = (this->*buildOperand)(operands[0]);
     
-    for (size_t i = 1; i < ctx->castExpression().size(); ++i) {
-        auto right = extractExpr(visit(ctx->castExpression(i)));
-        
-        ast::BinaryExpr::OpKind op;
-        if (i - 1 < ctx->children.size()) {
-            auto *token = dynamic_cast<antlr4::tree::TerminalNode*>(ctx->children[2*i - 1]);
-            if (token) {
-                switch (token->getSymbol()->getType()) {
-                    case CParser::Star: op = ast::BinaryExpr::OpKind::Mul; break;
-                    case CParser::Div: op = ast::BinaryExpr::OpKind::Div; break;
-                    case CParser::Mod: op = ast::BinaryExpr::OpKind::Mod; break;
-                    default: op = ast::BinaryExpr::OpKind::Mul; break;
-                }
-            } else {
-                op = ast::BinaryExpr::OpKind::Mul;
-            }
-        } else {
-            op = ast::BinaryExpr::OpKind::Mul;
-        }
-        
-        left = std::make_unique<ast::BinaryExpr>(std::move(left), std::move(right), op);
+    for (size_t i = 1; i < operands.size(); ++i) {
+        auto *right = (this->*buildOperand)(operands[i]);
+        auto *token = static_cast<antlr4::tree::TerminalNode*>(ctx->children[2*i - 1]);
+        left = setLocation(context_.create<ast::BinaryExpr>(left, right, tokenToBinaryOp(token->getSymbol())),
+                           token->getSymbol());
+        left = evaluator_.fold(left, context_);
     }
     
-    return std::any(left.release());
+    return left;
+}
+
+ast::Expr *ASTBuilder::buildLogicalOrExpression(CParser::LogicalOrExpressionContext *ctx) {
+    return buildBinaryChain(ctx, ctx->logicalAndExpression(), &ASTBuilder::buildLogicalAndExpression);
+}
+
+ast::Expr *ASTBuilder::buildLogicalAndExpression(CParser::LogicalAndExpressionContext *ctx) {
+    return buildBinaryChain(ctx, ctx->inclusiveOrExpression(), &ASTBuilder::buildInclusiveOrExpression);
+}
+
+ast::Expr *ASTBuilder::buildInclusiveOrExpression(CParser::InclusiveOrExpressionContext *ctx) {
+    return buildBinaryChain(ctx, ctx->exclusiveOrExpression(), &ASTBuilder::buildExclusiveOrExpression);
+}
+
+ast::Expr *ASTBuilder::buildExclusiveOrExpression(CParser::ExclusiveOrExpressionContext *ctx) {
+    return buildBinaryChain(ctx, ctx->andExpression(), &ASTBuilder::buildAndExpression);
 }
 
-antlrcpp::Any ASTBuilder::visitCastExpression(CParser::CastExpressionContext *ctx) {
-    // For now, skip cast expressions and just visit unary
-    return visit(ctx->unaryExpression());
+ast::Expr *ASTBuilder::buildAndExpression(CParser::AndExpressionContext *ctx) {
+    return buildBinaryChain(ctx, ctx->equalityExpression(), &ASTBuilder::buildEqualityExpression);
 }
 
-antlrcpp::Any ASTBuilder::visitUnaryExpression(CParser::UnaryExpressionContext *ctx) {
-    size_t idx = 0; int prefixInc=0, prefixDec=0; bool sawSizeof=false; std::string sizeofType;
+ast::Expr *ASTBuilder::buildEqualityExpression(CParser::EqualityExpressionContext *ctx) {
+    return buildBinaryChain(ctx, ctx->relationalExpression(), &ASTBuilder::buildRelationalExpression);
+}
+
+ast::Expr *ASTBuilder::buildRelationalExpression(CParser::RelationalExpressionContext *ctx) {
+    return buildBinaryChain(ctx, ctx->shiftExpression(), &ASTBuilder::buildShiftExpression);
+}
+
+ast::Expr *ASTBuilder::buildShiftExpression(CParser::ShiftExpressionContext *ctx) {
+    return buildBinaryChain(ctx, ctx->additiveExpression(), &ASTBuilder::buildAdditiveExpression);
+}
+
+ast::Expr *ASTBuilder::buildAdditiveExpression(CParser::AdditiveExpressionContext *ctx) {
+    return buildBinaryChain(ctx, ctx->multiplicativeExpression(), &ASTBuilder::buildMultiplicativeExpression);
+}
+
+ast::Expr *ASTBuilder::buildMultiplicativeExpression(CParser::MultiplicativeExpressionContext *ctx) {
+    return buildBinaryChain(ctx, ctx->castExpression(), &ASTBuilder::buildCastExpression);
+}
+
+ast::Expr *ASTBuilder::buildCastExpression(CParser::CastExpressionContext *ctx) {
+    if (ctx->unaryExpression()) {
+        return buildUnaryExpression(ctx->unaryExpression());
+    }
+    // For now, explicit casts are dropped and the operand used as is
+    if (ctx->castExpression()) {
+        return buildCastExpression(ctx->castExpression());
+    }
+    return nullptr;
+}
+
+ast::Expr *ASTBuilder::buildUnaryExpression(CParser::UnaryExpressionContext *ctx) {
+    size_t idx = 0; int prefixInc=0, prefixDec=0; bool sawSizeof=false;
     while (idx < ctx->children.size()) {
         if (auto *term = dynamic_cast<antlr4::tree::TerminalNode*>(ctx->children[idx])) {
-            int t = term->getSymbol()->getType();
+            size_t t = term->getSymbol()->getType();
             if (t == CParser::PlusPlus) { ++prefixInc; ++idx; continue; }
             if (t == CParser::MinusMinus) { ++prefixDec; ++idx; continue; }
             if (t == CParser::Sizeof) { sawSizeof=true; ++idx; continue; }
         }
         break;
     }
-    if (sawSizeof) {
-        // Very basic: sizeof <postfixExpression or unaryOperator castExpression>
-        // If pattern is: sizeof ( type ) we cannot easily distinguish; fallback constant 4
-        return std::any(static_cast<ast::Expr*>(new ast::IntegerLiteral(4)));
+    if (auto *typeName = ctx->typeName()) {
+        // sizeof '(' typeName ')' or _Alignof '(' typeName ')'
+        const ast::Type *type = buildTypeName(typeName);
+        uint64_t value = ctx->Alignof() ? type->getAlignment() : type->getSize();
+        return setLocation(context_.create<ast::IntegerLiteral>(static_cast<long long>(value),
+                                                                ast::BuiltinType::BuiltinKind::UnsignedLong),
+                           ctx->getStart());
     }
-    std::unique_ptr<ast::Expr> base;
+    ast::Expr *base;
     if (auto *post = ctx->postfixExpression()) {
-        base = extractExpr(visit(post));
-    } else if (ctx->unaryOperator()) {
-        auto operand = extractExpr(visit(ctx->castExpression()));
-        std::string opText = ctx->unaryOperator()->getText();
-        ast::UnaryExpr::OpKind op;
-        if (opText=="&") op=ast::UnaryExpr::OpKind::AddressOf; else if (opText=="*") op=ast::UnaryExpr::OpKind::Dereference; else if (opText=="+") op=ast::UnaryExpr::OpKind::Plus; else if (opText=="-") op=ast::UnaryExpr::OpKind::Minus; else if (opText=="~") op=ast::UnaryExpr::OpKind::BitwiseNot; else if (opText=="!") op=ast::UnaryExpr::OpKind::Not; else op=ast::UnaryExpr::OpKind::Plus;
-        base = std::make_unique<ast::UnaryExpr>(std::move(operand), op, true);
+        base = buildPostfixExpression(post);
+    } else if (auto *unaryOp = ctx->unaryOperator()) {
+        auto *operand = buildCastExpression(ctx->castExpression());
+        base = setLocation(context_.create<ast::UnaryExpr>(operand, tokenToUnaryOp(unaryOp->getStart()), true),
+                           unaryOp->getStart());
+        base = evaluator_.fold(base, context_);
     } else {
-        return visitChildren(ctx);
+        // _Alignof and label addresses are not modelled yet
+        return nullptr;
+    }
+    if (sawSizeof) {
+        // The operand's type, and so its size, is known after type checking
+        return setLocation(context_.create<ast::UnaryExpr>(base, ast::UnaryExpr::OpKind::Sizeof, true),
+                           ctx->getStart());
     }
     int net = prefixInc - prefixDec;
     while (net != 0) {
         ast::UnaryExpr::OpKind op = net>0 ? ast::UnaryExpr::OpKind::PreIncrement : ast::UnaryExpr::OpKind::PreDecrement;
-        base = std::make_unique<ast::UnaryExpr>(std::move(base), op, true);
+        base = setLocation(context_.create<ast::UnaryExpr>(base, op, true), ctx->getStart());
         net += (net>0 ? -1 : 1);
     }
-    return std::any(base.release());
+    return base;
 }
 
-antlrcpp::Any ASTBuilder::visitPostfixExpression(CParser::PostfixExpressionContext *ctx) {
-    std::unique_ptr<ast::Expr> expr;
-    if (ctx->primaryExpression()) {
-        expr = extractExpr(visit(ctx->primaryExpression()));
-    } else {
+ast::Expr *ASTBuilder::buildPostfixExpression(CParser::PostfixExpressionContext *ctx) {
+    if (!ctx->primaryExpression()) {
+        // Compound literals are not modelled yet
         return nullptr;
     }
+    ast::Expr *expr = buildPrimaryExpression(ctx->primaryExpression());
     size_t i = 1; // child index after primaryExpression
     while (i < ctx->children.size()) {
         auto *child = ctx->children[i];
         if (auto *term = dynamic_cast<antlr4::tree::TerminalNode*>(child)) {
-            int tt = term->getSymbol()->getType();
+            size_t tt = term->getSymbol()->getType();
             if (tt == CParser::PlusPlus) {
-                expr = std::make_unique<ast::UnaryExpr>(std::move(expr), ast::UnaryExpr::OpKind::PostIncrement, false);
+                expr = setLocation(context_.create<ast::UnaryExpr>(expr, ast::UnaryExpr::OpKind::PostIncrement, false),
+                                   term->getSymbol());
                 ++i; continue;
             } else if (tt == CParser::MinusMinus) {
-                expr = std::make_unique<ast::UnaryExpr>(std::move(expr), ast::UnaryExpr::OpKind::PostDecrement, false);
+                expr = setLocation(context_.create<ast::UnaryExpr>(expr, ast::UnaryExpr::OpKind::PostDecrement, false),
+                                   term->getSymbol());
                 ++i; continue;
             } else if (tt == CParser::LeftParen) {
                 // Function call: '(' argumentExpressionList? ')'
-                std::vector<std::unique_ptr<ast::Expr>> args;
-                // Look ahead to see if we have an argumentExpressionList
+                std::vector<ast::Expr*> args;
                 if (i + 1 < ctx->children.size()) {
                     if (auto *argList = dynamic_cast<CParser::ArgumentExpressionListContext*>(ctx->children[i+1])) {
-                        // Collect each assignmentExpression
                         for (auto *ae : argList->assignmentExpression()) {
-                            auto anyArg = visit(ae);
-                            auto *raw = std::any_cast<ast::Expr*>(anyArg);
-                            args.push_back(std::unique_ptr<ast::Expr>(raw));
+                            args.push_back(buildAssignmentExpression(ae));
                         }
-                        // Expect following ')'
                         i += 3; // '(', argList, ')'
                     } else {
-                        // No arguments -> expect immediate ')'
                         i += 2; // '(', ')'
                     }
                 } else {
                     // Malformed, break
                     ++i;
                 }
-                expr = std::make_unique<ast::CallExpr>(std::move(expr), std::move(args));
+                expr = setLocation(context_.create<ast::CallExpr>(expr, context_.copyArray(args)), term->getSymbol());
                 continue;
             } else if (tt == CParser::LeftBracket) {
                 // Array subscript: expr '[' expression ']'
                 if (i + 2 < ctx->children.size()) {
-                    auto *indexChild = ctx->children[i+1];
-                    auto indexAny = visit(indexChild);
-                    auto indexExpr = extractExpr(indexAny);
-                    expr = std::make_unique<ast::ArraySubscriptExpr>(std::move(expr), std::move(indexExpr));
+                    auto *indexCtx = static_cast<CParser::ExpressionContext*>(ctx->children[i+1]);
+                    expr = setLocation(context_.create<ast::ArraySubscriptExpr>(expr, buildExpression(indexCtx)),
+                                       term->getSymbol());
                     i += 3; continue; // '[', expr, ']'
                 }
             }
         }
         ++i; // Fallback advance
     }
-    return std::any(expr.release());
+    return expr;
 }
 
-antlrcpp::Any ASTBuilder::visitPrimaryExpression(CParser::PrimaryExpressionContext *ctx) {
+ast::Expr *ASTBuilder::buildPrimaryExpression(CParser::PrimaryExpressionContext *ctx) {
+    ast::Expr *expr = nullptr;
     if (ctx->Identifier()) {
-        return std::any(static_cast<ast::Expr*>(new ast::Identifier(ctx->Identifier()->getText())));
+        expr = context_.create<ast::Identifier>(context_.getIdentifier(ctx->Identifier()->getSymbol()->getText()));
     } else if (ctx->Constant()) {
         std::string text = ctx->Constant()->getText();
-        if (text.find('.') != std::string::npos || text.find('e') != std::string::npos || text.find('E') != std::string::npos) {
-            return std::any(static_cast<ast::Expr*>(new ast::FloatingLiteral(parseFloatingConstant(text))));
-        } else if (text.front() == '\'' && text.back() == '\'') {
-            return std::any(static_cast<ast::Expr*>(new ast::CharacterLiteral(parseCharacterConstant(text))));
+        if (text.front() == '\'' && text.back() == '\'') {
+            expr = context_.create<ast::CharacterLiteral>(parseCharacterConstant(text));
+        } else if (text.find_first_of(".eE") != std::string::npos && !isHexPrefixed(text)) {
+            expr = context_.create<ast::FloatingLiteral>(parseFloatingConstant(text));
         } else {
-            return std::any(static_cast<ast::Expr*>(new ast::IntegerLiteral(parseIntegerConstant(text))));
+            expr = parseIntegerConstant(ctx->Constant()->getSymbol());
         }
     } else if (!ctx->StringLiteral().empty()) {
-        return std::any(static_cast<ast::Expr*>(new ast::StringLiteral(parseStringLiteral(ctx->StringLiteral(0)->getText()))));
-    } else if (ctx->expression()) {
-        return visit(ctx->expression());
+        expr = context_.create<ast::StringLiteral>(context_.copyString(parseStringLiteral(ctx->StringLiteral(0)->getText())));
+    }
+    if (expr) {
+        return setLocation(expr, ctx->getStart());
+    }
+    if (ctx->expression()) {
+        return buildExpression(ctx->expression());
     }
     return nullptr;
 }
 
 // Helper methods implementation
 
-std::string ASTBuilder::extractTypeFromSpecifiers(CParser::DeclarationSpecifiersContext *ctx) {
-    std::string type;
-    for (auto *child : ctx->children) {
-        if (auto *typeSpec = dynamic_cast<CParser::TypeSpecifierContext*>(child)) {
-            // Use text-based parsing since the grammar uses literals
-            std::string text = typeSpec->getText();
-            if (text == "int") type += "int";
-            else if (text == "char") type += "char";
-            else if (text == "float") type += "float";
-            else if (text == "double") type += "double";
-            else if (text == "void") type += "void";
-            else if (text == "long") type += "long";
-            else if (text == "short") type += "short";
-            else if (text == "signed") type += "signed";
-            else if (text == "unsigned") type += "unsigned";
-            else type += text; // Default fallback
+namespace {
+
+/**
+ * Collects the type specifier and qualifier keywords of a declaration, in
+ * any order, and names the type they add up to (C11 6.7.2p2).
+ */
+struct SpecifierSet {
+    unsigned voids = 0, bools = 0, chars = 0, shorts = 0, ints = 0, longs = 0;
+    unsigned floats = 0, doubles = 0, signeds = 0, unsigneds = 0;
+    unsigned qualifiers = 0;
+
+    void addSpecifier(CParser::TypeSpecifierContext *ctx) {
+        switch (ctx->getStart()->getType()) {
+            case CParser::Void: ++voids; break;
+            case CParser::Bool: ++bools; break;
+            case CParser::Char: ++chars; break;
+            case CParser::Short: ++shorts; break;
+            case CParser::Int: ++ints; break;
+            case CParser::Long: ++longs; break;
+            case CParser::Float: ++floats; break;
+            case CParser::Double: ++doubles; break;
+            case CParser::Signed: ++signeds; break;
+            case CParser::Unsigned: ++unsigneds; break;
+            default:
+                // struct, enum and typedef names are not modelled yet and
+                // fall back to int
+                break;
         }
     }
-    return type.empty() ? "int" : type; // Default to int
-}
 
-std::string ASTBuilder::extractIdentifierName(CParser::DirectDeclaratorContext *ctx) {
-    if (ctx->Identifier()) {
-        return ctx->Identifier()->getText();
+    void addQualifier(CParser::TypeQualifierContext *ctx) {
+        switch (ctx->getStart()->getType()) {
+            case CParser::Const: qualifiers |= ast::QualifiedType::Const; break;
+            case CParser::Volatile: qualifiers |= ast::QualifiedType::Volatile; break;
+            case CParser::Restrict: qualifiers |= ast::QualifiedType::Restrict; break;
+            default: break;
+        }
     }
-    
-    // Handle recursive cases like "directDeclarator '(' parameterTypeList ')'"
-    // The identifier should be in the child directDeclarator
-    if (ctx->directDeclarator()) {
-        return extractIdentifierName(ctx->directDeclarator());
+
+    const ast::Type *resolve(ast::TypeContext &types) const {
+        using BK = ast::BuiltinType::BuiltinKind;
+        BK kind;
+        if (voids) {
+            kind = BK::Void;
+        } else if (bools) {
+            kind = BK::Bool;
+        } else if (chars) {
+            kind = unsigneds ? BK::UnsignedChar : signeds ? BK::SignedChar : BK::Char;
+        } else if (floats) {
+            kind = BK::Float;
+        } else if (doubles) {
+            kind = longs ? BK::LongDouble : BK::Double;
+        } else if (shorts) {
+            kind = unsigneds ? BK::UnsignedShort : BK::Short;
+        } else if (longs >= 2) {
+            kind = unsigneds ? BK::UnsignedLongLong : BK::LongLong;
+        } else if (longs == 1) {
+            kind = unsigneds ? BK::UnsignedLong : BK::Long;
+        } else {
+            kind = unsigneds ? BK::UnsignedInt : BK::Int; // also implicit int
+        }
+        return types.getQualifiedType(types.getBuiltinType(kind), qualifiers);
     }
-    
-    return "";
-}
+};
 
-std::vector<std::pair<std::string, std::string>> ASTBuilder::extractParameters(CParser::ParameterTypeListContext *ctx) {
-    std::vector<std::pair<std::string, std::string>> params;
-    
-    if (ctx->parameterList()) {
-        for (auto *paramDecl : ctx->parameterList()->parameterDeclaration()) {
-            std::string type = extractTypeFromSpecifiers(paramDecl->declarationSpecifiers());
-            std::string name;
-            if (paramDecl->declarator()) {
-                name = extractIdentifierName(paramDecl->declarator()->directDeclarator());
-            }
-            params.emplace_back(type, name);
+} // namespace
+
+const ast::Type *ASTBuilder::buildSpecifierType(
+        const std::vector<CParser::DeclarationSpecifierContext*> &specifiers) {
+    SpecifierSet set;
+    for (auto *specifier : specifiers) {
+        if (auto *typeSpec = specifier->typeSpecifier()) {
+            set.addSpecifier(typeSpec);
+        } else if (auto *qualifier = specifier->typeQualifier()) {
+            set.addQualifier(qualifier);
         }
     }
-    
-    return params;
+    return set.resolve(context_.getTypes());
 }
 
-long long ASTBuilder::parseIntegerConstant(const std::string &text) {
-    try {
-        if (text.size() > 2 && text.substr(0, 2) == "0x") {
-            return std::stoll(text, nullptr, 16);
-        } else if (text.size() > 1 && text[0] == '0') {
-            return std::stoll(text, nullptr, 8);
-        } else {
-            return std::stoll(text, nullptr, 10);
+const ast::Type *ASTBuilder::buildSpecifierType(CParser::SpecifierQualifierListContext *ctx) {
+    SpecifierSet set;
+    for (; ctx; ctx = ctx->specifierQualifierList()) {
+        if (auto *typeSpec = ctx->typeSpecifier()) {
+            set.addSpecifier(typeSpec);
+        } else if (auto *qualifier = ctx->typeQualifier()) {
+            set.addQualifier(qualifier);
         }
-    } catch (const std::exception&) {
-        return 0;
     }
+    return set.resolve(context_.getTypes());
 }
 
-double ASTBuilder::parseFloatingConstant(const std::string &text) {
-    try {
-        return std::stod(text);
-    } catch (const std::exception&) {
-        return 0.0;
+const ast::Type *ASTBuilder::buildTypeName(CParser::TypeNameContext *ctx) {
+    const ast::Type *type = buildSpecifierType(ctx->specifierQualifierList());
+    if (auto *abstract = ctx->abstractDeclarator()) {
+        type = applyAbstractDeclarator(type, abstract);
     }
+    return type;
 }
 
-char ASTBuilder::parseCharacterConstant(const std::string &text) {
-    if (text.size() >= 3) {
-        return text[1]; // Simple case: 'a' -> a
+const ast::Type *ASTBuilder::applyPointer(const ast::Type *type, CParser::PointerContext *ctx) {
+    if (!ctx) {
+        return type;
     }
-    return '\0';
+    auto &types = context_.getTypes();
+    for (auto *child : ctx->children) {
+        if (auto *qualifiers = dynamic_cast<CParser::TypeQualifierListContext*>(child)) {
+            // Qualifiers after a '*' apply to that pointer
+            SpecifierSet set;
+            for (auto *qualifier : qualifiers->typeQualifier()) {
+                set.addQualifier(qualifier);
+            }
+            type = types.getQualifiedType(type, set.qualifiers);
+        } else {
+            type = types.getPointerType(type);
+        }
+    }
+    return type;
 }
 
-std::string ASTBuilder::parseStringLiteral(const std::string &text) {
-    if (text.size() >= 2) {
-        return text.substr(1, text.size() - 2); // Remove quotes
+const ast::Type *ASTBuilder::applyDeclarator(const ast::Type *type, CParser::DeclaratorContext *ctx) {
+    type = applyPointer(type, ctx->pointer());
+    return ctx->directDeclarator() ? applyDirectDeclarator(type, ctx->directDeclarator()) : type;
+}
+
+const ast::Type *ASTBuilder::applyDirectDeclarator(const ast::Type *type,
+                                                   CParser::DirectDeclaratorContext *ctx) {
+    if (auto *inner = ctx->directDeclarator()) {
+        // The suffix binds tighter than anything inside, so it applies first
+        if (ctx->LeftBracket()) {
+            type = buildArrayType(type, ctx->assignmentExpression());
+        } else if (ctx->LeftParen()) {
+            type = buildFunctionType(type, ctx->parameterTypeList());
+        }
+        return applyDirectDeclarator(type, inner);
     }
-    return "";
+    if (auto *declarator = ctx->declarator()) {
+        // '(' declarator ')'
+        return applyDeclarator(type, declarator);
+    }
+    return type;
 }
 
-std::unique_ptr<ast::Expr> ASTBuilder::extractExpr(const antlrcpp::Any &result) {
-    try {
-        auto *ptr = std::any_cast<ast::Expr*>(result);
-        return std::unique_ptr<ast::Expr>(ptr);
-    } catch (const std::bad_any_cast&) {
-        return nullptr;
+const ast::Type *ASTBuilder::applyAbstractDeclarator(const ast::Type *type,
+                                                     CParser::AbstractDeclaratorContext *ctx) {
+    type = applyPointer(type, ctx->pointer());
+    if (auto *direct = ctx->directAbstractDeclarator()) {
+        type = applyDirectAbstractDeclarator(type, direct);
     }
+    return type;
 }
 
-std::unique_ptr<ast::Stmt> ASTBuilder::extractStmt(const antlrcpp::Any &result) {
-    try {
-        auto *ptr = std::any_cast<ast::Stmt*>(result);
-        if (ptr) return std::unique_ptr<ast::Stmt>(ptr);
-    } catch (const std::bad_any_cast&) {
-        // fallthrough to try derived types
+const ast::Type *ASTBuilder::applyDirectAbstractDeclarator(const ast::Type *type,
+                                                           CParser::DirectAbstractDeclaratorContext *ctx) {
+    if (auto *abstract = ctx->abstractDeclarator()) {
+        // '(' abstractDeclarator ')'
+        return applyAbstractDeclarator(type, abstract);
     }
-    try {
-        auto *ptr = std::any_cast<ast::CompoundStmt*>(result);
-        if (ptr) return std::unique_ptr<ast::Stmt>(ptr);
-    } catch (const std::bad_any_cast&) {
-        // ignore
+    if (ctx->LeftBracket()) {
+        type = buildArrayType(type, ctx->assignmentExpression());
+    } else if (ctx->LeftParen()) {
+        type = buildFunctionType(type, ctx->parameterTypeList());
     }
-    try {
-        auto *ptr = std::any_cast<ast::VarDecl*>(result);
-        if (ptr) return std::unique_ptr<ast::Stmt>(ptr);
-    } catch (const std::bad_any_cast&) {
-        // ignore
+    if (auto *inner = ctx->directAbstractDeclarator()) {
+        type = applyDirectAbstractDeclarator(type, inner);
     }
-    return nullptr;
+    return type;
 }
 
-// Missing method implementations (stubs for now)
+const ast::Type *ASTBuilder::buildArrayType(const ast::Type *element,
+                                            CParser::AssignmentExpressionContext *length) {
+    // Unsized and variable-length arrays get length 0
+    uint64_t count = 0;
+    if (length) {
+        if (auto value = evaluator_.evaluateAsInteger(buildAssignmentExpression(length))) {
+            count = *value > 0 ? static_cast<uint64_t>(*value) : 0;
+        }
+    }
+    return context_.getTypes().getArrayType(element, count);
+}
 
-antlrcpp::Any ASTBuilder::visitStatement(CParser::StatementContext *ctx) {
-    if (ctx->compoundStatement()) {
-        return visit(ctx->compoundStatement());
-    } else if (ctx->expressionStatement()) {
-        return visit(ctx->expressionStatement());
-    } else if (ctx->selectionStatement()) {
-        return visit(ctx->selectionStatement());
-    } else if (ctx->iterationStatement()) {
-        return visit(ctx->iterationStatement());
-    } else if (ctx->jumpStatement()) {
-        return visit(ctx->jumpStatement());
+const ast::Type *ASTBuilder::buildFunctionType(const ast::Type *result,
+                                               CParser::ParameterTypeListContext *ctx) {
+    std::vector<const ast::Type*> params;
+    bool variadic = false;
+    if (ctx) {
+        for (const auto &param : extractParameters(ctx)) {
+            params.push_back(param.first);
+        }
+        variadic = ctx->Ellipsis() != nullptr;
     }
-    return nullptr;
+    return context_.getTypes().getFunctionType(result, params, variadic);
 }
 
-antlrcpp::Any ASTBuilder::visitDeclarator(CParser::DeclaratorContext *ctx) {
-    // Simplified implementation
-    return visit(ctx->directDeclarator());
+const ast::Type *ASTBuilder::buildParameterType(CParser::ParameterDeclarationContext *ctx) {
+    const ast::Type *type;
+    if (auto *specifiers = ctx->declarationSpecifiers()) {
+        type = applyDeclarator(buildSpecifierType(specifiers->declarationSpecifier()), ctx->declarator());
+    } else {
+        type = buildSpecifierType(ctx->declarationSpecifiers2()->declarationSpecifier());
+        if (auto *abstract = ctx->abstractDeclarator()) {
+            type = applyAbstractDeclarator(type, abstract);
+        }
+    }
+
+    // Array and function parameters are adjusted to pointers (C11 6.7.6.3p7-8)
+    auto &types = context_.getTypes();
+    if (auto *array = ast::dyn_cast<ast::ArrayType>(type->getUnqualifiedType())) {
+        return types.getPointerType(array->getElementType());
+    }
+    if (type->isFunction()) {
+        return types.getPointerType(type);
+    }
+    return type;
 }
 
-antlrcpp::Any ASTBuilder::visitDirectDeclarator(CParser::DirectDeclaratorContext *ctx) {
-    // Simplified implementation - just return identifier name
+std::string ASTBuilder::extractIdentifierName(CParser::DirectDeclaratorContext *ctx) {
     if (ctx->Identifier()) {
-        return std::any(ctx->Identifier()->getText());
+        return ctx->Identifier()->getText();
     }
-    return std::any(std::string(""));
+    
+    // Handle recursive cases like "directDeclarator '(' parameterTypeList ')'"
+    // The identifier should be in the child directDeclarator
+    if (ctx->directDeclarator()) {
+        return extractIdentifierName(ctx->directDeclarator());
+    }
+    
+    return "";
 }
 
-antlrcpp::Any ASTBuilder::visitIterationStatement(CParser::IterationStatementContext *ctx) {
-    // Check if this is a while statement by looking for 'while' token
-    bool isWhileStatement = false;
-    bool isForStatement = false;
+std::span<ast::FunctionDecl::Parameter> ASTBuilder::extractParameters(CParser::ParameterTypeListContext *ctx) {
+    std::vector<ast::FunctionDecl::Parameter> params;
     
-    for (auto child : ctx->children) {
-        if (auto terminal = dynamic_cast<antlr4::tree::TerminalNode*>(child)) {
-            if (terminal->getText() == "while") {
-                isWhileStatement = true;
-                break;
-            } else if (terminal->getText() == "for") {
-                isForStatement = true;
-                break;
+    if (ctx->parameterList()) {
+        auto declarations = ctx->parameterList()->parameterDeclaration();
+        for (auto *paramDecl : declarations) {
+            const ast::Type *type = buildParameterType(paramDecl);
+            if (type->isVoid() && declarations.size() == 1 && !paramDecl->declarator()) {
+                break; // f(void) takes no parameters
+            }
+            std::string name;
+            if (paramDecl->declarator()) {
+                name = extractIdentifierName(paramDecl->declarator()->directDeclarator());
             }
+            params.emplace_back(type, context_.getIdentifier(name));
         }
     }
     
-    if (isWhileStatement) {
-        // Parse while statement: while '(' expression ')' statement
-        if (ctx->children.size() >= 5) {
-            // Get condition expression (index 2, between parentheses)
-            auto conditionCtx = ctx->children[2];
-            auto conditionResult = visit(conditionCtx);
-            auto condition = std::any_cast<ast::Expr*>(conditionResult);
-            
-            // Get body statement (index 4)
-            auto bodyCtx = ctx->children[4];
-            auto bodyResult = visit(bodyCtx);
-            
-            // Handle both CompoundStmt and regular Stmt
-            ast::Stmt* body = nullptr;
-            try {
-                body = std::any_cast<ast::Stmt*>(bodyResult);
-            } catch (const std::bad_any_cast&) {
-                // Try CompoundStmt
-                auto compoundBody = std::any_cast<ast::CompoundStmt*>(bodyResult);
-                body = static_cast<ast::Stmt*>(compoundBody);
-            }
-            
-            return std::any(static_cast<ast::Stmt*>(new ast::WhileStmt(
-                std::unique_ptr<ast::Expr>(condition),
-                std::unique_ptr<ast::Stmt>(body)
-            )));
-        }
-    } else if (isForStatement) {
-        // Parse for statement: for '(' forCondition ')' statement
-        if (ctx->children.size() >= 5) {
-            // Get the forCondition context (index 2)
-            auto forConditionCtx = dynamic_cast<CParser::ForConditionContext*>(ctx->children[2]);
-            if (forConditionCtx) {
-                // Parse the three parts of the for condition
-                ast::Stmt* init = nullptr;
-                ast::Expr* condition = nullptr;
-                ast::Expr* increment = nullptr;
-                
-                // Get init (forDeclaration or expression)
-                if (forConditionCtx->forDeclaration()) {
-                    auto initResult = visit(forConditionCtx->forDeclaration());
-                    init = std::any_cast<ast::Stmt*>(initResult);
-                } else if (forConditionCtx->expression()) {
-                    auto initResult = visit(forConditionCtx->expression());
-                    auto initExpr = std::any_cast<ast::Expr*>(initResult);
-                    // Wrap expression in an expression statement
-                    init = new ast::ExprStmt(std::unique_ptr<ast::Expr>(initExpr));
-                }
-                
-                // Get condition (first forExpression)
-                if (forConditionCtx->forExpression().size() > 0) {
-                    auto condResult = visit(forConditionCtx->forExpression(0));
-                    condition = std::any_cast<ast::Expr*>(condResult);
-                }
-                
-                // Get increment (second forExpression)
-                if (forConditionCtx->forExpression().size() > 1) {
-                    auto incResult = visit(forConditionCtx->forExpression(1));
-                    increment = std::any_cast<ast::Expr*>(incResult);
-                }
-                
-                // Get body statement (index 4)
-                auto bodyCtx = ctx->children[4];
-                auto bodyResult = visit(bodyCtx);
-                
-                // Handle both CompoundStmt and regular Stmt
-                ast::Stmt* body = nullptr;
-                try {
-                    body = std::any_cast<ast::Stmt*>(bodyResult);
-                } catch (const std::bad_any_cast&) {
-                    // Try CompoundStmt
-                    auto compoundBody = std::any_cast<ast::CompoundStmt*>(bodyResult);
-                    body = static_cast<ast::Stmt*>(compoundBody);
-                }
-                
-                return std::any(static_cast<ast::Stmt*>(new ast::ForStmt(
-                    std::unique_ptr<ast::Stmt>(init),
-                    std::unique_ptr<ast::Expr>(condition),
-                    std::unique_ptr<ast::Expr>(increment),
-                    std::unique_ptr<ast::Stmt>(body)
-                )));
-            }
+    return context_.copyArray(params);
+}
+
+ast::BinaryExpr::OpKind ASTBuilder::tokenToBinaryOp(antlr4::Token *token) {
+    switch (token->getType()) {
+        case CParser::Plus: return ast::BinaryExpr::OpKind::Add;
+        case CParser::Minus: return ast::BinaryExpr::OpKind::Sub;
+        case CParser::Star: return ast::BinaryExpr::OpKind::Mul;
+        case CParser::Div: return ast::BinaryExpr::OpKind::Div;
+        case CParser::Mod: return ast::BinaryExpr::OpKind::Mod;
+        case CParser::Less: return ast::BinaryExpr::OpKind::LT;
+        case CParser::Greater: return ast::BinaryExpr::OpKind::GT;
+        case CParser::LessEqual: return ast::BinaryExpr::OpKind::LE;
+        case CParser::GreaterEqual: return ast::BinaryExpr::OpKind::GE;
+        case CParser::Equal: return ast::BinaryExpr::OpKind::EQ;
+        case CParser::NotEqual: return ast::BinaryExpr::OpKind::NE;
+        case CParser::AndAnd: return ast::BinaryExpr::OpKind::LogicalAnd;
+        case CParser::OrOr: return ast::BinaryExpr::OpKind::LogicalOr;
+        case CParser::And: return ast::BinaryExpr::OpKind::BitwiseAnd;
+        case CParser::Or: return ast::BinaryExpr::OpKind::BitwiseOr;
+        case CParser::Caret: return ast::BinaryExpr::OpKind::BitwiseXor;
+        case CParser::LeftShift: return ast::BinaryExpr::OpKind::LeftShift;
+        case CParser::RightShift: return ast::BinaryExpr::OpKind::RightShift;
+        default: return ast::BinaryExpr::OpKind::Add;
+    }
+}
+
+ast::BinaryExpr::OpKind ASTBuilder::tokenToAssignmentOp(antlr4::Token *token) {
+    switch (token->getType()) {
+        case CParser::PlusAssign: return ast::BinaryExpr::OpKind::AddAssign;
+        case CParser::MinusAssign: return ast::BinaryExpr::OpKind::SubAssign;
+        case CParser::StarAssign: return ast::BinaryExpr::OpKind::MulAssign;
+        case CParser::DivAssign: return ast::BinaryExpr::OpKind::DivAssign;
+        case CParser::ModAssign: return ast::BinaryExpr::OpKind::ModAssign;
+        default: return ast::BinaryExpr::OpKind::Assign;
+    }
+}
+
+ast::UnaryExpr::OpKind ASTBuilder::tokenToUnaryOp(antlr4::Token *token) {
+    switch (token->getType()) {
+        case CParser::And: return ast::UnaryExpr::OpKind::AddressOf;
+        case CParser::Star: return ast::UnaryExpr::OpKind::Dereference;
+        case CParser::Minus: return ast::UnaryExpr::OpKind::Minus;
+        case CParser::Tilde: return ast::UnaryExpr::OpKind::BitwiseNot;
+        case CParser::Not: return ast::UnaryExpr::OpKind::Not;
+        default: return ast::UnaryExpr::OpKind::Plus;
+    }
+}
+
+ast::IntegerLiteral *ASTBuilder::parseIntegerConstant(antlr4::Token *token) {
+    using BK = ast::BuiltinType::BuiltinKind;
+    std::string text = token->getText();
+    // from_chars stops at the first invalid character, which is where the
+    // suffix starts, and returns errc::result_out_of_range on overflow
+    const char *first = text.data();
+    const char *last = text.data() + text.size();
+    int base = 10;
+    if (isHexPrefixed(text)) {
+        first += 2;
+        base = 16;
+    } else if (text.size() > 1 && text[0] == '0') {
+        base = 8;
+    }
+    uint64_t value = 0;
+    auto [suffix, ec] = std::from_chars(first, last, value, base);
+    if (ec == std::errc::result_out_of_range) {
+        throw utils::SemanticError("integer constant " + text + " at line " + std::to_string(token->getLine()) +
+                                   " is too large for any integer type");
+    }
+    bool isUnsigned = false;
+    int longs = 0;
+    for (; suffix != last; ++suffix) {
+        if (*suffix == 'u' || *suffix == 'U') {
+            isUnsigned = true;
+        } else if (*suffix == 'l' || *suffix == 'L') {
+            ++longs;
         }
     }
-    
-    // For other iteration statements (do-while), return stub for now
-    return nullptr;
-}
 
-antlrcpp::Any ASTBuilder::visitSelectionStatement(CParser::SelectionStatementContext *ctx) {
-    // Check if this is an if statement by looking for 'if' token
-    bool isIfStatement = false;
-    for (auto child : ctx->children) {
-        if (auto terminal = dynamic_cast<antlr4::tree::TerminalNode*>(child)) {
-            if (terminal->getText() == "if") {
-                isIfStatement = true;
-                break;
-            }
+    // The first type of the list for the suffix that holds the value (C11
+    // 6.4.4.1p5). Unsuffixed octal and hex constants may be unsigned,
+    // decimal ones only with a 'u'.
+    static constexpr BK candidates[] = {BK::Int, BK::UnsignedInt, BK::Long, BK::UnsignedLong,
+                                        BK::LongLong, BK::UnsignedLongLong};
+    BK kind = BK::UnsignedLongLong;
+    for (size_t i = std::min(longs, 2) * 2; i < std::size(candidates); ++i) {
+        bool unsignedCandidate = i % 2 == 1;
+        if (unsignedCandidate ? !isUnsigned && base == 10 : isUnsigned) {
+            continue;
         }
-    }
-    
-    if (isIfStatement) {
-        // Get the condition expression
-        auto conditionResult = visit(ctx->expression());
-        auto condition = extractExpr(conditionResult);
-        
-        // Get the then statement  
-        auto thenResult = visit(ctx->statement(0));
-        auto thenStmt = extractStmt(thenResult);
-        
-        // Get the else statement if present
-        std::unique_ptr<ast::Stmt> elseStmt = nullptr;
-        if (ctx->statement().size() > 1) {
-            auto elseResult = visit(ctx->statement(1));
-            elseStmt = extractStmt(elseResult);
+        unsigned bits = static_cast<unsigned>(ast::BuiltinType::getKindSize(candidates[i]) * 8);
+        uint64_t max = unsignedCandidate ? ~uint64_t(0) >> (64 - bits) : ~uint64_t(0) >> (65 - bits);
+        if (value <= max) {
+            kind = candidates[i];
+            break;
         }
-        
-        return std::any(static_cast<ast::Stmt*>(new ast::IfStmt(
-            std::move(condition), std::move(thenStmt), std::move(elseStmt)
-        )));
     }
-    
-    // TODO: Handle switch statement
-    return nullptr;
+    return context_.create<ast::IntegerLiteral>(static_cast<long long>(value), kind);
 }
 
-antlrcpp::Any ASTBuilder::visitParameterDeclaration(CParser::ParameterDeclarationContext *ctx) {
-    // Stub implementation
-    (void)ctx; // Suppress unused parameter warning
-    return nullptr;
+bool ASTBuilder::isHexPrefixed(const std::string &text) {
+    return text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X');
 }
 
-antlrcpp::Any ASTBuilder::visitDeclarationSpecifiers(CParser::DeclarationSpecifiersContext *ctx) {
-    // Stub implementation
-    (void)ctx; // Suppress unused parameter warning
-    return nullptr;
+double ASTBuilder::parseFloatingConstant(const std::string &text) {
+    return std::strtod(text.c_str(), nullptr);
 }
 
-antlrcpp::Any ASTBuilder::visitForDeclaration(CParser::ForDeclarationContext *ctx) {
-    // For declarations are typically simple variable declarations like "int i = 0"
-    // We'll reuse the declaration visitor logic
-    if (ctx->declarationSpecifiers() && ctx->initDeclaratorList()) {
-        // Get type
-        std::string type = extractTypeFromSpecifiers(ctx->declarationSpecifiers());
-        
-        // Get the first initDeclarator from the list (for now, only handle single declarations)
-        auto *initDeclList = ctx->initDeclaratorList();
-        if (initDeclList && !initDeclList->initDeclarator().empty()) {
-            auto *initDecl = initDeclList->initDeclarator(0);
-            if (initDecl && initDecl->declarator() && initDecl->declarator()->directDeclarator()) {
-                std::string name = extractIdentifierName(initDecl->declarator()->directDeclarator());
-                
-                // Handle initializer if present
-                ast::Expr* init = nullptr;
-                if (initDecl->initializer() && initDecl->initializer()->assignmentExpression()) {
-                    auto initResult = visit(initDecl->initializer()->assignmentExpression());
-                    init = std::any_cast<ast::Expr*>(initResult);
-                }
-                
-                // Create a variable declaration statement
-                auto varDecl = new ast::VarDecl(name, type, std::unique_ptr<ast::Expr>(init));
-                return std::any(static_cast<ast::Stmt*>(varDecl));
-            }
-        }
+char ASTBuilder::parseCharacterConstant(const std::string &text) {
+    if (text.size() >= 3) {
+        return text[1]; // Simple case: 'a' -> a
     }
-    
-    return nullptr;
+    return '\0';
 }
 
-antlrcpp::Any ASTBuilder::visitForExpression(CParser::ForExpressionContext *ctx) {
-    // ForExpression can have multiple assignmentExpressions separated by commas
-    // For now, we'll just return the first one (or last one for comma operator semantics)
-    if (!ctx->assignmentExpression().empty()) {
-        // Return the last expression (comma operator semantics)
-        auto lastExpr = ctx->assignmentExpression().back();
-        return visit(lastExpr);
+std::string ASTBuilder::parseStringLiteral(const std::string &text) {
+    if (text.size() >= 2) {
+        return text.substr(1, text.size() - 2); // Remove quotes
     }
-    
-    return nullptr;
+    return "";
 }
 
 } // namespace parser
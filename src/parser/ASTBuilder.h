@@ -1,82 +1,163 @@
 #pragma once
 
-#include "CBaseVisitor.h"
+#include "CParser.h"
 #include "ast/Node.h"
 #include "ast/Expr.h"
 #include "ast/Stmt.h"
-#include <memory>
+#include "ast/ASTContext.h"
+#include "ast/ConstantEvaluator.h"
+#include "ast/Type.h"
+#include "utils/SourceLocation.h"
+#include <span>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace parser {
 
 /**
- * ANTLR visitor that builds AST nodes from the parse tree.
+ * Builds AST nodes from the parse tree.
+ *
+ * Each grammar rule has a build method returning the node type it produces,
+ * so results are passed as plain pointers rather than boxed in std::any.
+ * Constructs the AST does not model yet yield nullptr.
  */
-class ASTBuilder : public CBaseVisitor {
+class ASTBuilder {
 public:
-    ASTBuilder() = default;
-    
+    /**
+     * @param context Arena receiving every node built
+     * @param bufferStart Location of the first character of the parsed
+     *        buffer; node locations are token offsets relative to it. The
+     *        default is where a SourceManager places its first buffer.
+     */
+    explicit ASTBuilder(ast::ASTContext &context,
+                        utils::SourceLocation bufferStart = utils::SourceLocation::getFromOffset(1))
+        : context_(context), bufferStart_(bufferStart) {}
+
     // Top-level
-    antlrcpp::Any visitTranslationUnit(CParser::TranslationUnitContext *ctx) override;
-    antlrcpp::Any visitExternalDeclaration(CParser::ExternalDeclarationContext *ctx) override;
-    
+    ast::TranslationUnit *buildTranslationUnit(CParser::TranslationUnitContext *ctx);
+
+    /**
+     * Build the AST for a single external declaration.
+     * @return The declaration node, or nullptr if it produced none
+     */
+    ast::Node *buildExternalDeclaration(CParser::ExternalDeclarationContext *ctx);
+
+    /**
+     * Build the AST for a function body or other block.
+     */
+    ast::CompoundStmt *buildCompoundStatement(CParser::CompoundStatementContext *ctx);
+
     // Function definitions
-    antlrcpp::Any visitFunctionDefinition(CParser::FunctionDefinitionContext *ctx) override;
-    
-    // Declarations
-    antlrcpp::Any visitDeclaration(CParser::DeclarationContext *ctx) override;
-    antlrcpp::Any visitDeclarationSpecifiers(CParser::DeclarationSpecifiersContext *ctx) override;
-    antlrcpp::Any visitDeclarator(CParser::DeclaratorContext *ctx) override;
-    antlrcpp::Any visitDirectDeclarator(CParser::DirectDeclaratorContext *ctx) override;
-    antlrcpp::Any visitParameterDeclaration(CParser::ParameterDeclarationContext *ctx) override;
-    
+    ast::FunctionDecl *buildFunctionDefinition(CParser::FunctionDefinitionContext *ctx);
+
+    /**
+     * Build a declaration.
+     * @return A VarDecl, a FunctionDecl without body for a prototype, or
+     *         nullptr if it declares nothing modelled
+     */
+    ast::Node *buildDeclaration(CParser::DeclarationContext *ctx);
+
     // Statements
-    antlrcpp::Any visitStatement(CParser::StatementContext *ctx) override;
-    antlrcpp::Any visitCompoundStatement(CParser::CompoundStatementContext *ctx) override;
-    antlrcpp::Any visitExpressionStatement(CParser::ExpressionStatementContext *ctx) override;
-    antlrcpp::Any visitSelectionStatement(CParser::SelectionStatementContext *ctx) override;
-    antlrcpp::Any visitIterationStatement(CParser::IterationStatementContext *ctx) override;
-    antlrcpp::Any visitJumpStatement(CParser::JumpStatementContext *ctx) override;
-    
+    ast::Stmt *buildStatement(CParser::StatementContext *ctx);
+    ast::Stmt *buildExpressionStatement(CParser::ExpressionStatementContext *ctx);
+    ast::Stmt *buildSelectionStatement(CParser::SelectionStatementContext *ctx);
+    ast::Stmt *buildIterationStatement(CParser::IterationStatementContext *ctx);
+    ast::Stmt *buildJumpStatement(CParser::JumpStatementContext *ctx);
+
     // For loop components
-    antlrcpp::Any visitForDeclaration(CParser::ForDeclarationContext *ctx) override;
-    antlrcpp::Any visitForExpression(CParser::ForExpressionContext *ctx) override;
-    
+    ast::VarDecl *buildForDeclaration(CParser::ForDeclarationContext *ctx);
+    ast::Expr *buildForExpression(CParser::ForExpressionContext *ctx);
+
     // Expressions
-    antlrcpp::Any visitExpression(CParser::ExpressionContext *ctx) override;
-    antlrcpp::Any visitAssignmentExpression(CParser::AssignmentExpressionContext *ctx) override;
-    antlrcpp::Any visitConditionalExpression(CParser::ConditionalExpressionContext *ctx) override;
-    antlrcpp::Any visitLogicalOrExpression(CParser::LogicalOrExpressionContext *ctx) override;
-    antlrcpp::Any visitLogicalAndExpression(CParser::LogicalAndExpressionContext *ctx) override;
-    antlrcpp::Any visitInclusiveOrExpression(CParser::InclusiveOrExpressionContext *ctx) override;
-    antlrcpp::Any visitExclusiveOrExpression(CParser::ExclusiveOrExpressionContext *ctx) override;
-    antlrcpp::Any visitAndExpression(CParser::AndExpressionContext *ctx) override;
-    antlrcpp::Any visitEqualityExpression(CParser::EqualityExpressionContext *ctx) override;
-    antlrcpp::Any visitRelationalExpression(CParser::RelationalExpressionContext *ctx) override;
-    antlrcpp::Any visitShiftExpression(CParser::ShiftExpressionContext *ctx) override;
-    antlrcpp::Any visitAdditiveExpression(CParser::AdditiveExpressionContext *ctx) override;
-    antlrcpp::Any visitMultiplicativeExpression(CParser::MultiplicativeExpressionContext *ctx) override;
-    antlrcpp::Any visitCastExpression(CParser::CastExpressionContext *ctx) override;
-    antlrcpp::Any visitUnaryExpression(CParser::UnaryExpressionContext *ctx) override;
-    antlrcpp::Any visitPostfixExpression(CParser::PostfixExpressionContext *ctx) override;
-    antlrcpp::Any visitPrimaryExpression(CParser::PrimaryExpressionContext *ctx) override;
-    
+    ast::Expr *buildExpression(CParser::ExpressionContext *ctx);
+    ast::Expr *buildAssignmentExpression(CParser::AssignmentExpressionContext *ctx);
+    ast::Expr *buildConditionalExpression(CParser::ConditionalExpressionContext *ctx);
+    ast::Expr *buildLogicalOrExpression(CParser::LogicalOrExpressionContext *ctx);
+    ast::Expr *buildLogicalAndExpression(CParser::LogicalAndExpressionContext *ctx);
+    ast::Expr *buildInclusiveOrExpression(CParser::InclusiveOrExpressionContext *ctx);
+    ast::Expr *buildExclusiveOrExpression(CParser::ExclusiveOrExpressionContext *ctx);
+    ast::Expr *buildAndExpression(CParser::AndExpressionContext *ctx);
+    ast::Expr *buildEqualityExpression(CParser::EqualityExpressionContext *ctx);
+    ast::Expr *buildRelationalExpression(CParser::RelationalExpressionContext *ctx);
+    ast::Expr *buildShiftExpression(CParser::ShiftExpressionContext *ctx);
+    ast::Expr *buildAdditiveExpression(CParser::AdditiveExpressionContext *ctx);
+    ast::Expr *buildMultiplicativeExpression(CParser::MultiplicativeExpressionContext *ctx);
+    ast::Expr *buildCastExpression(CParser::CastExpressionContext *ctx);
+    ast::Expr *buildUnaryExpression(CParser::UnaryExpressionContext *ctx);
+    ast::Expr *buildPostfixExpression(CParser::PostfixExpressionContext *ctx);
+    ast::Expr *buildPrimaryExpression(CParser::PrimaryExpressionContext *ctx);
+
 private:
+    ast::ASTContext &context_;
+    utils::SourceLocation bufferStart_;
+    ast::ConstantEvaluator evaluator_;
+
+    /** Location of a token's first character. */
+    utils::SourceLocation getLocation(antlr4::Token *token) const {
+        return bufferStart_.getLocWithOffset(static_cast<int64_t>(token->getStartIndex()));
+    }
+
+    template <typename T>
+    T *setLocation(T *node, antlr4::Token *token) const {
+        if (node) {
+            node->loc = getLocation(token);
+        }
+        return node;
+    }
+
+    // Types. Declarators are applied inside out to the type named by the
+    // specifiers, so `int *a[3]` yields an array of three pointers.
+    const ast::Type *buildSpecifierType(const std::vector<CParser::DeclarationSpecifierContext*> &specifiers);
+    const ast::Type *buildSpecifierType(CParser::SpecifierQualifierListContext *ctx);
+    const ast::Type *buildTypeName(CParser::TypeNameContext *ctx);
+    const ast::Type *applyPointer(const ast::Type *type, CParser::PointerContext *ctx);
+    const ast::Type *applyDeclarator(const ast::Type *type, CParser::DeclaratorContext *ctx);
+    const ast::Type *applyDirectDeclarator(const ast::Type *type, CParser::DirectDeclaratorContext *ctx);
+    const ast::Type *applyAbstractDeclarator(const ast::Type *type, CParser::AbstractDeclaratorContext *ctx);
+    const ast::Type *applyDirectAbstractDeclarator(const ast::Type *type,
+                                                   CParser::DirectAbstractDeclaratorContext *ctx);
+    const ast::Type *buildArrayType(const ast::Type *element, CParser::AssignmentExpressionContext *length);
+    const ast::Type *buildFunctionType(const ast::Type *result, CParser::ParameterTypeListContext *ctx);
+
     // Helper methods
-    std::string extractTypeFromSpecifiers(CParser::DeclarationSpecifiersContext *ctx);
     std::string extractIdentifierName(CParser::DirectDeclaratorContext *ctx);
-    std::vector<std::pair<std::string, std::string>> extractParameters(CParser::ParameterTypeListContext *ctx);
-    
-    // Extract nodes from ANTLR Any results
-    std::unique_ptr<ast::Expr> extractExpr(const antlrcpp::Any &result);
-    std::unique_ptr<ast::Stmt> extractStmt(const antlrcpp::Any &result);
-    
-    // Convert ANTLR tokens to binary operators
+    std::span<ast::FunctionDecl::Parameter> extractParameters(CParser::ParameterTypeListContext *ctx);
+    const ast::Type *buildParameterType(CParser::ParameterDeclarationContext *ctx);
+    ast::FunctionDecl *buildFunctionDecl(const ast::Type *returnType, CParser::DeclaratorContext *declarator,
+                                         ast::CompoundStmt *body);
+    ast::VarDecl *buildVarDecl(const ast::Type *baseType, CParser::InitDeclaratorContext *ctx);
+
+    /**
+     * Read the loop pragmas before an iteration statement. Later pragmas
+     * override earlier ones.
+     * @throws utils::SemanticError for a malformed pragma
+     */
+    ast::LoopHints buildLoopHints(CParser::IterationStatementContext *ctx);
+
+    /**
+     * Check a _Static_assert.
+     * @throws utils::SemanticError if it fails or its condition is not an
+     *         integer constant expression
+     */
+    void checkStaticAssert(CParser::StaticAssertDeclarationContext *ctx);
+
+    /**
+     * Fold a left-associative chain `operand (op operand)*` into BinaryExprs.
+     * Operator tokens sit between the operands in ctx->children.
+     */
+    template <typename Operand>
+    ast::Expr *buildBinaryChain(antlr4::ParserRuleContext *ctx, const std::vector<Operand*> &operands,
+                                ast::Expr *(ASTBuilder::*buildOperand)(Operand*));
+
+    // Convert ANTLR tokens to operators
     ast::BinaryExpr::OpKind tokenToBinaryOp(antlr4::Token *token);
+    ast::BinaryExpr::OpKind tokenToAssignmentOp(antlr4::Token *token);
     ast::UnaryExpr::OpKind tokenToUnaryOp(antlr4::Token *token);
-    
+
     // Parse numeric constants
-    long long parseIntegerConstant(const std::string &text);
+    static bool isHexPrefixed(const std::string &text);
+    ast::IntegerLiteral *parseIntegerConstant(antlr4::Token *token);
     double parseFloatingConstant(const std::string &text);
     char parseCharacterConstant(const std::string &text);
     std::string parseStringLiteral(const std::string &text);
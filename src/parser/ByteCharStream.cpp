@@ -0,0 +1,54 @@
+#include "parser/ByteCharStream.h"
+
+#include <algorithm>
+
+namespace parser {
+
+void ByteCharStream::consume() {
+    if (pos_ >= data_.size()) {
+        throw antlr4::IllegalStateException("cannot consume EOF");
+    }
+    ++pos_;
+}
+
+size_t ByteCharStream::LA(ssize_t i) {
+    if (i == 0) {
+        return 0; // undefined
+    }
+    ssize_t position = static_cast<ssize_t>(pos_);
+    if (i < 0) {
+        ++i; // LA(-1) is the symbol just before pos_
+        if (position + i - 1 < 0) {
+            return antlr4::IntStream::EOF;
+        }
+    }
+    if (position + i - 1 >= static_cast<ssize_t>(data_.size())) {
+        return antlr4::IntStream::EOF;
+    }
+    return static_cast<unsigned char>(data_[static_cast<size_t>(position + i - 1)]);
+}
+
+void ByteCharStream::seek(size_t index) {
+    pos_ = std::min(index, data_.size());
+}
+
+std::string ByteCharStream::getSourceName() const {
+    if (sourceName_.empty()) {
+        return antlr4::IntStream::UNKNOWN_SOURCE_NAME;
+    }
+    return sourceName_;
+}
+
+std::string ByteCharStream::getText(const antlr4::misc::Interval &interval) {
+    if (interval.a < 0 || interval.b < interval.a) {
+        return "";
+    }
+    size_t start = static_cast<size_t>(interval.a);
+    if (start >= data_.size()) {
+        return "";
+    }
+    size_t stop = std::min(static_cast<size_t>(interval.b), data_.size() - 1);
+    return std::string(data_.substr(start, stop - start + 1));
+}
+
+} // namespace parser
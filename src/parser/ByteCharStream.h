@@ -0,0 +1,41 @@
+#pragma once
+
+#include "antlr4-runtime.h"
+
+#include <string>
+#include <string_view>
+
+namespace parser {
+
+/**
+ * CharStream over a byte buffer the caller keeps alive.
+ *
+ * ANTLRInputStream decodes its input into a UTF-32 copy, four bytes per
+ * character. This reads the buffer in place, one byte per symbol, which is
+ * all the C lexer needs: identifiers and punctuators are ASCII, and bytes of
+ * multi-byte characters inside literals and comments pass through unchanged.
+ */
+class ByteCharStream : public antlr4::CharStream {
+public:
+    explicit ByteCharStream(std::string_view data, std::string sourceName = "")
+        : data_(data), sourceName_(std::move(sourceName)) {}
+
+    void consume() override;
+    size_t LA(ssize_t i) override;
+    ssize_t mark() override { return -1; }
+    void release(ssize_t marker) override { (void)marker; }
+    size_t index() override { return pos_; }
+    void seek(size_t index) override;
+    size_t size() override { return data_.size(); }
+    std::string getSourceName() const override;
+
+    std::string getText(const antlr4::misc::Interval &interval) override;
+    std::string toString() const override { return std::string(data_); }
+
+private:
+    std::string_view data_;
+    std::string sourceName_;
+    size_t pos_ = 0;
+};
+
+} // namespace parser
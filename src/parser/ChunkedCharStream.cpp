@@ -0,0 +1,95 @@
+#include "parser/ChunkedCharStream.h"
+
+#include <algorithm>
+
+namespace parser {
+
+namespace {
+
+// Discarded text is only erased once this much has built up
+constexpr size_t DiscardThreshold = 64 * 1024;
+
+} // namespace
+
+bool ChunkedCharStream::fill(size_t index) {
+    while (index >= base_ + buffer_.size()) {
+        std::string chunk;
+        if (exhausted_ || !chunks_.pop(chunk)) {
+            exhausted_ = true;
+            return false;
+        }
+        buffer_ += chunk;
+    }
+    return true;
+}
+
+void ChunkedCharStream::consume() {
+    if (!fill(pos_)) {
+        throw antlr4::IllegalStateException("cannot consume EOF");
+    }
+    ++pos_;
+}
+
+size_t ChunkedCharStream::LA(ssize_t i) {
+    if (i == 0) {
+        return 0; // undefined
+    }
+    ssize_t target = static_cast<ssize_t>(pos_) + (i > 0 ? i - 1 : i);
+    if (target < static_cast<ssize_t>(base_)) {
+        return antlr4::IntStream::EOF;
+    }
+    if (!fill(static_cast<size_t>(target))) {
+        return antlr4::IntStream::EOF;
+    }
+    return static_cast<unsigned char>(buffer_[static_cast<size_t>(target) - base_]);
+}
+
+ssize_t ChunkedCharStream::mark() {
+    if (marks_++ == 0) {
+        // A new token starts here; everything before it has been copied
+        // out. Keep one symbol before pos_ for LA(-1).
+        size_t keepFrom = pos_ > 0 ? pos_ - 1 : 0;
+        if (keepFrom > base_ && keepFrom - base_ >= DiscardThreshold) {
+            buffer_.erase(0, keepFrom - base_);
+            base_ = keepFrom;
+        }
+    }
+    return -static_cast<ssize_t>(marks_);
+}
+
+void ChunkedCharStream::release(ssize_t marker) {
+    (void)marker;
+    if (marks_ > 0) {
+        --marks_;
+    }
+}
+
+void ChunkedCharStream::seek(size_t index) {
+    if (index < base_) {
+        throw antlr4::IllegalStateException("cannot seek into discarded input");
+    }
+    fill(index);
+    pos_ = std::min(index, base_ + buffer_.size());
+}
+
+std::string ChunkedCharStream::getSourceName() const {
+    if (sourceName_.empty()) {
+        return antlr4::IntStream::UNKNOWN_SOURCE_NAME;
+    }
+    return sourceName_;
+}
+
+std::string ChunkedCharStream::getText(const antlr4::misc::Interval &interval) {
+    if (interval.a < 0 || interval.b < interval.a) {
+        return "";
+    }
+    size_t start = static_cast<size_t>(interval.a);
+    size_t stop = static_cast<size_t>(interval.b);
+    if (start < base_ || start >= base_ + buffer_.size()) {
+        return "";
+    }
+    stop = std::min(stop, base_ + buffer_.size() - 1);
+    return buffer_.substr(start - base_, stop - start + 1);
+}
+
+} // namespace parser
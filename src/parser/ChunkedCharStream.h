@@ -0,0 +1,50 @@
+#pragma once
+
+#include "utils/BoundedQueue.h"
+
+#include "antlr4-runtime.h"
+
+#include <string>
+
+namespace parser {
+
+/**
+ * CharStream fed by text chunks arriving on a queue, one byte per symbol.
+ *
+ * Lookahead past the buffered text blocks until the producer delivers the
+ * next chunk; the producer closing the queue is end of input. Text before
+ * the current token is discarded when the lexer starts the next one, so only
+ * a window around the token being lexed stays in memory. Token text must
+ * therefore be copied out of the stream before the next token is lexed.
+ */
+class ChunkedCharStream : public antlr4::CharStream {
+public:
+    explicit ChunkedCharStream(utils::BoundedQueue<std::string> &chunks, std::string sourceName = "")
+        : chunks_(chunks), sourceName_(std::move(sourceName)) {}
+
+    void consume() override;
+    size_t LA(ssize_t i) override;
+    ssize_t mark() override;
+    void release(ssize_t marker) override;
+    size_t index() override { return pos_; }
+    void seek(size_t index) override;
+    size_t size() override { return base_ + buffer_.size(); }
+    std::string getSourceName() const override;
+
+    std::string getText(const antlr4::misc::Interval &interval) override;
+    std::string toString() const override { return buffer_; }
+
+private:
+    utils::BoundedQueue<std::string> &chunks_;
+    std::string sourceName_;
+    std::string buffer_;   // text from absolute offset base_ onwards
+    size_t base_ = 0;
+    size_t pos_ = 0;
+    size_t marks_ = 0;
+    bool exhausted_ = false;
+
+    /** Make sure the symbol at absolute offset index is buffered. */
+    bool fill(size_t index);
+};
+
+} // namespace parser
@@ -0,0 +1,83 @@
+#include "parser/DeclarationStream.h"
+
+#include "CParser.h"
+
+namespace parser {
+
+ast::Node *DeclarationStream::next() {
+    // The previous declaration has been consumed
+    context_.reset();
+
+    for (;;) {
+        if (parser_) {
+            if (auto *decl = parser_->next()) {
+                return decl;
+            }
+            // Chunk finished; release its parser and tokens
+            syntaxErrors_ += parser_->getNumberOfSyntaxErrors();
+            parser_.reset();
+            chunk_.reset();
+        }
+
+        if (exhausted_) {
+            return nullptr;
+        }
+
+        auto tokens = readChunk();
+        if (tokens.empty()) {
+            continue;
+        }
+        chunk_ = std::make_unique<antlr4::ListTokenSource>(std::move(tokens));
+        parser_ = std::make_unique<TopLevelParser>(chunk_.get(), context_, bufferStart_);
+    }
+}
+
+std::vector<std::unique_ptr<antlr4::Token>> DeclarationStream::readChunk() {
+    std::vector<std::unique_ptr<antlr4::Token>> tokens;
+    DeclarationBoundary boundary;
+
+    for (;;) {
+        std::unique_ptr<antlr4::Token> token = lexer_->nextToken();
+        size_t type = token->getType();
+        if (type == antlr4::Token::EOF) {
+            exhausted_ = true;
+            break;
+        }
+        if (token->getChannel() != antlr4::Token::DEFAULT_CHANNEL) {
+            continue;
+        }
+
+        tokens.push_back(std::move(token));
+        if (boundary.feed(type)) {
+            break;
+        }
+    }
+
+    return tokens;
+}
+
+bool DeclarationBoundary::feed(size_t type) {
+    bool opensBody = type == CParser::LeftBrace && braces_ == 0 && parens_ == 0 &&
+                     previous_ == CParser::RightParen;
+    previous_ = type;
+
+    if (type == CParser::LeftParen) {
+        ++parens_;
+    } else if (type == CParser::RightParen) {
+        --parens_;
+    } else if (type == CParser::LeftBrace) {
+        functionBody_ = functionBody_ || opensBody;
+        ++braces_;
+    } else if (type == CParser::RightBrace) {
+        if (--braces_ == 0 && functionBody_) {
+            *this = DeclarationBoundary();
+            return true;
+        }
+    } else if (type == CParser::Semi && braces_ == 0 && parens_ == 0) {
+        *this = DeclarationBoundary();
+        return true;
+    }
+    return false;
+}
+
+} // namespace parser
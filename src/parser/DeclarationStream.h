@@ -0,0 +1,84 @@
+#pragma once
+
+#include "parser/TopLevelParser.h"
+#include "ast/Node.h"
+#include "ast/ASTContext.h"
+
+#include "antlr4-runtime.h"
+
+#include <memory>
+#include <vector>
+
+namespace parser {
+
+/**
+ * Finds where top-level declarations end in a stream of default-channel
+ * tokens: a ';' at file scope, or the '}' closing a function body (a '{' at
+ * file scope directly after ')').
+ */
+class DeclarationBoundary {
+public:
+    /**
+     * Account for the next token.
+     * @param type Token type
+     * @return true if the token ends the current declaration
+     */
+    bool feed(size_t type);
+
+private:
+    int parens_ = 0;
+    int braces_ = 0;
+    bool functionBody_ = false;
+    size_t previous_ = 0;
+};
+
+/**
+ * Streams external declarations straight off a lexer.
+ *
+ * Tokens are pulled from the lexer until one top-level declaration is
+ * complete (a ';' at file scope, or the '}' closing a function body), then
+ * that chunk alone is parsed and converted to AST. Tokens, parse tree,
+ * parser state and the declaration's arena are dropped before the next one
+ * is read, so memory does not grow with the size of the file.
+ */
+class DeclarationStream {
+public:
+    /**
+     * @param lexer Token source; must outlive the stream
+     * @param identifiers Table interning names; must outlive the stream and
+     *        anything keyed by the names it returns
+     * @param types Context uniquing types; same lifetime requirement
+     * @param bufferStart Location of the first character lexed, see
+     *        ASTBuilder
+     */
+    DeclarationStream(antlr4::TokenSource *lexer, ast::IdentifierTable &identifiers,
+                      ast::TypeContext &types,
+                      utils::SourceLocation bufferStart = utils::SourceLocation::getFromOffset(1))
+        : lexer_(lexer), context_(identifiers, types), bufferStart_(bufferStart) {}
+
+    /**
+     * Parse the next external declaration.
+     * @return The declaration's AST node, valid until the next call, or
+     *         nullptr at end of input
+     */
+    ast::Node *next();
+
+    /**
+     * Number of syntax errors reported so far.
+     */
+    size_t getNumberOfSyntaxErrors() const { return syntaxErrors_; }
+
+private:
+    antlr4::TokenSource *lexer_;
+    ast::ASTContext context_;
+    utils::SourceLocation bufferStart_;
+    std::unique_ptr<antlr4::ListTokenSource> chunk_;
+    std::unique_ptr<TopLevelParser> parser_;
+    bool exhausted_ = false;
+    size_t syntaxErrors_ = 0;
+
+    /** Read default-channel tokens up to the end of the next declaration. */
+    std::vector<std::unique_ptr<antlr4::Token>> readChunk();
+};
+
+} // namespace parser
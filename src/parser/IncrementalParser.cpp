@@ -0,0 +1,205 @@
+#include "parser/IncrementalParser.h"
+#include "parser/ByteCharStream.h"
+#include "parser/DeclarationStream.h"
+#include "parser/TopLevelParser.h"
+#include "ast/ASTVisitor.h"
+
+#include "antlr4-runtime.h"
+#include "CLexer.h"
+
+#include <deque>
+#include <string_view>
+#include <unordered_map>
+
+namespace parser {
+
+namespace {
+
+/** Moves every location in a subtree by a fixed delta. */
+class LocationShifter : public ast::ASTVisitor<LocationShifter> {
+    friend class ast::ASTVisitor<LocationShifter>;
+
+public:
+    explicit LocationShifter(int64_t delta) : delta_(delta) {}
+
+private:
+    int64_t delta_;
+
+    void visitBinaryExpr(ast::BinaryExpr *node) {
+        visit(node->left);
+        visit(node->right);
+        visitNode(node);
+    }
+    void visitUnaryExpr(ast::UnaryExpr *node) {
+        visit(node->operand);
+        visitNode(node);
+    }
+    void visitCallExpr(ast::CallExpr *node) {
+        visit(node->function);
+        for (auto *arg : node->arguments) {
+            visit(arg);
+        }
+        visitNode(node);
+    }
+    void visitArraySubscriptExpr(ast::ArraySubscriptExpr *node) {
+        visit(node->array);
+        visit(node->index);
+        visitNode(node);
+    }
+    void visitMemberExpr(ast::MemberExpr *node) {
+        visit(node->object);
+        visitNode(node);
+    }
+    void visitConditionalExpr(ast::ConditionalExpr *node) {
+        visit(node->condition);
+        visit(node->trueExpr);
+        visit(node->falseExpr);
+        visitNode(node);
+    }
+    void visitExprStmt(ast::ExprStmt *node) {
+        visit(node->expression);
+        visitNode(node);
+    }
+    void visitReturnStmt(ast::ReturnStmt *node) {
+        visit(node->expression);
+        visitNode(node);
+    }
+    void visitIfStmt(ast::IfStmt *node) {
+        visit(node->condition);
+        visit(node->thenStmt);
+        visit(node->elseStmt);
+        visitNode(node);
+    }
+    void visitWhileStmt(ast::WhileStmt *node) {
+        visit(node->condition);
+        visit(node->body);
+        visitNode(node);
+    }
+    void visitForStmt(ast::ForStmt *node) {
+        visit(node->init);
+        visit(node->condition);
+        visit(node->increment);
+        visit(node->body);
+        visitNode(node);
+    }
+    void visitCompoundStmt(ast::CompoundStmt *node) {
+        for (auto *stmt : node->statements) {
+            visit(stmt);
+        }
+        visitNode(node);
+    }
+    void visitVarDecl(ast::VarDecl *node) {
+        visit(node->initializer);
+        visitNode(node);
+    }
+    void visitFunctionDecl(ast::FunctionDecl *node) {
+        visit(node->body);
+        visitNode(node);
+    }
+    void visitNode(ast::Node *node) {
+        if (node && node->loc.isValid()) {
+            node->loc = node->loc.getLocWithOffset(delta_);
+        }
+    }
+};
+
+} // namespace
+
+ast::TranslationUnit *IncrementalParser::parse(const std::string &source) {
+    ByteCharStream input(source);
+    CLexer lexer(&input);
+
+    // Split the new version into declarations
+    std::vector<Chunk> chunks;
+    std::vector<std::vector<std::unique_ptr<antlr4::Token>>> chunkTokens;
+    std::vector<std::unique_ptr<antlr4::Token>> tokens;
+    DeclarationBoundary boundary;
+    for (;;) {
+        std::unique_ptr<antlr4::Token> token = lexer.nextToken();
+        size_t type = token->getType();
+        bool atEnd = type == antlr4::Token::EOF;
+        if (!atEnd) {
+            if (token->getChannel() != antlr4::Token::DEFAULT_CHANNEL) {
+                continue;
+            }
+            tokens.push_back(std::move(token));
+        }
+        if ((atEnd || boundary.feed(type)) && !tokens.empty()) {
+            Chunk chunk;
+            chunk.offset = tokens.front()->getStartIndex();
+            // Reused nodes are only shifted as a whole, so the spacing
+            // between the tokens is part of the key too
+            for (const auto &t : tokens) {
+                chunk.key += std::to_string(t->getStartIndex() - chunk.offset);
+                chunk.key += '\x1f';
+                chunk.key += std::to_string(t->getType());
+                chunk.key += '\x1f';
+                chunk.key += t->getText();
+                chunk.key += '\x1e';
+            }
+            chunks.push_back(std::move(chunk));
+            chunkTokens.push_back(std::move(tokens));
+            tokens.clear();
+        }
+        if (atEnd) {
+            break;
+        }
+    }
+
+    std::unordered_map<std::string_view, std::deque<size_t>> previousByKey;
+    for (size_t c = 0; c < chunks_.size(); ++c) {
+        previousByKey[chunks_[c].key].push_back(c);
+    }
+
+    std::vector<ast::Node*> declarations;
+    reparsed_ = 0;
+    for (size_t c = 0; c < chunks.size(); ++c) {
+        Chunk &chunk = chunks[c];
+
+        auto it = previousByKey.find(chunk.key);
+        if (it != previousByKey.end() && !it->second.empty()) {
+            // Unchanged: take over its arena and move the nodes to the new position
+            Chunk &old = chunks_[it->second.front()];
+            it->second.pop_front();
+
+            LocationShifter shifter(static_cast<int64_t>(chunk.offset) - static_cast<int64_t>(old.offset));
+            for (auto *node : old.nodes) {
+                if (chunk.offset != old.offset) {
+                    shifter.visit(node);
+                }
+                declarations.push_back(node);
+            }
+            chunk.context = std::move(old.context);
+            chunk.nodes = std::move(old.nodes);
+            chunk.syntaxErrors = old.syntaxErrors;
+            continue;
+        }
+
+        chunk.context = std::make_unique<ast::ASTContext>(identifiers_, types_);
+        antlr4::ListTokenSource chunkSource(std::move(chunkTokens[c]));
+        TopLevelParser topLevel(&chunkSource, *chunk.context);
+        while (auto *decl = topLevel.next()) {
+            declarations.push_back(decl);
+            chunk.nodes.push_back(decl);
+        }
+        chunk.syntaxErrors = topLevel.getNumberOfSyntaxErrors();
+        ++reparsed_;
+    }
+
+    // Keys in previousByKey view the old chunks, so replace them last.
+    // Arenas of declarations that were edited away are freed here.
+    chunks_ = std::move(chunks);
+    unitContext_.reset();
+    unit_ = unitContext_.create<ast::TranslationUnit>(unitContext_.copyArray(declarations));
+    return unit_;
+}
+
+size_t IncrementalParser::getNumberOfSyntaxErrors() const {
+    size_t errors = 0;
+    for (const auto &chunk : chunks_) {
+        errors += chunk.syntaxErrors;
+    }
+    return errors;
+}
+
+} // namespace parser
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "ast/Node.h"
+#include "ast/Stmt.h"
+#include "ast/ASTContext.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace parser {
+
+/**
+ * Reparses successive versions of one source file, reusing the AST of every
+ * top-level declaration whose tokens did not change.
+ *
+ * Each version is lexed in full and split into external declarations at
+ * file-scope ';' and function-body '}' tokens. A declaration whose token
+ * types, texts and relative offsets match one from the previous version
+ * keeps its previous ast::Node, with its location shifted to the new
+ * position; only the remaining declarations are parsed. Each declaration
+ * has its own arena, so one that is edited or removed is freed without
+ * touching the others. After a one-line edit, the parse costs one lex of
+ * the file plus one parse of the edited declaration.
+ */
+class IncrementalParser {
+public:
+    /**
+     * Parse a new version of the source.
+     * @return The translation unit; owned by the parser and valid until the
+     *         next call
+     */
+    ast::TranslationUnit *parse(const std::string &source);
+
+    /**
+     * Number of syntax errors in the current version.
+     */
+    size_t getNumberOfSyntaxErrors() const;
+
+    /**
+     * Number of declarations the last call had to parse.
+     */
+    size_t getReparsedCount() const { return reparsed_; }
+
+private:
+    /** One top-level declaration of the previous version. */
+    struct Chunk {
+        std::string key;        // token offsets from the first, types and texts
+        size_t offset = 0;      // of the first token
+        std::unique_ptr<ast::ASTContext> context;
+        std::vector<ast::Node*> nodes; // AST nodes it produced
+        size_t syntaxErrors = 0;
+    };
+
+    ast::IdentifierTable identifiers_; // shared by every version
+    ast::TypeContext types_;
+    std::vector<Chunk> chunks_;
+    ast::ASTContext unitContext_{identifiers_, types_};
+    ast::TranslationUnit *unit_ = nullptr;
+    size_t reparsed_ = 0;
+};
+
+} // namespace parser
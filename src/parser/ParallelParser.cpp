@@ -0,0 +1,203 @@
+#include "parser/ParallelParser.h"
+#include "parser/ASTBuilder.h"
+#include "parser/TopLevelParser.h"
+#include "utils/ThreadPool.h"
+#include "ast/Casting.h"
+
+#include "CParser.h"
+
+#include <unordered_map>
+#include <utility>
+
+namespace parser {
+
+namespace {
+
+std::unique_ptr<antlr4::Token> copyToken(antlr4::Token *token) {
+    return std::make_unique<antlr4::CommonToken>(token);
+}
+
+std::vector<ast::Node*> parseDeclarations(antlr4::TokenSource *source, ast::ASTContext &context,
+                                          utils::SourceLocation bufferStart, size_t &syntaxErrors) {
+    TopLevelParser topLevel(source, context, bufferStart);
+    std::vector<ast::Node*> declarations;
+    while (auto *decl = topLevel.next()) {
+        declarations.push_back(decl);
+    }
+    syntaxErrors = topLevel.getNumberOfSyntaxErrors();
+    return declarations;
+}
+
+} // namespace
+
+ast::TranslationUnit *ParallelParser::parse(antlr4::TokenSource *source, ast::ASTContext &context,
+                                            utils::SourceLocation bufferStart) {
+    syntaxErrors_ = 0;
+
+    antlr4::CommonTokenStream stream(source);
+    stream.fill();
+
+    // Only default-channel tokens reach the parser
+    std::vector<antlr4::Token*> tokens;
+    for (auto *token : stream.getTokens()) {
+        if (token->getChannel() == antlr4::Token::DEFAULT_CHANNEL && token->getType() != antlr4::Token::EOF) {
+            tokens.push_back(token);
+        }
+    }
+
+    std::vector<BodyRange> bodies = findFunctionBodies(tokens);
+    if (bodies.empty()) {
+        return parseSerially(tokens, context, bufferStart);
+    }
+
+    // Top-level token stream with every body collapsed to "{}"
+    std::vector<std::unique_ptr<antlr4::Token>> topLevelTokens;
+    size_t next = 0;
+    for (const auto &body : bodies) {
+        for (size_t i = next; i <= body.open; ++i) {
+            topLevelTokens.push_back(copyToken(tokens[i]));
+        }
+        topLevelTokens.push_back(copyToken(tokens[body.close]));
+        next = body.close + 1;
+    }
+    for (size_t i = next; i < tokens.size(); ++i) {
+        topLevelTokens.push_back(copyToken(tokens[i]));
+    }
+
+    // Bodies are parsed on the pool while this thread parses the top level.
+    // The pool is declared last so it drains before anything its tasks use.
+    std::vector<ast::CompoundStmt*> parsedBodies(bodies.size());
+    std::vector<ast::ASTContext> bodyContexts;
+    bodyContexts.reserve(bodies.size());
+    for (size_t b = 0; b < bodies.size(); ++b) {
+        bodyContexts.emplace_back(context.getIdentifiers(), context.getTypes());
+    }
+    utils::ThreadPool pool(jobs_);
+    for (size_t b = 0; b < bodies.size(); ++b) {
+        pool.submit([this, &tokens, &bodies, &parsedBodies, &bodyContexts, bufferStart, b] {
+            parsedBodies[b] = parseBody(tokens, bodies[b], bodyContexts[b], bufferStart);
+        });
+    }
+
+    antlr4::ListTokenSource topLevelSource(std::move(topLevelTokens));
+    size_t topLevelErrors = 0;
+    auto declarations = parseDeclarations(&topLevelSource, context, bufferStart, topLevelErrors);
+    pool.wait();
+    syntaxErrors_ += topLevelErrors;
+    for (auto &bodyContext : bodyContexts) {
+        context.adopt(std::move(bodyContext));
+    }
+
+    // Join bodies back by the location of their definition's first token
+    std::unordered_map<uint32_t, size_t> bodyByStart;
+    for (size_t b = 0; b < bodies.size(); ++b) {
+        auto start = static_cast<int64_t>(tokens[bodies[b].declStart]->getStartIndex());
+        bodyByStart[bufferStart.getLocWithOffset(start).getOffset()] = b;
+    }
+
+    size_t joined = 0;
+    for (auto *decl : declarations) {
+        auto *func = ast::dyn_cast<ast::FunctionDecl>(decl);
+        if (!func || !func->isDefinition()) {
+            continue;
+        }
+        auto it = bodyByStart.find(func->loc.getOffset());
+        if (it == bodyByStart.end() || !parsedBodies[it->second]) {
+            continue; // body was parsed inline, e.g. a K&R definition
+        }
+        func->body = parsedBodies[it->second];
+        ++joined;
+    }
+
+    if (joined != bodies.size()) {
+        // The brace scan found a body the grammar disagrees with; the split
+        // cannot be trusted, so parse the file as a whole instead.
+        return parseSerially(tokens, context, bufferStart);
+    }
+
+    return context.create<ast::TranslationUnit>(context.copyArray(declarations));
+}
+
+std::vector<ParallelParser::BodyRange> ParallelParser::findFunctionBodies(const std::vector<antlr4::Token*> &tokens) {
+    std::vector<BodyRange> bodies;
+    size_t declStart = 0;
+    int parens = 0;
+    int braces = 0;
+
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        size_t type = tokens[i]->getType();
+        if (type == CParser::LeftParen) {
+            ++parens;
+        } else if (type == CParser::RightParen) {
+            --parens;
+        } else if (type == CParser::LeftBrace) {
+            bool isBody = braces == 0 && parens == 0 && i > declStart &&
+                          tokens[i - 1]->getType() == CParser::RightParen;
+            if (!isBody) {
+                ++braces;
+                continue;
+            }
+
+            // Skip the body by brace matching
+            int depth = 0;
+            size_t close = i;
+            for (; close < tokens.size(); ++close) {
+                size_t t = tokens[close]->getType();
+                if (t == CParser::LeftBrace) {
+                    ++depth;
+                } else if (t == CParser::RightBrace && --depth == 0) {
+                    break;
+                }
+            }
+            if (close == tokens.size()) {
+                break; // unbalanced; leave the rest to the parser to report
+            }
+
+            bodies.push_back({declStart, i, close});
+            i = close;
+            declStart = close + 1;
+        } else if (type == CParser::RightBrace) {
+            --braces;
+        } else if (type == CParser::Semi && braces == 0 && parens == 0) {
+            declStart = i + 1;
+        }
+    }
+
+    return bodies;
+}
+
+ast::CompoundStmt *ParallelParser::parseBody(const std::vector<antlr4::Token*> &tokens, const BodyRange &range,
+                                             ast::ASTContext &context, utils::SourceLocation bufferStart) {
+    std::vector<std::unique_ptr<antlr4::Token>> bodyTokens;
+    bodyTokens.reserve(range.close - range.open + 1);
+    for (size_t i = range.open; i <= range.close; ++i) {
+        bodyTokens.push_back(copyToken(tokens[i]));
+    }
+
+    antlr4::ListTokenSource source(std::move(bodyTokens));
+    antlr4::CommonTokenStream stream(&source);
+    CParser parser(&stream);
+
+    auto *ctx = parser.compoundStatement();
+    syntaxErrors_ += parser.getNumberOfSyntaxErrors();
+
+    ASTBuilder builder(context, bufferStart);
+    return builder.buildCompoundStatement(ctx);
+}
+
+ast::TranslationUnit *ParallelParser::parseSerially(const std::vector<antlr4::Token*> &tokens, ast::ASTContext &context,
+                                                    utils::SourceLocation bufferStart) {
+    std::vector<std::unique_ptr<antlr4::Token>> copies;
+    copies.reserve(tokens.size());
+    for (auto *token : tokens) {
+        copies.push_back(copyToken(token));
+    }
+
+    antlr4::ListTokenSource source(std::move(copies));
+    size_t errors = 0;
+    auto declarations = parseDeclarations(&source, context, bufferStart, errors);
+    syntaxErrors_ = errors;
+    return context.create<ast::TranslationUnit>(context.copyArray(declarations));
+}
+
+} // namespace parser
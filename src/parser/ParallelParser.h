@@ -0,0 +1,72 @@
+#pragma once
+
+#include "ast/Node.h"
+#include "ast/Stmt.h"
+#include "ast/ASTContext.h"
+#include "utils/SourceLocation.h"
+
+#include "antlr4-runtime.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace parser {
+
+/**
+ * Parses a translation unit with function bodies deferred and parsed in
+ * parallel.
+ *
+ * The top level is parsed first with every function body collapsed to "{}".
+ * Bodies are found by brace matching on the token stream and recorded as
+ * token ranges; each is parsed into an ast::CompoundStmt on a thread pool by
+ * a worker with its own CParser over a copy of its range of the shared,
+ * read-only token buffer, allocating into its own ASTContext. Finished
+ * bodies are joined back into their ast::FunctionDecl in source order and
+ * their arenas adopted by the caller's context.
+ */
+class ParallelParser {
+public:
+    /**
+     * @param jobs Number of worker threads (0 selects the hardware concurrency)
+     */
+    explicit ParallelParser(unsigned jobs = 0) : jobs_(jobs) {}
+
+    /**
+     * Parse every token produced by source.
+     * @param context Arena receiving the AST
+     * @param bufferStart Location of the first character of the tokenized
+     *        buffer, see ASTBuilder
+     */
+    ast::TranslationUnit *parse(antlr4::TokenSource *source, ast::ASTContext &context,
+                                utils::SourceLocation bufferStart = utils::SourceLocation::getFromOffset(1));
+
+    /**
+     * Number of syntax errors reported by the last parse.
+     */
+    size_t getNumberOfSyntaxErrors() const { return syntaxErrors_; }
+
+private:
+    /** Token indices of a function body and of its declaration. */
+    struct BodyRange {
+        size_t declStart; // first token of the function definition
+        size_t open;      // '{'
+        size_t close;     // matching '}'
+    };
+
+    unsigned jobs_;
+    std::atomic<size_t> syntaxErrors_{0};
+
+    /** Find top-level function bodies: a '{' at file scope right after ')'. */
+    static std::vector<BodyRange> findFunctionBodies(const std::vector<antlr4::Token*> &tokens);
+
+    /** Parse one body with a private parser. */
+    ast::CompoundStmt *parseBody(const std::vector<antlr4::Token*> &tokens, const BodyRange &range,
+                                 ast::ASTContext &context, utils::SourceLocation bufferStart);
+
+    /** Parse the whole token buffer serially, one declaration at a time. */
+    ast::TranslationUnit *parseSerially(const std::vector<antlr4::Token*> &tokens, ast::ASTContext &context,
+                                        utils::SourceLocation bufferStart);
+};
+
+} // namespace parser
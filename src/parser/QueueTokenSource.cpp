@@ -0,0 +1,30 @@
+#include "parser/QueueTokenSource.h"
+
+namespace parser {
+
+std::unique_ptr<antlr4::Token> QueueTokenSource::nextToken() {
+    while (next_ == batch_.size()) {
+        batch_.clear();
+        next_ = 0;
+        if (!batches_.pop(batch_)) {
+            // End of input: synthesize EOF just past the last token
+            auto eof = std::make_unique<antlr4::CommonToken>(antlr4::Token::EOF, "<EOF>");
+            eof->setLine(line_);
+            eof->setCharPositionInLine(column_);
+            return eof;
+        }
+    }
+
+    const antlr4::Token &lexed = *batch_[next_++];
+    auto token = std::make_unique<antlr4::CommonToken>(
+        std::pair<antlr4::TokenSource*, antlr4::CharStream*>(this, nullptr), lexed.getType(), lexed.getChannel(),
+        lexed.getStartIndex(), lexed.getStopIndex());
+    token->setText(lexed.getText());
+    token->setLine(lexed.getLine());
+    token->setCharPositionInLine(lexed.getCharPositionInLine());
+    line_ = token->getLine();
+    column_ = token->getCharPositionInLine() + token->getText().size();
+    return token;
+}
+
+} // namespace parser
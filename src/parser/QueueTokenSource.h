@@ -0,0 +1,43 @@
+#pragma once
+
+#include "utils/BoundedQueue.h"
+
+#include "antlr4-runtime.h"
+
+#include <memory>
+#include <vector>
+
+namespace parser {
+
+/**
+ * TokenSource reading batches of tokens that a lexer on another thread
+ * pushes onto a queue. nextToken() blocks until the next batch arrives and
+ * returns EOF once the queue is closed. Tokens must carry their own text and
+ * position. They are handed to the parser as tokens of this source, since
+ * the lexer that made them may be gone before the parser is done with them
+ * (error recovery asks a token's source for its input stream).
+ */
+class QueueTokenSource : public antlr4::TokenSource {
+public:
+    using Batch = std::vector<std::unique_ptr<antlr4::Token>>;
+
+    explicit QueueTokenSource(utils::BoundedQueue<Batch> &batches) : batches_(batches) {}
+
+    std::unique_ptr<antlr4::Token> nextToken() override;
+    size_t getLine() const override { return line_; }
+    size_t getCharPositionInLine() override { return column_; }
+    antlr4::CharStream *getInputStream() override { return nullptr; }
+    std::string getSourceName() override { return antlr4::IntStream::UNKNOWN_SOURCE_NAME; }
+    antlr4::TokenFactory<antlr4::CommonToken> *getTokenFactory() override {
+        return antlr4::CommonTokenFactory::DEFAULT.get();
+    }
+
+private:
+    utils::BoundedQueue<Batch> &batches_;
+    Batch batch_;
+    size_t next_ = 0;
+    size_t line_ = 1;
+    size_t column_ = 0;
+};
+
+} // namespace parser
@@ -0,0 +1,36 @@
+#include "parser/TopLevelParser.h"
+
+namespace parser {
+
+TopLevelParser::TopLevelParser(antlr4::TokenSource *source, ast::ASTContext &context,
+                               utils::SourceLocation bufferStart)
+    : tokens_(source), parser_(&tokens_), builder_(context, bufferStart) {}
+
+ast::Node *TopLevelParser::next() {
+    while (tokens_.LA(1) != antlr4::Token::EOF) {
+        size_t start = tokens_.index();
+
+        auto *ctx = parser_.externalDeclaration();
+        ast::Node *decl = builder_.buildExternalDeclaration(ctx);
+
+        // The subtree has been converted; free it before parsing the next one.
+        // The error strategy may still point at a context from this subtree,
+        // so give it a fresh one as well.
+        parser_.releaseParseTrees();
+        parser_.setErrorHandler(std::make_shared<antlr4::DefaultErrorStrategy>());
+
+        // Error recovery normally guarantees progress, but that bookkeeping
+        // lived in the strategy we just replaced.
+        if (tokens_.index() == start) {
+            parser_.consume();
+        }
+
+        if (decl) {
+            return decl;
+        }
+        // Stray ';' or a declaration ASTBuilder does not model yet; keep going.
+    }
+    return nullptr;
+}
+
+} // namespace parser
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "parser/ASTBuilder.h"
+#include "ast/Node.h"
+#include "ast/ASTContext.h"
+
+#include "antlr4-runtime.h"
+#include "CParser.h"
+
+#include <memory>
+
+namespace parser {
+
+/**
+ * Parses a translation unit one external declaration at a time.
+ *
+ * CParser::translationUnit() materializes the parse tree for the whole file
+ * before ASTBuilder runs. Instead, this drives CParser::externalDeclaration()
+ * in a loop, converts each subtree to AST immediately and then frees every
+ * parse-tree node the parser allocated for it. Only the current declaration's
+ * ParserRuleContext tree is ever alive.
+ */
+class TopLevelParser {
+public:
+    /**
+     * @param source Token source (usually a CLexer); must outlive the parser
+     * @param context Arena receiving the AST
+     * @param bufferStart Location of the first character of the tokenized
+     *        buffer, see ASTBuilder
+     */
+    TopLevelParser(antlr4::TokenSource *source, ast::ASTContext &context,
+                   utils::SourceLocation bufferStart = utils::SourceLocation::getFromOffset(1));
+
+    /**
+     * Parse the next external declaration.
+     * @return The declaration's AST node, or nullptr at end of input
+     */
+    ast::Node *next();
+
+    /**
+     * Number of syntax errors reported so far.
+     */
+    size_t getNumberOfSyntaxErrors() { return parser_.getNumberOfSyntaxErrors(); }
+
+private:
+    /**
+     * CParser that can drop the parse-tree nodes it has allocated so far.
+     * Rule contexts and terminal nodes are owned by the parser's tracker,
+     * not by their parents, so they are otherwise kept until destruction.
+     */
+    class ReleasingParser : public CParser {
+    public:
+        using CParser::CParser;
+
+        void releaseParseTrees() { _tracker.reset(); }
+    };
+
+    antlr4::CommonTokenStream tokens_;
+    ReleasingParser parser_;
+    ASTBuilder builder_;
+};
+
+} // namespace parser
@@ -11,15 +11,9 @@
 namespace preprocessor {
 
 std::string Preprocessor::preprocess(const std::string &inputFile, const std::string &outputFile) {
-    log("Preprocessing " + inputFile);
-
-    // initialize macros from raw definitions (once per preprocess)
-    macros_.clear();
-    for (const auto &spec : macroDefinitions_) {
-        defineMacroFromSpec(spec);
-    }
-
-    std::string result = preprocessFileInternal(inputFile);
+    std::ostringstream out;
+    preprocess(inputFile, out);
+    std::string result = out.str();
 
     if (!outputFile.empty()) {
         std::ofstream file(outputFile);
@@ -33,6 +27,37 @@ std::string Preprocessor::preprocess(const std::string &inputFile, const std::st
     return result;
 }
 
+void Preprocessor::preprocess(const std::string &inputFile, std::ostream &out) {
+    log("Preprocessing " + inputFile);
+
+    // initialize macros from raw definitions (once per preprocess)
+    macros_.clear();
+    for (const auto &spec : macroDefinitions_) {
+        defineMacroFromSpec(spec);
+    }
+
+    outputLine_ = 0;
+    expectedLineLoc_ = utils::SourceLocation();
+    lineMarkers_.clear();
+
+    preprocessFileInternal(inputFile, out);
+}
+
+utils::FileID Preprocessor::preprocessToBuffer(const std::string &inputFile) {
+    if (!sourceManager_) {
+        throw std::logic_error("preprocessToBuffer requires a SourceManager");
+    }
+
+    std::ostringstream out;
+    preprocess(inputFile, out);
+
+    utils::FileID file = sourceManager_->createBuffer(inputFile, out.str());
+    for (const auto &[line, origin] : lineMarkers_) {
+        sourceManager_->addLineMarker(file, line, origin);
+    }
+    return file;
+}
+
 void Preprocessor::addIncludeDirectory(const std::string &dir) {
     includeDirs_.push_back(dir);
     log("Added include directory: " + dir);
@@ -44,46 +69,69 @@ void Preprocessor::addMacroDefinition(const std::string &macro) {
 }
 
 // --- Core processing ---
-std::string Preprocessor::preprocessFileInternal(const std::string &filePath) {
+void Preprocessor::preprocessFileInternal(const std::string &filePath, std::ostream &out,
+                                          utils::SourceLocation includeLoc) {
     std::string content = readFileToString(filePath);
     std::string dir = std::filesystem::path(filePath).parent_path().string();
-    return preprocessStringInternal(content, dir);
-}
+    if (!sourceManager_) {
+        preprocessStringInternal(content, dir, out);
+        return;
+    }
 
-std::string Preprocessor::preprocessStringInternal(const std::string &source, const std::string &currentFileDir) {
-    std::istringstream in(source);
-    std::ostringstream out;
+    // The SourceManager owns the text from here on
+    utils::FileID file = sourceManager_->createBuffer(filePath, std::move(content), includeLoc);
+    preprocessStringInternal(sourceManager_->getBufferData(file), dir, out,
+                             sourceManager_->getLocForStartOfFile(file));
+}
 
+void Preprocessor::preprocessStringInternal(std::string_view source, const std::string &currentFileDir, std::ostream &out,
+                                            utils::SourceLocation fileStart) {
     ifStack_.clear();
 
-    std::string line;
-    while (std::getline(in, line)) {
+    size_t lineStart = 0;
+    while (lineStart < source.size()) {
+        size_t lineEnd = source.find('\n', lineStart);
+        if (lineEnd == std::string_view::npos) {
+            lineEnd = source.size();
+        }
+        std::string line(source.substr(lineStart, lineEnd - lineStart));
+        utils::SourceLocation lineLoc;
+        if (fileStart.isValid()) {
+            lineLoc = fileStart.getLocWithOffset(lineStart);
+        }
+        lineStart = lineEnd + 1;
+        currentLineLoc_ = lineLoc;
+
         // Handle CRLF
         if (!line.empty() && line.back() == '\r') line.pop_back();
 
         std::string t = trim(line);
-        if (t.rfind('#', 0) == 0) {
-            // Preprocessor directive
+        bool isDirective = t.rfind('#', 0) == 0;
+        if (isDirective) {
+            // Preprocessor directive; the few the parser reads are passed on
             if (handleDirective(t, currentFileDir, out, isCurrentlyActive())) {
                 continue;
             }
-            continue;
-        }
-
-        if (!isCurrentlyActive()) {
+        } else if (!isCurrentlyActive()) {
             continue; // skip inactive regions
         }
 
-        // Expand macros in non-directive lines
-        std::string expanded = expandMacros(line);
-        out << expanded << '\n';
+        // Expand macros in non-directive lines and loop pragma arguments
+        out << (isDirective ? expandLoopPragma(t) : expandMacros(line)) << '\n';
+
+        // Mark only where output stops following the source line by line
+        ++outputLine_;
+        if (lineLoc.isValid()) {
+            if (lineLoc != expectedLineLoc_) {
+                lineMarkers_.emplace_back(outputLine_, lineLoc);
+            }
+            expectedLineLoc_ = fileStart.getLocWithOffset(lineStart);
+        }
     }
 
     if (!ifStack_.empty()) {
         throw std::runtime_error("Unterminated #if/#ifdef block");
     }
-
-    return out.str();
 }
 
 std::string Preprocessor::resolveInclude(const std::string &target, bool isSystem, const std::string &currentFileDir) {
@@ -127,7 +175,7 @@ std::string Preprocessor::readFileToString(const std::string &path) {
     return ss.str();
 }
 
-bool Preprocessor::handleDirective(const std::string &line, const std::string &currentFileDir, std::ostringstream &out, bool isActive) {
+bool Preprocessor::handleDirective(const std::string &line, const std::string &currentFileDir, std::ostream &out, bool isActive) {
     // line starts with '#'
     size_t i = 1;
     while (i < line.size() && std::isspace(static_cast<unsigned char>(line[i]))) ++i;
@@ -169,8 +217,12 @@ bool Preprocessor::handleDirective(const std::string &line, const std::string &c
     } else if (keyword == "endif") {
         popIf();
         return true;
-    } else if (keyword == "pragma" || keyword == "line" || keyword == "error" || keyword == "warning") {
-        // Ignore pragmas and diagnostics for now
+    } else if (keyword == "pragma") {
+        // Loop pragmas apply to the statement after them, so the parser gets
+        // them; any other pragma is ignored
+        return !isActive || !isLoopPragma(rest);
+    } else if (keyword == "line" || keyword == "error" || keyword == "warning") {
+        // Ignore diagnostics for now
         return true;
     }
 
@@ -220,7 +272,7 @@ void Preprocessor::handleUndef(const std::string &rest) {
     macros_.erase(name);
 }
 
-bool Preprocessor::handleInclude(const std::string &rest, const std::string &currentFileDir, std::ostringstream &out, bool isActive) {
+bool Preprocessor::handleInclude(const std::string &rest, const std::string &currentFileDir, std::ostream &out, bool isActive) {
     if (!isActive) return true; // ignore include in inactive blocks
 
     std::string r = trim(rest);
@@ -250,11 +302,8 @@ bool Preprocessor::handleInclude(const std::string &rest, const std::string &cur
         throw std::runtime_error("Include not found: " + target);
     }
 
-    // Recursively preprocess included file
-    std::string included = preprocessFileInternal(path);
-
-    // Append to output
-    out << included;
+    // Recursively preprocess included file straight into the output
+    preprocessFileInternal(path, out, currentLineLoc_);
     return true;
 }
 
@@ -419,6 +468,29 @@ std::string Preprocessor::expandMacros(const std::string &line) {
     return out;
 }
 
+bool Preprocessor::isLoopPragma(const std::string &pragma) {
+    std::istringstream words(pragma);
+    std::string first, second;
+    words >> first >> second;
+    if (first == "unroll" || first == "nounroll") {
+        return true;
+    }
+    return (first == "clang" && second == "loop") || (first == "GCC" && (second == "unroll" || second == "ivdep")) ||
+           (first == "omp" && second == "simd");
+}
+
+std::string Preprocessor::expandLoopPragma(const std::string &directive) {
+    // Keep '#', the keyword and the pragma's name, such as "clang loop"
+    std::istringstream words(directive.substr(1));
+    std::string keyword, first, second;
+    words >> keyword >> first;
+    if (first == "clang" || first == "GCC" || first == "omp") {
+        words >> second;
+    }
+    size_t nameEnd = words.eof() ? directive.size() : 1 + static_cast<size_t>(words.tellg());
+    return directive.substr(0, nameEnd) + expandMacros(directive.substr(nameEnd));
+}
+
 std::string Preprocessor::trim(const std::string &s) {
     size_t a = 0; while (a < s.size() && std::isspace(static_cast<unsigned char>(s[a]))) ++a;
     size_t b = s.size(); while (b > a && std::isspace(static_cast<unsigned char>(s[b-1]))) --b;
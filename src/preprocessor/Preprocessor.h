@@ -1,9 +1,12 @@
 #pragma once
 
+#include "utils/SourceManager.h"
+
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
-#include <sstream>
+#include <ostream>
 
 namespace preprocessor {
 
@@ -14,9 +17,11 @@ namespace preprocessor {
  *  - #define/#undef for object-like and simple function-like macros
  *  - #ifdef/#ifndef/#else/#elif/#endif with basic defined() expressions
  *  - Macro expansion on non-directive lines
+ *  - Loop pragmas (see isLoopPragma), passed on to the parser with their
+ *    arguments macro-expanded
  *
  * This is a pragmatic subset sufficient for our compiler tests; not a complete
- * C preprocessor. It intentionally ignores pragmas and many exotic features.
+ * C preprocessor. It intentionally ignores other pragmas and many exotic features.
  */
 class Preprocessor {
 public:
@@ -30,6 +35,28 @@ public:
      */
     std::string preprocess(const std::string &inputFile, const std::string &outputFile = "");
     
+    /**
+     * Preprocess a source file, writing output to a stream as it is produced.
+     * @param inputFile Path to the source file
+     * @param out Stream receiving the preprocessed source line by line
+     */
+    void preprocess(const std::string &inputFile, std::ostream &out);
+    
+    /**
+     * Preprocess a source file into a new buffer of the SourceManager.
+     * Line markers on the buffer map each output line back to the file and
+     * line it came from. Requires setSourceManager().
+     * @param inputFile Path to the source file
+     * @return The buffer holding the preprocessed source
+     */
+    utils::FileID preprocessToBuffer(const std::string &inputFile);
+    
+    /**
+     * Load every file read into a SourceManager, so locations in the
+     * preprocessed output can be traced back through #include.
+     */
+    void setSourceManager(utils::SourceManager *sourceManager) { sourceManager_ = sourceManager; }
+    
     /**
      * Add an include directory to the search path.
      */
@@ -57,11 +84,20 @@ private:
     std::unordered_map<std::string, Macro> macros_; // parsed and active
     bool verbose_ = false;
 
+    /** Location tracking, active only with a SourceManager */
+    utils::SourceManager *sourceManager_ = nullptr;
+    utils::SourceLocation currentLineLoc_;   // start of the line being processed
+    utils::SourceLocation expectedLineLoc_;  // origin of the next output line if no jump
+    unsigned outputLine_ = 0;
+    std::vector<std::pair<unsigned, utils::SourceLocation>> lineMarkers_;
+
     /**
      * Core preprocessors
      */
-    std::string preprocessFileInternal(const std::string &filePath);
-    std::string preprocessStringInternal(const std::string &source, const std::string &currentFileDir);
+    void preprocessFileInternal(const std::string &filePath, std::ostream &out,
+                                utils::SourceLocation includeLoc = {});
+    void preprocessStringInternal(std::string_view source, const std::string &currentFileDir, std::ostream &out,
+                                  utils::SourceLocation fileStart = {});
 
     /** Resolve an include target to a file path (empty if not found). */
     std::string resolveInclude(const std::string &target, bool isSystem, const std::string &currentFileDir);
@@ -69,11 +105,14 @@ private:
     /** Read a file into a string, throws on failure. */
     static std::string readFileToString(const std::string &path);
 
-    /** Directive handling */
-    bool handleDirective(const std::string &line, const std::string &currentFileDir, std::ostringstream &out, bool isActive);
+    /**
+     * Directive handling. handleDirective returns false for a directive
+     * to be passed on to the parser.
+     */
+    bool handleDirective(const std::string &line, const std::string &currentFileDir, std::ostream &out, bool isActive);
     void handleDefine(const std::string &rest);
     void handleUndef(const std::string &rest);
-    bool handleInclude(const std::string &rest, const std::string &currentFileDir, std::ostringstream &out, bool isActive);
+    bool handleInclude(const std::string &rest, const std::string &currentFileDir, std::ostream &out, bool isActive);
 
     /** Conditional compilation state */
     struct IfFrame {
@@ -99,6 +138,19 @@ private:
     /** Expand macros within a single logical line. */
     std::string expandMacros(const std::string &line);
 
+    /**
+     * Whether a #pragma, given the text after the keyword, requests a loop
+     * transformation: clang loop, unroll, nounroll, GCC unroll, GCC ivdep or
+     * omp simd.
+     */
+    static bool isLoopPragma(const std::string &pragma);
+
+    /**
+     * Expand macros in the arguments of a loop pragma, as GCC and clang do,
+     * so that `#pragma unroll N` takes N from a macro.
+     */
+    std::string expandLoopPragma(const std::string &directive);
+
     /** Utility */
     static std::string trim(const std::string &s);
     static void splitCommaArgs(const std::string &s, std::vector<std::string> &out);
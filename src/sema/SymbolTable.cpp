@@ -3,50 +3,108 @@
 namespace sema {
 
 void SymbolTable::enterScope() {
-    scopes_.emplace_back();
-    currentScope_ = scopes_.size() - 1;
+    scopeStarts_.push_back(symbols_.size());
 }
 
 void SymbolTable::exitScope() {
-    if (!scopes_.empty()) {
-        scopes_.pop_back();
-        currentScope_ = scopes_.empty() ? 0 : scopes_.size() - 1;
+    if (scopeStarts_.empty()) {
+        return;
+    }
+
+    // Unwind the scope's bindings, newest first
+    size_t start = scopeStarts_.back();
+    scopeStarts_.pop_back();
+    while (symbols_.size() > start) {
+        Symbol &symbol = symbols_.back();
+        const_cast<Entry*>(find(symbol.name))->binding = symbol.shadowed_;
+        symbols_.pop_back();
     }
 }
 
-bool SymbolTable::addSymbol(const std::string &name, const std::string &type, bool isFunction) {
-    if (scopes_.empty()) {
+Symbol* SymbolTable::addSymbol(const ast::IdentifierInfo *name, const ast::Type *type, bool isFunction) {
+    if (scopeStarts_.empty()) {
         enterScope(); // Create global scope if needed
     }
-    
-    auto &currentScopeMap = scopes_[currentScope_];
-    
-    if (currentScopeMap.find(name) != currentScopeMap.end()) {
-        return false; // Symbol already exists in current scope
+
+    Entry &entry = findOrInsert(name);
+    if (entry.binding && entry.binding->depth_ == scopeStarts_.size()) {
+        return nullptr; // Symbol already exists in current scope
+    }
+
+    Symbol &symbol = symbols_.emplace_back(name, type, isFunction);
+    symbol.shadowed_ = entry.binding;
+    symbol.depth_ = scopeStarts_.size();
+    entry.binding = &symbol;
+    return &symbol;
+}
+
+Symbol* SymbolTable::lookupSymbol(const ast::IdentifierInfo *name) {
+    const Entry *entry = find(name);
+    return entry ? entry->binding : nullptr;
+}
+
+const Symbol* SymbolTable::lookupSymbol(const ast::IdentifierInfo *name) const {
+    const Entry *entry = find(name);
+    return entry ? entry->binding : nullptr;
+}
+
+bool SymbolTable::existsInCurrentScope(const ast::IdentifierInfo *name) const {
+    const Entry *entry = find(name);
+    return entry && entry->binding && entry->binding->depth_ == scopeStarts_.size();
+}
+
+size_t SymbolTable::getSlot(const ast::IdentifierInfo *name) const {
+    // Fibonacci hashing; the low bits of a pointer are mostly alignment
+    uint64_t hash = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(name)) * 0x9e3779b97f4a7c15ull;
+    return static_cast<size_t>(hash >> 32) & (entries_.size() - 1);
+}
+
+const SymbolTable::Entry *SymbolTable::find(const ast::IdentifierInfo *name) const {
+    if (entries_.empty()) {
+        return nullptr;
+    }
+    for (size_t slot = getSlot(name);; slot = (slot + 1) & (entries_.size() - 1)) {
+        const Entry &entry = entries_[slot];
+        if (entry.name == name) {
+            return &entry;
+        }
+        if (!entry.name) {
+            return nullptr;
+        }
     }
-    
-    currentScopeMap[name] = std::make_unique<Symbol>(name, type, isFunction);
-    return true;
 }
 
-Symbol* SymbolTable::lookupSymbol(const std::string &name) {
-    // Search from current scope to global scope
-    for (auto it = scopes_.rbegin(); it != scopes_.rend(); ++it) {
-        auto found = it->find(name);
-        if (found != it->end()) {
-            return found->second.get();
+SymbolTable::Entry &SymbolTable::findOrInsert(const ast::IdentifierInfo *name) {
+    // Keep the load factor at most one half
+    if (2 * (numNames_ + 1) > entries_.size()) {
+        grow();
+    }
+    for (size_t slot = getSlot(name);; slot = (slot + 1) & (entries_.size() - 1)) {
+        Entry &entry = entries_[slot];
+        if (entry.name == name) {
+            return entry;
+        }
+        if (!entry.name) {
+            entry.name = name;
+            ++numNames_;
+            return entry;
         }
     }
-    return nullptr;
 }
 
-bool SymbolTable::existsInCurrentScope(const std::string &name) const {
-    if (scopes_.empty()) {
-        return false;
+void SymbolTable::grow() {
+    std::vector<Entry> old(entries_.empty() ? 64 : entries_.size() * 2);
+    old.swap(entries_);
+    for (const Entry &entry : old) {
+        if (!entry.name) {
+            continue;
+        }
+        size_t slot = getSlot(entry.name);
+        while (entries_[slot].name) {
+            slot = (slot + 1) & (entries_.size() - 1);
+        }
+        entries_[slot] = entry;
     }
-    
-    const auto &currentScopeMap = scopes_[currentScope_];
-    return currentScopeMap.find(name) != currentScopeMap.end();
 }
 
 } // namespace sema
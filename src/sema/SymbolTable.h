@@ -1,9 +1,12 @@
 #pragma once
 
-#include <string>
-#include <unordered_map>
+#include "ast/IdentifierTable.h"
+#include "ast/Type.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <vector>
-#include <memory>
 
 namespace sema {
 
@@ -11,49 +14,92 @@ namespace sema {
  * Symbol information.
  */
 struct Symbol {
-    std::string name;
-    std::string type;
+    const ast::IdentifierInfo *name;
+    const ast::Type *type;
     bool isFunction;
-    
-    Symbol(const std::string &n, const std::string &t, bool func = false)
+    bool isLocal = false;  // declared inside a function
+    bool hasPrototype = true;  // false for a function only declared as f()
+    unsigned index = 0;    // slot: per function if local, per translation unit if not
+
+    Symbol(const ast::IdentifierInfo *n, const ast::Type *t, bool func = false)
         : name(n), type(t), isFunction(func) {}
+
+private:
+    friend class SymbolTable;
+    Symbol *shadowed_ = nullptr;  // binding of the same name in an enclosing scope
+    size_t depth_ = 0;            // scope the symbol was added to
 };
 
 /**
- * Symbol table with scope management.
+ * Symbol table with scope management. Symbols are keyed by interned name.
+ *
+ * One open-addressing table maps each name to its innermost binding, which
+ * links to the binding it shadows. Symbols are stored in the order they
+ * were added, so the symbols of the current scope are the most recent ones
+ * and double as its undo log: leaving a scope pops them and restores what
+ * they shadowed. Lookups are a single probe whatever the nesting depth, and
+ * entering and leaving a scope costs only its own bindings.
  */
 class SymbolTable {
 public:
     SymbolTable() = default;
-    
+    SymbolTable(const SymbolTable &) = delete;
+    SymbolTable &operator=(const SymbolTable &) = delete;
+
     /**
      * Enter a new scope.
      */
     void enterScope();
-    
+
     /**
-     * Exit current scope.
+     * Exit current scope. Its symbols are destroyed.
      */
     void exitScope();
-    
+
     /**
      * Add a symbol to the current scope.
+     * @return The new symbol, or nullptr if the name is already bound in
+     *         the current scope
      */
-    bool addSymbol(const std::string &name, const std::string &type, bool isFunction = false);
-    
+    Symbol* addSymbol(const ast::IdentifierInfo *name, const ast::Type *type, bool isFunction = false);
+
     /**
      * Look up a symbol in all scopes.
+     * @return The innermost binding, valid until its scope is exited
      */
-    Symbol* lookupSymbol(const std::string &name);
-    
+    Symbol* lookupSymbol(const ast::IdentifierInfo *name);
+    const Symbol* lookupSymbol(const ast::IdentifierInfo *name) const;
+
     /**
      * Check if symbol exists in current scope only.
      */
-    bool existsInCurrentScope(const std::string &name) const;
-    
+    bool existsInCurrentScope(const ast::IdentifierInfo *name) const;
+
+    /**
+     * Number of scopes entered and not yet exited.
+     */
+    size_t getScopeDepth() const { return scopeStarts_.size(); }
+
 private:
-    std::vector<std::unordered_map<std::string, std::unique_ptr<Symbol>>> scopes_;
-    size_t currentScope_ = 0;
+    struct Entry {
+        const ast::IdentifierInfo *name = nullptr;  // null for an empty slot
+        Symbol *binding = nullptr;                  // null once every binding is gone
+    };
+
+    // Names stay in the table after their last binding is removed, so no
+    // tombstones are needed; the table only grows with distinct names
+    std::vector<Entry> entries_;
+    size_t numNames_ = 0;
+
+    // Every live symbol, oldest first; a deque never moves its elements
+    std::deque<Symbol> symbols_;
+    // Index into symbols_ of each open scope's first symbol
+    std::vector<size_t> scopeStarts_;
+
+    const Entry *find(const ast::IdentifierInfo *name) const;
+    Entry &findOrInsert(const ast::IdentifierInfo *name);
+    size_t getSlot(const ast::IdentifierInfo *name) const;
+    void grow();
 };
 
 } // namespace sema
@@ -1,175 +1,688 @@
 #include "sema/TypeChecker.h"
+#include "ast/Casting.h"
+#include "utils/ThreadPool.h"
 #include <algorithm>
+#include <cstdint>
 #include <iostream>
+#include <vector>
 
 namespace sema {
 
-bool TypeChecker::checkTypes(ast::TranslationUnit *tu) {
-    hasErrors_ = false;
+using BinaryOp = ast::BinaryExpr::OpKind;
+using UnaryOp = ast::UnaryExpr::OpKind;
+
+namespace {
+
+bool isShift(BinaryOp op) {
+    return op == BinaryOp::LeftShift || op == BinaryOp::RightShift;
+}
+
+bool isComparison(BinaryOp op) {
+    return op >= BinaryOp::LT && op <= BinaryOp::NE;
+}
+
+bool isBitwise(BinaryOp op) {
+    return op >= BinaryOp::BitwiseAnd && op <= BinaryOp::BitwiseXor;
+}
+
+/** The arithmetic operator a compound assignment applies. */
+BinaryOp getCompoundOperator(BinaryOp op) {
+    switch (op) {
+        case BinaryOp::AddAssign: return BinaryOp::Add;
+        case BinaryOp::SubAssign: return BinaryOp::Sub;
+        case BinaryOp::MulAssign: return BinaryOp::Mul;
+        case BinaryOp::DivAssign: return BinaryOp::Div;
+        case BinaryOp::ModAssign: return BinaryOp::Mod;
+        default: return op;
+    }
+}
+
+void setType(ast::Expr *expr, const ast::Type *type, ast::ValueCategory category = ast::ValueCategory::RValue) {
+    expr->type = type;
+    expr->valueCategory = category;
+}
+
+} // namespace
+
+TypeChecker::TypeChecker(ast::TypeContext &types, unsigned jobs) : types_(types), jobs_(jobs) {
     symbolTable_.enterScope(); // Global scope
+}
+
+TypeChecker::TypeChecker(const TypeChecker &parent, unsigned visibleGlobals)
+    : types_(parent.types_), globals_(&parent.symbolTable_), visibleGlobals_(visibleGlobals),
+      sourceManager_(parent.sourceManager_) {
+    symbolTable_.enterScope(); // Stands in for the global scope, which stays in parent
+}
+
+bool TypeChecker::checkTypes(ast::TranslationUnit *tu) {
+    size_t count = tu->declarations.size();
+    std::vector<std::string> diagnostics(count);
+    std::vector<ast::FunctionDecl*> bodies(count);
+    std::vector<unsigned> visibleGlobals(count);
+    bool result = true;
     
-    for (const auto &decl : tu->declarations) {
-        if (auto *funcDecl = dynamic_cast<ast::FunctionDecl*>(decl.get())) {
-            checkFunctionDecl(funcDecl);
-        } else if (auto *varDecl = dynamic_cast<ast::VarDecl*>(decl.get())) {
-            checkVarDecl(varDecl);
+    // Declarations in source order; bodies are only entered in the scope
+    for (size_t i = 0; i < count; ++i) {
+        hasErrors_ = false;
+        auto *func = ast::dyn_cast<ast::FunctionDecl>(tu->declarations[i]);
+        if (!func) {
+            visit(tu->declarations[i]);
+        } else if (declareFunction(func) && func->isDefinition()) {
+            bodies[i] = func;
         }
+        result &= !hasErrors_;
+        diagnostics[i] = std::move(diagnostics_);
+        diagnostics_.clear();
+        visibleGlobals[i] = numGlobals_;
     }
     
-    symbolTable_.exitScope();
+    // Bodies only read the global scope, so they may be checked in any order
+    std::vector<char> bodyFailed(count, false); // not vector<bool>: written concurrently
+    auto checkBody = [&](size_t i) {
+        TypeChecker checker(*this, visibleGlobals[i]);
+        checker.checkFunctionBody(bodies[i]);
+        diagnostics[i] += checker.diagnostics_;
+        bodyFailed[i] = checker.hasErrors_;
+    };
+    size_t numBodies = count - static_cast<size_t>(std::count(bodies.begin(), bodies.end(), nullptr));
+    if (jobs_ != 1 && numBodies > 1) {
+        utils::ThreadPool pool(jobs_);
+        for (size_t i = 0; i < count; ++i) {
+            if (bodies[i]) {
+                pool.submit([&checkBody, i] { checkBody(i); });
+            }
+        }
+        pool.wait();
+    } else {
+        for (size_t i = 0; i < count; ++i) {
+            if (bodies[i]) {
+                checkBody(i);
+            }
+        }
+    }
+    
+    for (size_t i = 0; i < count; ++i) {
+        *diagnosticStream_ << diagnostics[i];
+        result &= !bodyFailed[i];
+    }
+    return result;
+}
+
+bool TypeChecker::checkDeclaration(ast::Node *decl) {
+    hasErrors_ = false;
+    visit(decl);
+    *diagnosticStream_ << diagnostics_;
+    diagnostics_.clear();
     return !hasErrors_;
 }
 
-bool TypeChecker::checkFunctionDecl(ast::FunctionDecl *func) {
-    // Add function to symbol table
-    if (!symbolTable_.addSymbol(func->name, func->returnType, true)) {
-        error("Function '" + func->name + "' redefined");
-        return false;
+bool TypeChecker::visitFunctionDecl(ast::FunctionDecl *func) {
+    if (declareFunction(func) && func->isDefinition()) {
+        checkFunctionBody(func);
     }
+    return true;
+}
+
+bool TypeChecker::declareFunction(ast::FunctionDecl *func) {
+    std::string name(func->name->getName());
+    std::vector<const ast::Type*> paramTypes;
+    for (const auto &param : func->parameters) {
+        // Qualifiers on a parameter only bind inside the definition
+        paramTypes.push_back(param.first->getUnqualifiedType());
+    }
+    const ast::FunctionType *type = types_.getFunctionType(func->returnType, paramTypes);
     
-    if (func->isDefinition()) {
-        symbolTable_.enterScope(); // Function scope
-        
-        // Add parameters to symbol table
-        for (const auto &param : func->parameters) {
-            if (!symbolTable_.addSymbol(param.second, param.first)) {
-                error("Parameter '" + param.second + "' redefined");
-            }
+    // Add function to symbol table; a prototype may precede the definition
+    // and shares its slot
+    Symbol *symbol = symbolTable_.addSymbol(func->name, type, true);
+    if (symbol) {
+        symbol->index = numGlobals_++;
+        symbol->hasPrototype = func->hasPrototype;
+    } else {
+        symbol = symbolTable_.lookupSymbol(func->name);
+        if (!symbol->isFunction) {
+            return error(func, "'" + name + "' redeclared as a function");
         }
-        
-        // Check function body
-        if (func->body) {
-            for (const auto &stmt : func->body->statements) {
-                checkStmt(stmt.get());
-            }
+        if (!areFunctionDeclarationsCompatible(symbol, func, type)) {
+            return error(func, "Conflicting types for function '" + name + "'");
+        }
+        // Calls are checked against the prototype once there is one
+        if (func->hasPrototype && !symbol->hasPrototype) {
+            symbol->type = type;
+            symbol->hasPrototype = true;
         }
-        
-        symbolTable_.exitScope();
     }
+    func->index = symbol->index;
     
+    if (func->isDefinition() && !definedFunctions_.insert(func->name).second) {
+        return error(func, "Function '" + name + "' redefined");
+    }
     return true;
 }
 
-bool TypeChecker::checkVarDecl(ast::VarDecl *var) {
+void TypeChecker::checkFunctionBody(ast::FunctionDecl *func) {
+    symbolTable_.enterScope(); // Function scope
+    currentFunction_ = func;
+    
+    // Add parameters to symbol table; they take the first local slots
+    numLocals_ = static_cast<unsigned>(func->parameters.size());
+    for (unsigned i = 0; i < func->parameters.size(); ++i) {
+        const auto &param = func->parameters[i];
+        Symbol *paramSymbol = symbolTable_.addSymbol(param.second, param.first);
+        if (!paramSymbol) {
+            error(func, "Parameter '" + std::string(param.second->getName()) + "' redefined");
+            continue;
+        }
+        paramSymbol->isLocal = true;
+        paramSymbol->index = i;
+    }
+    
+    // Check function body
+    for (const auto &stmt : func->body->statements) {
+        visit(stmt);
+    }
+    
+    func->numLocals = numLocals_;
+    currentFunction_ = nullptr;
+    symbolTable_.exitScope();
+}
+
+const Symbol *TypeChecker::lookupSymbol(const ast::IdentifierInfo *name) const {
+    if (const Symbol *symbol = symbolTable_.lookupSymbol(name)) {
+        return symbol;
+    }
+    if (!globals_) {
+        return nullptr;
+    }
+    // Globals declared after the function are not in scope in its body
+    const Symbol *symbol = globals_->lookupSymbol(name);
+    return symbol && symbol->index < visibleGlobals_ ? symbol : nullptr;
+}
+
+bool TypeChecker::visitVarDecl(ast::VarDecl *var) {
     // Check if variable already exists in current scope
     if (symbolTable_.existsInCurrentScope(var->name)) {
-        error("Variable '" + var->name + "' redefined");
-        return false;
+        return error(var, "Variable '" + std::string(var->name->getName()) + "' redefined");
     }
     
-    // Add to symbol table
-    symbolTable_.addSymbol(var->name, var->type);
+    // Add to symbol table; the name is in scope in its own initializer
+    Symbol *symbol = symbolTable_.addSymbol(var->name, var->type);
+    symbol->isLocal = currentFunction_ != nullptr;
+    symbol->index = symbol->isLocal ? numLocals_++ : numGlobals_++;
+    var->index = symbol->index;
     
     // Check initializer if present
-    if (var->initializer) {
-        std::string initType = inferType(var->initializer.get());
-        if (!areTypesCompatible(var->type, initType)) {
-            error("Type mismatch in variable '" + var->name + "' initialization");
-            return false;
+    if (var->initializer && visit(var->initializer) && var->initializer->type) {
+        if (!areTypesCompatible(var->type, getDecayedType(var->initializer))) {
+            return error(var, "Type mismatch in variable '" + std::string(var->name->getName()) + "' initialization");
         }
     }
     
     return true;
 }
 
-bool TypeChecker::checkStmt(ast::Stmt *stmt) {
-    if (auto *varDecl = dynamic_cast<ast::VarDecl*>(stmt)) {
-        return checkVarDecl(varDecl);
-    } else if (auto *exprStmt = dynamic_cast<ast::ExprStmt*>(stmt)) {
-        if (exprStmt->expression) {
-            return checkExpr(exprStmt->expression.get());
+bool TypeChecker::visitExprStmt(ast::ExprStmt *stmt) {
+    return stmt->expression ? visit(stmt->expression) : true;
+}
+
+bool TypeChecker::visitReturnStmt(ast::ReturnStmt *stmt) {
+    if (!stmt->expression) {
+        return true;
+    }
+    if (!visit(stmt->expression) || !stmt->expression->type) {
+        return false;
+    }
+    
+    // The value is converted to the return type as if by assignment
+    const ast::Type *returnType = currentFunction_->returnType;
+    if (returnType->isVoid()) {
+        return error(stmt, "Void function '" + std::string(currentFunction_->name->getName()) +
+                     "' should not return a value");
+    }
+    if (!areTypesCompatible(returnType, getDecayedType(stmt->expression))) {
+        return error(stmt->expression, "Returning '" + stmt->expression->type->toString() +
+                     "' from a function with result type '" + returnType->toString() + "'");
+    }
+    return true;
+}
+
+bool TypeChecker::visitCompoundStmt(ast::CompoundStmt *stmt) {
+    symbolTable_.enterScope();
+    bool result = true;
+    for (const auto &s : stmt->statements) {
+        result &= visit(s);
+    }
+    symbolTable_.exitScope();
+    return result;
+}
+
+bool TypeChecker::visitIfStmt(ast::IfStmt *stmt) {
+    bool result = checkCondition(stmt->condition);
+    result &= visit(stmt->thenStmt);
+    if (stmt->elseStmt) {
+        result &= visit(stmt->elseStmt);
+    }
+    return result;
+}
+
+bool TypeChecker::visitWhileStmt(ast::WhileStmt *stmt) {
+    bool result = checkCondition(stmt->condition);
+    result &= visit(stmt->body);
+    return result;
+}
+
+bool TypeChecker::visitForStmt(ast::ForStmt *stmt) {
+    symbolTable_.enterScope(); // A declaration in the init clause is local to the loop
+    bool result = true;
+    if (stmt->init) {
+        result &= visit(stmt->init);
+    }
+    if (stmt->condition) {
+        result &= checkCondition(stmt->condition);
+    }
+    if (stmt->increment) {
+        result &= visit(stmt->increment);
+    }
+    if (stmt->body) {
+        result &= visit(stmt->body);
+    }
+    symbolTable_.exitScope();
+    return result;
+}
+
+bool TypeChecker::checkCondition(ast::Expr *condition) {
+    if (!visit(condition) || !condition || !condition->type) {
+        return false;
+    }
+    if (!getDecayedType(condition)->isScalar()) {
+        return error(condition, "Condition of type '" + condition->type->toString() + "' is not a scalar");
+    }
+    return true;
+}
+
+bool TypeChecker::visitIntegerLiteral(ast::IntegerLiteral *lit) {
+    setType(lit, types_.getBuiltinType(lit->builtinKind));
+    return true;
+}
+
+bool TypeChecker::visitFloatingLiteral(ast::FloatingLiteral *lit) {
+    setType(lit, types_.getDoubleType());
+    return true;
+}
+
+bool TypeChecker::visitCharacterLiteral(ast::CharacterLiteral *lit) {
+    setType(lit, types_.getIntType()); // a character constant has type int in C
+    return true;
+}
+
+bool TypeChecker::visitStringLiteral(ast::StringLiteral *lit) {
+    // An array object holding the characters and a terminating null
+    setType(lit, types_.getArrayType(types_.getCharType(), lit->value.size() + 1), ast::ValueCategory::LValue);
+    return true;
+}
+
+bool TypeChecker::visitIdentifier(ast::Identifier *id) {
+    const Symbol *symbol = lookupSymbol(id->name);
+    if (!symbol) {
+        return error(id, "Undefined variable '" + std::string(id->name->getName()) + "'");
+    }
+    if (symbol->isFunction) {
+        id->binding = ast::Identifier::BindingKind::Function;
+    } else {
+        id->binding = symbol->isLocal ? ast::Identifier::BindingKind::Local : ast::Identifier::BindingKind::Global;
+    }
+    id->index = symbol->index;
+    
+    // A function designator is not an object
+    setType(id, symbol->type, symbol->isFunction ? ast::ValueCategory::RValue : ast::ValueCategory::LValue);
+    return true;
+}
+
+bool TypeChecker::visitBinaryExpr(ast::BinaryExpr *expr) {
+    bool result = visit(expr->left);
+    result &= visit(expr->right);
+    if (!result || !expr->left || !expr->right || !expr->left->type || !expr->right->type) {
+        return false;
+    }
+    
+    switch (expr->op) {
+        case BinaryOp::Assign:
+        case BinaryOp::AddAssign:
+        case BinaryOp::SubAssign:
+        case BinaryOp::MulAssign:
+        case BinaryOp::DivAssign:
+        case BinaryOp::ModAssign:
+            return checkAssignment(expr);
+        case BinaryOp::LogicalAnd:
+        case BinaryOp::LogicalOr:
+            if (!getDecayedType(expr->left)->isScalar() || !getDecayedType(expr->right)->isScalar()) {
+                return error(expr, "Operands of a logical operator must be scalars");
+            }
+            setType(expr, types_.getIntType());
+            return true;
+        default:
+            return checkArithmetic(expr);
+    }
+}
+
+bool TypeChecker::checkArithmetic(ast::BinaryExpr *expr) {
+    const ast::Type *left = getDecayedType(expr->left);
+    const ast::Type *right = getDecayedType(expr->right);
+    BinaryOp op = getCompoundOperator(expr->op);
+    
+    if (left->isArithmetic() && right->isArithmetic()) {
+        bool needsIntegers = op == BinaryOp::Mod || isBitwise(op) || isShift(op);
+        if (needsIntegers && (!left->isInteger() || !right->isInteger())) {
+            return error(expr, "Invalid operands to binary expression ('" + left->toString() + "' and '" +
+                         right->toString() + "')");
         }
-    } else if (auto *returnStmt = dynamic_cast<ast::ReturnStmt*>(stmt)) {
-        if (returnStmt->expression) {
-            return checkExpr(returnStmt->expression.get());
+        // Shifts take the promoted type of their left operand alone
+        expr->operandType = isShift(op) ? getPromotedType(left) : getCommonType(left, right);
+        setType(expr, isComparison(op) ? types_.getIntType() : expr->operandType);
+        return true;
+    }
+    
+    // Pointer arithmetic and comparisons; the operands are not converted
+    expr->operandType = nullptr;
+    if (op == BinaryOp::Add && left->isPointer() && right->isInteger()) {
+        setType(expr, left);
+        return true;
+    }
+    if (op == BinaryOp::Add && left->isInteger() && right->isPointer()) {
+        setType(expr, right);
+        return true;
+    }
+    if (op == BinaryOp::Sub && left->isPointer() && right->isInteger()) {
+        setType(expr, left);
+        return true;
+    }
+    if (op == BinaryOp::Sub && left->isPointer() && right->isPointer()) {
+        setType(expr, types_.getLongType()); // ptrdiff_t
+        return true;
+    }
+    if (isComparison(op) && left->isScalar() && right->isScalar()) {
+        setType(expr, types_.getIntType());
+        return true;
+    }
+    return error(expr, "Invalid operands to binary expression ('" + left->toString() + "' and '" +
+                 right->toString() + "')");
+}
+
+bool TypeChecker::checkAssignment(ast::BinaryExpr *expr) {
+    if (!checkModifiable(expr->left, "assign to")) {
+        return false;
+    }
+    const ast::Type *target = expr->left->type->getUnqualifiedType();
+    
+    if (expr->op != BinaryOp::Assign) {
+        // E1 op= E2 computes E1 op E2 in the operator's operand type
+        const ast::Type *right = getDecayedType(expr->right);
+        if (!(target->isArithmetic() && right->isArithmetic())) {
+            bool pointerStep = target->isPointer() && right->isInteger() &&
+                               (expr->op == BinaryOp::AddAssign || expr->op == BinaryOp::SubAssign);
+            if (!pointerStep) {
+                return error(expr, "Invalid operands to compound assignment ('" + target->toString() + "' and '" +
+                             right->toString() + "')");
+            }
+        } else if (!checkArithmetic(expr)) {
+            return false;
         }
-    } else if (auto *compoundStmt = dynamic_cast<ast::CompoundStmt*>(stmt)) {
-        symbolTable_.enterScope();
-        bool result = true;
-        for (const auto &s : compoundStmt->statements) {
-            result &= checkStmt(s.get());
+    } else if (!areTypesCompatible(target, getDecayedType(expr->right))) {
+        return error(expr, "Assigning '" + expr->right->type->toString() + "' to '" + target->toString() + "'");
+    }
+    
+    // The value of an assignment is the value stored, and is not an lvalue
+    setType(expr, target);
+    return true;
+}
+
+bool TypeChecker::checkModifiable(ast::Expr *expr, const char *operation) {
+    if (!expr->isLValue()) {
+        return error(expr, std::string("Cannot ") + operation + " an rvalue");
+    }
+    if (expr->type->isArray()) {
+        return error(expr, std::string("Cannot ") + operation + " an array");
+    }
+    auto *qualified = ast::dyn_cast<ast::QualifiedType>(expr->type);
+    if (qualified && qualified->isConst()) {
+        return error(expr, std::string("Cannot ") + operation + " a const object");
+    }
+    return true;
+}
+
+bool TypeChecker::visitUnaryExpr(ast::UnaryExpr *expr) {
+    if (!visit(expr->operand) || !expr->operand || !expr->operand->type) {
+        return false;
+    }
+    const ast::Type *operand = getDecayedType(expr->operand);
+    
+    switch (expr->op) {
+        case UnaryOp::Sizeof:
+            // The operand does not decay: sizeof of an array is its whole size
+            if (expr->operand->type->isFunction() || expr->operand->type->isVoid()) {
+                return error(expr, "Invalid application of 'sizeof' to '" + expr->operand->type->toString() + "'");
+            }
+            setType(expr, types_.getBuiltinType(ast::BuiltinType::BuiltinKind::UnsignedLong));  // size_t
+            return true;
+        case UnaryOp::AddressOf:
+            if (!expr->operand->isLValue() && !expr->operand->type->isFunction()) {
+                return error(expr, "Cannot take the address of an rvalue");
+            }
+            setType(expr, types_.getPointerType(expr->operand->type));
+            return true;
+        case UnaryOp::Dereference: {
+            auto *pointer = ast::dyn_cast<ast::PointerType>(operand->getUnqualifiedType());
+            if (!pointer) {
+                return error(expr, "Dereference of non-pointer type '" + operand->toString() + "'");
+            }
+            setType(expr, pointer->getPointeeType(), ast::ValueCategory::LValue);
+            return true;
         }
-        symbolTable_.exitScope();
-        return result;
-    } else if (auto *ifStmt = dynamic_cast<ast::IfStmt*>(stmt)) {
-        bool result = checkExpr(ifStmt->condition.get());
-        result &= checkStmt(ifStmt->thenStmt.get());
-        if (ifStmt->elseStmt) {
-            result &= checkStmt(ifStmt->elseStmt.get());
+        case UnaryOp::PreIncrement:
+        case UnaryOp::PreDecrement:
+        case UnaryOp::PostIncrement:
+        case UnaryOp::PostDecrement:
+            if (!checkModifiable(expr->operand, "increment or decrement")) {
+                return false;
+            }
+            if (!operand->isScalar()) {
+                return error(expr, "Cannot increment or decrement '" + operand->toString() + "'");
+            }
+            setType(expr, operand->getUnqualifiedType());
+            return true;
+        case UnaryOp::Not:
+            if (!operand->isScalar()) {
+                return error(expr, "Invalid operand to '!' ('" + operand->toString() + "')");
+            }
+            setType(expr, types_.getIntType());
+            return true;
+        case UnaryOp::BitwiseNot:
+            if (!operand->isInteger()) {
+                return error(expr, "Invalid operand to '~' ('" + operand->toString() + "')");
+            }
+            setType(expr, getPromotedType(operand));
+            return true;
+        case UnaryOp::Plus:
+        case UnaryOp::Minus:
+            if (!operand->isArithmetic()) {
+                return error(expr, "Invalid operand to unary arithmetic ('" + operand->toString() + "')");
+            }
+            setType(expr, getPromotedType(operand));
+            return true;
+    }
+    return false;
+}
+
+bool TypeChecker::visitCallExpr(ast::CallExpr *expr) {
+    bool result = visit(expr->function);
+    for (auto *arg : expr->arguments) {
+        result &= visit(arg);
+    }
+    if (!result || !expr->function || !expr->function->type) {
+        return false;
+    }
+    
+    // Called either by name or through a pointer to function
+    const ast::Type *callee = getDecayedType(expr->function)->getUnqualifiedType();
+    auto *pointer = ast::dyn_cast<ast::PointerType>(callee);
+    auto *function = pointer ? ast::dyn_cast<ast::FunctionType>(pointer->getPointeeType()) : nullptr;
+    if (!function) {
+        return error(expr, "Called object of type '" + expr->function->type->toString() + "' is not a function");
+    }
+    
+    size_t expected = function->getParamTypes().size();
+    if (expr->arguments.size() < expected || (expr->arguments.size() > expected && !function->isVariadic())) {
+        return error(expr, "Call expects " + std::to_string(expected) + " arguments, got " +
+                     std::to_string(expr->arguments.size()));
+    }
+    for (size_t i = 0; i < expected; ++i) {
+        if (expr->arguments[i] && expr->arguments[i]->type &&
+            !areTypesCompatible(function->getParamTypes()[i], getDecayedType(expr->arguments[i]))) {
+            return error(expr->arguments[i], "Passing '" + expr->arguments[i]->type->toString() +
+                         "' to parameter of type '" + function->getParamTypes()[i]->toString() + "'");
         }
-        return result;
-    } else if (auto *whileStmt = dynamic_cast<ast::WhileStmt*>(stmt)) {
-        bool result = checkExpr(whileStmt->condition.get());
-        result &= checkStmt(whileStmt->body.get());
-        return result;
     }
     
+    setType(expr, function->getReturnType());
     return true;
 }
 
-bool TypeChecker::checkExpr(ast::Expr *expr) {
-    if (auto *id = dynamic_cast<ast::Identifier*>(expr)) {
-        Symbol *symbol = symbolTable_.lookupSymbol(id->name);
-        if (!symbol) {
-            error("Undefined variable '" + id->name + "'");
-            return false;
-        }
-    } else if (auto *binExpr = dynamic_cast<ast::BinaryExpr*>(expr)) {
-        bool result = checkExpr(binExpr->left.get());
-        result &= checkExpr(binExpr->right.get());
-        
-        // TODO: Check type compatibility for binary operations
-        return result;
-    } else if (auto *unaryExpr = dynamic_cast<ast::UnaryExpr*>(expr)) {
-        return checkExpr(unaryExpr->operand.get());
-    } else if (auto *callExpr = dynamic_cast<ast::CallExpr*>(expr)) {
-        // TODO: Check function calls
-        (void)callExpr; // Suppress unused warning
-        return true;
+bool TypeChecker::visitArraySubscriptExpr(ast::ArraySubscriptExpr *expr) {
+    bool result = visit(expr->array);
+    result &= visit(expr->index);
+    if (!result || !expr->array || !expr->index || !expr->array->type || !expr->index->type) {
+        return false;
     }
     
+    // E1[E2] is *(E1 + E2), so either operand may be the pointer
+    const ast::Type *base = getDecayedType(expr->array);
+    const ast::Type *index = getDecayedType(expr->index);
+    if (index->isPointer()) {
+        std::swap(base, index);
+    }
+    auto *pointer = ast::dyn_cast<ast::PointerType>(base->getUnqualifiedType());
+    if (!pointer || !index->isInteger()) {
+        return error(expr, "Subscripted value of type '" + expr->array->type->toString() +
+                     "' is not an array or pointer");
+    }
+    setType(expr, pointer->getPointeeType(), ast::ValueCategory::LValue);
     return true;
 }
 
-std::string TypeChecker::inferType(ast::Expr *expr) {
-    if (dynamic_cast<ast::IntegerLiteral*>(expr)) {
-        return "int";
-    } else if (dynamic_cast<ast::FloatingLiteral*>(expr)) {
-        return "double";
-    } else if (dynamic_cast<ast::CharacterLiteral*>(expr)) {
-        return "char";
-    } else if (dynamic_cast<ast::StringLiteral*>(expr)) {
-        return "char*";
-    } else if (auto *id = dynamic_cast<ast::Identifier*>(expr)) {
-        Symbol *symbol = symbolTable_.lookupSymbol(id->name);
-        return symbol ? symbol->type : "unknown";
-    } else if (auto *binExpr = dynamic_cast<ast::BinaryExpr*>(expr)) {
-        // For now, assume binary expressions return int
-        (void)binExpr; // Suppress unused warning
-        return "int";
+bool TypeChecker::visitMemberExpr(ast::MemberExpr *expr) {
+    visit(expr->object);
+    return error(expr, "Member access '" + std::string(expr->member->getName()) + "' requires a struct or union");
+}
+
+bool TypeChecker::visitConditionalExpr(ast::ConditionalExpr *expr) {
+    bool result = checkCondition(expr->condition);
+    result &= visit(expr->trueExpr);
+    result &= visit(expr->falseExpr);
+    if (!result || !expr->trueExpr || !expr->falseExpr || !expr->trueExpr->type || !expr->falseExpr->type) {
+        return false;
     }
     
-    return "unknown";
+    const ast::Type *trueType = getDecayedType(expr->trueExpr);
+    const ast::Type *falseType = getDecayedType(expr->falseExpr);
+    if (trueType->isArithmetic() && falseType->isArithmetic()) {
+        setType(expr, getCommonType(trueType, falseType));
+    } else if (trueType->isPointer()) {
+        setType(expr, trueType->getUnqualifiedType()); // the other arm is a pointer or a null constant
+    } else if (falseType->isPointer()) {
+        setType(expr, falseType->getUnqualifiedType());
+    } else if (trueType->getUnqualifiedType() == falseType->getUnqualifiedType()) {
+        setType(expr, trueType->getUnqualifiedType());
+    } else {
+        return error(expr, "Incompatible operand types ('" + trueType->toString() + "' and '" +
+                     falseType->toString() + "')");
+    }
+    return true;
+}
+
+bool TypeChecker::visitNode(ast::Node *node) {
+    // Break, continue and constructs the builder left out need no checking
+    (void)node;
+    return true;
+}
+
+const ast::Type *TypeChecker::getDecayedType(const ast::Expr *expr) {
+    const ast::Type *type = expr->type;
+    if (auto *array = ast::dyn_cast<ast::ArrayType>(type->getUnqualifiedType())) {
+        return types_.getPointerType(array->getElementType());
+    }
+    if (type->isFunction()) {
+        return types_.getPointerType(type);
+    }
+    return type;
 }
 
-bool TypeChecker::areTypesCompatible(const std::string &type1, const std::string &type2) {
-    // Simplified type compatibility
-    if (type1 == type2) {
+const ast::Type *TypeChecker::getPromotedType(const ast::Type *type) {
+    auto *builtin = ast::dyn_cast<ast::BuiltinType>(type->getUnqualifiedType());
+    if (!builtin) {
+        return type;
+    }
+    return types_.getBuiltinType(ast::BuiltinType::getPromotedKind(builtin->getBuiltinKind()));
+}
+
+const ast::Type *TypeChecker::getCommonType(const ast::Type *left, const ast::Type *right) {
+    auto leftKind = ast::cast<ast::BuiltinType>(getPromotedType(left))->getBuiltinKind();
+    auto rightKind = ast::cast<ast::BuiltinType>(getPromotedType(right))->getBuiltinKind();
+    return types_.getBuiltinType(ast::BuiltinType::getCommonKind(leftKind, rightKind));
+}
+
+bool TypeChecker::areTypesCompatible(const ast::Type *type1, const ast::Type *type2) {
+    if (!type1 || !type2) {
+        return false;
+    }
+    
+    // Types are uniqued, so identical types are the same object
+    if (type1->getUnqualifiedType() == type2->getUnqualifiedType()) {
         return true;
     }
     
-    // Allow implicit conversions between numeric types
-    std::vector<std::string> numericTypes = {"int", "char", "float", "double", "_Bool"};
-    auto isNumeric = [&](const std::string &type) {
-        return std::find(numericTypes.begin(), numericTypes.end(), type) != numericTypes.end();
-    };
+    // Casts are not kept in the AST, so any scalar converts to any other
+    return type1->isScalar() && type2->isScalar();
+}
+
+bool TypeChecker::areFunctionDeclarationsCompatible(const Symbol *symbol, const ast::FunctionDecl *func,
+                                                    const ast::FunctionType *type) {
+    bool hasPrototype = func->hasPrototype;
+    if (symbol->hasPrototype && hasPrototype) {
+        return symbol->type == type;
+    }
+    auto *previous = ast::cast<ast::FunctionType>(symbol->type);
+    if (previous->getReturnType() != type->getReturnType()) {
+        return false;
+    }
+    if (!symbol->hasPrototype && !hasPrototype) {
+        return true;
+    }
     
-    return isNumeric(type1) && isNumeric(type2);
+    // Arguments to a function without a prototype are promoted, so the
+    // prototype may only have parameters that promotion leaves alone
+    const ast::FunctionType *prototype = hasPrototype ? type : previous;
+    bool definedWithoutPrototype = hasPrototype ? definedFunctions_.count(func->name) != 0 : func->isDefinition();
+    if (prototype->isVariadic() || (definedWithoutPrototype && !prototype->getParamTypes().empty())) {
+        return false;
+    }
+    using BK = ast::BuiltinType::BuiltinKind;
+    for (const ast::Type *param : prototype->getParamTypes()) {
+        auto *builtin = ast::dyn_cast<ast::BuiltinType>(param);
+        if (builtin && (builtin->getBuiltinKind() == BK::Float ||
+                        ast::BuiltinType::getPromotedKind(builtin->getBuiltinKind()) != builtin->getBuiltinKind())) {
+            return false;
+        }
+    }
+    return true;
 }
 
-void TypeChecker::error(const std::string &message) {
-    std::cerr << "Type error: " << message << std::endl;
+bool TypeChecker::error(const ast::Node *node, const std::string &message) {
+    if (sourceManager_ && node && node->loc.isValid()) {
+        diagnostics_ += sourceManager_->getDescription(node->loc) + ": ";
+    }
+    diagnostics_ += "Type error: " + message + "\n";
     hasErrors_ = true;
+    return false;
 }
 
 } // namespace sema
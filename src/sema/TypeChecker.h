@@ -4,38 +4,169 @@
 #include "ast/Node.h"
 #include "ast/Expr.h"
 #include "ast/Stmt.h"
+#include "ast/ASTVisitor.h"
+#include "utils/SourceManager.h"
+
+#include <iostream>
+#include <string>
+#include <unordered_set>
 
 namespace sema {
 
 /**
  * Type checker for semantic analysis.
+ *
+ * Besides reporting errors, it annotates every expression it checks with
+ * its type and value category, and binary operators with the type their
+ * operands are converted to, so later passes read them off the node. It
+ * also binds each identifier to the slot of the declaration it names:
+ * locals are numbered per function and globals per translation unit, so a
+ * code generator can keep its values in arrays.
+ *
+ * A whole translation unit is checked in two phases. Declarations are
+ * checked first, serially and in source order; function bodies are then
+ * checked independently, on a thread pool when more than one job is
+ * requested. Each body gets a checker of its own that reads the global
+ * scope but never modifies it, and sees only the globals declared before
+ * its function. Calls are checked against the prototype the unit gives a
+ * function even if it follows the body, because the code generator also
+ * declares every function before lowering any body; checkDeclaration sees
+ * only the prototypes declared so far.
+ * Diagnostics are buffered per declaration and printed in source order.
+ *
+ * Casts are not represented in the AST, so conversions between scalar
+ * types are accepted without complaint.
  */
-class TypeChecker {
+class TypeChecker : public ast::ASTVisitor<TypeChecker, bool> {
+    friend class ast::ASTVisitor<TypeChecker, bool>;
+    
 public:
-    TypeChecker() = default;
+    /**
+     * @param types Context the AST's types were created in
+     * @param jobs Number of threads checking function bodies (0 selects the
+     *        hardware concurrency)
+     */
+    explicit TypeChecker(ast::TypeContext &types, unsigned jobs = 1);
     
     /**
      * Check types for a translation unit.
      */
     bool checkTypes(ast::TranslationUnit *tu);
     
+    /**
+     * Check one top-level declaration in the scope of those checked before
+     * it, for front ends that hand over declarations one at a time.
+     * @return false if an error was reported
+     */
+    bool checkDeclaration(ast::Node *decl);
+    
+    /**
+     * Print diagnostics to os instead of std::cerr.
+     */
+    void setDiagnosticStream(std::ostream &os) { diagnosticStream_ = &os; }
+    
+    /**
+     * Resolve node locations through sourceManager, so diagnostics name the
+     * file and line they were written at. Without one they carry none.
+     */
+    void setSourceManager(const utils::SourceManager *sourceManager) { sourceManager_ = sourceManager; }
+    
 private:
+    ast::TypeContext &types_;
+    unsigned jobs_ = 1;
     SymbolTable symbolTable_;
     
-    // Type checking methods
-    bool checkFunctionDecl(ast::FunctionDecl *func);
-    bool checkVarDecl(ast::VarDecl *var);
-    bool checkStmt(ast::Stmt *stmt);
-    bool checkExpr(ast::Expr *expr);
+    // Set in the checker of a single function body: the translation unit's
+    // global scope, shared and read-only, and the number of global slots
+    // handed out up to and including the function
+    const SymbolTable *globals_ = nullptr;
+    unsigned visibleGlobals_ = 0;
+    
+    // Diagnostics reported but not yet printed, and where they go
+    std::string diagnostics_;
+    std::ostream *diagnosticStream_ = &std::cerr;
+    const utils::SourceManager *sourceManager_ = nullptr;
     
-    // Type inference
-    std::string inferType(ast::Expr *expr);
+    // Functions whose body has been seen, to tell prototypes from redefinitions
+    std::unordered_set<const ast::IdentifierInfo*> definedFunctions_;
+    
+    // Slots handed out so far
+    unsigned numGlobals_ = 0;
+    unsigned numLocals_ = 0;
+    
+    // Function whose body is being checked; null at file scope
+    ast::FunctionDecl *currentFunction_ = nullptr;
+    
+    /**
+     * Checker for one body of the translation unit parent is checking.
+     */
+    TypeChecker(const TypeChecker &parent, unsigned visibleGlobals);
+    
+    /**
+     * Enter a function into the global scope and give it its slot.
+     * @return false if an error was reported
+     */
+    bool declareFunction(ast::FunctionDecl *func);
+    void checkFunctionBody(ast::FunctionDecl *func);
+    
+    /**
+     * Look up a name in the open scopes, then in the shared global scope.
+     */
+    const Symbol *lookupSymbol(const ast::IdentifierInfo *name) const;
+    
+    // Type checking methods, reached through visit(); nodes without their
+    // own method are accepted by visitNode
+    bool visitFunctionDecl(ast::FunctionDecl *func);
+    bool visitVarDecl(ast::VarDecl *var);
+    bool visitExprStmt(ast::ExprStmt *stmt);
+    bool visitReturnStmt(ast::ReturnStmt *stmt);
+    bool visitCompoundStmt(ast::CompoundStmt *stmt);
+    bool visitIfStmt(ast::IfStmt *stmt);
+    bool visitWhileStmt(ast::WhileStmt *stmt);
+    bool visitForStmt(ast::ForStmt *stmt);
+    bool visitIntegerLiteral(ast::IntegerLiteral *lit);
+    bool visitFloatingLiteral(ast::FloatingLiteral *lit);
+    bool visitCharacterLiteral(ast::CharacterLiteral *lit);
+    bool visitStringLiteral(ast::StringLiteral *lit);
+    bool visitIdentifier(ast::Identifier *id);
+    bool visitBinaryExpr(ast::BinaryExpr *expr);
+    bool visitUnaryExpr(ast::UnaryExpr *expr);
+    bool visitCallExpr(ast::CallExpr *expr);
+    bool visitArraySubscriptExpr(ast::ArraySubscriptExpr *expr);
+    bool visitMemberExpr(ast::MemberExpr *expr);
+    bool visitConditionalExpr(ast::ConditionalExpr *expr);
+    bool visitNode(ast::Node *node);
+    
+    bool checkCondition(ast::Expr *condition);
+    bool checkAssignment(ast::BinaryExpr *expr);
+    bool checkArithmetic(ast::BinaryExpr *expr);
+    
+    /**
+     * Check that expr designates an object that may be assigned.
+     */
+    bool checkModifiable(ast::Expr *expr, const char *operation);
+    
+    // Type rules
+    
+    /** Arrays and functions used as values become pointers (C11 6.3.2.1). */
+    const ast::Type *getDecayedType(const ast::Expr *expr);
+    const ast::Type *getPromotedType(const ast::Type *type);
+    const ast::Type *getCommonType(const ast::Type *left, const ast::Type *right);
     
     // Type compatibility
-    bool areTypesCompatible(const std::string &type1, const std::string &type2);
+    bool areTypesCompatible(const ast::Type *type1, const ast::Type *type2);
+    
+    /**
+     * Whether a redeclaration of a function agrees with its symbol. A
+     * declaration without a prototype agrees with any prototype whose
+     * parameters survive the default argument promotions, or, if it is a
+     * definition, with one without parameters (C11 6.7.6.3p15).
+     */
+    bool areFunctionDeclarationsCompatible(const Symbol *symbol, const ast::FunctionDecl *func,
+                                           const ast::FunctionType *type);
     
-    // Error reporting
-    void error(const std::string &message);
+    // Error reporting, at the location of the offending node
+    bool error(const ast::Node *node, const std::string &message);
     
     bool hasErrors_ = false;
 };
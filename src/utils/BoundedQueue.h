@@ -0,0 +1,91 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+
+namespace utils {
+
+/**
+ * Blocking FIFO with a fixed capacity, connecting one pipeline stage to the
+ * next. The producer blocks while the queue is full and the consumer while
+ * it is empty.
+ */
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : capacity_(capacity ? capacity : 1) {}
+
+    BoundedQueue(const BoundedQueue &) = delete;
+    BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+    /**
+     * Append an item, waiting for room.
+     * @return false if the consumer has cancelled the queue
+     */
+    bool push(T item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notFull_.wait(lock, [this] { return items_.size() < capacity_ || cancelled_; });
+        if (cancelled_) {
+            return false;
+        }
+        items_.push_back(std::move(item));
+        notEmpty_.notify_one();
+        return true;
+    }
+
+    /**
+     * Remove the oldest item, waiting for one to arrive.
+     * Rethrows the producer's error once the queue has drained.
+     * @return false once the producer has closed the queue and it is empty
+     */
+    bool pop(T &item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notEmpty_.wait(lock, [this] { return !items_.empty() || closed_; });
+        if (items_.empty()) {
+            if (error_) {
+                std::rethrow_exception(error_);
+            }
+            return false;
+        }
+        item = std::move(items_.front());
+        items_.pop_front();
+        notFull_.notify_one();
+        return true;
+    }
+
+    /**
+     * Producer side: no more items will be pushed.
+     * @param error Failure to report to the consumer, if any
+     */
+    void close(std::exception_ptr error = nullptr) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        error_ = error;
+        notEmpty_.notify_all();
+    }
+
+    /**
+     * Consumer side: stop accepting items and release a blocked producer.
+     */
+    void cancel() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cancelled_ = true;
+        items_.clear();
+        notFull_.notify_all();
+    }
+
+private:
+    size_t capacity_;
+    std::deque<T> items_;
+    std::mutex mutex_;
+    std::condition_variable notEmpty_;
+    std::condition_variable notFull_;
+    bool closed_ = false;
+    bool cancelled_ = false;
+    std::exception_ptr error_;
+};
+
+} // namespace utils
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+
+namespace utils {
+
+/**
+ * A position in source code, encoded as one 32-bit offset.
+ *
+ * A SourceManager gives every buffer it loads a contiguous range of
+ * offsets; a location is an offset inside one of those ranges. Line,
+ * column and file are recovered from the SourceManager on demand, so nodes
+ * and tokens carry four bytes instead of a line, column and file name.
+ * Offset 0 is never assigned and marks an invalid location.
+ */
+class SourceLocation {
+public:
+    SourceLocation() = default;
+
+    static SourceLocation getFromOffset(uint32_t offset) {
+        SourceLocation loc;
+        loc.offset_ = offset;
+        return loc;
+    }
+
+    bool isValid() const { return offset_ != 0; }
+    bool isInvalid() const { return offset_ == 0; }
+
+    uint32_t getOffset() const { return offset_; }
+
+    SourceLocation getLocWithOffset(int64_t delta) const {
+        return getFromOffset(static_cast<uint32_t>(offset_ + delta));
+    }
+
+    friend bool operator==(SourceLocation a, SourceLocation b) { return a.offset_ == b.offset_; }
+    friend bool operator!=(SourceLocation a, SourceLocation b) { return a.offset_ != b.offset_; }
+    friend bool operator<(SourceLocation a, SourceLocation b) { return a.offset_ < b.offset_; }
+
+private:
+    uint32_t offset_ = 0;
+};
+
+static_assert(sizeof(SourceLocation) == 4, "locations must stay 32 bits");
+
+} // namespace utils
@@ -0,0 +1,166 @@
+#include "utils/SourceManager.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace utils {
+
+void computeLineStarts(std::string_view text, std::vector<uint32_t> &lineStarts) {
+    lineStarts.clear();
+    lineStarts.push_back(0);
+
+    const char *data = text.data();
+    size_t size = text.size();
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    // Compare 16 bytes at a time and walk the set bits of the match mask
+    const __m128i newline = _mm_set1_epi8('\n');
+    for (; i + 16 <= size; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)));
+        while (mask != 0) {
+            lineStarts.push_back(static_cast<uint32_t>(i + __builtin_ctz(mask) + 1));
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    for (; i < size; ++i) {
+        if (data[i] == '\n') {
+            lineStarts.push_back(static_cast<uint32_t>(i + 1));
+        }
+    }
+}
+
+FileID SourceManager::createBuffer(std::string name, std::string contents, SourceLocation includeLoc) {
+    // One extra offset for the end-of-file location
+    uint64_t end = uint64_t(nextOffset_) + contents.size() + 1;
+    if (end > std::numeric_limits<uint32_t>::max()) {
+        throw std::runtime_error("Source too large: " + name);
+    }
+
+    Buffer &buffer = buffers_.emplace_back();
+    buffer.name = std::move(name);
+    buffer.data = std::move(contents);
+    buffer.start = nextOffset_;
+    buffer.includeLoc = includeLoc;
+    starts_.push_back(nextOffset_);
+
+    nextOffset_ = static_cast<uint32_t>(end);
+    return FileID(static_cast<unsigned>(buffers_.size()));
+}
+
+const SourceManager::Buffer &SourceManager::getBuffer(FileID file) const {
+    if (!file.isValid() || file.id_ > buffers_.size()) {
+        throw std::out_of_range("Invalid FileID");
+    }
+    return buffers_[file.id_ - 1];
+}
+
+std::string_view SourceManager::getBufferData(FileID file) const {
+    return getBuffer(file).data;
+}
+
+std::string_view SourceManager::getBufferName(FileID file) const {
+    return getBuffer(file).name;
+}
+
+SourceLocation SourceManager::getLocForStartOfFile(FileID file) const {
+    return SourceLocation::getFromOffset(getBuffer(file).start);
+}
+
+SourceLocation SourceManager::getIncludeLoc(FileID file) const {
+    return getBuffer(file).includeLoc;
+}
+
+FileID SourceManager::getFileID(SourceLocation loc) const {
+    if (loc.isInvalid() || loc.getOffset() >= nextOffset_) {
+        return FileID();
+    }
+    // Last buffer starting at or before the location
+    auto it = std::upper_bound(starts_.begin(), starts_.end(), loc.getOffset());
+    return FileID(static_cast<unsigned>(it - starts_.begin()));
+}
+
+const SourceManager::Buffer *SourceManager::findBuffer(SourceLocation loc) const {
+    FileID file = getFileID(loc);
+    return file.isValid() ? &buffers_[file.id_ - 1] : nullptr;
+}
+
+unsigned SourceManager::getFileOffset(SourceLocation loc) const {
+    const Buffer *buffer = findBuffer(loc);
+    return buffer ? loc.getOffset() - buffer->start : 0;
+}
+
+void SourceManager::addLineMarker(FileID file, unsigned line, SourceLocation origin) {
+    getBuffer(file);  // validates the ID
+    auto &markers = buffers_[file.id_ - 1].markers;
+    if (!markers.empty() && markers.back().line >= line) {
+        throw std::invalid_argument("Line markers must be added in increasing line order");
+    }
+    markers.push_back(LineMarker{line, origin});
+}
+
+std::pair<unsigned, unsigned> SourceManager::getLineAndColumn(const Buffer &buffer, uint32_t offset) const {
+    std::call_once(buffer.lineTableOnce, [&buffer] {
+        computeLineStarts(buffer.data, buffer.lineStarts);
+    });
+
+    const auto &lineStarts = buffer.lineStarts;
+    auto it = std::upper_bound(lineStarts.begin(), lineStarts.end(), offset);
+    unsigned line = static_cast<unsigned>(it - lineStarts.begin());
+    unsigned column = offset - lineStarts[line - 1] + 1;
+    return {line, column};
+}
+
+unsigned SourceManager::getLineNumber(SourceLocation loc) const {
+    const Buffer *buffer = findBuffer(loc);
+    return buffer ? getLineAndColumn(*buffer, loc.getOffset() - buffer->start).first : 0;
+}
+
+unsigned SourceManager::getColumnNumber(SourceLocation loc) const {
+    const Buffer *buffer = findBuffer(loc);
+    return buffer ? getLineAndColumn(*buffer, loc.getOffset() - buffer->start).second : 0;
+}
+
+PresumedLoc SourceManager::getPresumedLoc(SourceLocation loc) const {
+    const Buffer *buffer = findBuffer(loc);
+    if (!buffer) {
+        return PresumedLoc();
+    }
+
+    auto [line, column] = getLineAndColumn(*buffer, loc.getOffset() - buffer->start);
+
+    // Last marker at or before this line
+    auto marker = std::upper_bound(buffer->markers.begin(), buffer->markers.end(), line,
+                                   [](unsigned l, const LineMarker &m) { return l < m.line; });
+    if (marker == buffer->markers.begin()) {
+        return PresumedLoc{buffer->name, line, column, buffer->includeLoc};
+    }
+    --marker;
+
+    PresumedLoc origin = getPresumedLoc(marker->origin);
+    if (!origin.isValid()) {
+        return PresumedLoc{buffer->name, line, column, buffer->includeLoc};
+    }
+    origin.line += line - marker->line;
+    origin.column = column;
+    return origin;
+}
+
+std::string SourceManager::getDescription(SourceLocation loc) const {
+    PresumedLoc presumed = getPresumedLoc(loc);
+    if (!presumed.isValid()) {
+        return "<unknown>";
+    }
+    return std::string(presumed.filename) + ":" + std::to_string(presumed.line) + ":" +
+           std::to_string(presumed.column);
+}
+
+} // namespace utils
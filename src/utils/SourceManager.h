@@ -0,0 +1,135 @@
+#pragma once
+
+#include "utils/SourceLocation.h"
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace utils {
+
+/**
+ * Identifies one buffer loaded into a SourceManager.
+ */
+class FileID {
+public:
+    FileID() = default;
+
+    bool isValid() const { return id_ != 0; }
+
+    friend bool operator==(FileID a, FileID b) { return a.id_ == b.id_; }
+    friend bool operator!=(FileID a, FileID b) { return a.id_ != b.id_; }
+
+private:
+    friend class SourceManager;
+    explicit FileID(unsigned id) : id_(id) {}
+
+    unsigned id_ = 0;  // index + 1; 0 is invalid
+};
+
+/**
+ * A location as the user sees it: the file, line and column it was written
+ * at, after following the line markers of a preprocessed buffer.
+ */
+struct PresumedLoc {
+    std::string_view filename;
+    unsigned line = 0;          // 1-based, 0 if invalid
+    unsigned column = 0;        // 1-based
+    SourceLocation includeLoc;  // the #include that pulled the file in
+
+    bool isValid() const { return line != 0; }
+};
+
+/**
+ * Owns the source buffers of one compilation and maps SourceLocations back
+ * to them.
+ *
+ * Each buffer is assigned the offsets [start, start + size], the last one
+ * being its end-of-file location, so a location names both a buffer and a
+ * byte within it. Line tables are built the first time a buffer is asked
+ * for a line or column. Loading buffers must not race with other calls;
+ * once loading is done, queries may run from several threads.
+ */
+class SourceManager {
+public:
+    SourceManager() = default;
+    SourceManager(const SourceManager &) = delete;
+    SourceManager &operator=(const SourceManager &) = delete;
+
+    /**
+     * Take ownership of a buffer and assign it a range of locations.
+     * @param name File name reported in diagnostics
+     * @param contents The text of the buffer
+     * @param includeLoc Location of the #include that loaded it, if any
+     */
+    FileID createBuffer(std::string name, std::string contents, SourceLocation includeLoc = {});
+
+    std::string_view getBufferData(FileID file) const;
+    std::string_view getBufferName(FileID file) const;
+    SourceLocation getLocForStartOfFile(FileID file) const;
+    SourceLocation getIncludeLoc(FileID file) const;
+
+    /** The buffer containing a location (invalid if none does). */
+    FileID getFileID(SourceLocation loc) const;
+
+    /** Byte offset of a location from the start of its buffer. */
+    unsigned getFileOffset(SourceLocation loc) const;
+
+    /**
+     * Record that lines of a buffer from `line` on were written at `origin`
+     * and the lines following it, the way a #line directive does. Used to
+     * map preprocessed output back to the files it came from; markers must
+     * be added in increasing line order.
+     */
+    void addLineMarker(FileID file, unsigned line, SourceLocation origin);
+
+    /** 1-based line and column within the buffer, ignoring line markers. */
+    unsigned getLineNumber(SourceLocation loc) const;
+    unsigned getColumnNumber(SourceLocation loc) const;
+
+    PresumedLoc getPresumedLoc(SourceLocation loc) const;
+
+    /** "file:line:column", or "<unknown>" for an invalid location. */
+    std::string getDescription(SourceLocation loc) const;
+
+    size_t getNumBuffers() const { return buffers_.size(); }
+
+private:
+    struct LineMarker {
+        unsigned line;
+        SourceLocation origin;
+    };
+
+    struct Buffer {
+        std::string name;
+        std::string data;
+        uint32_t start;
+        SourceLocation includeLoc;
+        std::vector<LineMarker> markers;
+
+        mutable std::once_flag lineTableOnce;
+        mutable std::vector<uint32_t> lineStarts;
+    };
+
+    // Deques never move their elements, so buffer data stays put
+    std::deque<Buffer> buffers_;
+    std::vector<uint32_t> starts_;  // start offset of each buffer, ascending
+    uint32_t nextOffset_ = 1;
+
+    const Buffer &getBuffer(FileID file) const;
+    const Buffer *findBuffer(SourceLocation loc) const;
+
+    /** Line and column of an offset into a buffer, 1-based. */
+    std::pair<unsigned, unsigned> getLineAndColumn(const Buffer &buffer, uint32_t offset) const;
+};
+
+/**
+ * Offsets of the first character of every line of `text`: lineStarts[0] is
+ * 0, and each newline adds the offset just past it.
+ */
+void computeLineStarts(std::string_view text, std::vector<uint32_t> &lineStarts);
+
+} // namespace utils
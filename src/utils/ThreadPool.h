@@ -0,0 +1,56 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace utils {
+
+/**
+ * Fixed-size pool of worker threads running submitted tasks in FIFO order.
+ */
+class ThreadPool {
+public:
+    /**
+     * @param threads Number of workers (0 selects the hardware concurrency)
+     */
+    explicit ThreadPool(unsigned threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /**
+     * Queue a task for execution on a worker thread.
+     */
+    void submit(std::function<void()> task);
+
+    /**
+     * Block until every submitted task has finished.
+     * Rethrows the first exception thrown by a task, if any.
+     */
+    void wait();
+
+    /**
+     * Number of worker threads.
+     */
+    unsigned size() const { return static_cast<unsigned>(workers_.size()); }
+
+private:
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable available_;
+    std::condition_variable idle_;
+    size_t running_ = 0;
+    bool stopping_ = false;
+    std::exception_ptr firstError_;
+
+    void workerLoop();
+};
+
+} // namespace utils
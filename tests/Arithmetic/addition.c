@@ -1,6 +1,6 @@
 // Test arithmetic operations  
 // Expected exit code: 8
-// RUN: %mmoc %s -o %t && %t
+// RUN: %mmoc %s -o %t && { %t; test $? -eq 8; }
 
 int main() {
     return 5 + 3;
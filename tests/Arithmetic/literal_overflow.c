@@ -0,0 +1,7 @@
+// An integer constant that no integer type can hold is an error rather
+// than a silent 0
+// RUN: ! %mmoc -fsyntax-only %s 2> %t
+// RUN: grep -q "integer constant 18446744073709551616u at line 7 is too large" %t
+
+unsigned long long fits = 18446744073709551615u;
+unsigned long long overflows = 18446744073709551616u;
@@ -0,0 +1,17 @@
+// Integer constants take their type from the suffix and radix (C11
+// 6.4.4.1p5), so 1u << 31 is an unsigned shift rather than an overflow
+// RUN: %mmoc %s -o %t && %t
+
+int main() {
+    int s = 31;
+    if ((1u << s) >> s != 1) return 1; // a logical shift back
+    if (sizeof(1u) != 4 || sizeof(1) != 4) return 2;
+    if (sizeof(1L) != 8 || sizeof(1ll) != 8) return 3;
+    if (sizeof(2147483648) != 8) return 4;  // decimal: long
+    if (sizeof(0x80000000) != 4) return 5;  // hex: unsigned int
+    if (0x80000000 >> 31 != 1) return 6;
+    if (-1 < 0u) return 7;  // -1 converts to UINT_MAX
+    if (0xFFFFFFFFu + 1 != 0) return 8;
+    if (0X1E != 30 || 0x1e != 30) return 9;  // the E is a digit, not an exponent
+    return 0;
+}
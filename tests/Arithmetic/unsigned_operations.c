@@ -0,0 +1,21 @@
+// Operators follow the C types of their operands: unsigned values divide,
+// shift and compare as unsigned, and mixed operands use the common type
+// RUN: %mmoc %s -o %t && %t
+
+int main() {
+    unsigned int big = 4000000000;
+    if (big / 2 != 2000000000) return 1;
+    if (big < 1) return 2;
+    if (big >> 31 != 1) return 3;
+    int minusOne = -1;
+    if (minusOne < big) return 4; // -1 converts to UINT_MAX
+    big /= 4;
+    if (big != 1000000000) return 5;
+    char c = 'a';
+    if (c != 'a') return 6;
+    int x = 41;
+    int *p = &x;
+    ++*p;
+    if (*p != 42) return 7;
+    return 0;
+}
@@ -0,0 +1,16 @@
+// With -fwrapv signed overflow is defined to wrap around, so the check
+// below must not be folded away
+// RUN: %mmoc -fwrapv %s -o %t && %t
+
+int overflows(int x) {
+    return x + 1 < x;
+}
+
+int main() {
+    if (!overflows(2147483647)) return 1;
+    if (overflows(41)) return 2;
+    int n = 2147483647;
+    n++;
+    if (n >= 0) return 3;
+    return 0;
+}
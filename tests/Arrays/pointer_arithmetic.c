@@ -0,0 +1,33 @@
+// Pointer arithmetic and subscripts step by whole elements, whatever the
+// element size, and the difference of two pointers counts elements
+// RUN: %mmoc %s -o %t && %t
+
+int sum(int *p, int n) {
+    int s = 0;
+    for (int i = 0; i < n; i++) {
+        s += p[i];
+    }
+    return s;
+}
+
+int main() {
+    int a[5];
+    for (int i = 0; i < 5; i++) {
+        a[i] = i * 2;
+    }
+    if (sum(a, 5) != 20) return 1;
+    int *p = a;
+    p++;
+    ++p;
+    if (*p != 4) return 2;
+    int *q = a + 4;
+    if (q - p != 2) return 3;
+    q -= 1;
+    if (*q != 6) return 4;
+    if (2[a] != 4) return 5;
+    long m[2][3];
+    m[1][2] = 7;
+    if (*(*(m + 1) + 2) != 7) return 6;
+    if ((1 + p)[-1] != 4) return 7;
+    return 0;
+}
@@ -0,0 +1,24 @@
+// A program compiled from its serialized AST must behave like the source
+// RUN: %mmoc -emit-ast %s -o %t.ast && %mmoc %t.ast -o %t && %t
+
+int offset = 4;
+
+long scale(long value, int factor);
+
+int half(int x) {
+    return x / 2;
+}
+
+long scale(long value, int factor) {
+    long result = value;
+    for (int i = 1; i < factor; i++) {
+        result += value;
+    }
+    return result;
+}
+
+int main() {
+    if (scale(7, 3) != 21) return 1;
+    if (half(9) != offset) return 2;
+    return 0;
+}
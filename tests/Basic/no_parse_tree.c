@@ -0,0 +1,22 @@
+// Per-declaration parsing must build the same program as the full parse tree
+// RUN: %mmoc -fno-parse-tree %s -o %t && %t
+
+int square(int x) {
+    return x * x;
+}
+
+;
+
+int sum_to(int n) {
+    int total = 0;
+    for (int i = 1; i <= n; i++) {
+        total += i;
+    }
+    return total;
+}
+
+int main() {
+    if (square(6) != 36) return 1;
+    if (sum_to(4) != 10) return 2;
+    return 0;
+}
@@ -1,5 +1,5 @@
 // Test basic program compilation and execution
-// RUN: %mmoc %s -o %t && %t
+// RUN: %mmoc %s -o %t && { %t; test $? -eq 42; }
 
 int main() {
     return 42;
@@ -0,0 +1,15 @@
+// -fsyntax-only parses and type-checks several files in one process and
+// writes nothing
+// RUN: rm -f %t && %mmoc -fsyntax-only -j 2 %s %s -o %t && test ! -e %t
+
+int total = 0;
+
+int add(int a, int b) {
+    return a + b;
+}
+
+int main() {
+    unsigned int big = 4000000000;
+    total = add(1, 2);
+    return big > 0 && total == 3 ? 0 : 1;
+}
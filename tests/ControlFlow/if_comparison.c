@@ -1,6 +1,5 @@
 // Test if statements with comparisons
-// RUN: %mmoc %s -o %t && %t
-// RUN: test $? -eq 99
+// RUN: %mmoc %s -o %t && { %t; test $? -eq 99; }
 
 int main() {
     int x = 5;
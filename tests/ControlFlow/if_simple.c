@@ -1,6 +1,5 @@
 // Test if statements - should work now
-// RUN: %mmoc %s -o %t && %t
-// RUN: test $? -eq 42
+// RUN: %mmoc %s -o %t && { %t; test $? -eq 42; }
 
 int main() {
     if (1) return 42;
@@ -0,0 +1,25 @@
+// Locals declared in a loop body are allocated once per call, not once
+// per iteration: ten million iterations must not exhaust the stack
+// RUN: %mmoc %s -o %t && %t
+
+int main() {
+    long sum = 0;
+    int i = 0;
+    while (i < 10000000) {
+        long a = i;
+        long b = a * 2;
+        i++;
+        if (b > 10) {
+            long skipped = b;
+            sum += skipped - b;
+            continue;
+        }
+        sum += b;
+    }
+    for (int j = 0; j < 10000000; j++) {
+        long c = j;
+        if (c == 5) break;
+    }
+    if (sum != 30) return 1;
+    return 0;
+}
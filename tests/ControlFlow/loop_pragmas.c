@@ -0,0 +1,43 @@
+// Loop pragmas only ask for transformations; the loops must compute the
+// same results however they are vectorized or unrolled
+// RUN: %mmoc -O2 %s -o %t && %t
+
+#define UNROLL 4
+#define WIDTH 8
+
+int scale(int *p, int n) {
+    #pragma omp simd simdlen(WIDTH)
+    for (int i = 0; i < n; i++) {
+        p[i] = p[i] * 2;
+    }
+    int sum = 0;
+    #pragma clang loop vectorize(enable) interleave_count(4)
+    for (int i = 0; i < n; i++) {
+        sum += p[i];
+    }
+    return sum;
+}
+
+int main() {
+    int a[100];
+    #pragma GCC ivdep
+    #pragma unroll UNROLL
+    for (int i = 0; i < 100; i++) {
+        a[i] = i;
+    }
+    if (scale(a, 100) != 9900) return 1;
+    int n = 10;
+    int steps = 0;
+    #pragma nounroll
+    while (n > 0) {
+        n -= 3;
+        steps++;
+    }
+    if (steps != 4) return 2;
+    #pragma GCC unroll 2
+    for (int i = 0; i < 3; i++) {
+        steps += a[i];
+    }
+    if (steps != 10) return 3;
+    return 0;
+}
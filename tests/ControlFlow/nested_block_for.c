@@ -0,0 +1,16 @@
+// RUN: %mmoc %s | %run ; if [ $? -eq 7 ]; then echo "PASS"; else echo "FAIL (got $?)"; fi
+// Test nested blocks, a for loop without a condition and right shift
+
+int main() {
+    int count = 0;
+    {
+        int limit = 64 >> 3;
+        for (int i = 1; ; i = i + 1) {
+            if (i == limit) {
+                break;
+            }
+            count = count + 1;
+        }
+    }
+    return count;  // Should return 7
+}
@@ -1,6 +1,5 @@
 // Test while loops
-// RUN: %mmoc %s -o %t && %t
-// RUN: test $? -eq 5
+// RUN: %mmoc %s -o %t && { %t; test $? -eq 5; }
 
 int main() {
     int x = 0;
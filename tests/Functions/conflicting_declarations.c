@@ -0,0 +1,25 @@
+// A prototype must survive the default argument promotions to agree with
+// f(), and a return must fit the function's result type
+// RUN: ! %mmoc -fsyntax-only %s 2> %t
+// RUN: grep -q "Conflicting types for function 'narrow'" %t
+// RUN: grep -q "Conflicting types for function 'defined'" %t
+// RUN: grep -q "Void function 'nothing' should not return a value" %t
+// RUN: grep -q "Returning 'void' from a function with result type 'int'" %t
+
+int narrow();
+int narrow(char c) {
+    return c;
+}
+
+int defined() {
+    return 0;
+}
+int defined(int x);
+
+void nothing(void) {
+    return 1;
+}
+
+int something(void) {
+    return nothing();
+}
@@ -0,0 +1,31 @@
+// Function bodies parsed on worker threads are joined back in source order
+// RUN: %mmoc -fparallel-parse=4 %s -o %t && %t
+
+int counter;
+
+int add(int a, int b) {
+    return a + b;
+}
+
+int twice(int x) {
+    if (x > 0) {
+        return add(x, x);
+    }
+    return 0;
+}
+
+int count_down(int n) {
+    int steps = 0;
+    while (n > 0) {
+        n--;
+        steps++;
+    }
+    return steps;
+}
+
+int main() {
+    if (add(2, 3) != 5) return 1;
+    if (twice(21) != 42) return 2;
+    if (count_down(7) != 7) return 3;
+    return 0;
+}
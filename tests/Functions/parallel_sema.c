@@ -0,0 +1,28 @@
+// Function bodies type-checked on worker threads see the globals and
+// functions declared before them
+// RUN: %mmoc -fparallel-sema=4 %s -o %t && %t
+
+int scale = 3;
+
+int triple(int x) {
+    return x * scale;
+}
+
+unsigned int halve(unsigned int x) {
+    return x / 2;
+}
+
+int offset = 5;
+
+int shifted(int x) {
+    int offset = 1;
+    return triple(x) + offset;
+}
+
+int main() {
+    if (triple(4) != 12) return 1;
+    if (halve(4000000000) != 2000000000) return 2;
+    if (shifted(2) != 7) return 3;
+    if (offset != 5) return 4;
+    return 0;
+}
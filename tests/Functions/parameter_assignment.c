@@ -0,0 +1,42 @@
+// Scalar locals and parameters live in SSA registers unless their address
+// is taken: parameters may be assigned, values merge across loops and
+// branches, and nested && and || pick their operands from the right blocks
+// RUN: %mmoc %s -o %t && %t
+
+int fact(int n) {
+    int r = 1;
+    while (n > 1) {
+        r *= n;
+        n--;
+    }
+    return r;
+}
+
+int bump(int x) {
+    int *p = &x;
+    *p = *p + 1;
+    return x;
+}
+
+int logic(int a, int b, int c) {
+    return a && b || c;
+}
+
+int pick(int k) {
+    int v = 0;
+    for (int i = 0; i < k; i++) {
+        if (i == 2) v = i * 10;
+        else v = v + 1;
+    }
+    return v;
+}
+
+int main() {
+    if (fact(5) != 120) return 1;
+    if (bump(41) != 42) return 2;
+    if (logic(1, 0, 1) != 1) return 3;
+    if (logic(1, 1, 0) != 1) return 4;
+    if (logic(0, 1, 0) != 0) return 5;
+    if (pick(5) != 22) return 6;
+    return 0;
+}
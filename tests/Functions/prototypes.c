@@ -0,0 +1,33 @@
+// Qualifiers on a parameter are not part of the function's type, and a
+// declaration without a prototype agrees with any later prototype
+// RUN: %mmoc %s -o %t && %t
+
+int twice(int);
+
+int twice(const int x) {
+    return x * 2;
+}
+
+int add();
+
+int add(int a, int b) {
+    return a + b;
+}
+
+int zero(void);
+
+int zero() {
+    return 0;
+}
+
+long widen(int x) {
+    return x;
+}
+
+int main() {
+    if (twice(4) != 8) return 1;
+    if (add(2, 3) != 5) return 2;
+    if (zero() != 0) return 3;
+    if (widen(-1) != -1) return 4;
+    return 0;
+}
@@ -1,6 +1,5 @@
 // Test function definitions and calls
-// RUN: %mmoc %s -o %t && %t
-// RUN: test $? -eq 5
+// RUN: %mmoc %s -o %t && { %t; test $? -eq 5; }
 
 int add(int a, int b) {
     return a + b;
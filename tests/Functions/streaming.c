@@ -0,0 +1,24 @@
+// Each function lands in its own module; calls and globals cross modules
+// RUN: %mmoc -fstreaming -fstream-batch=1 %s -o %t && %t
+
+int base = 40;
+
+int add(int a, int b);
+
+int twice(int x) {
+    return add(x, x);
+}
+
+int add(int a, int b) {
+    return a + b;
+}
+
+int offset() {
+    return base + 2;
+}
+
+int main() {
+    if (twice(21) != 42) return 1;
+    if (offset() != 42) return 2;
+    return 0;
+}
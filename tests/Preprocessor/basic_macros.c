@@ -1,4 +1,4 @@
-// RUN: %mmoc %s -o %t && %t
+// RUN: %mmoc %s -o %t && { %t; test $? -eq 13; }
 // Test basic macro expansion functionality
 
 #define PI 3
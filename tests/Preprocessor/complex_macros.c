@@ -1,4 +1,4 @@
-// RUN: %mmoc %s -o %t && %t
+// RUN: %mmoc %s -o %t && { %t; test $? -eq 5; }
 // Test complex macro functionality
 
 #define ADD(a, b) ((a) + (b))
@@ -0,0 +1,12 @@
+// Errors are reported at the file and line they were written at, even
+// when the file was pulled in by #include
+// RUN: ! %mmoc -fsyntax-only %s 2> %t
+// RUN: grep -q "include_error.h:5:16: Type error: Undefined variable 'fctor'" %t
+// RUN: grep -q "include_diagnostics.c:11:12: Type error: Undefined variable 'resut'" %t
+
+#include "include_error.h"
+
+int main() {
+    int result = scale(21);
+    return resut;
+}
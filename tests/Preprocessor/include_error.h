@@ -0,0 +1,6 @@
+// Header for include_diagnostics.c, with an error on line 5
+
+int scale(int x) {
+    int factor = 2;
+    return x * fctor;
+}
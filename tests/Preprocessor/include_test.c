@@ -1,4 +1,4 @@
-// RUN: %mmoc %s -o %t && %t
+// RUN: %mmoc %s -o %t && { %t; test $? -eq 42; }
 // Test include directive functionality
 
 #define HELPER_VALUE 42
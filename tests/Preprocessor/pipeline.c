@@ -0,0 +1,19 @@
+// Preprocessor, lexer and parser run as concurrent pipeline stages
+// RUN: %mmoc -fpipeline -fstream-batch=1 %s -o %t && %t
+
+#define LIMIT 5
+#define DOUBLE(x) ((x) * 2)
+
+int sum_to(int n) {
+    int total = 0;
+    for (int i = 1; i <= n; i++) {
+        total += i;
+    }
+    return total;
+}
+
+int main() {
+    if (sum_to(LIMIT) != 15) return 1;
+    if (DOUBLE(21) != 42) return 2;
+    return 0;
+}
@@ -0,0 +1,10 @@
+// Error recovery in the pipelined parser reaches tokens lexed by a thread
+// that has already finished; a missing ';' must be reported, not crash
+// RUN: %mmoc -fpipeline %s -o %t 2> %t; test $? -eq 1 && grep -q "Failed to parse input" %t
+
+#define ANSWER 42
+
+int main() {
+    int x = ANSWER
+    return x;
+}
@@ -0,0 +1,20 @@
+// sizeof an expression is the size of its type, which the operand keeps:
+// arrays do not decay, and the operand is not evaluated
+// RUN: %mmoc %s -o %t && %t
+
+int main() {
+    double d = 0;
+    long l = 0;
+    double *p = &d;
+    int a[10];
+    int n = 3;
+    if (sizeof p != 8) return 1;
+    if (sizeof d != 8) return 2;
+    if (sizeof l != 8) return 3;
+    if (sizeof a != 40) return 4;
+    if (sizeof a[0] != 4) return 5;
+    if (n * sizeof *p != 24) return 6;
+    if (sizeof n++ != 4) return 7;
+    if (n != 3) return 8;
+    return 0;
+}
@@ -0,0 +1,7 @@
+// RUN: %mmoc %s | %run ; if [ $? -eq 62 ]; then echo "PASS"; else echo "FAIL (got $?)"; fi
+// sizeof a type name follows the LP64 layout: 1 + 2 + 4 + 8 + 8 + 8 + 4*3 + 8 + 1 + 8 = 62
+
+int main() {
+    return sizeof(char) + sizeof(short) + sizeof(int) + sizeof(long) + sizeof(long long)
+         + sizeof(double) + sizeof(int[3]) + sizeof(char *) + sizeof(_Bool) + sizeof(unsigned long);
+}
@@ -1,6 +1,5 @@
 // Test variable assignment
-// RUN: %mmoc %s -o %t && %t
-// RUN: test $? -eq 15
+// RUN: %mmoc %s -o %t && { %t; test $? -eq 15; }
 
 int main() {
     int x = 5;
@@ -0,0 +1,37 @@
+// Global initializers and array lengths may be any constant expression
+// RUN: %mmoc %s -o %t && %t
+
+_Static_assert(sizeof(int) == 4 && (1 << 4) == 16, "constant folding");
+
+int flags = (1 << 4) | 3;
+long big = 1 << 30;
+int negative = -5;
+char narrowed = 300;
+double ratio = 1.0 / 4;
+int chosen = 2 > 1 ? 10 : 20;
+// Folding must keep the type: the difference is a long, so the shift is too
+long shifted = (4294967296 - 4294967295) << 40;
+// Suffixed and hex constants are unsigned, so these do not overflow
+unsigned mask = 1u << 31;
+unsigned all = 0xFFFFFFFFu;
+
+_Static_assert(sizeof(-2147483648) == 8, "-2147483648 is a negated long");
+_Static_assert(sizeof(4294967296 - 4294967295) == 8, "a long difference stays long");
+_Static_assert(0xFFFFFFFFu + 1 == 0, "unsigned int arithmetic wraps");
+int main() {
+    _Static_assert(sizeof 1.0 == 8, "a double constant has type double");
+    if (flags != 19) return 1;
+    if (big != 1073741824) return 2;
+    if (negative + 5 != 0) return 3;
+    if (narrowed != 44) return 4;
+    if (ratio != 0.25) return 5;
+    if (chosen != 10) return 6;
+    if (shifted != 1099511627776) return 8;
+    if (sizeof(4294967296 - 4294967295) != 8) return 9;
+    if (mask >> 31 != 1) return 10;
+    if (all != 4294967295u || all + 1 != 0) return 11;
+    int buffer[2 * 4];
+    buffer[7] = 7;
+    if (buffer[7] != 7) return 7;
+    return 0;
+}
@@ -1,6 +1,5 @@
 // Test variable declarations and usage
-// RUN: %mmoc %s -o %t && %t
-// RUN: test $? -eq 10
+// RUN: %mmoc %s -o %t && { %t; test $? -eq 10; }
 
 int main() {
     int x = 10;
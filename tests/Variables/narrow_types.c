@@ -0,0 +1,11 @@
+// RUN: %mmoc %s | %run ; if [ $? -eq 51 ]; then echo "PASS"; else echo "FAIL (got $?)"; fi
+// Values are converted to the declared width on store: 300 wraps to 44 in a char
+
+int main() {
+    char c = 300;
+    short s = 5;
+    long l = c + s;
+    double d = 2;
+    l = l + d;
+    return l;
+}
@@ -0,0 +1,26 @@
+// An inner declaration hides outer ones of the same name until its block
+// ends, and each declaration keeps its own storage
+// RUN: %mmoc %s -o %t && %t
+
+int x = 1;
+
+int get() {
+    return x;
+}
+
+int main() {
+    if (x != 1) return 1;
+    int x = 2;
+    {
+        int x = 3;
+        if (x != 3) return 2;
+        x = 4;
+    }
+    if (x != 2) return 3;
+    int seen = 0;
+    for (int x = 10; x < 11; x++) seen = x;
+    if (seen != 10) return 4;
+    if (x != 2) return 5;
+    if (get() != 1) return 6;
+    return 0;
+}
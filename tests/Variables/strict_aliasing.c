@@ -0,0 +1,30 @@
+// Stores through one pointer type are seen by loads of the same type and
+// of character type, whatever else is accessed in between
+// RUN: %mmoc %s -o %t && %t
+
+int update(int *counts, double *weights, char *bytes, int n) {
+    int total = 0;
+    for (int i = 0; i < n; i++) {
+        counts[i] += 1;
+        weights[i] = weights[i] * 2;
+        total += counts[i];
+    }
+    bytes[0] = 7;
+    return total + bytes[0];
+}
+
+int main() {
+    int counts[4];
+    double weights[4];
+    char bytes[2];
+    for (int i = 0; i < 4; i++) {
+        counts[i] = i;
+        weights[i] = i;
+    }
+    int *p = counts;
+    int **pp = &p;
+    if (update(*pp, weights, bytes, 4) != 17) return 1;
+    if (weights[3] != 6) return 2;
+    if (**pp != 1) return 3;
+    return 0;
+}
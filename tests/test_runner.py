@@ -80,15 +80,16 @@ class MMOCTestSuite:
                 if res.stderr and res.returncode == 0:
                     out_lines.append(f"Warnings: {res.stderr}")
                 if res.returncode != 0:
-                    if any(k in res.stderr.lower() for k in ['error:', 'fatal error:', 'cannot open']):
-                        err_lines.append(res.stderr)
-                        return TestResult(
-                            name,
-                            'FAIL',
-                            time.time() - start,
-                            '\n'.join(out_lines),
-                            '\n'.join(err_lines)
-                        )
+                    # Every RUN line must succeed, so checks such as grep -q or
+                    # test $? -eq N fail the test without printing anything
+                    err_lines.append(res.stderr or f"exit status {res.returncode}")
+                    return TestResult(
+                        name,
+                        'FAIL',
+                        time.time() - start,
+                        '\n'.join(out_lines),
+                        '\n'.join(err_lines)
+                    )
             tmp = path.with_suffix('.tmp')
             if tmp.exists():
                 tmp.unlink()